@@ -0,0 +1,24 @@
+if(LIBURING_LIBRARIES AND LIBURING_INCLUDE_DIRS)
+    set(LIBURING_FOUND TRUE)
+else()
+    find_path(
+        LIBURING_INCLUDE_DIR
+        NAMES liburing.h
+        PATHS /usr/include /usr/local/include /opt/local/include /sw/include ${CMAKE_INCLUDE_PATH} ${CMAKE_INSTALL_PREFIX}/include
+    )
+
+    find_library(
+        LIBURING_LIBRARY
+        NAMES uring
+        PATHS /usr/lib /usr/lib64 /usr/local/lib /usr/local/lib64 /opt/local/lib /sw/lib ${CMAKE_LIBRARY_PATH} ${CMAKE_INSTALL_PREFIX}/lib
+    )
+
+    if(LIBURING_INCLUDE_DIR AND LIBURING_LIBRARY)
+        set(LIBURING_FOUND TRUE)
+    else(LIBURING_INCLUDE_DIR AND LIBURING_LIBRARY)
+        set(LIBURING_FOUND FALSE)
+    endif(LIBURING_INCLUDE_DIR AND LIBURING_LIBRARY)
+
+    set(LIBURING_INCLUDE_DIRS ${LIBURING_INCLUDE_DIR})
+    set(LIBURING_LIBRARIES ${LIBURING_LIBRARY})
+endif()
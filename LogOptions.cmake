@@ -1,30 +1,9 @@
-option(ENABLE_LOG_LOG "Enable log messages" ON)
-option(ENABLE_LOG_WARNING "Enable warning messages" ON)
-option(ENABLE_LOG_ERROR "Enable error messages" ON)
-option(ENABLE_LOG_DEBUG1 "Enable level 1 debug messages" ON)
-option(ENABLE_LOG_DEBUG2 "Enable level 2 debug messages" OFF)
-option(ENABLE_LOG_DEBUG3 "Enable level 3 debug messages" OFF)
+# least severe log level compiled in - informational and debug messages below it are removed by the compiler
+set(SYSTEM_LOG_LEVEL "DBG" CACHE STRING "Least severe log level compiled in: ERR, WRN, INF or DBG")
+set_property(CACHE SYSTEM_LOG_LEVEL PROPERTY STRINGS ERR WRN INF DBG)
 
-if(ENABLE_LOG_LOG)
-	add_definitions(-DLOG)
+if(NOT SYSTEM_LOG_LEVEL MATCHES "^(ERR|WRN|INF|DBG)$")
+	message(FATAL_ERROR "Invalid SYSTEM_LOG_LEVEL value ${SYSTEM_LOG_LEVEL} - use ERR, WRN, INF or DBG")
 endif()
 
-if(ENABLE_LOG_WARNING)
-	add_definitions(-DWARNING)
-endif()
-
-if(ENABLE_LOG_ERROR)
-	add_definitions(-DERROR)
-endif()
-
-if(ENABLE_LOG_DEBUG1)
-	add_definitions(-DDEBUG1)
-endif()
-
-if(ENABLE_LOG_DEBUG2)
-	add_definitions(-DDEBUG2)
-endif()
-
-if(ENABLE_LOG_DEBUG3)
-	add_definitions(-DDEBUG3)
-endif()
\ No newline at end of file
+add_compile_definitions(SYSTEM_LOG_LEVEL_MIN=SR_LL_${SYSTEM_LOG_LEVEL})
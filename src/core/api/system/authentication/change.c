@@ -12,85 +12,61 @@
  */
 #include "change.h"
 #include "core/common.h"
+#include "core/fs_batch.h"
+#include "core/journal.h"
+#include "core/log.h"
 #include "libyang/tree_data.h"
+#include "core/api/system/authentication/load.h"
+#include "core/api/system/authentication/password.h"
 #include "core/api/system/authentication/store.h"
+#include "core/api/system/authentication/txn.h"
+#include "core/backend.h"
 #include "core/data/system/authentication/authorized_key.h"
-#include "core/data/system/authentication/authorized_key/list.h"
 #include "core/data/system/authentication/local_user.h"
-#include "core/data/system/authentication/local_user/list.h"
+#include "core/data/system/authentication/local_user/change.h"
 #include "core/types.h"
-#include "umgmt/db.h"
-#include "umgmt/types.h"
-#include "umgmt/user.h"
 
-#include <assert.h>
 #include <linux/limits.h>
+#include <string.h>
 #include <sysrepo.h>
-#include <sysrepo/xpath.h>
 
-#include <unistd.h>
+#include <uthash.h>
 #include <utlist.h>
 
-static int system_authentication_change_user_extract_name(sr_session_ctx_t *session, const struct lyd_node *node, char *name_buffer, size_t buffer_size);
-static int system_authentication_change_user_authorized_key_extract_name(sr_session_ctx_t *session, const struct lyd_node *node, char *name_buffer, size_t buffer_size);
-static int delete_home_directory(const char *username);
+static const char *system_authentication_change_instance_name(const struct lyd_node *node, const char *list);
+static int system_authentication_change_user_key(system_local_user_change_t *user_change, const srpc_change_ctx_t *change_ctx, const char *node_name, const char *node_value);
+static int system_authentication_user_check_keys(const system_local_user_change_t *user_change);
 
-int system_authentication_user_apply_changes(system_ctx_t *ctx)
+int system_authentication_user_apply_changes(system_transaction_t *transaction)
 {
 	int error = 0;
-	um_db_t *user_db = NULL;
-	um_user_t *temp_user = NULL;
-	bool has_user_changes = false;
-	char file_path_buffer[PATH_MAX] = {0};
+	system_ctx_t *ctx = transaction->ctx;
+	system_authentication_txn_t txn = {0};
+	system_fs_batch_t batch = {0};
+	system_journal_t journal = {.fd = -1};
 
-	system_local_user_element_t *user_iter = NULL;
+	system_local_user_change_t *change_iter = NULL, *change_tmp = NULL;
 	system_authorized_key_element_t *key_iter = NULL;
 
-	SRPLG_LOG_INF(PLUGIN_NAME, "Created users:");
-	LL_FOREACH(ctx->temp_users.created, user_iter)
-	{
-		SRPLG_LOG_INF(PLUGIN_NAME, "\t %s : %s", user_iter->user.name, user_iter->user.password);
-	}
-
-	SRPLG_LOG_INF(PLUGIN_NAME, "(Non)modified users:");
-	LL_FOREACH(ctx->temp_users.modified, user_iter)
-	{
-		SRPLG_LOG_INF(PLUGIN_NAME, "\t %s : %s", user_iter->user.name, user_iter->user.password);
-	}
-
-	SRPLG_LOG_INF(PLUGIN_NAME, "Deleted users:");
-	LL_FOREACH(ctx->temp_users.deleted, user_iter)
-	{
-		SRPLG_LOG_INF(PLUGIN_NAME, "\t %s", user_iter->user.name);
-	}
-
-	SRPLG_LOG_INF(PLUGIN_NAME, "Created user keys:");
-	LL_FOREACH(ctx->temp_users.keys.created, user_iter)
-	{
-		SRPLG_LOG_INF(PLUGIN_NAME, "\tKeys for user %s:", user_iter->user.name);
-		LL_FOREACH(user_iter->user.key_head, key_iter)
+	// the records are only walked when their contents are logged
+	if (SYSTEM_LOG_ENABLED(SR_LL_DBG)) {
+		HASH_ITER(hh, transaction->user_changes, change_iter, change_tmp)
 		{
-			SRPLG_LOG_INF(PLUGIN_NAME, "\t\t %s : %s : %s", key_iter->key.name, key_iter->key.algorithm, key_iter->key.data);
-		}
-	}
-
-	SRPLG_LOG_INF(PLUGIN_NAME, "Modified user keys:");
-	LL_FOREACH(ctx->temp_users.keys.modified, user_iter)
-	{
-		SRPLG_LOG_INF(PLUGIN_NAME, "\tKeys for user %s:", user_iter->user.name);
-		LL_FOREACH(user_iter->user.key_head, key_iter)
-		{
-			SRPLG_LOG_INF(PLUGIN_NAME, "\t\t %s : %s : %s", key_iter->key.name, key_iter->key.algorithm, key_iter->key.data);
-		}
-	}
+			SYSTEM_LOG_DBG("User %s:%s%s%s password = %s", change_iter->user.name, change_iter->created ? " created" : "", change_iter->deleted ? " deleted" : "", change_iter->password_changed ? " password changed" : "", SYSTEM_LOG_SECRET(change_iter->user.password));
 
-	SRPLG_LOG_INF(PLUGIN_NAME, "Deleted user keys:");
-	LL_FOREACH(ctx->temp_users.keys.deleted, user_iter)
-	{
-		SRPLG_LOG_INF(PLUGIN_NAME, "\tKeys for user %s:", user_iter->user.name);
-		LL_FOREACH(user_iter->user.key_head, key_iter)
-		{
-			SRPLG_LOG_INF(PLUGIN_NAME, "\t\t %s : %s : %s", key_iter->key.name, key_iter->key.algorithm, key_iter->key.data);
+			// key data is long and adds nothing to the key name
+			LL_FOREACH(change_iter->keys_created, key_iter)
+			{
+				SYSTEM_LOG_DBG("\tcreated key %s : %s", key_iter->key.name, key_iter->key.algorithm);
+			}
+			LL_FOREACH(change_iter->keys_modified, key_iter)
+			{
+				SYSTEM_LOG_DBG("\tmodified key %s : %s", key_iter->key.name, key_iter->key.algorithm ? key_iter->key.algorithm : "(unchanged)");
+			}
+			LL_FOREACH(change_iter->keys_deleted, key_iter)
+			{
+				SYSTEM_LOG_DBG("\tdeleted key %s", key_iter->key.name);
+			}
 		}
 	}
 
@@ -98,669 +74,315 @@ int system_authentication_user_apply_changes(system_ctx_t *ctx)
 
 #ifdef APPLY_CHANGES
 
-	// for created users - use store API
-	error = system_authentication_store_user(ctx, ctx->temp_users.created);
-	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_store_user() error (%d)", error);
-		goto error_out;
-	}
-
-	user_db = um_db_new();
-
-	error = um_db_load(user_db);
-	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "um_db_load() error (%d)", error);
-		goto error_out;
-	}
-
-	if (ctx->temp_users.modified || ctx->temp_users.deleted) {
-		has_user_changes = true;
-	}
-
-	// for modified users - iterate and change passwords
-	LL_FOREACH(ctx->temp_users.modified, user_iter)
+	// build the keys of every user whose keys changed and reject keys whose data does not match the configured
+	// algorithm before anything is written - all keys of a user are rendered into one authorized_keys file
+	HASH_ITER(hh, transaction->user_changes, change_iter, change_tmp)
 	{
-		// get user
-		temp_user = um_db_get_user(user_db, user_iter->user.name);
-		if (!temp_user) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to find user %s in the user database", user_iter->user.name);
-			goto error_out;
+		if (change_iter->deleted || !system_local_user_change_has_keys(change_iter)) {
+			continue;
 		}
 
-		// if the password has changed - store new value
-		if ((user_iter->user.password == NULL && um_user_get_password_hash(temp_user) != NULL) || strcmp(user_iter->user.password, um_user_get_password_hash(temp_user))) {
-			SRPLG_LOG_INF(PLUGIN_NAME, "Password changed for %s: %s --> %s", user_iter->user.name, um_user_get_password_hash(temp_user), user_iter->user.password);
-			error = um_user_set_password_hash(temp_user, user_iter->user.password);
+		// a user created by this change has no keys yet
+		if (!change_iter->created) {
+			error = system_authentication_load_user_authorized_key(ctx, change_iter->user.name, NULL, &change_iter->user.key_head);
 			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "um_user_set_password_hash() error (%d)", error);
+				SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_load_user_authorized_key() error (%d) for user %s", error, change_iter->user.name);
 				goto error_out;
 			}
 		}
-	}
-
-	// for deleted users - delete recursively home directory and remove user from the database
-	LL_FOREACH(ctx->temp_users.deleted, user_iter)
-	{
-		// 1. remove home directory of the user
-		error = delete_home_directory(user_iter->user.name);
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "delete_home_directory() error (%d)", error);
-			goto error_out;
-		}
 
-		// 2. remove user and user group from the database
-		error = um_db_delete_user(user_db, user_iter->user.name);
+		error = system_local_user_change_merge_keys(change_iter);
 		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "um_db_delete_user() error (%d) for user %s", error, user_iter->user.name);
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_change_merge_keys() error (%d) for user %s", error, change_iter->user.name);
 			goto error_out;
 		}
-		error = um_db_delete_group(user_db, user_iter->user.name);
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "um_db_delete_group() error (%d) for user %s", error, user_iter->user.name);
-			goto error_out;
-		}
-	}
-
-	if (has_user_changes) {
-		error = um_db_store(user_db);
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "um_db_store() error (%d)", error);
-			goto error_out;
-		}
-	}
 
-	LL_FOREACH(ctx->temp_users.keys.created, user_iter)
-	{
-		error = system_authentication_store_user_authorized_key(ctx, user_iter->user.name, user_iter->user.key_head);
+		error = system_authentication_user_check_keys(change_iter);
 		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_store_user_authorized_key() error (%d) for user %s", error, user_iter->user.name);
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_user_check_keys() error (%d)", error);
 			goto error_out;
 		}
 	}
 
-	LL_FOREACH(ctx->temp_users.keys.modified, user_iter)
-	{
-		error = system_authentication_store_user_authorized_key(ctx, user_iter->user.name, user_iter->user.key_head);
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_store_user_authorized_key() error (%d) for user %s", error, user_iter->user.name);
-			goto error_out;
-		}
+	// collect all account changes in one transaction - the account database is written only once
+	error = SYSTEM_ACCOUNTS_BACKEND_CALL(begin, &txn);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_txn_begin() error (%d)", error);
+		goto error_out;
 	}
 
-	LL_FOREACH(ctx->temp_users.keys.deleted, user_iter)
+	HASH_ITER(hh, transaction->user_changes, change_iter, change_tmp)
 	{
-		LL_FOREACH(user_iter->user.key_head, key_iter)
-		{
-			if (snprintf(file_path_buffer, sizeof(file_path_buffer), "/home/%s/.ssh/%s", user_iter->user.name, key_iter->key.name) < 0) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error");
-				goto error_out;
-			}
-
-			// file path written - remove file
-			error = remove(file_path_buffer);
-			if (error != 0) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "remove() failed (%d)", error);
+		if (change_iter->deleted) {
+			// remove user from the database; home directory is removed after commit
+			error = SYSTEM_ACCOUNTS_BACKEND_CALL(delete_user, &txn, change_iter->user.name);
+			if (error) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_txn_delete_user() error (%d) for user %s", error, change_iter->user.name);
 				goto error_out;
 			}
-		}
-	}
-#else
-	goto error_out;
-#endif
-
-	goto out;
-
-error_out:
-	error = -1;
-
-out:
-	if (user_db) {
-		um_db_free(user_db);
-	}
-
-	return error;
-}
-
-int system_authentication_change_user_name(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx)
-{
-	int error = 0;
-	system_ctx_t *ctx = priv;
-	const char *node_name = LYD_NAME(change_ctx->node);
-	const char *node_value = lyd_get_value(change_ctx->node);
-	system_local_user_t user = {0};
-
-	assert(strcmp(node_name, "name") == 0);
-
-	SRPLG_LOG_INF(PLUGIN_NAME, "Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
-
-	system_local_user_init(&user);
-
-	switch (change_ctx->operation) {
-		case SR_OP_CREATED:
-			// create new user and add it to the created list
-			user.name = (char *) node_value;
-
-			error = system_local_user_list_add(&ctx->temp_users.created, user);
+		} else if (change_iter->created) {
+			// add user and user group
+			error = SYSTEM_ACCOUNTS_BACKEND_CALL(add_user, &txn, change_iter->user.name, change_iter->user.password);
 			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_list_add() error (%d)", error);
+				SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_txn_add_user() error (%d) for user %s", error, change_iter->user.name);
 				goto error_out;
 			}
-
-			break;
-		case SR_OP_MODIFIED:
-			// can't modify name
-			break;
-		case SR_OP_DELETED:
-			user.name = (char *) node_value;
-
-			error = system_local_user_list_add(&ctx->temp_users.deleted, user);
+		} else if (change_iter->password_changed) {
+			error = SYSTEM_ACCOUNTS_BACKEND_CALL(set_password, &txn, change_iter->user.name, change_iter->user.password);
 			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_list_add() error (%d)", error);
+				SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_txn_set_password() error (%d) for user %s", error, change_iter->user.name);
 				goto error_out;
 			}
-			break;
-		case SR_OP_MOVED:
-			break;
+		}
 	}
 
-	goto out;
-
-error_out:
-	error = -1;
-
-out:
-	return error;
-}
-
-int system_authentication_change_user_password(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx)
-{
-	int error = 0;
-	system_ctx_t *ctx = priv;
-	const char *node_name = LYD_NAME(change_ctx->node);
-	const char *node_value = lyd_get_value(change_ctx->node);
-	char username_buffer[33] = {0};
-	system_local_user_element_t *found_user = NULL;
-
-	assert(strcmp(node_name, "password") == 0);
-
-	SRPLG_LOG_INF(PLUGIN_NAME, "Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
-
-	// get username
-	error = system_authentication_change_user_extract_name(session, change_ctx->node, username_buffer, sizeof(username_buffer));
+	error = SYSTEM_ACCOUNTS_BACKEND_CALL(commit, &txn);
 	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_change_user_extract_name() error (%d)", error);
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_txn_commit() error (%d)", error);
 		goto error_out;
 	}
 
-	SRPLG_LOG_INF(PLUGIN_NAME, "Recieved user name: %s", username_buffer);
-
-	// got the username - able to continue with operation
-	switch (change_ctx->operation) {
-		case SR_OP_CREATED:
-			// find user and add password
-			found_user = system_local_user_list_find(ctx->temp_users.created, username_buffer);
-			if (!found_user) {
-				// user was not created but now the password is - modified user
-				found_user = system_local_user_list_find(ctx->temp_users.modified, username_buffer);
-				if (found_user) {
-					error = system_local_user_set_password(&found_user->user, node_value);
-					if (error) {
-						SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_set_password() error (%d)", error);
-						goto error_out;
-					}
-				} else {
-					SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_list_find() failed for user %s", username_buffer);
-					goto error_out;
-				}
-			} else {
-				// user found - set password
-				error = system_local_user_set_password(&found_user->user, node_value);
-				if (error) {
-					SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_set_password() error (%d)", error);
-					goto error_out;
-				}
-			}
-
-			break;
-		case SR_OP_MODIFIED:
-			// add user with the username and add the password to the modified list
-			found_user = system_local_user_list_find(ctx->temp_users.modified, username_buffer);
-			if (found_user) {
-				error = system_local_user_set_password(&found_user->user, node_value);
-				if (error) {
-					SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_set_password() error (%d)", error);
-					goto error_out;
-				}
-			} else {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_list_find() failed for user %s", username_buffer);
+	HASH_ITER(hh, transaction->user_changes, change_iter, change_tmp)
+	{
+		if (change_iter->deleted) {
+			// deleted users - their keys index is not valid anymore
+			error = system_authentication_store_user_authorized_key_remove_index(ctx, change_iter->user.name);
+			if (error) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_store_user_authorized_key_remove_index() error (%d) for user %s", error, change_iter->user.name);
 				goto error_out;
 			}
-			break;
-		case SR_OP_DELETED:
-			found_user = system_local_user_list_find(ctx->temp_users.deleted, username_buffer);
-			if (!found_user) {
-				// if user not deleted remove his password - modified user
-				found_user = system_local_user_list_find(ctx->temp_users.modified, username_buffer);
-				if (found_user) {
-					error = system_local_user_set_password(&found_user->user, NULL);
-					if (error) {
-						SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_set_password() error (%d)", error);
-						goto error_out;
-					}
-				} else {
-					SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_list_find() failed for user %s", username_buffer);
-					goto error_out;
-				}
+		} else if (system_local_user_change_has_keys(change_iter)) {
+			// unchanged files are not rewritten
+			error = system_authentication_store_user_authorized_key_queue(ctx, &batch, change_iter->user.name, change_iter->user.key_head);
+			if (error) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_store_user_authorized_key_queue() error (%d) for user %s", error, change_iter->user.name);
+				goto error_out;
 			}
-			break;
-		case SR_OP_MOVED:
-			break;
-	}
-
-	goto out;
-
-error_out:
-	error = -1;
-
-out:
-	return error;
-}
-
-static int system_authentication_change_user_extract_name(sr_session_ctx_t *session, const struct lyd_node *node, char *name_buffer, size_t buffer_size)
-{
-	int error = 0;
-
-	const char *name = NULL;
-
-	sr_xpath_ctx_t xpath_ctx = {0};
-	char path_buffer[PATH_MAX] = {0};
-
-	// get node full path
-	error = (lyd_path(node, LYD_PATH_STD, path_buffer, sizeof(path_buffer)) == NULL);
-	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "lyd_path() failed");
-		goto error_out;
+		}
 	}
 
-	// extract key
-	name = sr_xpath_key_value(path_buffer, "user", "name", &xpath_ctx);
-	if (!name) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_xpath_key_value() failed");
-		goto error_out;
-	}
+	// the key files of all users are written together - the accounts exist already, so the batch is committed at once
+	if (batch.count) {
+		error = system_journal_begin(&journal, &batch, true);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_journal_begin() error (%d)", error);
+			goto error_out;
+		}
 
-	// store to buffer
-	error = snprintf(name_buffer, buffer_size, "%s", name);
-	if (error < 0) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() failed");
-		goto error_out;
+		error = system_fs_batch_run(&batch);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_fs_batch_run() error (%d)", error);
+			goto error_out;
+		}
 	}
+#else
+	goto error_out;
+#endif
 
-	error = 0;
 	goto out;
 
 error_out:
 	error = -1;
 
 out:
+	system_journal_end(&journal);
+	system_fs_batch_free(&batch);
+	SYSTEM_ACCOUNTS_BACKEND_CALL(free, &txn);
+
 	return error;
 }
 
-static int system_authentication_change_user_authorized_key_extract_name(sr_session_ctx_t *session, const struct lyd_node *node, char *name_buffer, size_t buffer_size)
+int system_authentication_change_user(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx)
 {
 	int error = 0;
+	system_transaction_t *transaction = priv;
+	const struct lyd_node *parent = lyd_parent(change_ctx->node);
+	const char *node_name = LYD_NAME(change_ctx->node);
+	const char *node_value = NULL;
+	const char *username = NULL;
+	system_local_user_change_t *user_change = NULL;
 
-	const char *name = NULL;
-
-	sr_xpath_ctx_t xpath_ctx = {0};
-	char path_buffer[PATH_MAX] = {0};
-
-	// get node full path
-	error = (lyd_path(node, LYD_PATH_STD, path_buffer, sizeof(path_buffer)) == NULL);
-	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "lyd_path() failed");
-		goto error_out;
+	// list instances are reported together with their key leaves - only leaves carry values
+	if (!parent || !(change_ctx->node->schema->nodetype & LYS_LEAF)) {
+		return 0;
 	}
 
-	// extract key
-	name = sr_xpath_key_value(path_buffer, "authorized-key", "name", &xpath_ctx);
-	if (!name) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_xpath_key_value() failed");
-		goto error_out;
-	}
+	node_value = lyd_get_value(change_ctx->node);
 
-	// store to buffer
-	error = snprintf(name_buffer, buffer_size, "%s", name);
-	if (error < 0) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() failed");
-		goto error_out;
+	if (!strcmp(node_name, "password")) {
+		SYSTEM_LOG_DBG("Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, SYSTEM_LOG_SECRET(change_ctx->previous_value), SYSTEM_LOG_SECRET(node_value), change_ctx->operation);
+	} else {
+		SYSTEM_LOG_DBG("Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
 	}
 
-	error = 0;
-	goto out;
-
-error_out:
-	error = -1;
-
-out:
-	return error;
-}
-
-static int delete_home_directory(const char *username)
-{
-	int error = 0;
-	char home_buffer[PATH_MAX] = {0};
-	char command_buffer[PATH_MAX + 100] = {0};
-
-	error = snprintf(home_buffer, sizeof(home_buffer), "/home/%s", username);
-	if (error < 0) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error (%d)", error);
+	// the owner is the user list instance above the node - its key is the first child
+	username = system_authentication_change_instance_name(change_ctx->node, "user");
+	if (!username) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to find the user of node %s", node_name);
 		goto error_out;
 	}
 
-	error = snprintf(command_buffer, sizeof(command_buffer), "rm -r %s", home_buffer);
-	if (error < 0) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error (%d)", error);
+	user_change = system_local_user_change_get(&transaction->user_changes, username);
+	if (!user_change) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_change_get() failed for user %s", username);
 		goto error_out;
 	}
 
-	// rm -r should return 0
-	error = system(command_buffer);
-	if (error != 0) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "system() failed for command \"%s\"", command_buffer);
-		goto error_out;
+	if (!strcmp(LYD_NAME(parent), "authorized-key")) {
+		error = system_authentication_change_user_key(user_change, change_ctx, node_name, node_value);
+		if (error) {
+			goto error_out;
+		}
+	} else if (!strcmp(node_name, "name")) {
+		switch (change_ctx->operation) {
+			case SR_OP_CREATED:
+				user_change->created = true;
+				break;
+			case SR_OP_DELETED:
+				user_change->deleted = true;
+				break;
+			case SR_OP_MODIFIED:
+				// can't modify name
+			case SR_OP_MOVED:
+				break;
+		}
+	} else if (!strcmp(node_name, "password")) {
+		switch (change_ctx->operation) {
+			case SR_OP_CREATED:
+			case SR_OP_MODIFIED:
+				user_change->password_changed = true;
+				error = system_local_user_set_password(&user_change->user, node_value);
+				break;
+			case SR_OP_DELETED:
+				// ignored if the user is deleted as well
+				user_change->password_changed = true;
+				error = system_local_user_set_password(&user_change->user, NULL);
+				break;
+			case SR_OP_MOVED:
+				break;
+		}
+
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_set_password() error (%d)", error);
+			goto error_out;
+		}
 	}
 
-	error = 0;
 	goto out;
 
 error_out:
 	error = -1;
 
 out:
-
 	return error;
 }
 
-int system_authentication_user_change_authorized_key_name(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx)
+int system_authentication_change_user_password_cleartext(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx)
 {
-	int error = 0;
-	system_ctx_t *ctx = priv;
-	const char *node_name = LYD_NAME(change_ctx->node);
+	system_password_batch_t *batch = priv;
 	const char *node_value = lyd_get_value(change_ctx->node);
-	char username_buffer[33] = {0};
-	system_local_user_element_t *user_el = NULL;
-	system_local_user_t temp_user = {0};
-	system_authorized_key_t temp_key = {0};
-
-	assert(strcmp(node_name, "name") == 0);
-
-	SRPLG_LOG_INF(PLUGIN_NAME, "Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
+	char path_buffer[PATH_MAX] = {0};
 
-	// get username
-	error = system_authentication_change_user_extract_name(session, change_ctx->node, username_buffer, sizeof(username_buffer));
-	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_change_user_extract_name() error (%d)", error);
-		goto error_out;
+	if (change_ctx->operation != SR_OP_CREATED && change_ctx->operation != SR_OP_MODIFIED) {
+		return 0;
 	}
 
-	SRPLG_LOG_INF(PLUGIN_NAME, "Recieved user name: %s", username_buffer);
-
-	// setup data
-	temp_user.name = username_buffer;
-	temp_key.name = (char *) node_value;
-
-	switch (change_ctx->operation) {
-		case SR_OP_CREATED:
-			// check for user in the list
-			user_el = system_local_user_list_find(ctx->temp_users.keys.created, username_buffer);
-			if (!user_el) {
-				// user does not exist - create one
-
-				// add user to the list
-				error = system_local_user_list_add(&ctx->temp_users.keys.created, temp_user);
-				if (error) {
-					SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_list_add() error (%d)", error);
-					goto error_out;
-				}
-
-				// get user element
-				user_el = system_local_user_list_find(ctx->temp_users.keys.created, username_buffer);
-				if (!user_el) {
-					SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_list_find() failed");
-					goto error_out;
-				}
-			}
-
-			// add new key to the user keys list
-			error = system_authorized_key_list_add(&user_el->user.key_head, temp_key);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "system_authorized_key_list_add() error (%d)", error);
-				goto error_out;
-			}
-			break;
-		case SR_OP_MODIFIED:
-			// check for user in the list
-			user_el = system_local_user_list_find(ctx->temp_users.keys.modified, username_buffer);
-			if (!user_el) {
-				// user does not exist - create one
-
-				// add user to the list
-				error = system_local_user_list_add(&ctx->temp_users.keys.modified, temp_user);
-				if (error) {
-					SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_list_add() error (%d)", error);
-					goto error_out;
-				}
-
-				// get user element
-				user_el = system_local_user_list_find(ctx->temp_users.keys.modified, username_buffer);
-				if (!user_el) {
-					SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_list_find() failed");
-					goto error_out;
-				}
-			}
-
-			// add new key to the user keys list
-			error = system_authorized_key_list_add(&user_el->user.key_head, temp_key);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "system_authorized_key_list_add() error (%d)", error);
-				goto error_out;
-			}
-			break;
-		case SR_OP_DELETED:
-			// check for user in the list
-			user_el = system_local_user_list_find(ctx->temp_users.keys.deleted, username_buffer);
-			if (!user_el) {
-				// user does not exist - create one
-
-				// add user to the list
-				error = system_local_user_list_add(&ctx->temp_users.keys.deleted, temp_user);
-				if (error) {
-					SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_list_add() error (%d)", error);
-					goto error_out;
-				}
-
-				// get user element
-				user_el = system_local_user_list_find(ctx->temp_users.keys.deleted, username_buffer);
-				if (!user_el) {
-					SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_list_find() failed");
-					goto error_out;
-				}
-			}
-
-			// add new key to the user keys list
-			error = system_authorized_key_list_add(&user_el->user.key_head, temp_key);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "system_authorized_key_list_add() error (%d)", error);
-				goto error_out;
-			}
-			break;
-		case SR_OP_MOVED:
-			break;
+	// values which already are hashes are stored as they are
+	if (!system_authentication_password_is_cleartext(node_value)) {
+		return 0;
 	}
 
-	goto out;
-
-error_out:
-	error = -1;
-
-out:
+	if (!lyd_path(change_ctx->node, LYD_PATH_STD, path_buffer, sizeof(path_buffer))) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "lyd_path() failed");
+		return -1;
+	}
 
-	return error;
+	return system_authentication_password_batch_add(batch, path_buffer, node_value + sizeof(SYSTEM_AUTHENTICATION_PASSWORD_CLEARTEXT_PREFIX) - 1);
 }
 
-int system_authentication_user_change_authorized_key_algorithm(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx)
+static const char *system_authentication_change_instance_name(const struct lyd_node *node, const char *list)
 {
-	int error = 0;
-	system_ctx_t *ctx = priv;
-	const char *node_name = LYD_NAME(change_ctx->node);
-	const char *node_value = lyd_get_value(change_ctx->node);
-
-	char username_buffer[33] = {0};
-	char key_buffer[PATH_MAX] = {0};
-
-	system_local_user_element_t *user_el = NULL;
-	system_authorized_key_element_t *key_el = NULL;
-	system_local_user_element_t **users_list = NULL;
-
-	assert(strcmp(node_name, "algorithm") == 0);
-
-	SRPLG_LOG_INF(PLUGIN_NAME, "Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
-
-	// get username
-	error = system_authentication_change_user_extract_name(session, change_ctx->node, username_buffer, sizeof(username_buffer));
-	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_change_user_extract_name() error (%d)", error);
-		goto error_out;
-	}
-
-	// get key name
-	error = system_authentication_change_user_authorized_key_extract_name(session, change_ctx->node, key_buffer, sizeof(key_buffer));
-	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_change_user_authorized_key_extract_name() error (%d)", error);
-		goto error_out;
-	}
-
-	SRPLG_LOG_INF(PLUGIN_NAME, "Recieved user name: %s", username_buffer);
-
-	switch (change_ctx->operation) {
-		case SR_OP_CREATED:
-			users_list = &ctx->temp_users.keys.created;
-			break;
-		case SR_OP_MODIFIED:
-			users_list = &ctx->temp_users.keys.modified;
-			break;
-		case SR_OP_DELETED:
-			// if deleted, information not needed
-			goto out;
-			break;
-		case SR_OP_MOVED:
-			break;
-	}
+	const struct lyd_node *key = NULL;
 
-	user_el = system_local_user_list_find(*users_list, username_buffer);
-	if (!user_el) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_list_find() failed");
-		goto error_out;
+	while (node && strcmp(LYD_NAME(node), list)) {
+		node = lyd_parent(node);
 	}
 
-	key_el = system_authorized_key_list_find(user_el->user.key_head, key_buffer);
-	if (!key_el) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authorized_key_list_find() failed");
-		goto error_out;
+	if (!node) {
+		return NULL;
 	}
 
-	// set algorithm
-	error = system_authorized_key_set_algorithm(&key_el->key, node_value);
-	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authorized_key_set_algorithm() error (%d)", error);
-		goto error_out;
+	// list keys always come first in an instance
+	key = lyd_child(node);
+	if (!key || strcmp(LYD_NAME(key), "name")) {
+		return NULL;
 	}
 
-	goto out;
-
-error_out:
-	error = -1;
-
-out:
-
-	return error;
+	return lyd_get_value(key);
 }
 
-int system_authentication_user_change_authorized_key_key_data(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx)
+static int system_authentication_change_user_key(system_local_user_change_t *user_change, const srpc_change_ctx_t *change_ctx, const char *node_name, const char *node_value)
 {
 	int error = 0;
-	system_ctx_t *ctx = priv;
-	const char *node_name = LYD_NAME(change_ctx->node);
-	const char *node_value = lyd_get_value(change_ctx->node);
-
-	char username_buffer[33] = {0};
-	char key_buffer[PATH_MAX] = {0};
-
-	system_local_user_element_t *user_el = NULL;
+	const char *key_name = system_authentication_change_instance_name(change_ctx->node, "authorized-key");
 	system_authorized_key_element_t *key_el = NULL;
-	system_local_user_element_t **users_list = NULL;
-
-	assert(strcmp(node_name, "key-data") == 0);
-
-	SRPLG_LOG_INF(PLUGIN_NAME, "Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
-
-	// get username
-	error = system_authentication_change_user_extract_name(session, change_ctx->node, username_buffer, sizeof(username_buffer));
-	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_change_user_extract_name() error (%d)", error);
-		goto error_out;
-	}
 
-	// get key name
-	error = system_authentication_change_user_authorized_key_extract_name(session, change_ctx->node, key_buffer, sizeof(key_buffer));
-	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_change_user_authorized_key_extract_name() error (%d)", error);
-		goto error_out;
+	if (!key_name) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to find the authorized key of node %s", node_name);
+		return -1;
 	}
 
-	SRPLG_LOG_INF(PLUGIN_NAME, "Recieved user name: %s", username_buffer);
-
 	switch (change_ctx->operation) {
 		case SR_OP_CREATED:
-			users_list = &ctx->temp_users.keys.created;
+			key_el = system_local_user_change_get_key(&user_change->keys_created, key_name);
 			break;
 		case SR_OP_MODIFIED:
-			users_list = &ctx->temp_users.keys.modified;
+			key_el = system_local_user_change_get_key(&user_change->keys_modified, key_name);
 			break;
 		case SR_OP_DELETED:
-			// if deleted, information not needed
-			goto out;
-			break;
+			// the whole key is removed once its name is - other deleted leaves carry no information
+			if (!strcmp(node_name, "name") && !system_local_user_change_get_key(&user_change->keys_deleted, key_name)) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_change_get_key() failed for key %s", key_name);
+				return -1;
+			}
+			return 0;
 		case SR_OP_MOVED:
-			break;
-	}
-
-	user_el = system_local_user_list_find(*users_list, username_buffer);
-	if (!user_el) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_list_find() failed");
-		goto error_out;
+			return 0;
 	}
 
-	key_el = system_authorized_key_list_find(user_el->user.key_head, key_buffer);
 	if (!key_el) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authorized_key_list_find() failed");
-		goto error_out;
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_change_get_key() failed for key %s", key_name);
+		return -1;
 	}
 
-	// set key-data
-	error = system_authorized_key_set_data(&key_el->key, node_value);
-	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authorized_key_set_data() error (%d)", error);
-		goto error_out;
+	if (!strcmp(node_name, "algorithm")) {
+		error = system_authorized_key_set_algorithm(&key_el->key, node_value);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_authorized_key_set_algorithm() error (%d)", error);
+			return -1;
+		}
+	} else if (!strcmp(node_name, "key-data")) {
+		error = system_authorized_key_set_data(&key_el->key, node_value);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_authorized_key_set_data() error (%d)", error);
+			return -1;
+		}
 	}
 
-	goto out;
+	return 0;
+}
 
-error_out:
-	error = -1;
+static int system_authentication_user_check_keys(const system_local_user_change_t *user_change)
+{
+	system_authorized_key_element_t *key_iter = NULL;
 
-out:
+	LL_FOREACH(user_change->user.key_head, key_iter)
+	{
+		if (system_authorized_key_check_algorithm(&key_iter->key)) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "Key %s of user %s: key-data does not contain a %s key", key_iter->key.name, user_change->user.name, key_iter->key.algorithm ? key_iter->key.algorithm : "(none)");
+			return -1;
+		}
+	}
 
-	return error;
-}
\ No newline at end of file
+	return 0;
+}
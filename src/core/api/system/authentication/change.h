@@ -18,12 +18,10 @@
 #include <srpc.h>
 
 // apply changes gathered in callback functions below
-int system_authentication_user_apply_changes(system_ctx_t *ctx);
+int system_authentication_user_apply_changes(system_transaction_t *transaction);
 
-int system_authentication_change_user_name(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx);
-int system_authentication_change_user_password(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx);
-int system_authentication_user_change_authorized_key_name(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx);
-int system_authentication_user_change_authorized_key_algorithm(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx);
-int system_authentication_user_change_authorized_key_key_data(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx);
+// one call per changed leaf of the user list - gathers the changes of each user into one record
+int system_authentication_change_user(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx);
+int system_authentication_change_user_password_cleartext(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx);
 
 #endif // SYSTEM_PLUGIN_API_AUTHENTICATION_CHANGE_H
\ No newline at end of file
@@ -13,6 +13,7 @@
 #include "check.h"
 #include "load.h"
 #include "core/common.h"
+#include "core/stats.h"
 #include "core/data/system/authentication/local_user/list.h"
 #include "core/data/system/authentication/authorized_key/list.h"
 
@@ -28,6 +29,8 @@ srpc_check_status_t system_authentication_check_user(system_ctx_t *ctx, system_l
 
 	system_local_user_element_t *user_el = NULL, *found_el = NULL;
 
+	SYSTEM_STATS_BEGIN(SYSTEM_STATS_OP_CHECK_AUTHENTICATION_USER);
+
 	error = system_authentication_load_user(ctx, system_head);
 	if (error) {
 		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_load_user() error (%d)", error);
@@ -64,6 +67,8 @@ error_out:
 
 out:
 
+	SYSTEM_STATS_END(status == srpc_check_status_error);
+
 	return status;
 }
 
@@ -76,7 +81,9 @@ srpc_check_status_t system_authentication_check_user_authorized_key(system_ctx_t
 
 	system_authorized_key_element_t *system_key_head = NULL, *key_el = NULL, *found_el = NULL;
 
-	error = system_authentication_load_user_authorized_key(ctx, user, &system_key_head);
+	SYSTEM_STATS_BEGIN(SYSTEM_STATS_OP_CHECK_AUTHORIZED_KEY);
+
+	error = system_authentication_load_user_authorized_key(ctx, user, NULL, &system_key_head);
 	if (error) {
 		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_load_user_authorized_key() error (%d)", error);
 		goto error_out;
@@ -90,7 +97,8 @@ srpc_check_status_t system_authentication_check_user_authorized_key(system_ctx_t
 	{
 		found_el = NULL;
 
-		LL_SEARCH(system_key_head, found_el, key_el, system_authorized_key_element_cmp_fn);
+		// same key material - names are only comments in authorized_keys
+		LL_SEARCH(system_key_head, found_el, key_el, system_authorized_key_element_fingerprint_cmp_fn);
 
 		if (found_el != NULL) {
 			contains_count++;
@@ -114,5 +122,7 @@ out:
 
 	system_authorized_key_list_free(&system_key_head);
 
+	SYSTEM_STATS_END(status == srpc_check_status_error);
+
 	return status;
 }
\ No newline at end of file
@@ -14,202 +14,479 @@
 #include "sysrepo.h"
 #include "core/types.h"
 #include "core/common.h"
+#include "core/log.h"
+#include "core/root.h"
+#include "core/backend.h"
+#include "core/stats.h"
 
 #include "core/data/system/authentication/authorized_key/list.h"
 #include "core/data/system/authentication/authorized_key.h"
-#include "core/data/system/authentication/local_user/list.h"
-#include "core/data/system/authentication/local_user.h"
-#include "umgmt/user.h"
 
 #include <unistd.h>
 #include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pwd.h>
+#include <sys/stat.h>
+#include <stdbool.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <linux/limits.h>
 
-#include <umgmt.h>
-
 #include <utlist.h>
 
-static int system_check_file_extension(const char *path, const char *ext);
+static int system_authentication_read_file(int fd, char **content, size_t *size);
+static int system_authentication_load_key_files(const char *user, int ssh_fd, system_authorized_key_element_t **head);
+static char *system_next_token(char **cursor);
+static bool system_is_key_algorithm(const char *token);
 
 int system_authentication_load_user(system_ctx_t *ctx, system_local_user_element_t **head)
 {
 	int error = 0;
 
-	system_local_user_t temp_user = {0};
-	um_db_t *db = NULL;
-	const um_user_element_t *user_head = NULL;
-	const um_user_element_t *user_iter = NULL;
+	SYSTEM_STATS_BEGIN(SYSTEM_STATS_OP_LOAD_AUTHENTICATION_USER);
+
+	error = SYSTEM_ACCOUNTS_BACKEND_CALL(load_users, head);
+
+	SYSTEM_STATS_END(error != 0);
+
+	return error;
+}
+
+int system_authentication_load_user_authorized_key(system_ctx_t *ctx, const char *user, const char *home, system_authorized_key_element_t **head)
+{
+	int error = 0;
+	char pw_buffer[4096] = {0};
+	char home_path_buffer[PATH_MAX] = {0};
+	struct passwd pw = {0};
+	int home_fd = -1;
+	int ssh_fd = -1;
+
+	SYSTEM_STATS_BEGIN(SYSTEM_STATS_OP_LOAD_AUTHORIZED_KEY);
+
+	// callers without a loaded user look the home directory up
+	if (!home) {
+		error = system_root_getpwnam(user, &pw, pw_buffer, sizeof(pw_buffer));
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "getpwnam_r() failed for user %s", user);
+			goto error_out;
+		}
+		home = pw.pw_dir;
+	}
 
-	db = um_db_new();
-	if (!db) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "um_db_new() failed");
+	if (system_root_path(home_path_buffer, sizeof(home_path_buffer), home)) {
 		goto error_out;
 	}
 
-	error = um_db_load(db);
-	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "um_db_load() error (%d)", error);
+	// open the file relative to the home directory and ~/.ssh - the user may have replaced either with a symlink
+	home_fd = open(home_path_buffer, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+	if (home_fd == -1) {
+		SYSTEM_LOG_INF("Home directory doesn't exist for user %s", user);
+		goto out;
+	}
+
+	ssh_fd = openat(home_fd, ".ssh", O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+	if (ssh_fd == -1) {
+		SYSTEM_LOG_INF("~/.ssh directory doesn't exist for user %s", user);
+		goto out;
+	}
+
+	error = system_authentication_load_authorized_keys_file(user, ssh_fd, head, NULL);
+	if (error == 1) {
+		// keys stored by earlier versions are in one file per key until the first store renders authorized_keys
+		SYSTEM_LOG_INF("~/.ssh/authorized_keys doesn't exist for user %s - looking for per-key files", user);
+		error = system_authentication_load_key_files(user, ssh_fd, head);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_load_key_files() error (%d) for user %s", error, user);
+			goto error_out;
+		}
+	} else if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_load_authorized_keys_file() error (%d) for user %s", error, user);
 		goto error_out;
 	}
 
-	user_head = um_db_get_user_list_head(db);
+	error = 0;
+	goto out;
 
-	LL_FOREACH(user_head, user_iter)
-	{
-		const um_user_t *user = user_iter->user;
+error_out:
+	error = -1;
 
-		if (um_user_get_uid(user) == 0 || (um_user_get_uid(user) >= 1000 && um_user_get_uid(user) < 65534)) {
-			SRPLG_LOG_INF(PLUGIN_NAME, "Found user %s [ UID = %d ]", um_user_get_name(user), um_user_get_uid(user));
+out:
+	if (ssh_fd != -1) {
+		close(ssh_fd);
+	}
 
-			// add new user
-			system_local_user_init(&temp_user);
+	if (home_fd != -1) {
+		close(home_fd);
+	}
 
-			temp_user.name = (char *) um_user_get_name(user);
-			if (um_user_get_password_hash(user) &&
-				strcmp(um_user_get_password_hash(user), "*") &&
-				strcmp(um_user_get_password_hash(user), "!")) {
-				temp_user.password = (char *) um_user_get_password_hash(user);
-			}
+	SYSTEM_STATS_END(error != 0);
 
-			error = system_local_user_list_add(head, temp_user);
-			if (error != 0) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_list_add() error (%d) for user %s", error, temp_user.name);
-				goto error_out;
-			}
+	return error;
+}
+
+int system_authentication_load_authorized_keys_file(const char *user, int ssh_fd, system_authorized_key_element_t **head, size_t *skipped)
+{
+	int error = 0;
+	int keys_fd = -1;
+	char *content = NULL;
+	size_t content_size = 0;
+
+	keys_fd = openat(ssh_fd, SYSTEM_AUTHENTICATION_AUTHORIZED_KEYS_FILE, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+	if (keys_fd == -1) {
+		if (errno == ENOENT) {
+			return 1;
 		}
+		SRPLG_LOG_ERR(PLUGIN_NAME, "openat() failed (%d) for ~/.ssh/authorized_keys of user %s", errno, user);
+		return -1;
+	}
+
+	error = system_authentication_read_file(keys_fd, &content, &content_size);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_read_file() failed for ~/.ssh/authorized_keys of user %s", user);
+		goto error_out;
 	}
 
+	error = system_authentication_parse_authorized_keys(user, content, content_size, head, skipped);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_parse_authorized_keys() error (%d) for user %s", error, user);
+		goto error_out;
+	}
+
+	error = 0;
 	goto out;
 
 error_out:
 	error = -1;
 
 out:
-	if (db) {
-		um_db_free(db);
-	}
+	free(content);
+	close(keys_fd);
 
 	return error;
 }
 
-int system_authentication_load_user_authorized_key(system_ctx_t *ctx, const char *user, system_authorized_key_element_t **head)
+static int system_authentication_load_key_files(const char *user, int ssh_fd, system_authorized_key_element_t **head)
 {
 	int error = 0;
-	char dir_buffer[PATH_MAX] = {0};
-	char path_buffer[PATH_MAX] = {0};
-	char algorithm_buffer[100] = {0};
-	char data_buffer[16384] = {0};
-	FILE *pub_file = NULL;
-
-	system_authorized_key_t temp_key = {0};
-
+	int dir_fd = -1;
+	int key_fd = -1;
 	DIR *dir = NULL;
 	struct dirent *dir_entry = NULL;
+	char *content = NULL;
+	size_t content_size = 0;
+	char *cursor = NULL;
+	char *algorithm = NULL;
+	char *data = NULL;
+	system_authorized_key_t temp_key = {0};
+
+	// the directory stream takes over its own descriptor
+	dir_fd = dup(ssh_fd);
+	if (dir_fd == -1 || !(dir = fdopendir(dir_fd))) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "fdopendir() failed (%d) for ~/.ssh of user %s", errno, user);
+		goto error_out;
+	}
+	dir_fd = -1;
 
-	if (!strncmp(user, "root", 4)) {
-		if (snprintf(dir_buffer, sizeof(dir_buffer), "/root/.ssh") < 0) {
+	// "<algorithm> <key-data>" in ~/.ssh/<name>.pub - the layout of earlier versions, named by the file
+	while ((dir_entry = readdir(dir)) != NULL) {
+		const size_t length = strlen(dir_entry->d_name);
+
+		if (length <= 4 || strcmp(dir_entry->d_name + length - 4, ".pub")) {
+			continue;
+		}
+
+		key_fd = openat(dirfd(dir), dir_entry->d_name, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+		if (key_fd == -1 || system_authentication_read_file(key_fd, &content, &content_size)) {
+			SYSTEM_LOG_INF("Skipping unreadable key file ~/.ssh/%s of user %s", dir_entry->d_name, user);
+			goto next;
+		}
+
+		cursor = content;
+		algorithm = system_next_token(&cursor);
+		data = algorithm ? system_next_token(&cursor) : NULL;
+		if (!data || !system_is_key_algorithm(algorithm)) {
+			SYSTEM_LOG_INF("Skipping key file ~/.ssh/%s of user %s - not a public key", dir_entry->d_name, user);
+			goto next;
+		}
+
+		system_authorized_key_init(&temp_key);
+
+		error = system_authorized_key_set_name(&temp_key, dir_entry->d_name);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_authorized_key_set_name() error (%d)", error);
 			goto error_out;
 		}
-	} else {
-		if (snprintf(dir_buffer, sizeof(dir_buffer), "/home/%s/.ssh", user) < 0) {
+
+		error = system_authorized_key_set_algorithm(&temp_key, algorithm);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_authorized_key_set_algorithm() error (%d)", error);
 			goto error_out;
 		}
+
+		if (system_authorized_key_set_data(&temp_key, data) || system_authorized_key_check_algorithm(&temp_key)) {
+			SYSTEM_LOG_INF("Skipping key file ~/.ssh/%s of user %s - malformed key", dir_entry->d_name, user);
+			system_authorized_key_free(&temp_key);
+			goto next;
+		}
+
+		error = system_authorized_key_list_add(head, temp_key);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_authorized_key_list_add() error (%d)", error);
+			goto error_out;
+		}
+
+		system_authorized_key_free(&temp_key);
+
+	next:
+		if (key_fd != -1) {
+			close(key_fd);
+			key_fd = -1;
+		}
+		free(content);
+		content = NULL;
 	}
 
-	// check dir for .ssh key files
-	if ((dir = opendir(dir_buffer)) == NULL) {
-		SRPLG_LOG_INF(PLUGIN_NAME, "~/.ssh directory doesn't exist for user %s", user);
-		goto out;
-	} else {
-		while ((dir_entry = readdir(dir)) != NULL) {
-			if (!system_check_file_extension(dir_entry->d_name, ".pub")) {
+	error = 0;
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	system_authorized_key_free(&temp_key);
+
+	free(content);
+
+	if (key_fd != -1) {
+		close(key_fd);
+	}
+
+	if (dir_fd != -1) {
+		close(dir_fd);
+	}
+
+	if (dir) {
+		closedir(dir);
+	}
+
+	return error;
+}
+
+static int system_authentication_read_file(int fd, char **content, size_t *size)
+{
+	struct stat st = {0};
+	size_t offset = 0;
+	char *buffer = NULL;
+
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+		return -1;
+	}
+
+	// whole file in one read - the buffer is tokenized in place afterwards
+	buffer = (char *) malloc((size_t) st.st_size + 1);
+	if (!buffer) {
+		return -1;
+	}
+
+	while (offset < (size_t) st.st_size) {
+		const ssize_t read_size = read(fd, buffer + offset, (size_t) st.st_size - offset);
+
+		if (read_size < 0 && errno == EINTR) {
+			continue;
+		}
+
+		if (read_size < 0) {
+			free(buffer);
+			return -1;
+		}
+
+		// file truncated while reading
+		if (read_size == 0) {
+			break;
+		}
+
+		offset += (size_t) read_size;
+	}
+
+	buffer[offset] = 0;
+
+	*content = buffer;
+	*size = offset;
+
+	return 0;
+}
+
+int system_authentication_parse_authorized_keys(const char *user, char *content, size_t size, system_authorized_key_element_t **head, size_t *skipped)
+{
+	int error = 0;
+	char name_buffer[32] = {0};
+	char *line = content;
+	char *const end = content + size;
+	size_t line_number = 0;
+	size_t content_lines = 0;
+	size_t key_lines = 0;
+	system_authorized_key_t temp_key = {0};
+
+	// one key per line - "[options] <algorithm> <key-data> [name]"
+	while (line < end) {
+		char *line_end = memchr(line, '\n', (size_t) (end - line));
+		char *cursor = line;
+		char *options = NULL;
+		char *algorithm = NULL;
+		char *data = NULL;
+		char *name = NULL;
+
+		if (!line_end) {
+			line_end = end;
+		}
+		*line_end = 0;
+		line_number++;
+
+		algorithm = system_next_token(&cursor);
+		if (!algorithm) {
+			line = line_end + 1;
+			continue;
+		}
+
+		content_lines++;
+
+		if (algorithm[0] == '#') {
+			line = line_end + 1;
+			continue;
+		}
+
+		// keys written by other tools may be prefixed with options - they are kept with the key
+		if (!system_is_key_algorithm(algorithm)) {
+			options = algorithm;
+			algorithm = system_next_token(&cursor);
+			if (!algorithm || !system_is_key_algorithm(algorithm)) {
+				SYSTEM_LOG_INF("Skipping unsupported line %zu in authorized_keys of user %s", line_number, user);
+				line = line_end + 1;
 				continue;
 			}
+		}
 
-			// found new key
-			system_authorized_key_init(&temp_key);
-			error = system_authorized_key_set_name(&temp_key, dir_entry->d_name);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "system_authorized_key_set_name() error (%d)", error);
-				goto error_out;
-			}
+		data = system_next_token(&cursor);
+		if (!data) {
+			SYSTEM_LOG_INF("Skipping line %zu without key data in authorized_keys of user %s", line_number, user);
+			line = line_end + 1;
+			continue;
+		}
 
-			// found .pub file - read data
-			error = snprintf(path_buffer, sizeof(path_buffer), "%s/%s", dir_buffer, dir_entry->d_name);
-			if (error < 0) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error (%d)", error);
-				goto error_out;
-			}
+		// the key name is stored as the key comment - the rest of the line; name keys without one by their line
+		while (*cursor == ' ' || *cursor == '\t') {
+			cursor++;
+		}
+		name = cursor;
+		for (char *trail = name + strlen(name); trail > name && (trail[-1] == '\r' || trail[-1] == ' ' || trail[-1] == '\t'); trail--) {
+			trail[-1] = 0;
+		}
+		if (!*name) {
+			snprintf(name_buffer, sizeof(name_buffer), "key-%zu", line_number);
+			name = name_buffer;
+		}
 
-			// open file
-			pub_file = fopen(path_buffer, "r");
-			if (!pub_file) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "fopen() error (%d)", error);
-				goto error_out;
-			}
+		line = line_end + 1;
 
-			// read algorithm and data
-			error = fscanf(pub_file, "%s %s", algorithm_buffer, data_buffer);
-			if (error != 2) {
-				// unable to read both parameters needed - error
-				SRPLG_LOG_ERR(PLUGIN_NAME, "fscanf() error (%d)", error);
-				goto error_out;
-			}
+		system_authorized_key_init(&temp_key);
 
-			// got both - setup key and add it to the array
-			error = system_authorized_key_set_algorithm(&temp_key, algorithm_buffer);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "system_authorized_key_set_algorithm() error (%d)", error);
-				goto error_out;
-			}
+		error = system_authorized_key_set_name(&temp_key, name);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_authorized_key_set_name() error (%d)", error);
+			goto error_out;
+		}
 
-			error = system_authorized_key_set_data(&temp_key, data_buffer);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "system_authorized_key_set_data() error (%d)", error);
-				goto error_out;
-			}
+		error = system_authorized_key_set_algorithm(&temp_key, algorithm);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_authorized_key_set_algorithm() error (%d)", error);
+			goto error_out;
+		}
 
-			// append to list
-			error = system_authorized_key_list_add(head, temp_key);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "system_authorized_key_list_add() error (%d)", error);
-				goto error_out;
-			}
+		error = system_authorized_key_set_options(&temp_key, options);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_authorized_key_set_options() error (%d)", error);
+			goto error_out;
+		}
 
-			// free current data
+		error = system_authorized_key_set_data(&temp_key, data);
+		if (error) {
+			// malformed keys are ignored by sshd as well
+			SYSTEM_LOG_INF("Skipping key with malformed data on line %zu in authorized_keys of user %s", line_number, user);
 			system_authorized_key_free(&temp_key);
+			continue;
+		}
 
-			// close current file
-			fclose(pub_file);
-			pub_file = NULL;
+		if (system_authorized_key_check_algorithm(&temp_key)) {
+			SYSTEM_LOG_INF("Skipping key with mismatched algorithm on line %zu in authorized_keys of user %s", line_number, user);
+			system_authorized_key_free(&temp_key);
+			continue;
 		}
+
+		// append to list
+		error = system_authorized_key_list_add(head, temp_key);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_authorized_key_list_add() error (%d)", error);
+			goto error_out;
+		}
+		key_lines++;
+
+		// free current data
+		system_authorized_key_free(&temp_key);
 	}
 
+	// comments and lines which are not valid keys can not be written back - the caller is told how many there were
+	if (skipped) {
+		*skipped = content_lines - key_lines;
+	}
+
+	error = 0;
 	goto out;
 
 error_out:
 	error = -1;
 
 out:
-	// close if interrupted
-	if (pub_file) {
-		fclose(pub_file);
-	}
-
 	// if interrurpted the key will have allocated data - free
 	system_authorized_key_free(&temp_key);
 
-	// close dir iterator
-	closedir(dir);
 	return error;
 }
 
-static int system_check_file_extension(const char *path, const char *ext)
+static char *system_next_token(char **cursor)
 {
-	const size_t path_len = strlen(path);
-	const size_t ext_len = strlen(ext);
+	char *token = *cursor;
+	char *iter = NULL;
+	bool quoted = false;
+
+	while (*token == ' ' || *token == '\t' || *token == '\r') {
+		token++;
+	}
+
+	if (!*token) {
+		*cursor = token;
+		return NULL;
+	}
 
-	return path_len > ext_len && strncmp(path + (path_len - ext_len), ext, ext_len) == 0;
-}
\ No newline at end of file
+	// whitespace inside quoted option values does not end the token
+	for (iter = token; *iter; iter++) {
+		if (*iter == '"') {
+			quoted = !quoted;
+		} else if (!quoted && (*iter == ' ' || *iter == '\t' || *iter == '\r')) {
+			break;
+		}
+	}
+
+	if (*iter) {
+		*iter++ = 0;
+	}
+	*cursor = iter;
+
+	return token;
+}
+
+static bool system_is_key_algorithm(const char *token)
+{
+	return !strncmp(token, "ssh-", 4) || !strncmp(token, "ecdsa-", 6) || !strncmp(token, "sk-", 3);
+}
@@ -17,6 +17,8 @@
 #include "core/types.h"
 
 int system_authentication_load_user(system_ctx_t *ctx, system_local_user_element_t **head);
-int system_authentication_load_user_authorized_key(system_ctx_t *ctx, const char *user, system_authorized_key_element_t **head);
+int system_authentication_load_user_authorized_key(system_ctx_t *ctx, const char *user, const char *home, system_authorized_key_element_t **head);
+int system_authentication_load_authorized_keys_file(const char *user, int ssh_fd, system_authorized_key_element_t **head, size_t *skipped);
+int system_authentication_parse_authorized_keys(const char *user, char *content, size_t size, system_authorized_key_element_t **head, size_t *skipped);
 
 #endif // SYSTEM_PLUGIN_API_AUTHENTICATION_LOAD_H
\ No newline at end of file
@@ -0,0 +1,231 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "password.h"
+#include "core/common.h"
+#include "core/log.h"
+
+#include <crypt.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/random.h>
+#include <unistd.h>
+
+#include <sysrepo.h>
+
+static int system_authentication_password_hash_r(const char *cleartext, char **hash, struct crypt_data *data);
+static int system_authentication_password_setting(char *buffer, size_t buffer_size);
+static size_t system_authentication_password_workers(size_t jobs);
+static void *system_authentication_password_worker(void *arg);
+
+bool system_authentication_password_is_cleartext(const char *value)
+{
+	return value && !strncmp(value, SYSTEM_AUTHENTICATION_PASSWORD_CLEARTEXT_PREFIX, sizeof(SYSTEM_AUTHENTICATION_PASSWORD_CLEARTEXT_PREFIX) - 1);
+}
+
+int system_authentication_password_hash(const char *cleartext, char **hash)
+{
+	int error = 0;
+	struct crypt_data *data = NULL;
+
+	// the crypt_r() state is too large for the stack of the subscription threads
+	data = calloc(1, sizeof(*data));
+	if (!data) {
+		return -1;
+	}
+
+	error = system_authentication_password_hash_r(cleartext, hash, data);
+
+	explicit_bzero(data, sizeof(*data));
+	free(data);
+
+	return error;
+}
+
+int system_authentication_password_batch_add(system_password_batch_t *batch, const char *xpath, const char *cleartext)
+{
+	system_password_job_t *jobs = NULL;
+	system_password_job_t *job = NULL;
+
+	if (batch->count == batch->capacity) {
+		const size_t capacity = batch->capacity ? batch->capacity * 2 : 8;
+
+		jobs = realloc(batch->jobs, capacity * sizeof(*jobs));
+		if (!jobs) {
+			return -1;
+		}
+
+		batch->jobs = jobs;
+		batch->capacity = capacity;
+	}
+
+	job = &batch->jobs[batch->count];
+	*job = (system_password_job_t){0};
+
+	job->xpath = strdup(xpath);
+	job->cleartext = strdup(cleartext);
+	if (!job->xpath || !job->cleartext) {
+		free(job->xpath);
+		free(job->cleartext);
+		return -1;
+	}
+
+	batch->count++;
+
+	return 0;
+}
+
+int system_authentication_password_batch_hash(system_password_batch_t *batch)
+{
+	int error = 0;
+	pthread_t threads[SYSTEM_AUTHENTICATION_PASSWORD_WORKERS_MAX] = {0};
+	const size_t workers = system_authentication_password_workers(batch->count);
+	size_t started = 0;
+
+	atomic_store(&batch->next, 0);
+
+	// the calling thread is one of the workers - the others only help when there is more than one job
+	for (started = 0; started + 1 < workers; started++) {
+		if (pthread_create(&threads[started], NULL, system_authentication_password_worker, batch)) {
+			SRPLG_LOG_WRN(PLUGIN_NAME, "Unable to start a password hashing thread - continuing with %zu", started + 1);
+			break;
+		}
+	}
+
+	system_authentication_password_worker(batch);
+
+	for (size_t i = 0; i < started; i++) {
+		pthread_join(threads[i], NULL);
+	}
+
+	for (size_t i = 0; i < batch->count; i++) {
+		if (batch->jobs[i].error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to hash the password of %s", batch->jobs[i].xpath);
+			error = -1;
+		}
+	}
+
+	SYSTEM_LOG_DBG("Hashed %zu passwords using %zu threads", batch->count, started + 1);
+
+	return error;
+}
+
+void system_authentication_password_batch_free(system_password_batch_t *batch)
+{
+	for (size_t i = 0; i < batch->count; i++) {
+		system_password_job_t *job = &batch->jobs[i];
+
+		explicit_bzero(job->cleartext, strlen(job->cleartext));
+		free(job->cleartext);
+		free(job->xpath);
+		free(job->hash);
+	}
+
+	free(batch->jobs);
+
+	batch->jobs = NULL;
+	batch->count = 0;
+	batch->capacity = 0;
+}
+
+static int system_authentication_password_hash_r(const char *cleartext, char **hash, struct crypt_data *data)
+{
+	char setting[sizeof(SYSTEM_AUTHENTICATION_PASSWORD_HASH_PREFIX) + SYSTEM_AUTHENTICATION_PASSWORD_SALT_LENGTH + 1] = {0};
+	const char *result = NULL;
+
+	if (system_authentication_password_setting(setting, sizeof(setting))) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to generate a password salt");
+		return -1;
+	}
+
+	// libxcrypt returns a string starting with '*' instead of NULL on failure
+	result = crypt_r(cleartext, setting, data);
+	if (!result || result[0] == '*') {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "crypt_r() failed for the SHA-512 method");
+		return -1;
+	}
+
+	*hash = strdup(result);
+	if (!*hash) {
+		return -1;
+	}
+
+	return 0;
+}
+
+static int system_authentication_password_setting(char *buffer, size_t buffer_size)
+{
+	static const char alphabet[] = "./0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+	const size_t prefix_length = sizeof(SYSTEM_AUTHENTICATION_PASSWORD_HASH_PREFIX) - 1;
+	uint8_t random[SYSTEM_AUTHENTICATION_PASSWORD_SALT_LENGTH] = {0};
+
+	if (buffer_size < prefix_length + sizeof(random) + 1) {
+		return -1;
+	}
+
+	if (getrandom(random, sizeof(random), 0) != (ssize_t) sizeof(random)) {
+		return -1;
+	}
+
+	memcpy(buffer, SYSTEM_AUTHENTICATION_PASSWORD_HASH_PREFIX, prefix_length);
+
+	// the alphabet has 64 characters - the low 6 bits of every byte pick one without bias
+	for (size_t i = 0; i < sizeof(random); i++) {
+		buffer[prefix_length + i] = alphabet[random[i] & 0x3f];
+	}
+
+	buffer[prefix_length + sizeof(random)] = 0;
+
+	return 0;
+}
+
+static size_t system_authentication_password_workers(size_t jobs)
+{
+	const char *env = getenv(SYSTEM_AUTHENTICATION_PASSWORD_WORKERS_ENV);
+	long workers = 0;
+
+	if (env && *env) {
+		workers = strtol(env, NULL, 10);
+	} else {
+		workers = sysconf(_SC_NPROCESSORS_ONLN);
+	}
+
+	if (workers < 1) {
+		workers = 1;
+	} else if (workers > SYSTEM_AUTHENTICATION_PASSWORD_WORKERS_MAX) {
+		workers = SYSTEM_AUTHENTICATION_PASSWORD_WORKERS_MAX;
+	}
+
+	return (size_t) workers < jobs ? (size_t) workers : (jobs ? jobs : 1);
+}
+
+static void *system_authentication_password_worker(void *arg)
+{
+	system_password_batch_t *batch = arg;
+	struct crypt_data *data = calloc(1, sizeof(*data));
+
+	for (size_t i = atomic_fetch_add(&batch->next, 1); i < batch->count; i = atomic_fetch_add(&batch->next, 1)) {
+		system_password_job_t *job = &batch->jobs[i];
+
+		job->error = data ? system_authentication_password_hash_r(job->cleartext, &job->hash, data) : -1;
+	}
+
+	if (data) {
+		explicit_bzero(data, sizeof(*data));
+		free(data);
+	}
+
+	return NULL;
+}
@@ -0,0 +1,32 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_API_AUTHENTICATION_PASSWORD_H
+#define SYSTEM_PLUGIN_API_AUTHENTICATION_PASSWORD_H
+
+#include "core/types.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Hashing of the cleartext passwords ("$0$<password>" crypt-hash values) into SHA-512-crypt with a random salt. A batch
+ * is spread over at most SYSTEM_AUTHENTICATION_PASSWORD_WORKERS_MAX threads, the calling thread being one of them.
+ */
+bool system_authentication_password_is_cleartext(const char *value);
+int system_authentication_password_hash(const char *cleartext, char **hash);
+
+int system_authentication_password_batch_add(system_password_batch_t *batch, const char *xpath, const char *cleartext);
+int system_authentication_password_batch_hash(system_password_batch_t *batch);
+void system_authentication_password_batch_free(system_password_batch_t *batch);
+
+#endif // SYSTEM_PLUGIN_API_AUTHENTICATION_PASSWORD_H
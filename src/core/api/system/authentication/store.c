@@ -12,435 +12,510 @@
  */
 #include "store.h"
 #include "core/common.h"
-#include "umgmt/group.h"
+#include "core/backend.h"
+#include "core/fs_batch.h"
+#include "core/log.h"
+#include "core/root.h"
+#include "core/stats.h"
+#include "load.h"
+#include "txn.h"
+#include "core/data/system/authentication/authorized_key.h"
+#include "core/data/system/authentication/authorized_key/list.h"
+#include "core/ssh/key_index.h"
 
 #include <asm-generic/errno-base.h>
 #include <linux/limits.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <sysrepo.h>
 #include <unistd.h>
 #include <utlist.h>
+#include <uthash.h>
 #include <dirent.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <pwd.h>
 #include <shadow.h>
 
 #include <srpc.h>
-#include <umgmt.h>
 
-static int system_authentication_user_create_home(const char *username, const uid_t uid, const gid_t gid);
-static int system_authentication_user_copy_skel(const char *username, const uid_t uid, const gid_t gid);
+typedef struct system_authentication_key_seen_s system_authentication_key_seen_t;
+
+struct system_authentication_key_seen_s {
+	const uint8_t *fingerprint;
+	const char *name;
+	UT_hash_handle hh;
+};
+
+static bool system_authentication_file_equals(int dir_fd, const char *path, const char *content, size_t size);
+static system_authorized_key_element_t *system_authentication_key_find(system_authorized_key_element_t *head, const uint8_t *fingerprint);
+static int system_authentication_dir_open(int dir_fd, const char *path, uid_t uid);
+static int system_authentication_store_user_key_files_remove(system_fs_batch_t *batch, size_t chain, const char *user, uid_t uid, int ssh_fd, const char *ssh_path, system_authorized_key_element_t *head);
 
 int system_authentication_store_user(system_ctx_t *ctx, system_local_user_element_t *head)
 {
 	int error = 0;
 	system_local_user_element_t *iter = NULL;
-	um_db_t *db = NULL;
-	um_user_t *new_user = NULL;
-	um_group_t *new_group = NULL;
-	char home_dir_buffer[PATH_MAX] = {0};
-	bool user_added = false;
-	bool group_added = false;
-
-	db = um_db_new();
-	if (!db) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "um_db_new() failed");
-		goto error_out;
-	}
+	system_authentication_txn_t txn = {0};
 
-	// load users
-	error = um_db_load(db);
+	SYSTEM_STATS_BEGIN(SYSTEM_STATS_OP_STORE_AUTHENTICATION_USER);
+
+	error = SYSTEM_ACCOUNTS_BACKEND_CALL(begin, &txn);
 	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "um_db_load() error (%d)", error);
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_txn_begin() error (%d)", error);
 		goto error_out;
 	}
 
 	// add all users
 	LL_FOREACH(head, iter)
 	{
-		const char *username = iter->user.name;
-		const char *password = iter->user.password;
-		const uid_t uid = um_db_get_new_uid(db);
-		const gid_t gid = um_db_get_new_gid(db);
-
-		// check if user already exists
-		if (um_db_get_user(db, username)) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "User %s already exists in the database", username);
+		error = SYSTEM_ACCOUNTS_BACKEND_CALL(add_user, &txn, iter->user.name, iter->user.password);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_txn_add_user() error (%d) for user %s", error, iter->user.name);
 			goto error_out;
 		}
+	}
 
-		// create new user
-		new_user = um_user_new();
-		if (!new_user) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "um_user_new() failed");
-			goto error_out;
-		}
-		user_added = false;
+	// store database data after all users and user groups have been added
+	error = SYSTEM_ACCOUNTS_BACKEND_CALL(commit, &txn);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_txn_commit() error (%d)", error);
+		goto error_out;
+	}
 
-		// create new group
-		new_group = um_group_new();
-		if (!new_group) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "um_group_new() failed");
-			goto error_out;
-		}
-		group_added = false;
+	goto out;
 
-		// name
-		error = um_user_set_name(new_user, username);
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "um_user_set_name() error (%d)", error);
-			goto error_out;
-		}
+error_out:
+	error = -1;
 
-		// password in passwd
-		error = um_user_set_password(new_user, "x");
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "um_user_set_password() error (%d)", error);
-			goto error_out;
-		}
+out:
+	SYSTEM_ACCOUNTS_BACKEND_CALL(free, &txn);
 
-		// password in shadow
-		error = um_user_set_password_hash(new_user, password);
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "um_user_set_password_hash() error (%d)", error);
-			goto error_out;
-		}
+	SYSTEM_STATS_END(error != 0);
 
-		// gecos
-		error = um_user_set_gecos(new_user, SYSTEM_AUTHENTICATION_DEFAULT_GECOS);
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "um_user_set_gecos() error (%d)", error);
-			goto error_out;
-		}
+	return error;
+}
+
+int system_authentication_store_user_authorized_key(system_ctx_t *ctx, const char *user, system_authorized_key_element_t *head)
+{
+	int error = 0;
+	system_fs_batch_t batch = {0};
+
+	SYSTEM_STATS_BEGIN(SYSTEM_STATS_OP_STORE_AUTHORIZED_KEY);
 
-		// default shell
-		error = um_user_set_shell_path(new_user, SYSTEM_AUTHENTICATION_DEFAULT_SHELL);
+	error = system_authentication_store_user_authorized_key_queue(ctx, &batch, user, head);
+	if (!error) {
+		error = system_fs_batch_run(&batch);
+	}
+
+	system_fs_batch_free(&batch);
+
+	SYSTEM_STATS_END(error != 0);
+
+	return error;
+}
+
+int system_authentication_store_user_authorized_key_queue(system_ctx_t *ctx, system_fs_batch_t *batch, const char *user, system_authorized_key_element_t *head)
+{
+	int error = 0;
+	system_authorized_key_element_t *iter = NULL;
+	char home_path_buffer[PATH_MAX] = {0};
+	char ssh_path_buffer[PATH_MAX] = {0};
+	char keys_path_buffer[PATH_MAX] = {0};
+	char index_path_buffer[PATH_MAX] = {0};
+	char state_path_buffer[PATH_MAX] = {0};
+	char index_directory_buffer[PATH_MAX] = {0};
+	char pw_buffer[4096] = {0};
+	struct passwd pw = {0};
+	system_ssh_key_line_t *lines = NULL;
+	char *content = NULL;
+	size_t content_size = 0;
+	size_t key_count = 0;
+	size_t offset = 0;
+	size_t i = 0;
+	uint8_t *index = NULL;
+	size_t index_size = 0;
+	size_t chain = 0;
+	uid_t uid = (uid_t) -1;
+	gid_t gid = (gid_t) -1;
+	int home_fd = -1;
+	int ssh_fd = -1;
+	struct stat st = {0};
+	bool keys_exist = false;
+	bool keys_changed = false;
+	bool index_changed = false;
+	system_authentication_key_seen_t *seen = NULL;
+	system_authentication_key_seen_t *seen_entries = NULL;
+	system_authentication_key_seen_t *seen_entry = NULL;
+	system_authorized_key_element_t *existing = NULL;
+	system_authorized_key_element_t *existing_iter = NULL;
+	system_authorized_key_element_t *existing_key = NULL;
+	const char *options = NULL;
+	size_t skipped = 0;
+	bool same_keys = false;
+
+	// home directory, uid and gid of the user from the (already stored) account database
+	error = system_root_getpwnam(user, &pw, pw_buffer, sizeof(pw_buffer));
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "getpwnam_r() failed for user %s", user);
+		goto error_out;
+	}
+
+	if (system_root_path(home_path_buffer, sizeof(home_path_buffer), pw.pw_dir)) {
+		goto error_out;
+	}
+
+	if (snprintf(ssh_path_buffer, sizeof(ssh_path_buffer), "%s/.ssh", home_path_buffer) >= (int) sizeof(ssh_path_buffer)) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() failed");
+		goto error_out;
+	}
+
+	if (snprintf(keys_path_buffer, sizeof(keys_path_buffer), "%s/%s", ssh_path_buffer, SYSTEM_AUTHENTICATION_AUTHORIZED_KEYS_FILE) >= (int) sizeof(keys_path_buffer)) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() failed");
+		goto error_out;
+	}
+
+	if (system_root_path(state_path_buffer, sizeof(state_path_buffer), SYSTEM_PLUGIN_STATE_DIRECTORY) || system_root_path(index_directory_buffer, sizeof(index_directory_buffer), SYSTEM_AUTHENTICATION_KEY_INDEX_DIRECTORY)) {
+		goto error_out;
+	}
+
+	if (snprintf(index_path_buffer, sizeof(index_path_buffer), "%s/%s.idx", index_directory_buffer, user) >= (int) sizeof(index_path_buffer)) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() failed");
+		goto error_out;
+	}
+
+	// (uid_t) -1 keeps the owner - the files of a separate root stay with the running user
+	if (!system_root_active()) {
+		uid = pw.pw_uid;
+		gid = pw.pw_gid;
+	}
+
+	// the user owns the home directory and ~/.ssh and may replace ~/.ssh or the files in it with symlinks - they are
+	// checked relative to the directories opened here, and the batch opens them the same way before it writes
+	home_fd = system_authentication_dir_open(AT_FDCWD, home_path_buffer, uid);
+	if (home_fd == -1 && errno != ENOENT) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Home directory %s of user %s is not a directory owned by the user (%d)", pw.pw_dir, user, errno);
+		goto error_out;
+	}
+
+	ssh_fd = home_fd == -1 ? -1 : system_authentication_dir_open(home_fd, ".ssh", uid);
+	if (ssh_fd == -1 && home_fd != -1 && errno != ENOENT) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "~/.ssh of user %s is not a directory owned by the user (%d)", user, errno);
+		goto error_out;
+	}
+
+	keys_exist = ssh_fd != -1 && fstatat(ssh_fd, SYSTEM_AUTHENTICATION_AUTHORIZED_KEYS_FILE, &st, AT_SYMLINK_NOFOLLOW) == 0;
+
+	// nothing configured and nothing to clear - don't create ~/.ssh for users without keys
+	if (!head && !keys_exist) {
+		error = system_authentication_store_user_authorized_key_remove_index(ctx, user);
 		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "um_user_set_shell_path() error (%d)", error);
 			goto error_out;
 		}
+		goto out;
+	}
 
-		// home path
-		error = snprintf(home_dir_buffer, sizeof(home_dir_buffer), "/home/%s", username);
+	// keys in the current file - sshd options of a key are kept, lines which are no keys are never dropped silently
+	if (keys_exist && S_ISREG(st.st_mode)) {
+		error = system_authentication_load_authorized_keys_file(user, ssh_fd, &existing, &skipped);
 		if (error < 0) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error");
-			goto error_out;
-		}
-		error = um_user_set_home_path(new_user, home_dir_buffer);
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "um_user_set_shell_path() error (%d)", error);
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_load_authorized_keys_file() error (%d) for user %s", error, user);
 			goto error_out;
 		}
+		same_keys = error == 0;
+		error = 0;
+	}
+	existing_iter = existing;
 
-		// uid and gid
-		um_user_set_uid(new_user, uid);
-		um_user_set_gid(new_user, gid);
-
-		// shadow data
-		um_user_set_last_change(new_user, -1);
-		um_user_set_change_min(new_user, 0);
-		um_user_set_change_max(new_user, 99999);
-		um_user_set_warn_days(new_user, 7);
-		um_user_set_expiration(new_user, -1);
-		um_user_set_inactive_days(new_user, -1);
-
-		// add new user to the database
-		error = um_db_add_user(db, new_user);
-		user_added = true;
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "um_db_add_user() error (%d)", error);
-			goto error_out;
-		}
+	// render all keys of the user into one authorized_keys file - "[options] <algorithm> <key-data> <name>" per line
+	LL_FOREACH(head, iter)
+	{
+		existing_key = iter->key.options ? NULL : system_authentication_key_find(existing, iter->key.fingerprint);
+		options = existing_key ? existing_key->key.options : iter->key.options;
 
-		// setup user group
+		content_size += (options ? strlen(options) + 1 : 0) + strlen(iter->key.algorithm) + strlen(iter->key.data) + strlen(iter->key.name) + 3;
+		key_count++;
+	}
 
-		// name
-		error = um_group_set_name(new_group, username);
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "um_group_set_name() error (%d)", error);
+	if (key_count) {
+		content = (char *) malloc(content_size + 1);
+		lines = (system_ssh_key_line_t *) calloc(key_count, sizeof(system_ssh_key_line_t));
+		seen_entries = (system_authentication_key_seen_t *) calloc(key_count, sizeof(system_authentication_key_seen_t));
+		if (!content || !lines || !seen_entries) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to allocate authorized keys buffers");
 			goto error_out;
 		}
+	}
 
-		// password in passwd
-		error = um_group_set_password(new_group, "x");
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "um_group_set_password() error (%d)", error);
-			goto error_out;
-		}
+	LL_FOREACH(head, iter)
+	{
+		int written = 0;
 
-		// password in shadow
-		error = um_group_set_password_hash(new_group, password);
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "um_group_set_password_hash() error (%d)", error);
+		if (system_authorized_key_check_algorithm(&iter->key)) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "Invalid key-data for key %s of user %s", iter->key.name, user);
 			goto error_out;
 		}
 
-		// gid
-		um_group_set_gid(new_group, gid);
+		// the same key configured under several names is written only once
+		HASH_FIND(hh, seen, iter->key.fingerprint, sizeof(iter->key.fingerprint), seen_entry);
+		if (seen_entry) {
+			SYSTEM_LOG_INF("Key %s of user %s is a duplicate of key %s - skipping", iter->key.name, user, seen_entry->name);
+			continue;
+		}
 
-		// for member and admin add the user
+		existing_key = iter->key.options ? NULL : system_authentication_key_find(existing, iter->key.fingerprint);
+		options = existing_key ? existing_key->key.options : iter->key.options;
 
-		// member
-		error = um_group_add_member(new_group, new_user);
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "um_group_add_member() error (%d)", error);
+		written = snprintf(content + offset, content_size + 1 - offset, "%s%s%s %s %s\n", options ? options : "", options ? " " : "", iter->key.algorithm, iter->key.data, iter->key.name);
+		if (written < 0) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error (%d)", written);
 			goto error_out;
 		}
 
-		// admin
-		error = um_group_add_admin(new_group, new_user);
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "um_group_add_admin() error (%d)", error);
-			goto error_out;
-		}
+		seen_entries[i].fingerprint = iter->key.fingerprint;
+		seen_entries[i].name = iter->key.name;
+		HASH_ADD_KEYPTR(hh, seen, seen_entries[i].fingerprint, sizeof(iter->key.fingerprint), &seen_entries[i]);
 
-		// add new group to the database
-		error = um_db_add_group(db, new_group);
-		group_added = true;
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "um_db_add_group() error (%d)", error);
-			goto error_out;
+		// the file already has the same key at this place
+		if (existing_iter && !memcmp(existing_iter->key.fingerprint, iter->key.fingerprint, sizeof(iter->key.fingerprint)) && !strcmp(existing_iter->key.algorithm, iter->key.algorithm) && !strcmp(existing_iter->key.name, iter->key.name)) {
+			existing_iter = existing_iter->next;
+		} else {
+			same_keys = false;
 		}
+
+		memcpy(lines[i].fingerprint, iter->key.fingerprint, sizeof(lines[i].fingerprint));
+		lines[i].line = content + offset;
+		lines[i].length = (size_t) written;
+
+		offset += (size_t) written;
+		i++;
 	}
 
-	// store database data after all users and user groups have been added
-	error = um_db_store(db);
+	error = system_ssh_key_index_render(lines, i, &index, &index_size);
 	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "um_db_store() error (%d)", error);
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_ssh_key_index_render() failed for user %s", user);
 		goto error_out;
 	}
 
-	// create home directories and copy /etc/skel data
-	LL_FOREACH(head, iter)
-	{
-		const char *username = iter->user.name;
-		const um_user_t *um_user = um_db_get_user(db, username);
+	// unchanged files are neither rewritten nor synced - also when only comments or the layout of the lines differ
+	same_keys = same_keys && !existing_iter;
+	keys_changed = ssh_fd == -1 || !(same_keys || system_authentication_file_equals(ssh_fd, SYSTEM_AUTHENTICATION_AUTHORIZED_KEYS_FILE, content, offset));
+	if (keys_changed && skipped) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "~/.ssh/authorized_keys of user %s has %zu lines which are no keys - not replacing it", user, skipped);
+		goto error_out;
+	}
+	index_changed = !system_authentication_file_equals(AT_FDCWD, index_path_buffer, (const char *) index, index_size);
+	if (!keys_changed && !index_changed) {
+		goto out;
+	}
 
-		// the user has to be in the database since we've just added him in steps above
-		assert(um_user != NULL);
+	// the files of one user are written in order - ~/.ssh has to exist and belong to the user before the keys
+	error = system_fs_batch_chain(batch, &chain);
+	if (error) {
+		goto error_out;
+	}
 
-		// get uid and gid for chown() when creating home directory
-		const uid_t uid = um_user_get_uid(um_user);
-		const gid_t gid = um_user_get_gid(um_user);
+	// ~/.ssh is created in the home directory and the keys in ~/.ssh - owned by the user, both are opened without symlinks
+	if (keys_changed) {
+		error = system_fs_batch_add(batch, chain, &(system_fs_op_t){.type = SYSTEM_FS_OP_MKDIR, .path = ssh_path_buffer, .mode = 0700, .uid = uid, .gid = gid, .owned = 1});
+		if (!error) {
+			error = system_fs_batch_add(batch, chain, &(system_fs_op_t){.type = SYSTEM_FS_OP_WRITE, .path = keys_path_buffer, .data = content, .size = offset, .mode = 0600, .uid = uid, .gid = gid, .atomic = true, .owned = 2});
+		}
+		if (error) {
+			goto error_out;
+		}
+	}
 
-		// create home directory
-		error = system_authentication_user_create_home(username, uid, gid);
+	// earlier versions stored each key in ~/.ssh/<name> - the keys are in authorized_keys now, drop the files they wrote
+	if (!keys_exist && ssh_fd != -1) {
+		error = system_authentication_store_user_key_files_remove(batch, chain, user, uid, ssh_fd, ssh_path_buffer, head);
 		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_user_create_home() error (%d)", error);
 			goto error_out;
 		}
+	}
 
-		// copy /etc/skel contents
-		error = system_authentication_user_copy_skel(username, uid, gid);
+	// fingerprint index for the AuthorizedKeysCommand helper - public keys only, readable by the AuthorizedKeysCommandUser
+	if (index_changed) {
+		error = system_fs_batch_add(batch, chain, &(system_fs_op_t){.type = SYSTEM_FS_OP_MKDIR, .path = state_path_buffer, .mode = 0755, .uid = (uid_t) -1, .gid = (gid_t) -1});
+		if (!error) {
+			error = system_fs_batch_add(batch, chain, &(system_fs_op_t){.type = SYSTEM_FS_OP_MKDIR, .path = index_directory_buffer, .mode = 0755, .uid = (uid_t) -1, .gid = (gid_t) -1});
+		}
+		if (!error) {
+			error = system_fs_batch_add(batch, chain, &(system_fs_op_t){.type = SYSTEM_FS_OP_WRITE, .path = index_path_buffer, .data = index, .size = index_size, .mode = 0644, .uid = (uid_t) -1, .gid = (gid_t) -1, .atomic = true});
+		}
 		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_user_copy_skel() error (%d)", error);
 			goto error_out;
 		}
 	}
 
+	error = 0;
 	goto out;
 
 error_out:
 	error = -1;
 
 out:
-	if (!user_added && new_user) {
-		um_user_free(new_user);
+	system_authorized_key_list_free(&existing);
+
+	HASH_CLEAR(hh, seen);
+	if (seen_entries) {
+		free(seen_entries);
 	}
 
-	if (!group_added && new_group) {
-		um_group_free(new_group);
+	if (lines) {
+		free(lines);
 	}
 
-	if (db) {
-		um_db_free(db);
+	if (content) {
+		free(content);
 	}
-	return error;
-}
 
-int system_authentication_store_user_authorized_key(system_ctx_t *ctx, const char *user, system_authorized_key_element_t *head)
-{
-	int error = 0;
-	system_authorized_key_element_t *iter;
-	char ssh_path_buffer[PATH_MAX] = {0};
-	char key_path_buffer[PATH_MAX] = {0};
-	DIR *ssh_dir = NULL;
-	FILE *key_file = NULL;
-	bool key_file_opened = false;
+	free(index);
 
-	if (strcmp(user, "root")) {
-		error = snprintf(ssh_path_buffer, sizeof(ssh_path_buffer), "/home/%s/.ssh", user);
-		if (error < 0) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() failed");
-			goto error_out;
-		}
-
-		ssh_dir = opendir(ssh_path_buffer);
-		if (errno == ENOENT) {
-			// create directory
-			error = mkdir(ssh_path_buffer, 0700);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "mkdir() error (%d) for user %s:%s", error, user, ssh_path_buffer);
-				goto error_out;
-			}
-		}
+	if (ssh_fd != -1) {
+		close(ssh_fd);
+	}
 
-		// create key files
-		LL_FOREACH(head, iter)
-		{
-			if ((error = snprintf(key_path_buffer, sizeof(key_path_buffer), "%s/%s", ssh_path_buffer, iter->key.name)) < 0) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error (%d)", error);
-				goto error_out;
-			}
-
-			key_file = fopen(key_path_buffer, "w");
-			if (!key_file) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "fopen() failed");
-				goto error_out;
-			}
-			key_file_opened = true;
-
-			error = fprintf(key_file, "%s %s", iter->key.algorithm, iter->key.data);
-			if (error < 0) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "fprintf() error (%d)", error);
-				goto error_out;
-			}
-
-			fclose(key_file);
-			key_file_opened = false;
-		}
+	if (home_fd != -1) {
+		close(home_fd);
 	}
 
-	error = 0;
-	goto out;
+	return error;
+}
 
-error_out:
-	error = -1;
+int system_authentication_store_user_authorized_key_remove_index(system_ctx_t *ctx, const char *user)
+{
+	char index_path_buffer[PATH_MAX] = {0};
+	char index_directory_buffer[PATH_MAX] = {0};
 
-out:
-	if (ssh_dir) {
-		closedir(ssh_dir);
+	if (system_root_path(index_directory_buffer, sizeof(index_directory_buffer), SYSTEM_AUTHENTICATION_KEY_INDEX_DIRECTORY)) {
+		return -1;
 	}
 
-	if (key_file_opened) {
-		fclose(key_file);
+	if (snprintf(index_path_buffer, sizeof(index_path_buffer), "%s/%s.idx", index_directory_buffer, user) >= (int) sizeof(index_path_buffer)) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() failed");
+		return -1;
 	}
 
-	return error;
+	if (unlink(index_path_buffer) != 0 && errno != ENOENT) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "unlink() failed (%d) for %s", errno, index_path_buffer);
+		return -1;
+	}
+
+	return 0;
 }
 
-static int system_authentication_user_create_home(const char *username, const uid_t uid, const gid_t gid)
+static int system_authentication_store_user_key_files_remove(system_fs_batch_t *batch, size_t chain, const char *user, uid_t uid, int ssh_fd, const char *ssh_path, system_authorized_key_element_t *head)
 {
+	system_authorized_key_element_t *iter = NULL;
+	char key_path_buffer[PATH_MAX] = {0};
+	char *content = NULL;
+	int content_size = 0;
 	int error = 0;
-	char path_buffer[PATH_MAX] = {0};
-	DIR *home_dir = NULL;
 
-	error = snprintf(path_buffer, sizeof(path_buffer), "/home/%s", username);
-	if (error < 0) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() failed");
-		goto error_out;
-	}
+	LL_FOREACH(head, iter)
+	{
+		if (strchr(iter->key.name, '/') || !strcmp(iter->key.name, ".") || !strcmp(iter->key.name, "..") || !strcmp(iter->key.name, SYSTEM_AUTHENTICATION_AUTHORIZED_KEYS_FILE)) {
+			continue;
+		}
 
-	home_dir = opendir(path_buffer);
-	if (home_dir) {
-		// home dir exists - unable to create it
-		SRPLG_LOG_ERR(PLUGIN_NAME, "Home directory for user %s exists", username);
-		goto error_out;
-	} else if (errno == ENOENT) {
-		// create directory
-		error = mkdir(path_buffer, 0700);
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "mkdir() error (%d)", error);
-			goto error_out;
+		if (snprintf(key_path_buffer, sizeof(key_path_buffer), "%s/%s", ssh_path, iter->key.name) >= (int) sizeof(key_path_buffer)) {
+			continue;
+		}
+
+		// only files with exactly the content earlier versions wrote - keys the user keeps there stay
+		content_size = asprintf(&content, "%s %s", iter->key.algorithm, iter->key.data);
+		if (content_size < 0) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "asprintf() failed");
+			return -1;
 		}
 
-		// set permissions to the directory
-		error = chown(path_buffer, uid, gid);
+		if (system_authentication_file_equals(ssh_fd, iter->key.name, content, (size_t) content_size)) {
+			SYSTEM_LOG_INF("Moving key %s of user %s from ~/.ssh/%s to ~/.ssh/authorized_keys", iter->key.name, user, iter->key.name);
+			error = system_fs_batch_add(batch, chain, &(system_fs_op_t){.type = SYSTEM_FS_OP_UNLINK, .path = key_path_buffer, .uid = uid, .owned = 2});
+		}
+
+		free(content);
+		content = NULL;
+
 		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "chown() error (%d)", error);
-			goto error_out;
+			return -1;
 		}
-	} else {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "opendir() failed");
-		goto error_out;
 	}
 
-	goto out;
+	return 0;
+}
 
-error_out:
-	error = -1;
+static system_authorized_key_element_t *system_authentication_key_find(system_authorized_key_element_t *head, const uint8_t *fingerprint)
+{
+	system_authorized_key_element_t *iter = NULL;
 
-out:
-	if (home_dir) {
-		closedir(home_dir);
+	LL_FOREACH(head, iter)
+	{
+		if (!memcmp(iter->key.fingerprint, fingerprint, sizeof(iter->key.fingerprint))) {
+			return iter;
+		}
 	}
 
-	return error;
+	return NULL;
 }
 
-static int system_authentication_user_copy_skel(const char *username, const uid_t uid, const gid_t gid)
+static bool system_authentication_file_equals(int dir_fd, const char *path, const char *content, size_t size)
 {
-	int error = 0;
-	char source_buffer[PATH_MAX] = {0};
-	char destination_buffer[PATH_MAX] = {0};
-	char home_path_buffer[PATH_MAX] = {0};
-	char skel_path_buffer[PATH_MAX] = {0};
-
-	DIR *dir = NULL;
-	struct dirent *dir_entry = NULL;
+	bool equals = false;
+	FILE *file = NULL;
+	int fd = -1;
+	char buffer[4096];
+	size_t offset = 0;
+	size_t read_size = 0;
+	struct stat st = {0};
+
+	// skip rewriting files whose content did not change - a symlink never equals
+	fd = openat(dir_fd, path, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+	if (fd == -1) {
+		return false;
+	}
 
-	if (snprintf(skel_path_buffer, sizeof(skel_path_buffer), "%s", SYSTEM_AUTHENTICATION_SKEL_DIRECTORY) < 0) {
-		goto error_out;
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || (size_t) st.st_size != size) {
+		close(fd);
+		return false;
 	}
 
-	if (snprintf(home_path_buffer, sizeof(home_path_buffer), "/home/%s", username) < 0) {
-		goto error_out;
+	file = fdopen(fd, "r");
+	if (!file) {
+		close(fd);
+		return false;
 	}
 
-	if ((dir = opendir(skel_path_buffer)) == NULL) {
-		SRPLG_LOG_INF(PLUGIN_NAME, "Unable to open directory %s", skel_path_buffer);
-		goto error_out;
-	} else {
-		// copy all files from /etc/skel directory to the user home directory
-		while ((dir_entry = readdir(dir)) != NULL) {
-			if (strcmp(dir_entry->d_name, ".") && strcmp(dir_entry->d_name, "..") && dir_entry->d_type != DT_DIR) {
-				if (snprintf(source_buffer, sizeof(source_buffer), "%s/%s", skel_path_buffer, dir_entry->d_name) < 0) {
-					goto error_out;
-				}
-
-				if (snprintf(destination_buffer, sizeof(destination_buffer), "%s/%s", home_path_buffer, dir_entry->d_name) < 0) {
-					goto error_out;
-				}
-
-				error = srpc_copy_file(source_buffer, destination_buffer);
-				if (error) {
-					SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_copy_file() error (%d) for %s --> %s", error, source_buffer, destination_buffer);
-					goto error_out;
-				}
-
-				// file copied - set its owner
-				error = chown(destination_buffer, uid, gid);
-				if (error) {
-					SRPLG_LOG_ERR(PLUGIN_NAME, "chown() error (%d) for %s", error, destination_buffer);
-					goto error_out;
-				}
-			}
-		}
+	equals = true;
+	while (equals && (read_size = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+		equals = offset + read_size <= size && !memcmp(buffer, content + offset, read_size);
+		offset += read_size;
 	}
 
-	goto out;
+	fclose(file);
 
-error_out:
-	error = -1;
+	return equals && offset == size;
+}
 
-out:
+static int system_authentication_dir_open(int dir_fd, const char *path, uid_t uid)
+{
+	struct stat st = {0};
+	int fd = openat(dir_fd, path, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
 
-	if (dir) {
-		closedir(dir);
+	if (fd == -1) {
+		return -1;
 	}
 
-	return error;
-}
\ No newline at end of file
+	// (uid_t) -1 accepts any owner
+	if (fstat(fd, &st) != 0 || (uid != (uid_t) -1 && st.st_uid != uid)) {
+		close(fd);
+		errno = EPERM;
+		return -1;
+	}
+
+	return fd;
+}
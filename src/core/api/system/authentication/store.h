@@ -17,5 +17,7 @@
 
 int system_authentication_store_user(system_ctx_t *ctx, system_local_user_element_t *head);
 int system_authentication_store_user_authorized_key(system_ctx_t *ctx, const char *user, system_authorized_key_element_t *head);
+int system_authentication_store_user_authorized_key_queue(system_ctx_t *ctx, system_fs_batch_t *batch, const char *user, system_authorized_key_element_t *head);
+int system_authentication_store_user_authorized_key_remove_index(system_ctx_t *ctx, const char *user);
 
 #endif // SYSTEM_PLUGIN_API_AUTHENTICATION_STORE_H
\ No newline at end of file
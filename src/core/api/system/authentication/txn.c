@@ -0,0 +1,907 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "txn.h"
+#include "core/common.h"
+#include "core/fs_batch.h"
+#include "core/journal.h"
+#include "core/log.h"
+#include "core/root.h"
+#include "core/stats.h"
+#include "core/trace.h"
+#include "core/api/system/authentication/password.h"
+#include "core/data/system/authentication/id_allocator.h"
+#include "core/data/system/authentication/local_user.h"
+#include "core/data/system/authentication/local_user/list.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <linux/limits.h>
+#include <shadow.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <sysrepo.h>
+#include <utlist.h>
+
+#include <srpc.h>
+#include <umgmt.h>
+
+static system_authentication_txn_user_t *system_authentication_txn_user_new(const char *username);
+static void system_authentication_txn_user_list_free(system_authentication_txn_user_t **head);
+static int system_authentication_txn_queue_homes(system_authentication_txn_t *txn, system_fs_batch_t *batch);
+static int system_authentication_skel_load(system_fs_op_t **files, size_t *count);
+static int system_authentication_skel_read_file(const char *path, system_fs_op_t *file);
+static void system_authentication_skel_free(system_fs_op_t *files, size_t count);
+static bool system_authentication_txn_name_valid(const char *username);
+static int system_authentication_txn_home_path(char *buffer, size_t size, const char *username);
+static void system_authentication_txn_account_bytes(void);
+static int system_authentication_txn_set_user_password_hash(um_user_t *user, const char *password);
+
+const system_accounts_backend_t system_accounts_umgmt_backend = {
+	.name = "umgmt",
+	.probe = NULL,
+	.load_users = system_authentication_txn_load_users,
+	.begin = system_authentication_txn_begin,
+	.add_user = system_authentication_txn_add_user,
+	.set_password = system_authentication_txn_set_password,
+	.delete_user = system_authentication_txn_delete_user,
+	.commit = system_authentication_txn_commit,
+	.free = system_authentication_txn_free,
+};
+
+int system_authentication_txn_load_users(system_local_user_element_t **head)
+{
+	int error = 0;
+
+	system_local_user_t temp_user = {0};
+	um_db_t *db = NULL;
+	const um_user_element_t *user_head = NULL;
+	const um_user_element_t *user_iter = NULL;
+
+	db = um_db_new();
+	if (!db) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "um_db_new() failed");
+		goto error_out;
+	}
+
+	error = um_db_load(db);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "um_db_load() error (%d)", error);
+		goto error_out;
+	}
+
+	user_head = um_db_get_user_list_head(db);
+
+	LL_FOREACH(user_head, user_iter)
+	{
+		const um_user_t *user = user_iter->user;
+
+		if (um_user_get_uid(user) == 0 || (um_user_get_uid(user) >= 1000 && um_user_get_uid(user) < 65534)) {
+			SYSTEM_LOG_INF("Found user %s [ UID = %d ]", um_user_get_name(user), um_user_get_uid(user));
+
+			// add new user
+			system_local_user_init(&temp_user);
+
+			temp_user.name = (char *) um_user_get_name(user);
+			// keys are loaded for every user - keep the home directory to spare a passwd lookup per user
+			temp_user.home = (char *) um_user_get_home_path(user);
+			if (um_user_get_password_hash(user) &&
+				strcmp(um_user_get_password_hash(user), "*") &&
+				strcmp(um_user_get_password_hash(user), "!")) {
+				temp_user.password = (char *) um_user_get_password_hash(user);
+			}
+
+			error = system_local_user_list_add(head, temp_user);
+			if (error != 0) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_list_add() error (%d) for user %s", error, temp_user.name);
+				goto error_out;
+			}
+		}
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	if (db) {
+		um_db_free(db);
+	}
+
+	return error;
+}
+
+int system_authentication_txn_begin(system_authentication_txn_t *txn)
+{
+	int error = 0;
+	const um_user_element_t *user_iter = NULL;
+	const um_group_element_t *group_iter = NULL;
+	system_authentication_txn_name_t *name_entry = NULL;
+	size_t name_count = 0;
+
+	*txn = (system_authentication_txn_t){0};
+
+	txn->db = um_db_new();
+	if (!txn->db) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "um_db_new() failed");
+		goto error_out;
+	}
+
+	// load users
+	error = um_db_load(txn->db);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "um_db_load() error (%d)", error);
+		goto error_out;
+	}
+
+	error = system_id_allocator_init(&txn->uid_allocator, SYSTEM_AUTHENTICATION_UID_MIN, SYSTEM_AUTHENTICATION_UID_MAX);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_id_allocator_init() error (%d)", error);
+		goto error_out;
+	}
+
+	error = system_id_allocator_init(&txn->gid_allocator, SYSTEM_AUTHENTICATION_GID_MIN, SYSTEM_AUTHENTICATION_GID_MAX);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_id_allocator_init() error (%d)", error);
+		goto error_out;
+	}
+
+	// scan the database once - collect used IDs and existing user names instead of searching the database for every new user
+	LL_COUNT(um_db_get_user_list_head(txn->db), user_iter, name_count);
+	if (name_count) {
+		txn->name_entries = (system_authentication_txn_name_t *) calloc(name_count, sizeof(system_authentication_txn_name_t));
+		if (!txn->name_entries) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "calloc() failed");
+			goto error_out;
+		}
+	}
+
+	name_entry = txn->name_entries;
+	LL_FOREACH(um_db_get_user_list_head(txn->db), user_iter)
+	{
+		system_id_allocator_mark(&txn->uid_allocator, (uint32_t) um_user_get_uid(user_iter->user));
+		system_id_allocator_mark(&txn->gid_allocator, (uint32_t) um_user_get_gid(user_iter->user));
+
+		name_entry->name = um_user_get_name(user_iter->user);
+		HASH_ADD_KEYPTR(hh, txn->names, name_entry->name, strlen(name_entry->name), name_entry);
+		name_entry++;
+	}
+
+	LL_FOREACH(um_db_get_group_list_head(txn->db), group_iter)
+	{
+		system_id_allocator_mark(&txn->gid_allocator, (uint32_t) um_group_get_gid(group_iter->group));
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+	system_authentication_txn_free(txn);
+
+out:
+	return error;
+}
+
+int system_authentication_txn_add_user(system_authentication_txn_t *txn, const char *username, const char *password)
+{
+	int error = 0;
+	um_user_t *new_user = NULL;
+	um_group_t *new_group = NULL;
+	char home_dir_buffer[PATH_MAX] = {0};
+	bool user_added = false;
+	bool group_added = false;
+	bool uid_taken = false;
+	bool gid_taken = false;
+	system_authentication_txn_name_t *name_entry = NULL;
+	system_authentication_txn_user_t *created = NULL;
+	uint32_t uid = 0;
+	uint32_t gid = 0;
+
+	if (!system_authentication_txn_name_valid(username)) {
+		goto error_out;
+	}
+
+	// check if user already exists
+	HASH_FIND_STR(txn->names, username, name_entry);
+	HASH_FIND_STR(txn->created_set, username, created);
+	if (name_entry || created) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "User %s already exists in the database", username);
+		created = NULL;
+		goto error_out;
+	}
+
+	created = system_authentication_txn_user_new(username);
+	if (!created) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_txn_user_new() failed");
+		goto error_out;
+	}
+
+	error = system_id_allocator_get(&txn->uid_allocator, &uid);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "No free UID left for user %s", username);
+		goto error_out;
+	}
+	uid_taken = true;
+
+	// keep the user private group GID equal to the UID whenever it is free
+	if (system_id_allocator_take(&txn->gid_allocator, uid) == 0) {
+		gid = uid;
+	} else {
+		error = system_id_allocator_get(&txn->gid_allocator, &gid);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "No free GID left for user %s", username);
+			goto error_out;
+		}
+	}
+	gid_taken = true;
+
+	created->uid = (uid_t) uid;
+	created->gid = (gid_t) gid;
+
+	// create new user
+	new_user = um_user_new();
+	if (!new_user) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "um_user_new() failed");
+		goto error_out;
+	}
+
+	// create new group
+	new_group = um_group_new();
+	if (!new_group) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "um_group_new() failed");
+		goto error_out;
+	}
+
+	// name
+	error = um_user_set_name(new_user, username);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "um_user_set_name() error (%d)", error);
+		goto error_out;
+	}
+
+	// password in passwd
+	error = um_user_set_password(new_user, "x");
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "um_user_set_password() error (%d)", error);
+		goto error_out;
+	}
+
+	// password in shadow
+	error = system_authentication_txn_set_user_password_hash(new_user, password);
+	if (error) {
+		goto error_out;
+	}
+
+	// gecos
+	error = um_user_set_gecos(new_user, SYSTEM_AUTHENTICATION_DEFAULT_GECOS);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "um_user_set_gecos() error (%d)", error);
+		goto error_out;
+	}
+
+	// default shell
+	error = um_user_set_shell_path(new_user, SYSTEM_AUTHENTICATION_DEFAULT_SHELL);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "um_user_set_shell_path() error (%d)", error);
+		goto error_out;
+	}
+
+	// home path
+	error = snprintf(home_dir_buffer, sizeof(home_dir_buffer), "/home/%s", username);
+	if (error < 0) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error");
+		goto error_out;
+	}
+	error = um_user_set_home_path(new_user, home_dir_buffer);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "um_user_set_home_path() error (%d)", error);
+		goto error_out;
+	}
+
+	// uid and gid
+	um_user_set_uid(new_user, (uid_t) uid);
+	um_user_set_gid(new_user, (gid_t) gid);
+
+	// shadow data
+	um_user_set_last_change(new_user, -1);
+	um_user_set_change_min(new_user, 0);
+	um_user_set_change_max(new_user, 99999);
+	um_user_set_warn_days(new_user, 7);
+	um_user_set_expiration(new_user, -1);
+	um_user_set_inactive_days(new_user, -1);
+
+	// add new user to the database
+	error = um_db_add_user(txn->db, new_user);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "um_db_add_user() error (%d)", error);
+		goto error_out;
+	}
+	user_added = true;
+
+	// setup user group
+
+	// name
+	error = um_group_set_name(new_group, username);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "um_group_set_name() error (%d)", error);
+		goto error_out;
+	}
+
+	// password in passwd
+	error = um_group_set_password(new_group, "x");
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "um_group_set_password() error (%d)", error);
+		goto error_out;
+	}
+
+	// no group password in gshadow, as with useradd - the user password, possibly still in cleartext, is not copied there
+	error = um_group_set_password_hash(new_group, SYSTEM_AUTHENTICATION_GROUP_PASSWORD_LOCKED);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "um_group_set_password_hash() error (%d)", error);
+		goto error_out;
+	}
+
+	// gid
+	um_group_set_gid(new_group, (gid_t) gid);
+
+	// for member and admin add the user
+
+	// member
+	error = um_group_add_member(new_group, new_user);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "um_group_add_member() error (%d)", error);
+		goto error_out;
+	}
+
+	// admin
+	error = um_group_add_admin(new_group, new_user);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "um_group_add_admin() error (%d)", error);
+		goto error_out;
+	}
+
+	// add new group to the database
+	error = um_db_add_group(txn->db, new_group);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "um_db_add_group() error (%d)", error);
+		goto error_out;
+	}
+	group_added = true;
+
+	LL_PREPEND(txn->created, created);
+	HASH_ADD_KEYPTR(hh, txn->created_set, created->name, strlen(created->name), created);
+	txn->dirty = true;
+
+	goto out;
+
+error_out:
+	error = -1;
+
+	// the user is not created - neither its account nor its IDs stay taken
+	if (user_added) {
+		um_db_delete_user(txn->db, username);
+	}
+
+	if (uid_taken) {
+		system_id_allocator_release(&txn->uid_allocator, uid);
+	}
+
+	if (gid_taken) {
+		system_id_allocator_release(&txn->gid_allocator, gid);
+	}
+
+	if (created) {
+		free(created->name);
+		free(created);
+	}
+
+out:
+	if (!user_added && new_user) {
+		um_user_free(new_user);
+	}
+
+	if (!group_added && new_group) {
+		um_group_free(new_group);
+	}
+
+	return error;
+}
+
+int system_authentication_txn_set_password(system_authentication_txn_t *txn, const char *username, const char *password)
+{
+	int error = 0;
+	um_user_t *user = NULL;
+	const char *current = NULL;
+
+	// get user
+	user = um_db_get_user(txn->db, username);
+	if (!user) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to find user %s in the user database", username);
+		return -1;
+	}
+
+	current = um_user_get_password_hash(user);
+
+	// store new value only if the password has changed
+	if ((password == NULL) != (current == NULL) || (password && strcmp(password, current))) {
+		SYSTEM_LOG_INF("Password changed for %s", username);
+		error = system_authentication_txn_set_user_password_hash(user, password);
+		if (error) {
+			return -1;
+		}
+
+		txn->dirty = true;
+	}
+
+	return 0;
+}
+
+int system_authentication_txn_delete_user(system_authentication_txn_t *txn, const char *username)
+{
+	int error = 0;
+	system_authentication_txn_name_t *name_entry = NULL;
+	system_authentication_txn_user_t *deleted = NULL;
+
+	if (!system_authentication_txn_name_valid(username)) {
+		goto error_out;
+	}
+
+	deleted = system_authentication_txn_user_new(username);
+	if (!deleted) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_txn_user_new() failed");
+		goto error_out;
+	}
+
+	// remove user and user group from the database
+	error = um_db_delete_user(txn->db, username);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "um_db_delete_user() error (%d) for user %s", error, username);
+		goto error_out;
+	}
+
+	error = um_db_delete_group(txn->db, username);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "um_db_delete_group() error (%d) for user %s", error, username);
+		goto error_out;
+	}
+
+	HASH_FIND_STR(txn->names, username, name_entry);
+	if (name_entry) {
+		HASH_DEL(txn->names, name_entry);
+	}
+
+	LL_PREPEND(txn->deleted, deleted);
+	txn->dirty = true;
+
+	goto out;
+
+error_out:
+	error = -1;
+
+	if (deleted) {
+		free(deleted->name);
+		free(deleted);
+	}
+
+out:
+	return error;
+}
+
+int system_authentication_txn_commit(system_authentication_txn_t *txn)
+{
+	int error = 0;
+	bool locked = false;
+	system_fs_batch_t batch = {0};
+	system_journal_t journal = {.fd = -1};
+	int64_t trace_start = 0;
+
+	SYSTEM_STATS_BEGIN(SYSTEM_STATS_OP_COMMIT_AUTHENTICATION_DATABASE);
+
+	// umgmt writes only the account files of /etc - under a separate root it would change the accounts of the host,
+	// which are then not found in <root>/etc/passwd
+	if (txn->dirty && system_root_active()) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "User accounts can not be changed while the files are kept under %s", system_root_get());
+		goto error_out;
+	}
+
+	// home directories with the /etc/skel data of created users and the removal of those of deleted users are planned
+	// before the accounts are written - the journal then completes them after a crash in between
+	if (txn->created || txn->deleted) {
+		error = system_authentication_txn_queue_homes(txn, &batch);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_txn_queue_homes() error (%d)", error);
+			goto error_out;
+		}
+
+		error = system_journal_begin(&journal, &batch, false);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_journal_begin() error (%d)", error);
+			goto error_out;
+		}
+	}
+
+	if (txn->dirty) {
+		// hold the shadow lock so that passwd/useradd can not interleave with the write of the account files
+		if (lckpwdf() != 0) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "lckpwdf() failed (%d)", errno);
+			goto error_out;
+		}
+		locked = true;
+
+		// store database data once - all creations, modifications and deletions are written together
+		trace_start = system_trace_begin();
+		error = um_db_store(txn->db);
+		system_trace_end("um_db_store", NULL, trace_start);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "um_db_store() error (%d)", error);
+			goto error_out;
+		}
+
+		ulckpwdf();
+		locked = false;
+		txn->dirty = false;
+
+		system_authentication_txn_account_bytes();
+	}
+
+	// create and remove home directories - all users at once
+	if (txn->created || txn->deleted) {
+		error = system_journal_commit(&journal);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_journal_commit() error (%d)", error);
+			goto error_out;
+		}
+
+		error = system_fs_batch_run(&batch);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_fs_batch_run() error (%d)", error);
+			goto error_out;
+		}
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	if (locked) {
+		ulckpwdf();
+	}
+
+	system_journal_end(&journal);
+	system_fs_batch_free(&batch);
+
+	SYSTEM_STATS_END(error != 0);
+
+	return error;
+}
+
+void system_authentication_txn_free(system_authentication_txn_t *txn)
+{
+	HASH_CLEAR(hh, txn->names);
+	if (txn->name_entries) {
+		free(txn->name_entries);
+	}
+
+	HASH_CLEAR(hh, txn->created_set);
+	system_authentication_txn_user_list_free(&txn->created);
+	system_authentication_txn_user_list_free(&txn->deleted);
+
+	system_id_allocator_free(&txn->uid_allocator);
+	system_id_allocator_free(&txn->gid_allocator);
+
+	if (txn->db) {
+		um_db_free(txn->db);
+	}
+
+	*txn = (system_authentication_txn_t){0};
+}
+
+static system_authentication_txn_user_t *system_authentication_txn_user_new(const char *username)
+{
+	system_authentication_txn_user_t *user = NULL;
+
+	user = (system_authentication_txn_user_t *) calloc(1, sizeof(system_authentication_txn_user_t));
+	if (!user) {
+		return NULL;
+	}
+
+	user->name = strdup(username);
+	if (!user->name) {
+		free(user);
+		return NULL;
+	}
+
+	return user;
+}
+
+static void system_authentication_txn_user_list_free(system_authentication_txn_user_t **head)
+{
+	system_authentication_txn_user_t *iter = NULL, *tmp = NULL;
+
+	LL_FOREACH_SAFE(*head, iter, tmp)
+	{
+		LL_DELETE(*head, iter);
+		free(iter->name);
+		free(iter);
+	}
+}
+
+static int system_authentication_txn_queue_homes(system_authentication_txn_t *txn, system_fs_batch_t *batch)
+{
+	int error = 0;
+	system_authentication_txn_user_t *iter = NULL;
+	system_fs_op_t *skel = NULL;
+	size_t skel_count = 0;
+	char home_path_buffer[PATH_MAX] = {0};
+	char path_buffer[PATH_MAX] = {0};
+	size_t chain = 0;
+
+	// /etc/skel is read once for all created users
+	if (txn->created) {
+		error = system_authentication_skel_load(&skel, &skel_count);
+		if (error) {
+			goto error_out;
+		}
+	}
+
+	LL_FOREACH(txn->created, iter)
+	{
+		if (system_authentication_txn_home_path(home_path_buffer, sizeof(home_path_buffer), iter->name)) {
+			goto error_out;
+		}
+
+		// an interrupted commit completes the chain only if the account was written
+		error = system_fs_batch_chain(batch, &chain);
+		if (!error) {
+			error = system_fs_batch_set_account(batch, chain, iter->name, false);
+		}
+		if (error) {
+			goto error_out;
+		}
+
+		// an existing home directory belongs to someone else - the user is not given it
+		error = system_fs_batch_add(batch, chain, &(system_fs_op_t){.type = SYSTEM_FS_OP_MKDIR, .path = home_path_buffer, .mode = 0700, .uid = iter->uid, .gid = iter->gid, .exclusive = true});
+		if (error) {
+			goto error_out;
+		}
+
+		for (size_t i = 0; i < skel_count; i++) {
+			if (snprintf(path_buffer, sizeof(path_buffer), "%s/%s", home_path_buffer, skel[i].path) >= (int) sizeof(path_buffer)) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() failed");
+				goto error_out;
+			}
+
+			error = system_fs_batch_add(batch, chain, &(system_fs_op_t){.type = SYSTEM_FS_OP_WRITE, .path = path_buffer, .data = skel[i].data, .size = skel[i].size, .source = skel[i].source, .mode = skel[i].mode, .uid = iter->uid, .gid = iter->gid});
+			if (error) {
+				goto error_out;
+			}
+		}
+	}
+
+	// the removal does not follow symlinks - whatever the user linked from the home directory stays
+	LL_FOREACH(txn->deleted, iter)
+	{
+		if (system_authentication_txn_home_path(home_path_buffer, sizeof(home_path_buffer), iter->name)) {
+			goto error_out;
+		}
+
+		error = system_fs_batch_chain(batch, &chain);
+		if (!error) {
+			error = system_fs_batch_set_account(batch, chain, iter->name, true);
+		}
+		if (!error) {
+			error = system_fs_batch_add(batch, chain, &(system_fs_op_t){.type = SYSTEM_FS_OP_REMOVE, .path = home_path_buffer, .uid = (uid_t) -1, .gid = (gid_t) -1});
+		}
+		if (error) {
+			goto error_out;
+		}
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	system_authentication_skel_free(skel, skel_count);
+
+	return error;
+}
+
+static int system_authentication_skel_load(system_fs_op_t **files, size_t *count)
+{
+	int error = 0;
+	char skel_path_buffer[PATH_MAX] = {0};
+	char path_buffer[PATH_MAX] = {0};
+	DIR *dir = NULL;
+	struct dirent *dir_entry = NULL;
+	system_fs_op_t *skel = NULL;
+	system_fs_op_t *resized = NULL;
+	size_t skel_count = 0;
+	size_t capacity = 0;
+
+	if (system_root_path(skel_path_buffer, sizeof(skel_path_buffer), SYSTEM_AUTHENTICATION_SKEL_DIRECTORY)) {
+		goto error_out;
+	}
+
+	if ((dir = opendir(skel_path_buffer)) == NULL) {
+		SYSTEM_LOG_INF("Unable to open directory %s", skel_path_buffer);
+		goto error_out;
+	}
+
+	// files of /etc/skel as they are written into every home directory - the path is the name of the file, the source
+	// the file itself, which the journal records instead of the content
+	while ((dir_entry = readdir(dir)) != NULL) {
+		if (!strcmp(dir_entry->d_name, ".") || !strcmp(dir_entry->d_name, "..") || dir_entry->d_type == DT_DIR) {
+			continue;
+		}
+
+		if (skel_count == capacity) {
+			capacity = capacity ? capacity * 2 : 8;
+			resized = realloc(skel, capacity * sizeof(*skel));
+			if (!resized) {
+				goto error_out;
+			}
+			skel = resized;
+		}
+
+		if (snprintf(path_buffer, sizeof(path_buffer), "%s/%s", skel_path_buffer, dir_entry->d_name) >= (int) sizeof(path_buffer)) {
+			goto error_out;
+		}
+
+		skel[skel_count] = (system_fs_op_t){0};
+		error = system_authentication_skel_read_file(path_buffer, &skel[skel_count]);
+		if (!error) {
+			skel[skel_count].path = strdup(dir_entry->d_name);
+			skel[skel_count].source = strdup(path_buffer);
+			error = (skel[skel_count].path && skel[skel_count].source) ? 0 : -1;
+		}
+		skel_count++;
+
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to read %s", path_buffer);
+			goto error_out;
+		}
+	}
+
+	*files = skel;
+	*count = skel_count;
+
+	goto out;
+
+error_out:
+	error = -1;
+
+	system_authentication_skel_free(skel, skel_count);
+
+out:
+	if (dir) {
+		closedir(dir);
+	}
+
+	return error;
+}
+
+static int system_authentication_skel_read_file(const char *path, system_fs_op_t *file)
+{
+	FILE *source = NULL;
+	struct stat st = {0};
+
+	source = fopen(path, "re");
+	if (!source) {
+		return -1;
+	}
+
+	if (fstat(fileno(source), &st) != 0) {
+		fclose(source);
+		return -1;
+	}
+
+	file->size = (size_t) st.st_size;
+	file->mode = st.st_mode & 07777;
+
+	if (file->size) {
+		file->data = malloc(file->size);
+		if (!file->data || fread(file->data, 1, file->size, source) != file->size) {
+			fclose(source);
+			return -1;
+		}
+	}
+
+	fclose(source);
+
+	return 0;
+}
+
+static void system_authentication_skel_free(system_fs_op_t *files, size_t count)
+{
+	for (size_t i = 0; i < count; i++) {
+		free(files[i].path);
+		free(files[i].data);
+		free(files[i].source);
+	}
+
+	free(files);
+}
+
+static bool system_authentication_txn_name_valid(const char *username)
+{
+	// the name is a component of the home directory path - /home itself or anything outside of it is never used
+	if (!*username || strchr(username, '/') || !strcmp(username, ".") || !strcmp(username, "..")) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "User name %s can not name a home directory", username);
+		return false;
+	}
+
+	return true;
+}
+
+static int system_authentication_txn_home_path(char *buffer, size_t size, const char *username)
+{
+	char home_path_buffer[PATH_MAX] = {0};
+
+	if (snprintf(home_path_buffer, sizeof(home_path_buffer), "/home/%s", username) >= (int) sizeof(home_path_buffer)) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() failed");
+		return -1;
+	}
+
+	return system_root_path(buffer, size, home_path_buffer);
+}
+
+static void system_authentication_txn_account_bytes(void)
+{
+	// umgmt rewrites the account files as a whole
+	const char *paths[] = {
+		SYSTEM_AUTHENTICATION_PASSWD_PATH,
+		SYSTEM_AUTHENTICATION_SHADOW_PATH,
+		SYSTEM_AUTHENTICATION_GROUP_PATH,
+	};
+	struct stat st = {0};
+
+	for (size_t i = 0; i < ARRAY_SIZE(paths); i++) {
+		if (stat(paths[i], &st) == 0) {
+			system_stats_add_bytes((size_t) st.st_size);
+		}
+	}
+}
+
+static int system_authentication_txn_set_user_password_hash(um_user_t *user, const char *password)
+{
+	int error = 0;
+	char *hash = NULL;
+
+	// startup data applied to the system never went through the SR_EV_UPDATE hashing - cleartext is not stored as is
+	if (system_authentication_password_is_cleartext(password)) {
+		error = system_authentication_password_hash(password + sizeof(SYSTEM_AUTHENTICATION_PASSWORD_CLEARTEXT_PREFIX) - 1, &hash);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_password_hash() error (%d)", error);
+			return -1;
+		}
+
+		password = hash;
+	}
+
+	error = um_user_set_password_hash(user, password);
+	free(hash);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "um_user_set_password_hash() error (%d)", error);
+		return -1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,76 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_API_AUTHENTICATION_TXN_H
+#define SYSTEM_PLUGIN_API_AUTHENTICATION_TXN_H
+
+#include "core/types.h"
+
+#include <stdbool.h>
+#include <sys/types.h>
+#include <uthash.h>
+#include <umgmt/types.h>
+
+typedef struct system_authentication_txn_name_s system_authentication_txn_name_t;
+typedef struct system_authentication_txn_user_s system_authentication_txn_user_t;
+
+struct system_authentication_txn_name_s {
+	const char *name;
+	UT_hash_handle hh;
+};
+
+struct system_authentication_txn_user_s {
+	char *name;
+	uid_t uid;
+	gid_t gid;
+	UT_hash_handle hh;
+	system_authentication_txn_user_t *next;
+};
+
+/**
+ * Account database transaction of the umgmt accounts backend.
+ *
+ * Created users, password changes and deleted users are collected against a single loaded umgmt database which is
+ * written once on commit. Home directories are created and removed only after the database has been stored. umgmt
+ * knows only the account files of /etc, so a commit with changes fails while a separate root is set.
+ */
+struct system_authentication_txn_s {
+	um_db_t *db;
+	system_id_allocator_t uid_allocator;
+	system_id_allocator_t gid_allocator;
+
+	// users found in the database when the transaction began
+	system_authentication_txn_name_t *names;
+	system_authentication_txn_name_t *name_entries;
+
+	// users created in this transaction - kept both as a list and as a hash by name
+	system_authentication_txn_user_t *created;
+	system_authentication_txn_user_t *created_set;
+
+	// users deleted in this transaction - their home directories are removed after commit
+	system_authentication_txn_user_t *deleted;
+
+	// database has changes which need to be stored
+	bool dirty;
+};
+
+extern const system_accounts_backend_t system_accounts_umgmt_backend;
+
+int system_authentication_txn_load_users(system_local_user_element_t **head);
+int system_authentication_txn_begin(system_authentication_txn_t *txn);
+int system_authentication_txn_add_user(system_authentication_txn_t *txn, const char *username, const char *password);
+int system_authentication_txn_set_password(system_authentication_txn_t *txn, const char *username, const char *password);
+int system_authentication_txn_delete_user(system_authentication_txn_t *txn, const char *username);
+int system_authentication_txn_commit(system_authentication_txn_t *txn);
+void system_authentication_txn_free(system_authentication_txn_t *txn);
+
+#endif // SYSTEM_PLUGIN_API_AUTHENTICATION_TXN_H
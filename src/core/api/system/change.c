@@ -13,8 +13,11 @@
 #include "change.h"
 #include "load.h"
 #include "store.h"
+#include "core/root.h"
+#include "core/log.h"
 
 #include <unistd.h>
+#include <linux/limits.h>
 
 #include <sysrepo.h>
 #include <srpc.h>
@@ -45,7 +48,7 @@ int system_change_contact(void *priv, sr_session_ctx_t *session, const srpc_chan
 
 	assert(strcmp(node_name, "contact") == 0);
 
-	SRPLG_LOG_DBG(PLUGIN_NAME, "Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
+	SYSTEM_LOG_DBG("Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
 
 	switch (change_ctx->operation) {
 		case SR_OP_CREATED:
@@ -84,7 +87,7 @@ int system_change_hostname(void *priv, sr_session_ctx_t *session, const srpc_cha
 
 	assert(strcmp(node_name, "hostname") == 0);
 
-	SRPLG_LOG_DBG(PLUGIN_NAME, "Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
+	SYSTEM_LOG_DBG("Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
 
 	switch (change_ctx->operation) {
 		case SR_OP_CREATED:
@@ -123,7 +126,7 @@ int system_change_location(void *priv, sr_session_ctx_t *session, const srpc_cha
 
 	assert(strcmp(node_name, "location") == 0);
 
-	SRPLG_LOG_DBG(PLUGIN_NAME, "Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
+	SYSTEM_LOG_DBG("Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
 
 	switch (change_ctx->operation) {
 		case SR_OP_CREATED:
@@ -162,7 +165,7 @@ int system_change_timezone_name(void *priv, sr_session_ctx_t *session, const srp
 
 	assert(strcmp(node_name, "timezone-name") == 0);
 
-	SRPLG_LOG_DBG(PLUGIN_NAME, "Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
+	SYSTEM_LOG_DBG("Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
 
 	switch (change_ctx->operation) {
 		case SR_OP_CREATED:
@@ -285,14 +288,19 @@ static int system_change_timezone_name_delete(system_ctx_t *ctx)
 	(void) ctx;
 
 	int error = 0;
+	char localtime_path_buffer[PATH_MAX] = {0};
 
-	error = access(SYSTEM_LOCALTIME_FILE, F_OK);
+	if (system_root_path(localtime_path_buffer, sizeof(localtime_path_buffer), SYSTEM_LOCALTIME_FILE)) {
+		goto error_out;
+	}
+
+	error = access(localtime_path_buffer, F_OK);
 	if (error != 0) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "/etc/localtime doesn't exist");
+		SRPLG_LOG_ERR(PLUGIN_NAME, "%s doesn't exist", localtime_path_buffer);
 		goto error_out;
 	}
 
-	error = unlink(SYSTEM_LOCALTIME_FILE);
+	error = unlink(localtime_path_buffer);
 	if (error != 0) {
 		SRPLG_LOG_ERR(PLUGIN_NAME, "unlink() failed (%d)", error);
 		goto error_out;
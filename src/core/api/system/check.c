@@ -11,6 +11,7 @@
  * SPDX-License-Identifier: BSD-3-Clause
  */
 #include "check.h"
+#include "core/stats.h"
 #include "load.h"
 
 #include <sysrepo.h>
@@ -21,6 +22,8 @@ srpc_check_status_t system_check_hostname(system_ctx_t *ctx, const char *hostnam
 	char hostname_buffer[SYSTEM_HOSTNAME_LENGTH_MAX] = {0};
 	int error = 0;
 
+	SYSTEM_STATS_BEGIN(SYSTEM_STATS_OP_CHECK_HOSTNAME);
+
 	error = system_load_hostname(ctx, hostname_buffer);
 	if (error) {
 		SRPLG_LOG_ERR(PLUGIN_NAME, "system_load_hostname() error (%d)", error);
@@ -40,6 +43,8 @@ error_out:
 	status = srpc_check_status_error;
 
 out:
+	SYSTEM_STATS_END(status == srpc_check_status_error);
+
 	return status;
 }
 
@@ -63,6 +68,8 @@ srpc_check_status_t system_check_timezone_name(system_ctx_t *ctx, const char *ti
 	char timezone_name_buffer[SYSTEM_TIMEZONE_NAME_LENGTH_MAX] = {0};
 	int error = 0;
 
+	SYSTEM_STATS_BEGIN(SYSTEM_STATS_OP_CHECK_TIMEZONE_NAME);
+
 	error = system_load_timezone_name(ctx, timezone_name_buffer);
 	if (error) {
 		SRPLG_LOG_ERR(PLUGIN_NAME, "system_load_timezone_name() error (%d)", error);
@@ -82,5 +89,7 @@ error_out:
 	status = srpc_check_status_error;
 
 out:
+	SYSTEM_STATS_END(status == srpc_check_status_error);
+
 	return status;
 }
\ No newline at end of file
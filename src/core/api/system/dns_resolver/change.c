@@ -18,6 +18,7 @@
 #include "sysrepo_types.h"
 #include "core/types.h"
 #include "core/common.h"
+#include "core/log.h"
 
 // data
 #include "core/data/system/dns_resolver/server/list.h"
@@ -33,14 +34,14 @@
 int system_dns_resolver_change_search(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx)
 {
 	int error = 0;
-	system_ctx_t *ctx = priv;
+	system_transaction_t *transaction = priv;
 	const char *node_name = LYD_NAME(change_ctx->node);
 	const char *node_value = lyd_get_value(change_ctx->node);
 	system_dns_search_t temp_search = {0};
 
 	assert(strcmp(node_name, "search") == 0);
 
-	SRPLG_LOG_DBG(PLUGIN_NAME, "Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
+	SYSTEM_LOG_DBG("Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
 
 	system_dns_search_init(&temp_search);
 	system_dns_search_set_search(&temp_search, false);
@@ -55,7 +56,7 @@ int system_dns_resolver_change_search(void *priv, sr_session_ctx_t *session, con
 			}
 
 			// add to the list
-			error = system_dns_search_list_add(&ctx->temp_dns_search, temp_search);
+			error = system_dns_search_list_add(&transaction->dns_search, temp_search);
 			if (error) {
 				SRPLG_LOG_ERR(PLUGIN_NAME, "system_dns_search_list_add() error (%d)", error);
 				goto error_out;
@@ -65,7 +66,7 @@ int system_dns_resolver_change_search(void *priv, sr_session_ctx_t *session, con
 			// not supported - cannot modify leaf-list element, it can be only created and deleted
 			break;
 		case SR_OP_DELETED:
-			error = system_dns_search_list_remove(&ctx->temp_dns_search, node_value);
+			error = system_dns_search_list_remove(&transaction->dns_search, node_value);
 			if (error) {
 				SRPLG_LOG_ERR(PLUGIN_NAME, "system_dns_search_list_remove() error (%d)", error);
 				goto error_out;
@@ -93,7 +94,7 @@ int system_dns_resolver_change_server_name(void *priv, sr_session_ctx_t *session
 
 	assert(strcmp(node_name, "name") == 0);
 
-	SRPLG_LOG_DBG(PLUGIN_NAME, "Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
+	SYSTEM_LOG_DBG("Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
 
 	switch (change_ctx->operation) {
 		case SR_OP_CREATED:
@@ -112,7 +113,7 @@ int system_dns_resolver_change_server_name(void *priv, sr_session_ctx_t *session
 int system_dns_resolver_change_server_address(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx)
 {
 	int error = 0;
-	system_ctx_t *ctx = priv;
+	system_transaction_t *transaction = priv;
 	const char *node_name = LYD_NAME(change_ctx->node);
 	const char *node_value = lyd_get_value(change_ctx->node);
 	system_dns_server_t temp_server = {0};
@@ -123,7 +124,7 @@ int system_dns_resolver_change_server_address(void *priv, sr_session_ctx_t *sess
 
 	assert(strcmp(node_name, "address") == 0);
 
-	SRPLG_LOG_DBG(PLUGIN_NAME, "Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
+	SYSTEM_LOG_DBG("Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
 
 	// parse address to internal struct
 	error = system_ip_address_from_str(&temp_addr, node_value);
@@ -149,7 +150,7 @@ int system_dns_resolver_change_server_address(void *priv, sr_session_ctx_t *sess
 			}
 
 			// add to the list
-			error = system_dns_server_list_add(&ctx->temp_dns_servers, temp_server);
+			error = system_dns_server_list_add(&transaction->dns_servers, temp_server);
 			if (error) {
 				SRPLG_LOG_ERR(PLUGIN_NAME, "system_dns_server_list_add() error (%d)", error);
 				goto error_out;
@@ -157,7 +158,7 @@ int system_dns_resolver_change_server_address(void *priv, sr_session_ctx_t *sess
 			break;
 		case SR_OP_MODIFIED:
 			// get existing and modify
-			found_server_el = system_dns_server_list_find(ctx->temp_dns_servers, change_ctx->previous_value);
+			found_server_el = system_dns_server_list_find(transaction->dns_servers, change_ctx->previous_value);
 			if (!found_server_el) {
 				SRPLG_LOG_ERR(PLUGIN_NAME, "system_dns_server_list_find() error (%d)", error);
 				goto error_out;
@@ -179,7 +180,7 @@ int system_dns_resolver_change_server_address(void *priv, sr_session_ctx_t *sess
 			break;
 		case SR_OP_DELETED:
 			// remove element from the list
-			error = system_dns_server_list_remove(&ctx->temp_dns_servers, node_value);
+			error = system_dns_server_list_remove(&transaction->dns_servers, node_value);
 			if (error) {
 				SRPLG_LOG_ERR(PLUGIN_NAME, "system_dns_server_list_remove() error (%d)", error);
 				goto error_out;
@@ -207,7 +208,7 @@ int system_dns_resolver_change_server_port(void *priv, sr_session_ctx_t *session
 
 	assert(strcmp(node_name, "port") == 0);
 
-	SRPLG_LOG_DBG(PLUGIN_NAME, "Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
+	SYSTEM_LOG_DBG("Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
 
 	switch (change_ctx->operation) {
 		case SR_OP_CREATED:
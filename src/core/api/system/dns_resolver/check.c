@@ -15,6 +15,7 @@
 #include "srpc/types.h"
 #include "core/types.h"
 #include "core/common.h"
+#include "core/stats.h"
 #include "core/data/system/dns_resolver/search/list.h"
 #include "core/data/system/dns_resolver/server/list.h"
 
@@ -31,6 +32,8 @@ srpc_check_status_t system_dns_resolver_check_search(system_ctx_t *ctx, system_d
 
 	system_dns_search_element_t *system_search_head = NULL, *search_el = NULL, *found_el = NULL;
 
+	SYSTEM_STATS_BEGIN(SYSTEM_STATS_OP_CHECK_DNS_RESOLVER_SEARCH);
+
 	error = system_dns_resolver_load_search(ctx, &system_search_head);
 	if (error) {
 		SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to load current dns-resolver search leaf-list from the system");
@@ -69,6 +72,8 @@ out:
 	// release memory
 	system_dns_search_list_free(&system_search_head);
 
+	SYSTEM_STATS_END(status == srpc_check_status_error);
+
 	return status;
 }
 
@@ -81,6 +86,8 @@ srpc_check_status_t system_dns_resolver_check_server(system_ctx_t *ctx, system_d
 
 	system_dns_server_element_t *system_server_head = NULL, *server_el = NULL, *found_el = NULL;
 
+	SYSTEM_STATS_BEGIN(SYSTEM_STATS_OP_CHECK_DNS_RESOLVER_SERVER);
+
 	error = system_dns_resolver_load_server(ctx, &system_server_head);
 	if (error) {
 		SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to load current dns-resolver server list from the system");
@@ -119,5 +126,7 @@ out:
 	// release memory
 	system_dns_server_list_free(&system_server_head);
 
+	SYSTEM_STATS_END(status == srpc_check_status_error);
+
 	return status;
 }
@@ -0,0 +1,314 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "resolv_conf.h"
+#include "core/common.h"
+#include "core/fs_batch.h"
+#include "core/log.h"
+#include "core/root.h"
+#include "core/stats.h"
+
+// data
+#include "core/data/system/dns_resolver/server.h"
+#include "core/data/system/dns_resolver/server/list.h"
+#include "core/data/system/dns_resolver/search/list.h"
+#include "core/data/system/ip_address.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <linux/limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sysrepo.h>
+
+#include <utlist.h>
+
+// glibc uses only the first MAXNS servers
+#define SYSTEM_RESOLV_CONF_SERVERS_MAX 3
+
+static int system_dns_resolver_resolv_conf_load(system_dns_search_element_t **search_head, system_dns_server_element_t **server_head);
+static int system_dns_resolver_resolv_conf_replace(const char *keyword, const char *alias, const char *lines);
+static char *system_dns_resolver_resolv_conf_keyword(char *line, const char *keyword);
+
+const system_dns_resolver_backend_t system_dns_resolver_resolv_conf_backend = {
+	.name = "resolv.conf",
+	.source_file = SYSTEM_RESOLV_CONF_FILE,
+	.source_rooted = true,
+	.probe = NULL,
+	.load_search = system_dns_resolver_resolv_conf_load_search,
+	.load_server = system_dns_resolver_resolv_conf_load_server,
+	.store_search = system_dns_resolver_resolv_conf_store_search,
+	.store_server = system_dns_resolver_resolv_conf_store_server,
+};
+
+int system_dns_resolver_resolv_conf_load_search(system_dns_search_element_t **head)
+{
+	return system_dns_resolver_resolv_conf_load(head, NULL);
+}
+
+int system_dns_resolver_resolv_conf_load_server(system_dns_server_element_t **head)
+{
+	return system_dns_resolver_resolv_conf_load(NULL, head);
+}
+
+int system_dns_resolver_resolv_conf_store_search(system_dns_search_element_t *head)
+{
+	int error = 0;
+	system_dns_search_element_t *iter = NULL;
+	char *lines = NULL;
+	size_t lines_size = 0;
+	FILE *stream = NULL;
+
+	stream = open_memstream(&lines, &lines_size);
+	if (!stream) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "open_memstream() failed");
+		return -1;
+	}
+
+	// all domains on one line - a later search or domain line would replace it
+	if (head) {
+		fputs("search", stream);
+		LL_FOREACH(head, iter)
+		{
+			fprintf(stream, " %s", iter->search.domain);
+		}
+		fputc('\n', stream);
+	}
+
+	if (fclose(stream)) {
+		free(lines);
+		return -1;
+	}
+
+	error = system_dns_resolver_resolv_conf_replace("search", "domain", lines);
+
+	free(lines);
+
+	return error;
+}
+
+int system_dns_resolver_resolv_conf_store_server(system_dns_server_element_t *head)
+{
+	int error = 0;
+	system_dns_server_element_t *iter = NULL;
+	char address_buffer[INET6_ADDRSTRLEN] = {0};
+	char *lines = NULL;
+	size_t lines_size = 0;
+	size_t count = 0;
+	FILE *stream = NULL;
+
+	stream = open_memstream(&lines, &lines_size);
+	if (!stream) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "open_memstream() failed");
+		return -1;
+	}
+
+	LL_FOREACH(head, iter)
+	{
+		error = system_ip_address_to_str(&iter->server.address, address_buffer, sizeof(address_buffer));
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_ip_address_to_str() error (%d) for server %s", error, iter->server.name);
+			fclose(stream);
+			free(lines);
+			return -1;
+		}
+
+		fprintf(stream, "nameserver %s\n", address_buffer);
+		count++;
+	}
+
+	if (fclose(stream)) {
+		free(lines);
+		return -1;
+	}
+
+	if (count > SYSTEM_RESOLV_CONF_SERVERS_MAX) {
+		SRPLG_LOG_WRN(PLUGIN_NAME, "%zu DNS servers configured - the resolver uses only the first %d", count, SYSTEM_RESOLV_CONF_SERVERS_MAX);
+	}
+
+	error = system_dns_resolver_resolv_conf_replace("nameserver", NULL, lines);
+
+	free(lines);
+
+	return error;
+}
+
+static int system_dns_resolver_resolv_conf_load(system_dns_search_element_t **search_head, system_dns_server_element_t **server_head)
+{
+	int error = 0;
+	char path_buffer[PATH_MAX] = {0};
+	FILE *file = NULL;
+	char *line = NULL;
+	size_t line_size = 0;
+	char *value = NULL;
+	char *save_ptr = NULL;
+	system_dns_search_t search = {0};
+	system_dns_server_t server = {0};
+
+	if (system_root_path(path_buffer, sizeof(path_buffer), SYSTEM_RESOLV_CONF_FILE)) {
+		goto error_out;
+	}
+
+	// a system without the file uses the local resolver and no search domains
+	file = fopen(path_buffer, "re");
+	if (!file) {
+		if (errno == ENOENT) {
+			goto out;
+		}
+		SRPLG_LOG_ERR(PLUGIN_NAME, "fopen() failed (%d) for %s", errno, path_buffer);
+		goto error_out;
+	}
+
+	while (getline(&line, &line_size, file) != -1) {
+		if (search_head && ((value = system_dns_resolver_resolv_conf_keyword(line, "search")) || (value = system_dns_resolver_resolv_conf_keyword(line, "domain")))) {
+			// the last search or domain line is the one in effect
+			system_dns_search_list_free(search_head);
+
+			for (char *domain = strtok_r(value, " \t\r\n", &save_ptr); domain; domain = strtok_r(NULL, " \t\r\n", &save_ptr)) {
+				search = (system_dns_search_t){.domain = domain, .search = 1};
+				if (system_dns_search_list_add(search_head, search)) {
+					SRPLG_LOG_ERR(PLUGIN_NAME, "system_dns_search_list_add() failed");
+					goto error_out;
+				}
+			}
+		} else if (server_head && (value = system_dns_resolver_resolv_conf_keyword(line, "nameserver"))) {
+			char *address = strtok_r(value, " \t\r\n", &save_ptr);
+
+			// e.g. link-local addresses with a zone - they have no ietf-system representation
+			if (!address || system_ip_address_from_str(&server.address, address)) {
+				SYSTEM_LOG_DBG("Skipping nameserver %s", address ? address : "(none)");
+				continue;
+			}
+
+			// servers are named by their address, as with resolved
+			server.name = address;
+			if (system_dns_server_list_add(server_head, server)) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "system_dns_server_list_add() failed");
+				goto error_out;
+			}
+			server = (system_dns_server_t){0};
+		}
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	if (file) {
+		fclose(file);
+	}
+
+	free(line);
+
+	return error;
+}
+
+static int system_dns_resolver_resolv_conf_replace(const char *keyword, const char *alias, const char *lines)
+{
+	int error = 0;
+	char path_buffer[PATH_MAX] = {0};
+	FILE *file = NULL;
+	FILE *stream = NULL;
+	char *line = NULL;
+	size_t line_size = 0;
+	char *data = NULL;
+	size_t size = 0;
+	bool replaced = false;
+
+	if (system_root_path(path_buffer, sizeof(path_buffer), SYSTEM_RESOLV_CONF_FILE)) {
+		goto error_out;
+	}
+
+	stream = open_memstream(&data, &size);
+	if (!stream) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "open_memstream() failed");
+		goto error_out;
+	}
+
+	file = fopen(path_buffer, "re");
+	if (!file && errno != ENOENT) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "fopen() failed (%d) for %s", errno, path_buffer);
+		goto error_out;
+	}
+
+	// the other lines (comments, options, sortlist) are kept - the new lines take the place of the first old one
+	while (file && getline(&line, &line_size, file) != -1) {
+		if (system_dns_resolver_resolv_conf_keyword(line, keyword) || (alias && system_dns_resolver_resolv_conf_keyword(line, alias))) {
+			if (!replaced) {
+				fputs(lines, stream);
+				replaced = true;
+			}
+			continue;
+		}
+
+		fputs(line, stream);
+	}
+
+	if (!replaced) {
+		// the last line may lack its newline
+		fflush(stream);
+		if (size && data[size - 1] != '\n') {
+			fputc('\n', stream);
+		}
+		fputs(lines, stream);
+	}
+
+	if (fclose(stream)) {
+		stream = NULL;
+		goto error_out;
+	}
+	stream = NULL;
+
+	// readers never see a partially written file
+	error = system_fs_write_file_atomic(path_buffer, data, size, 0644, (uid_t) -1, (gid_t) -1);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_fs_write_file_atomic() failed for %s", path_buffer);
+		goto error_out;
+	}
+
+	system_stats_add_bytes(size);
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	if (stream) {
+		fclose(stream);
+	}
+
+	if (file) {
+		fclose(file);
+	}
+
+	free(line);
+	free(data);
+
+	return error;
+}
+
+static char *system_dns_resolver_resolv_conf_keyword(char *line, const char *keyword)
+{
+	const size_t length = strlen(keyword);
+
+	// the keyword starts the line and is followed by white space
+	if (strncmp(line, keyword, length) || (line[length] != ' ' && line[length] != '\t')) {
+		return NULL;
+	}
+
+	return line + length;
+}
@@ -0,0 +1,29 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_API_DNS_RESOLVER_RESOLV_CONF_H
+#define SYSTEM_PLUGIN_API_DNS_RESOLVER_RESOLV_CONF_H
+
+#include "core/types.h"
+
+/**
+ * DNS resolver backend of /etc/resolv.conf - search domains are kept on one search line and servers on nameserver
+ * lines, all other lines of the file are left as they are. Always available.
+ */
+extern const system_dns_resolver_backend_t system_dns_resolver_resolv_conf_backend;
+
+int system_dns_resolver_resolv_conf_load_search(system_dns_search_element_t **head);
+int system_dns_resolver_resolv_conf_load_server(system_dns_server_element_t **head);
+int system_dns_resolver_resolv_conf_store_search(system_dns_search_element_t *head);
+int system_dns_resolver_resolv_conf_store_server(system_dns_server_element_t *head);
+
+#endif // SYSTEM_PLUGIN_API_DNS_RESOLVER_RESOLV_CONF_H
@@ -0,0 +1,460 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "resolved.h"
+#include "core/common.h"
+#include "core/backend.h"
+#include "core/log.h"
+#include "core/trace.h"
+
+#ifdef SYSTEMD
+
+// data
+#include "core/data/system/dns_resolver/server.h"
+#include "core/data/system/dns_resolver/server/list.h"
+#include "core/data/system/dns_resolver/search/list.h"
+#include "core/data/system/ip_address.h"
+
+#include <string.h>
+
+#include <systemd/sd-bus.h>
+
+#include <sysrepo.h>
+
+#include <utlist.h>
+
+const system_dns_resolver_backend_t system_dns_resolver_resolved_backend = {
+	.name = "resolved",
+	.source_file = SYSTEM_RESOLVED_RESOLV_CONF_FILE,
+	.source_rooted = false,
+	.probe = system_dns_resolver_resolved_probe,
+	.load_search = system_dns_resolver_resolved_load_search,
+	.load_server = system_dns_resolver_resolved_load_server,
+	.store_search = system_dns_resolver_resolved_store_search,
+	.store_server = system_dns_resolver_resolved_store_server,
+};
+
+bool system_dns_resolver_resolved_probe(void)
+{
+	return system_backend_bus_name_available(SYSTEM_RESOLVED_SERVICE);
+}
+
+int system_dns_resolver_resolved_load_search(system_dns_search_element_t **head)
+{
+	int error = 0;
+	system_dns_search_t tmp_search = {0};
+	int r;
+	sd_bus_message *msg = NULL;
+	sd_bus_error sdb_err = SD_BUS_ERROR_NULL;
+	sd_bus *bus = NULL;
+	int64_t trace_start = 0;
+
+	r = sd_bus_open_system(&bus);
+	if (r < 0) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Failed to open system bus: %s\n", strerror(-r));
+		error = -1;
+		goto invalid;
+	}
+
+	trace_start = system_trace_begin();
+	r = sd_bus_get_property(
+		bus,
+		SYSTEM_RESOLVED_SERVICE,
+		SYSTEM_RESOLVED_OBJECT_PATH,
+		SYSTEM_RESOLVED_MANAGER_INTERFACE,
+		"Domains",
+		&sdb_err,
+		&msg,
+		"a(isb)");
+	system_trace_end("sd_bus_get_property", "Domains", trace_start);
+
+	if (r < 0) {
+		error = -2;
+		goto invalid;
+	}
+
+	// message recieved -> enter msg and get needed info
+	r = sd_bus_message_enter_container(msg, 'a', "(isb)");
+	if (r < 0) {
+		error = -3;
+		goto invalid;
+	}
+
+	for (;;) {
+		r = sd_bus_message_enter_container(msg, 'r', "isb");
+		if (r < 0) {
+			error = -4;
+			goto invalid;
+		}
+
+		if (r == 0) {
+			// done with reading data
+			break;
+		}
+
+		// read Domain struct
+		r = sd_bus_message_read(msg, "isb", &tmp_search.ifindex, &tmp_search.domain, &tmp_search.search);
+		if (r < 0) {
+			error = -6;
+			goto invalid;
+		}
+
+		// leave Domain struct
+		r = sd_bus_message_exit_container(msg);
+		if (r < 0) {
+			error = -7;
+			goto invalid;
+		}
+
+		error = system_dns_search_list_add(head, tmp_search);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_dns_search_list_add() error (%d)", error);
+			error = -8;
+			goto invalid;
+		}
+	}
+
+	goto finish;
+
+invalid:
+	SRPLG_LOG_ERR(PLUGIN_NAME, "sd-bus failure (%d): %s", r, sdb_err.message);
+	// error = -1;
+
+finish:
+	sd_bus_message_unref(msg);
+	sd_bus_flush_close_unref(bus);
+
+	return error;
+}
+
+int system_dns_resolver_resolved_load_server(system_dns_server_element_t **head)
+{
+	int error = 0;
+	int r;
+	sd_bus_message *msg = NULL;
+	sd_bus_error sdb_err = SD_BUS_ERROR_NULL;
+	sd_bus *bus = NULL;
+	int tmp_ifindex = 0;
+	size_t tmp_length = 0;
+
+	char ip_buffer[46] = {0};
+
+	system_dns_server_t tmp_server = {0};
+	int64_t trace_start = 0;
+
+	r = sd_bus_open_system(&bus);
+	if (r < 0) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Failed to open system bus: %s\n", strerror(-r));
+		goto invalid;
+	}
+
+	trace_start = system_trace_begin();
+	r = sd_bus_get_property(
+		bus,
+		SYSTEM_RESOLVED_SERVICE,
+		SYSTEM_RESOLVED_OBJECT_PATH,
+		SYSTEM_RESOLVED_MANAGER_INTERFACE,
+		"DNS",
+		&sdb_err,
+		&msg,
+		"a(iiay)");
+	system_trace_end("sd_bus_get_property", "DNS", trace_start);
+
+	if (r < 0) {
+		goto invalid;
+	}
+
+	r = sd_bus_message_enter_container(msg, 'a', "(iiay)");
+	if (r < 0) {
+		goto invalid;
+	}
+
+	for (;;) {
+		const void *data;
+		r = sd_bus_message_enter_container(msg, 'r', "iiay");
+		if (r < 0) {
+			goto invalid;
+		}
+		if (r == 0) {
+			break;
+		}
+		r = sd_bus_message_read(msg, "ii", &tmp_ifindex, &tmp_server.address.family);
+		if (r < 0) {
+			goto invalid;
+		}
+
+		switch (tmp_server.address.family) {
+			case AF_INET:
+				r = sd_bus_message_read_array(msg, 'y', (const void **) &data, &tmp_length);
+				if (r >= 0) {
+					memcpy(tmp_server.address.value.v4, data, tmp_length);
+				}
+				break;
+			case AF_INET6:
+				r = sd_bus_message_read_array(msg, 'y', (const void **) &data, &tmp_length);
+				if (r >= 0) {
+					memcpy(tmp_server.address.value.v6, data, tmp_length);
+				}
+				break;
+			default:
+				// unknown address family -> for now abort
+				r = -1;
+				break;
+		}
+
+		if (r < 0) {
+			goto invalid;
+		}
+
+		r = sd_bus_message_exit_container(msg);
+		if (r < 0) {
+			goto invalid;
+		}
+
+		// setup name to be equal to the address -> convert IP to string
+		error = system_ip_address_to_str(&tmp_server.address, ip_buffer, sizeof(ip_buffer));
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_ip_address_to_str() error (%d)", error);
+			goto invalid;
+		}
+
+		// copy to the current server name
+		tmp_server.name = strdup(ip_buffer);
+
+		error = system_dns_server_list_add(head, tmp_server);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_dns_server_list_add() error (%d)", error);
+			goto invalid;
+		}
+
+		// free temp server
+		system_dns_server_free(&tmp_server);
+	}
+
+	goto finish;
+
+invalid:
+	SRPLG_LOG_ERR(PLUGIN_NAME, "sd-bus failure (%d): %s", r, sdb_err.message);
+	error = -1;
+
+finish:
+	sd_bus_message_unref(msg);
+	sd_bus_flush_close_unref(bus);
+
+	return error;
+}
+
+int system_dns_resolver_resolved_store_search(system_dns_search_element_t *head)
+{
+	int error = 0;
+	system_dns_search_element_t *search_iter_el = NULL;
+	int r;
+	sd_bus_error sdb_err = SD_BUS_ERROR_NULL;
+	sd_bus_message *msg = NULL;
+	sd_bus_message *reply = NULL;
+	sd_bus *bus = NULL;
+	int64_t trace_start = 0;
+
+	r = sd_bus_open_system(&bus);
+	if (r < 0) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Failed to open system bus: %s\n", strerror(-r));
+		goto invalid;
+	}
+
+	r = sd_bus_message_new_method_call(
+		bus,
+		&msg,
+		SYSTEM_RESOLVED_SERVICE,
+		SYSTEM_RESOLVED_OBJECT_PATH,
+		SYSTEM_RESOLVED_MANAGER_INTERFACE,
+		"SetLinkDomains");
+	if (r < 0) {
+		goto invalid;
+	}
+
+	// set ifindex to the first value in the list
+	r = sd_bus_message_append(msg, "i", SYSTEMD_IFINDEX);
+	if (r < 0) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sd_bus_message_append() error");
+		goto invalid;
+	}
+
+	r = sd_bus_message_open_container(msg, 'a', "(sb)");
+	if (r < 0) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sd_bus_message_open_container() error");
+		goto invalid;
+	}
+
+	LL_FOREACH(head, search_iter_el)
+	{
+		r = sd_bus_message_append(msg, "(sb)", search_iter_el->search.domain, search_iter_el->search.search);
+		if (r < 0) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "sd_bus_message_append() error");
+			goto invalid;
+		}
+	}
+
+	r = sd_bus_message_close_container(msg);
+	if (r < 0) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sd_bus_message_close_container() error");
+		goto invalid;
+	}
+
+	trace_start = system_trace_begin();
+	r = sd_bus_call(bus, msg, 0, &sdb_err, &reply);
+	system_trace_end("sd_bus_call", sd_bus_message_get_member(msg), trace_start);
+	if (r < 0) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sd_bus_call() error");
+		goto invalid;
+	}
+
+	// SRP_LOG_INF("Set domains successfully!");
+	goto finish;
+
+invalid:
+	SRPLG_LOG_ERR(PLUGIN_NAME, "sd-bus failure (%d): %s", r, sdb_err.message);
+	error = -1;
+
+finish:
+	sd_bus_message_unref(msg);
+	sd_bus_message_unref(reply);
+	sd_bus_flush_close_unref(bus);
+
+	return error;
+}
+
+int system_dns_resolver_resolved_store_server(system_dns_server_element_t *head)
+{
+	int error = 0;
+	system_dns_server_element_t *server_iter_el = NULL;
+	int r;
+	sd_bus_error sdb_err = SD_BUS_ERROR_NULL;
+	sd_bus_message *msg = NULL;
+	sd_bus_message *reply = NULL;
+	sd_bus *bus = NULL;
+	int64_t trace_start = 0;
+
+	r = sd_bus_open_system(&bus);
+	if (r < 0) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Failed to open system bus: %s\n", strerror(-r));
+		goto invalid;
+	}
+
+	r = sd_bus_message_new_method_call(
+		bus,
+		&msg,
+		SYSTEM_RESOLVED_SERVICE,
+		SYSTEM_RESOLVED_OBJECT_PATH,
+		SYSTEM_RESOLVED_MANAGER_INTERFACE,
+		"SetLinkDNS");
+	if (r < 0) {
+		goto invalid;
+	}
+
+	r = sd_bus_message_append(msg, "i", SYSTEMD_IFINDEX);
+	if (r < 0) {
+		goto invalid;
+	}
+
+	// enter array of structs
+	r = sd_bus_message_open_container(msg, 'a', "(iay)");
+	if (r < 0) {
+		goto invalid;
+	}
+
+	LL_FOREACH(head, server_iter_el)
+	{
+		system_dns_server_t *server = &server_iter_el->server;
+
+		// enter a struct first
+		r = sd_bus_message_open_container(msg, 'r', "iay");
+		if (r < 0) {
+			goto invalid;
+		}
+
+		// set address family
+		r = sd_bus_message_append(msg, "i", server->address.family);
+		if (r < 0) {
+			goto invalid;
+		}
+
+		// enter array of bytes for an address
+		r = sd_bus_message_open_container(msg, 'a', "y");
+		if (r < 0) {
+			goto invalid;
+		}
+
+		// append address bytes accordingly with address family
+		switch (server->address.family) {
+			case AF_INET:
+				for (unsigned char j = 0; j < ARRAY_SIZE(server->address.value.v4); j++) {
+					r = sd_bus_message_append(msg, "y", server->address.value.v4[j]);
+					if (r < 0) {
+						goto invalid;
+					}
+				}
+				break;
+			case AF_INET6:
+				for (unsigned char j = 0; j < ARRAY_SIZE(server->address.value.v6); j++) {
+					r = sd_bus_message_append(msg, "y", server->address.value.v6[j]);
+					if (r < 0) {
+						goto invalid;
+					}
+				}
+				break;
+			default:
+				break;
+		}
+
+		// exit array
+		r = sd_bus_message_close_container(msg);
+		if (r < 0) {
+			goto invalid;
+		}
+
+		// exit struct
+		r = sd_bus_message_close_container(msg);
+		if (r < 0) {
+			goto invalid;
+		}
+	}
+
+	// exit array of structs
+	r = sd_bus_message_close_container(msg);
+	if (r < 0) {
+		goto invalid;
+	}
+
+	// finally call created method
+	trace_start = system_trace_begin();
+	r = sd_bus_call(bus, msg, 0, &sdb_err, &reply);
+	system_trace_end("sd_bus_call", sd_bus_message_get_member(msg), trace_start);
+	if (r < 0) {
+		goto invalid;
+	}
+
+	SYSTEM_LOG_INF("Set DNS servers successfully.");
+	goto finish;
+
+invalid:
+	SRPLG_LOG_ERR(PLUGIN_NAME, "sd-bus failure (%d): %s", r, sdb_err.message);
+	error = -1;
+
+finish:
+	sd_bus_message_unref(msg);
+	sd_bus_message_unref(reply);
+	sd_bus_flush_close_unref(bus);
+
+	return error;
+}
+
+#endif
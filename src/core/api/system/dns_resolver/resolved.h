@@ -0,0 +1,30 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_API_DNS_RESOLVER_RESOLVED_H
+#define SYSTEM_PLUGIN_API_DNS_RESOLVER_RESOLVED_H
+
+#include "core/types.h"
+
+/**
+ * DNS resolver backend of systemd-resolved - search domains and servers of the SYSTEMD_IFINDEX link over D-Bus.
+ * Compiled in with SYSTEMD only.
+ */
+extern const system_dns_resolver_backend_t system_dns_resolver_resolved_backend;
+
+bool system_dns_resolver_resolved_probe(void);
+int system_dns_resolver_resolved_load_search(system_dns_search_element_t **head);
+int system_dns_resolver_resolved_load_server(system_dns_server_element_t **head);
+int system_dns_resolver_resolved_store_search(system_dns_search_element_t *head);
+int system_dns_resolver_resolved_store_server(system_dns_server_element_t *head);
+
+#endif // SYSTEM_PLUGIN_API_DNS_RESOLVER_RESOLVED_H
@@ -0,0 +1,158 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "hostnamed.h"
+#include "core/common.h"
+#include "core/backend.h"
+#include "core/trace.h"
+
+#ifdef SYSTEMD
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <systemd/sd-bus.h>
+
+#include <sysrepo.h>
+
+static int system_hostname_hostnamed_get(sd_bus *bus, const char *property, char **value);
+static int system_hostname_hostnamed_set(sd_bus *bus, const char *method, const char *hostname);
+
+const system_hostname_backend_t system_hostname_hostnamed_backend = {
+	.name = "hostnamed",
+	.probe = system_hostname_hostnamed_probe,
+	.load = system_hostname_hostnamed_load,
+	.store = system_hostname_hostnamed_store,
+};
+
+bool system_hostname_hostnamed_probe(void)
+{
+	return system_backend_bus_name_available(SYSTEM_HOSTNAMED_SERVICE);
+}
+
+int system_hostname_hostnamed_load(char *buffer, size_t size)
+{
+	int error = 0;
+	int r;
+	sd_bus *bus = NULL;
+	char *hostname = NULL;
+
+	r = sd_bus_open_system(&bus);
+	if (r < 0) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Failed to open system bus: %s", strerror(-r));
+		goto error_out;
+	}
+
+	// the static hostname is the configured one - it is empty when only a transient name was given
+	if (system_hostname_hostnamed_get(bus, "StaticHostname", &hostname)) {
+		goto error_out;
+	}
+
+	if (!hostname[0]) {
+		free(hostname);
+		hostname = NULL;
+
+		if (system_hostname_hostnamed_get(bus, "Hostname", &hostname)) {
+			goto error_out;
+		}
+	}
+
+	if (strlen(hostname) >= size) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Hostname %s is too long", hostname);
+		goto error_out;
+	}
+
+	strcpy(buffer, hostname);
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	free(hostname);
+	sd_bus_flush_close_unref(bus);
+
+	return error;
+}
+
+int system_hostname_hostnamed_store(const char *hostname)
+{
+	int error = 0;
+	int r;
+	sd_bus *bus = NULL;
+
+	r = sd_bus_open_system(&bus);
+	if (r < 0) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Failed to open system bus: %s", strerror(-r));
+		goto error_out;
+	}
+
+	// hostnamed writes the static hostname to /etc/hostname - the transient one is set on the kernel
+	if (system_hostname_hostnamed_set(bus, "SetStaticHostname", hostname) || system_hostname_hostnamed_set(bus, "SetHostname", hostname)) {
+		goto error_out;
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	sd_bus_flush_close_unref(bus);
+
+	return error;
+}
+
+static int system_hostname_hostnamed_get(sd_bus *bus, const char *property, char **value)
+{
+	int r;
+	sd_bus_error sdb_err = SD_BUS_ERROR_NULL;
+	int64_t trace_start = 0;
+
+	trace_start = system_trace_begin();
+	r = sd_bus_get_property_string(bus, SYSTEM_HOSTNAMED_SERVICE, SYSTEM_HOSTNAMED_OBJECT_PATH, SYSTEM_HOSTNAMED_INTERFACE, property, &sdb_err, value);
+	system_trace_end("sd_bus_get_property", property, trace_start);
+
+	if (r < 0) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sd-bus failure (%d): %s", r, sdb_err.message);
+		sd_bus_error_free(&sdb_err);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int system_hostname_hostnamed_set(sd_bus *bus, const char *method, const char *hostname)
+{
+	int r;
+	sd_bus_error sdb_err = SD_BUS_ERROR_NULL;
+	sd_bus_message *reply = NULL;
+	int64_t trace_start = 0;
+
+	// not interactive - polkit does not ask for authorization
+	trace_start = system_trace_begin();
+	r = sd_bus_call_method(bus, SYSTEM_HOSTNAMED_SERVICE, SYSTEM_HOSTNAMED_OBJECT_PATH, SYSTEM_HOSTNAMED_INTERFACE, method, &sdb_err, &reply, "sb", hostname, 0);
+	system_trace_end("sd_bus_call", method, trace_start);
+
+	sd_bus_message_unref(reply);
+
+	if (r < 0) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sd-bus failure (%d): %s", r, sdb_err.message);
+		sd_bus_error_free(&sdb_err);
+		return -1;
+	}
+
+	return 0;
+}
+
+#endif
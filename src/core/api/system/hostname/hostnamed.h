@@ -0,0 +1,28 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_API_HOSTNAME_HOSTNAMED_H
+#define SYSTEM_PLUGIN_API_HOSTNAME_HOSTNAMED_H
+
+#include "core/types.h"
+
+/**
+ * Hostname backend of systemd-hostnamed - the static hostname over D-Bus, which hostnamed also writes to
+ * /etc/hostname. Compiled in with SYSTEMD only.
+ */
+extern const system_hostname_backend_t system_hostname_hostnamed_backend;
+
+bool system_hostname_hostnamed_probe(void);
+int system_hostname_hostnamed_load(char *buffer, size_t size);
+int system_hostname_hostnamed_store(const char *hostname);
+
+#endif // SYSTEM_PLUGIN_API_HOSTNAME_HOSTNAMED_H
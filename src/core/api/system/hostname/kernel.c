@@ -0,0 +1,134 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "kernel.h"
+#include "core/common.h"
+#include "core/root.h"
+#include "core/stats.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/limits.h>
+
+#include <sysrepo.h>
+
+static int system_hostname_kernel_load_file(char *buffer, size_t size);
+static int system_hostname_kernel_store_file(const char *hostname);
+
+const system_hostname_backend_t system_hostname_kernel_backend = {
+	.name = "kernel",
+	.probe = NULL,
+	.load = system_hostname_kernel_load,
+	.store = system_hostname_kernel_store,
+};
+
+int system_hostname_kernel_load(char *buffer, size_t size)
+{
+	// the kernel hostname belongs to the live system - a separate root keeps it in its own file
+	if (system_root_active()) {
+		return system_hostname_kernel_load_file(buffer, size);
+	}
+
+	if (gethostname(buffer, size)) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "gethostname() failed");
+		return -1;
+	}
+
+	return 0;
+}
+
+int system_hostname_kernel_store(const char *hostname)
+{
+	if (system_root_active()) {
+		return system_hostname_kernel_store_file(hostname);
+	}
+
+	if (sethostname(hostname, strlen(hostname))) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sethostname() failed");
+		return -1;
+	}
+
+	return 0;
+}
+
+static int system_hostname_kernel_load_file(char *buffer, size_t size)
+{
+	int error = 0;
+	char path_buffer[PATH_MAX] = {0};
+	FILE *file = NULL;
+
+	if (system_root_path(path_buffer, sizeof(path_buffer), SYSTEM_HOSTNAME_FILE)) {
+		goto error_out;
+	}
+
+	file = fopen(path_buffer, "r");
+	if (!file) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "fopen() failed for %s", path_buffer);
+		goto error_out;
+	}
+
+	if (!fgets(buffer, (int) size, file)) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "fgets() failed for %s", path_buffer);
+		goto error_out;
+	}
+
+	buffer[strcspn(buffer, "\n")] = 0;
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	if (file) {
+		fclose(file);
+	}
+
+	return error;
+}
+
+static int system_hostname_kernel_store_file(const char *hostname)
+{
+	int error = 0;
+	char path_buffer[PATH_MAX] = {0};
+	FILE *file = NULL;
+
+	if (system_root_path(path_buffer, sizeof(path_buffer), SYSTEM_HOSTNAME_FILE)) {
+		goto error_out;
+	}
+
+	file = fopen(path_buffer, "w");
+	if (!file) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "fopen() failed for %s", path_buffer);
+		goto error_out;
+	}
+
+	if (fprintf(file, "%s\n", hostname) < 0) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "fprintf() failed for %s", path_buffer);
+		goto error_out;
+	}
+
+	system_stats_add_bytes(strlen(hostname) + 1);
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	if (file && fclose(file) != 0) {
+		error = -1;
+	}
+
+	return error;
+}
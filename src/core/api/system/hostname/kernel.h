@@ -0,0 +1,27 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_API_HOSTNAME_KERNEL_H
+#define SYSTEM_PLUGIN_API_HOSTNAME_KERNEL_H
+
+#include "core/types.h"
+
+/**
+ * Hostname backend of the kernel - gethostname() and sethostname() on the live system, SYSTEM_HOSTNAME_FILE under a
+ * separate root. Always available.
+ */
+extern const system_hostname_backend_t system_hostname_kernel_backend;
+
+int system_hostname_kernel_load(char *buffer, size_t size);
+int system_hostname_kernel_store(const char *hostname);
+
+#endif // SYSTEM_PLUGIN_API_HOSTNAME_KERNEL_H
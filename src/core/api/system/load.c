@@ -11,7 +11,11 @@
  * SPDX-License-Identifier: BSD-3-Clause
  */
 #include "load.h"
+#include "core/backend.h"
+#include "core/root.h"
+#include "core/stats.h"
 
+#include <stdio.h>
 #include <unistd.h>
 #include <linux/limits.h>
 
@@ -21,12 +25,13 @@ int system_load_hostname(system_ctx_t *ctx, char buffer[SYSTEM_HOSTNAME_LENGTH_M
 {
 	int error = 0;
 
-	error = gethostname(buffer, SYSTEM_HOSTNAME_LENGTH_MAX);
-	if (error) {
-		return -1;
-	}
+	SYSTEM_STATS_BEGIN(SYSTEM_STATS_OP_LOAD_HOSTNAME);
+
+	error = SYSTEM_HOSTNAME_BACKEND_CALL(load, buffer, SYSTEM_HOSTNAME_LENGTH_MAX);
+
+	SYSTEM_STATS_END(error != 0);
 
-	return 0;
+	return error;
 }
 
 int system_load_contact(system_ctx_t *ctx, char buffer[256])
@@ -46,11 +51,18 @@ int system_load_timezone_name(system_ctx_t *ctx, char buffer[SYSTEM_TIMEZONE_NAM
 	int error = 0;
 
 	char timezone_path_buffer[PATH_MAX] = {0};
+	char localtime_path_buffer[PATH_MAX] = {0};
 
 	ssize_t len = 0;
 	size_t start = 0;
 
-	len = readlink(SYSTEM_LOCALTIME_FILE, timezone_path_buffer, sizeof(timezone_path_buffer) - 1);
+	SYSTEM_STATS_BEGIN(SYSTEM_STATS_OP_LOAD_TIMEZONE_NAME);
+
+	if (system_root_path(localtime_path_buffer, sizeof(localtime_path_buffer), SYSTEM_LOCALTIME_FILE)) {
+		goto error_out;
+	}
+
+	len = readlink(localtime_path_buffer, timezone_path_buffer, sizeof(timezone_path_buffer) - 1);
 	if (len == -1) {
 		SRPLG_LOG_ERR(PLUGIN_NAME, "readlink() error");
 		goto error_out;
@@ -75,5 +87,7 @@ error_out:
 	error = -1;
 
 out:
+	SYSTEM_STATS_END(error != 0);
+
 	return error;
-}
\ No newline at end of file
+}
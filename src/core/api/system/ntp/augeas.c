@@ -0,0 +1,325 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "augeas.h"
+#include "core/common.h"
+#include "core/context.h"
+#include "core/log.h"
+#include "core/trace.h"
+#include "libyang/printer_data.h"
+#include "srpc/ly_tree.h"
+
+// data
+#include "core/data/system/ntp/server.h"
+#include "core/data/system/ntp/server/list.h"
+
+#include <assert.h>
+#include <string.h>
+#include <sysrepo.h>
+#include <srpc.h>
+#include <utlist.h>
+
+const system_ntp_backend_t system_ntp_augeas_backend = {
+	.name = "augeas",
+	.probe = NULL,
+	.load_server = system_ntp_augeas_load_server,
+	.store_server = system_ntp_augeas_store_server,
+};
+
+int system_ntp_augeas_load_server(system_ctx_t *ctx, system_ntp_server_element_t **head)
+{
+	int error = 0;
+
+	sr_data_t *subtree = NULL;
+
+	// temp values
+	system_ntp_server_t temp_server = {0};
+
+	// ntp config nodes
+	struct lyd_node *config_entry_node = NULL, *server_node = NULL, *peer_node = NULL, *pool_node = NULL, *chosen_node = NULL, *word_node = NULL;
+
+	// NTP server options (iburst and prefer)
+	struct lyd_node *options_entry_node = NULL, *iburst_node = NULL, *prefer_node = NULL;
+
+	// get ntp config startup data
+	pthread_mutex_lock(&ctx->startup_lock);
+	error = sr_get_subtree(ctx->startup_session, "/ntp:ntp[config-file=\'/etc/ntp.conf\']", 0, &subtree);
+	pthread_mutex_unlock(&ctx->startup_lock);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_get_subtree() error (%d): %s", error, sr_strerror(error));
+		goto error_out;
+	}
+
+	if (subtree) {
+		// iterate config file data and apply to startup DS
+		config_entry_node = srpc_ly_tree_get_child_list(subtree->tree, "config-entries");
+		while (config_entry_node) {
+			// entry can be either server, pool or peer
+			server_node = srpc_ly_tree_get_child_container(config_entry_node, "server");
+			pool_node = srpc_ly_tree_get_child_container(config_entry_node, "pool");
+			peer_node = srpc_ly_tree_get_child_container(config_entry_node, "peer");
+
+			if (server_node || pool_node || peer_node) {
+				system_ntp_server_init(&temp_server);
+
+				if (server_node) {
+					chosen_node = server_node;
+				} else if (pool_node) {
+					chosen_node = pool_node;
+				} else if (peer_node) {
+					chosen_node = peer_node;
+				}
+
+				word_node = srpc_ly_tree_get_child_leaf(chosen_node, "word");
+
+				assert(word_node != NULL);
+
+				error = system_ntp_server_set_word(&temp_server, lyd_get_value(word_node));
+				if (error) {
+					SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_server_set_word() error (%d)", error);
+					goto error_out;
+				}
+
+				error = system_ntp_server_set_association_type(&temp_server, LYD_NAME(chosen_node));
+				if (error) {
+					SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_server_set_association_type() error (%d)", error);
+					goto error_out;
+				}
+
+				options_entry_node = srpc_ly_tree_get_child_list(chosen_node, "config-entries");
+				if (options_entry_node) {
+					// iterate options and apply to the server node
+					while (options_entry_node) {
+						iburst_node = srpc_ly_tree_get_child_leaf(options_entry_node, "iburst");
+						prefer_node = srpc_ly_tree_get_child_leaf(options_entry_node, "prefer");
+
+						// iburst
+						if (iburst_node) {
+							error = system_ntp_server_set_iburst(&temp_server, "true");
+							if (error) {
+								SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_server_set_iburst() error (%d)", error);
+								goto error_out;
+							}
+						}
+
+						// prefer
+						if (prefer_node) {
+							error = system_ntp_server_set_prefer(&temp_server, "true");
+							if (error) {
+								SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_server_set_prefer() error (%d)", error);
+								goto error_out;
+							}
+						}
+						options_entry_node = srpc_ly_tree_get_list_next(options_entry_node);
+					}
+				}
+
+				// add the element to the list
+				error = system_ntp_server_list_add(head, temp_server);
+				if (error) {
+					SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_server_list_add() error (%d)", error);
+					goto error_out;
+				}
+
+				// free temporary server
+				system_ntp_server_free(&temp_server);
+			}
+			config_entry_node = srpc_ly_tree_get_list_next(config_entry_node);
+		}
+	}
+
+	goto out;
+error_out:
+	error = -1;
+
+out:
+	if (subtree) {
+		sr_release_data(subtree);
+	}
+
+	// free if load interrupted
+	system_ntp_server_free(&temp_server);
+
+	return error;
+}
+
+int system_ntp_augeas_store_server(system_ctx_t *ctx, system_ntp_server_element_t *head)
+{
+	int error = 0;
+
+	// config nodes
+	const struct ly_ctx *ly_ctx = NULL;
+	struct lyd_node *ntp_list_node = NULL, *config_entry_node = NULL, *server_node = NULL;
+	struct lyd_node *options_entry_node = NULL;
+	sr_conn_ctx_t *conn_ctx = NULL;
+	char id_buffer[100] = {0};
+	char full_address_buffer[100] = {0};
+
+	size_t id, option_id;
+	system_ntp_server_element_t *iter = NULL;
+	int64_t trace_start = 0;
+
+	conn_ctx = sr_session_get_connection(ctx->startup_session);
+	ly_ctx = sr_acquire_context(conn_ctx);
+	if (ly_ctx == NULL) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to get ly_ctx variable");
+		goto error_out;
+	}
+
+	error = srpc_ly_tree_create_list(ly_ctx, NULL, &ntp_list_node, "/ntp:ntp", "config-file", "/etc/ntp.conf");
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_ly_tree_create_list() error (%d)", error);
+	}
+
+	id = 1;
+	LL_FOREACH(head, iter)
+	{
+		SYSTEM_LOG_DBG("Adding NTP server %s", iter->server.name);
+
+		// 1. create config entry
+		SYSTEM_LOG_DBG("Creating new config-entries list node");
+		error = snprintf(id_buffer, sizeof(id_buffer), "%lu", id);
+		if (error < 0) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error (%d)", error);
+			goto error_out;
+		}
+		error = srpc_ly_tree_create_list(ly_ctx, ntp_list_node, &config_entry_node, "config-entries", "_id", id_buffer);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_ly_tree_create_list() error (%d)", error);
+			goto error_out;
+		}
+
+		// 2. add pool | server | peer node
+		SYSTEM_LOG_DBG("Creating new server list node");
+		assert(
+			strcmp(iter->server.association_type, "server") == 0 ||
+			strcmp(iter->server.association_type, "pool") == 0 ||
+			strcmp(iter->server.association_type, "peer") == 0);
+		error = srpc_ly_tree_create_container(ly_ctx, config_entry_node, &server_node, iter->server.association_type);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_ly_tree_create_container() error (%d)", error);
+			goto error_out;
+		}
+
+		// 3. set word (address:port) to the server
+		SYSTEM_LOG_DBG("Setting server list address and port");
+		if (iter->server.port) {
+			error = snprintf(full_address_buffer, sizeof(full_address_buffer), "%s:%s", iter->server.address, iter->server.port);
+			if (error < 0) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error (%d)", error);
+				goto error_out;
+			}
+		} else {
+			error = snprintf(full_address_buffer, sizeof(full_address_buffer), "%s", iter->server.address);
+			if (error < 0) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error (%d)", error);
+				goto error_out;
+			}
+		}
+
+		error = srpc_ly_tree_create_leaf(ly_ctx, server_node, NULL, "word", full_address_buffer);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_ly_tree_create_leaf() error (%d)", error);
+			goto error_out;
+		}
+
+		// 4. setup properties (iburst and prefer)
+		SYSTEM_LOG_DBG("Adding iburst and prefer options");
+		option_id = 1;
+
+		if (iter->server.iburst) {
+			if (!strcmp(iter->server.iburst, "true")) {
+				SYSTEM_LOG_DBG("Adding iburst options for server %s", iter->server.name);
+				error = snprintf(id_buffer, sizeof(id_buffer), "%lu", option_id);
+				if (error < 0) {
+					SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error (%d)", error);
+					goto error_out;
+				}
+				error = srpc_ly_tree_create_list(ly_ctx, server_node, &options_entry_node, "config-entries", "_id", id_buffer);
+				if (error) {
+					SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_ly_tree_create_list() error (%d)", error);
+					goto error_out;
+				}
+
+				error = srpc_ly_tree_create_leaf(ly_ctx, options_entry_node, NULL, "iburst", NULL);
+				if (error) {
+					SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_ly_tree_create_leaf() error (%d)", error);
+					goto error_out;
+				}
+
+				++option_id;
+			}
+		}
+
+		if (iter->server.prefer) {
+			if (!strcmp(iter->server.prefer, "true")) {
+				SYSTEM_LOG_DBG("Adding prefer options for server %s", iter->server.name);
+				error = snprintf(id_buffer, sizeof(id_buffer), "%lu", option_id);
+				if (error < 0) {
+					SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error (%d)", error);
+					goto error_out;
+				}
+				error = srpc_ly_tree_create_list(ly_ctx, server_node, &options_entry_node, "config-entries", "_id", id_buffer);
+				if (error) {
+					SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_ly_tree_create_list() error (%d)", error);
+					goto error_out;
+				}
+
+				error = srpc_ly_tree_create_leaf(ly_ctx, options_entry_node, NULL, "prefer", NULL);
+				if (error) {
+					SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_ly_tree_create_leaf() error (%d)", error);
+					goto error_out;
+				}
+			}
+		}
+
+		++id;
+	}
+
+	// apply changes to the config file
+	SYSTEM_LOG_INF("Applying created changes to the /etc/ntp.conf config file");
+
+	// lyd_print_file(stdout, ntp_list_node, LYD_XML, 0);
+
+	pthread_mutex_lock(&ctx->startup_lock);
+
+	error = sr_edit_batch(ctx->startup_session, ntp_list_node, "merge");
+	if (error != SR_ERR_OK) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_edit_batch() error (%d): %s", error, sr_strerror(error));
+		pthread_mutex_unlock(&ctx->startup_lock);
+		goto error_out;
+	}
+
+	trace_start = system_trace_begin();
+	error = sr_apply_changes(ctx->startup_session, 0);
+	system_trace_end("sr_apply_changes", NULL, trace_start);
+	pthread_mutex_unlock(&ctx->startup_lock);
+	if (error != 0) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_apply_changes() error (%d): %s", error, sr_strerror(error));
+		goto error_out;
+	}
+
+	SYSTEM_LOG_INF("Successfully applied /etc/ntp.conf config file changes");
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	if (ntp_list_node) {
+		lyd_free_tree(ntp_list_node);
+	}
+	sr_release_context(conn_ctx);
+
+	return error;
+}
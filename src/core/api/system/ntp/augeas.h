@@ -0,0 +1,27 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_API_NTP_AUGEAS_H
+#define SYSTEM_PLUGIN_API_NTP_AUGEAS_H
+
+#include "core/types.h"
+
+/**
+ * NTP backend of the augeas datastore plugin - the servers of /etc/ntp.conf through the ntp module in the startup
+ * datastore. Always available.
+ */
+extern const system_ntp_backend_t system_ntp_augeas_backend;
+
+int system_ntp_augeas_load_server(system_ctx_t *ctx, system_ntp_server_element_t **head);
+int system_ntp_augeas_store_server(system_ctx_t *ctx, system_ntp_server_element_t *head);
+
+#endif // SYSTEM_PLUGIN_API_NTP_AUGEAS_H
@@ -12,6 +12,8 @@
  */
 #include "change.h"
 #include "core/common.h"
+#include "core/log.h"
+#include "core/stats.h"
 
 #include "libyang/tree_data.h"
 #include "sysrepo/xpath.h"
@@ -33,22 +35,28 @@ int system_ntp_change_enabled(void *priv, sr_session_ctx_t *session, const srpc_
 
 	assert(strcmp(node_name, "enabled") == 0);
 
-	SRPLG_LOG_INF(PLUGIN_NAME, "Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
+	SYSTEM_LOG_DBG("Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
 
 	switch (change_ctx->operation) {
 		case SR_OP_CREATED:
 		case SR_OP_MODIFIED:
 			if (enabled) {
+				system_stats_add_fork();
 				SRPC_SAFE_CALL_ERR(error, system("systemctl start ntp"), error_out);
+				system_stats_add_fork();
 				SRPC_SAFE_CALL_ERR(error, system("systemctl enable ntp"), error_out);
 			} else {
+				system_stats_add_fork();
 				SRPC_SAFE_CALL_ERR(error, system("systemctl stop ntp"), error_out);
+				system_stats_add_fork();
 				SRPC_SAFE_CALL_ERR(error, system("systemctl disable ntp"), error_out);
 			}
 			break;
 		case SR_OP_DELETED:
 			// set default value = true
+			system_stats_add_fork();
 			SRPC_SAFE_CALL_ERR(error, system("systemctl start ntp"), error_out);
+			system_stats_add_fork();
 			SRPC_SAFE_CALL_ERR(error, system("systemctl enable ntp"), error_out);
 			break;
 		case SR_OP_MOVED:
@@ -72,7 +80,7 @@ int system_ntp_change_server_name(void *priv, sr_session_ctx_t *session, const s
 
 	assert(strcmp(node_name, "name") == 0);
 
-	SRPLG_LOG_DBG(PLUGIN_NAME, "Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
+	SYSTEM_LOG_DBG("Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
 
 	switch (change_ctx->operation) {
 		case SR_OP_CREATED:
@@ -91,7 +99,7 @@ int system_ntp_change_server_name(void *priv, sr_session_ctx_t *session, const s
 int system_ntp_change_server_address(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx)
 {
 	int error = 0;
-	system_ctx_t *ctx = priv;
+	system_transaction_t *transaction = priv;
 	const char *node_name = LYD_NAME(change_ctx->node);
 	const char *node_value = lyd_get_value(change_ctx->node);
 	system_ntp_server_t temp_server = {0};
@@ -99,7 +107,7 @@ int system_ntp_change_server_address(void *priv, sr_session_ctx_t *session, cons
 
 	assert(strcmp(node_name, "address") == 0);
 
-	SRPLG_LOG_DBG(PLUGIN_NAME, "Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
+	SYSTEM_LOG_DBG("Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
 
 	system_ntp_server_init(&temp_server);
 
@@ -118,7 +126,7 @@ int system_ntp_change_server_address(void *priv, sr_session_ctx_t *session, cons
 			}
 
 			// add the new server to the list
-			error = system_ntp_server_list_add(&ctx->temp_ntp_servers, temp_server);
+			error = system_ntp_server_list_add(&transaction->ntp_servers, temp_server);
 			if (error) {
 				SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_server_list_add() error (%d)", error);
 				goto error_out;
@@ -126,7 +134,7 @@ int system_ntp_change_server_address(void *priv, sr_session_ctx_t *session, cons
 			break;
 		case SR_OP_MODIFIED:
 			// get existing server and change address
-			found_server_el = system_ntp_server_list_find(ctx->temp_ntp_servers, node_value);
+			found_server_el = system_ntp_server_list_find(transaction->ntp_servers, node_value);
 			if (!found_server_el) {
 				SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_server_list_find() error");
 				goto error_out;
@@ -149,7 +157,7 @@ int system_ntp_change_server_address(void *priv, sr_session_ctx_t *session, cons
 			break;
 		case SR_OP_DELETED:
 			// remove data from list
-			error = system_ntp_server_list_remove(&ctx->temp_ntp_servers, node_value);
+			error = system_ntp_server_list_remove(&transaction->ntp_servers, node_value);
 			if (error) {
 				SRPLG_LOG_ERR(PLUGIN_NAME, "system_dns_server_list_remove() error (%d)", error);
 				goto error_out;
@@ -177,7 +185,7 @@ int system_ntp_change_server_port(void *priv, sr_session_ctx_t *session, const s
 
 	assert(strcmp(node_name, "port") == 0);
 
-	SRPLG_LOG_DBG(PLUGIN_NAME, "Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
+	SYSTEM_LOG_DBG("Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
 
 	error = system_ntp_load_server_node_address(session, change_ctx->node, address_buffer, sizeof(address_buffer));
 	if (error) {
@@ -185,7 +193,7 @@ int system_ntp_change_server_port(void *priv, sr_session_ctx_t *session, const s
 		goto error_out;
 	}
 
-	SRPLG_LOG_DBG(PLUGIN_NAME, "ADDRESS = %s, PORT=100", address_buffer);
+	SYSTEM_LOG_DBG("ADDRESS = %s, PORT=100", address_buffer);
 
 	switch (change_ctx->operation) {
 		case SR_OP_CREATED:
@@ -210,7 +218,7 @@ out:
 int system_ntp_change_server_association_type(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx)
 {
 	int error = 0;
-	system_ctx_t *ctx = priv;
+	system_transaction_t *transaction = priv;
 	const char *node_name = LYD_NAME(change_ctx->node);
 	const char *node_value = lyd_get_value(change_ctx->node);
 	char address_buffer[100] = {0};
@@ -218,7 +226,7 @@ int system_ntp_change_server_association_type(void *priv, sr_session_ctx_t *sess
 
 	assert(strcmp(node_name, "association-type") == 0);
 
-	SRPLG_LOG_DBG(PLUGIN_NAME, "Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
+	SYSTEM_LOG_DBG("Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
 
 	error = system_ntp_load_server_node_address(session, change_ctx->node, address_buffer, sizeof(address_buffer));
 	if (error) {
@@ -226,13 +234,13 @@ int system_ntp_change_server_association_type(void *priv, sr_session_ctx_t *sess
 		goto error_out;
 	}
 
-	SRPLG_LOG_DBG(PLUGIN_NAME, "Changing association-type for server %s", address_buffer);
+	SYSTEM_LOG_DBG("Changing association-type for server %s", address_buffer);
 
 	switch (change_ctx->operation) {
 		case SR_OP_CREATED:
 		case SR_OP_MODIFIED:
 			// find server
-			found_server_el = system_ntp_server_list_find(ctx->temp_ntp_servers, address_buffer);
+			found_server_el = system_ntp_server_list_find(transaction->ntp_servers, address_buffer);
 			if (!found_server_el) {
 				SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_server_list_find() failed");
 				goto error_out;
@@ -264,7 +272,7 @@ out:
 int system_ntp_change_server_iburst(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx)
 {
 	int error = 0;
-	system_ctx_t *ctx = priv;
+	system_transaction_t *transaction = priv;
 	const char *node_name = LYD_NAME(change_ctx->node);
 	const char *node_value = lyd_get_value(change_ctx->node);
 	char address_buffer[100] = {0};
@@ -272,7 +280,7 @@ int system_ntp_change_server_iburst(void *priv, sr_session_ctx_t *session, const
 
 	assert(strcmp(node_name, "iburst") == 0);
 
-	SRPLG_LOG_DBG(PLUGIN_NAME, "Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
+	SYSTEM_LOG_DBG("Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
 
 	error = system_ntp_load_server_node_address(session, change_ctx->node, address_buffer, sizeof(address_buffer));
 	if (error) {
@@ -280,13 +288,13 @@ int system_ntp_change_server_iburst(void *priv, sr_session_ctx_t *session, const
 		goto error_out;
 	}
 
-	SRPLG_LOG_DBG(PLUGIN_NAME, "Changing iburst for server %s", address_buffer);
+	SYSTEM_LOG_DBG("Changing iburst for server %s", address_buffer);
 
 	switch (change_ctx->operation) {
 		case SR_OP_CREATED:
 		case SR_OP_MODIFIED:
 			// find server
-			found_server_el = system_ntp_server_list_find(ctx->temp_ntp_servers, address_buffer);
+			found_server_el = system_ntp_server_list_find(transaction->ntp_servers, address_buffer);
 			if (!found_server_el) {
 				SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_server_list_find() failed");
 				goto error_out;
@@ -318,7 +326,7 @@ out:
 int system_ntp_change_server_prefer(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx)
 {
 	int error = 0;
-	system_ctx_t *ctx = priv;
+	system_transaction_t *transaction = priv;
 	const char *node_name = LYD_NAME(change_ctx->node);
 	const char *node_value = lyd_get_value(change_ctx->node);
 	char address_buffer[100] = {0};
@@ -326,7 +334,7 @@ int system_ntp_change_server_prefer(void *priv, sr_session_ctx_t *session, const
 
 	assert(strcmp(node_name, "prefer") == 0);
 
-	SRPLG_LOG_DBG(PLUGIN_NAME, "Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
+	SYSTEM_LOG_DBG("Node Name: %s; Previous Value: %s, Value: %s; Operation: %d", node_name, change_ctx->previous_value, node_value, change_ctx->operation);
 
 	error = system_ntp_load_server_node_address(session, change_ctx->node, address_buffer, sizeof(address_buffer));
 	if (error) {
@@ -334,13 +342,13 @@ int system_ntp_change_server_prefer(void *priv, sr_session_ctx_t *session, const
 		goto error_out;
 	}
 
-	SRPLG_LOG_DBG(PLUGIN_NAME, "Changing prefer for server %s", address_buffer);
+	SYSTEM_LOG_DBG("Changing prefer for server %s", address_buffer);
 
 	switch (change_ctx->operation) {
 		case SR_OP_CREATED:
 		case SR_OP_MODIFIED:
 			// find server
-			found_server_el = system_ntp_server_list_find(ctx->temp_ntp_servers, address_buffer);
+			found_server_el = system_ntp_server_list_find(transaction->ntp_servers, address_buffer);
 			if (!found_server_el) {
 				SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_server_list_find() failed");
 				goto error_out;
@@ -13,6 +13,7 @@
 #include "check.h"
 #include "load.h"
 #include "core/common.h"
+#include "core/stats.h"
 #include "core/data/system/ntp/server/list.h"
 
 #include <srpc.h>
@@ -28,6 +29,8 @@ srpc_check_status_t system_ntp_check_server(system_ctx_t *ctx, system_ntp_server
 
 	system_ntp_server_element_t *system_server_head = NULL, *server_el = NULL, *found_el = NULL;
 
+	SYSTEM_STATS_BEGIN(SYSTEM_STATS_OP_CHECK_NTP_SERVER);
+
 	error = system_ntp_load_server(ctx, &system_server_head);
 	if (error) {
 		SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to load current NTP server list from the system");
@@ -67,5 +70,7 @@ out:
 	// release memory
 	system_ntp_server_list_free(&system_server_head);
 
+	SYSTEM_STATS_END(status == srpc_check_status_error);
+
 	return status;
 }
\ No newline at end of file
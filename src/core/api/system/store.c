@@ -12,9 +12,15 @@
  */
 #include "store.h"
 #include "core/common.h"
+#include "core/backend.h"
+#include "core/log.h"
+#include "core/root.h"
+#include "core/stats.h"
 
+#include <stdio.h>
 #include <unistd.h>
 #include <string.h>
+#include <linux/limits.h>
 
 #include <sysrepo.h>
 
@@ -22,39 +28,23 @@ int system_store_hostname(system_ctx_t *ctx, const char *hostname)
 {
 	int error = 0;
 
-#ifdef AUGYANG
-	int augeas = 0;
-#endif
+	SYSTEM_STATS_BEGIN(SYSTEM_STATS_OP_STORE_HOSTNAME);
 
-	const size_t len = strlen(hostname);
-
-	error = sethostname(hostname, len);
+	error = SYSTEM_HOSTNAME_BACKEND_CALL(store, hostname);
 	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "sethostname() failed");
-		return -1;
+		goto error_out;
 	}
 
-#ifdef AUGYANG
-	SRPLG_LOG_INF(PLUGIN_NAME, "Setting /etc/hostname value using augeas datastore plugin");
-	error = sr_set_item_str(ctx->startup_session, "/hostname:hostname[config-file=\'/etc/hostname\']/hostname", hostname, NULL, 0);
-	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_set_item_str() error (%d): %s", error, sr_strerror(error));
-	} else {
-		SRPLG_LOG_INF(PLUGIN_NAME, "/etc/hostname set");
-		augeas = 1;
-	}
+	error = 0;
+	goto out;
 
-	if (augeas) {
-		SRPLG_LOG_INF(PLUGIN_NAME, "Applying /etc/hostname changes");
-		error = sr_apply_changes(ctx->startup_session, 0);
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "sr_apply_changes() error (%d): %s", error, sr_strerror(error));
-			return -1;
-		}
-	}
-#endif
+error_out:
+	error = -1;
 
-	return 0;
+out:
+	SYSTEM_STATS_END(error != 0);
+
+	return error;
 }
 
 int system_store_contact(system_ctx_t *ctx, const char *contact)
@@ -75,6 +65,10 @@ int system_store_timezone_name(system_ctx_t *ctx, const char *timezone_name)
 {
 	int error = 0;
 	char path_buffer[PATH_MAX] = {0};
+	char zone_path_buffer[PATH_MAX] = {0};
+	char localtime_path_buffer[PATH_MAX] = {0};
+
+	SYSTEM_STATS_BEGIN(SYSTEM_STATS_OP_STORE_TIMEZONE_NAME);
 
 	error = snprintf(path_buffer, sizeof(path_buffer), "%s/%s", SYSTEM_TIMEZONE_DIR, timezone_name);
 	if (error < 0) {
@@ -82,21 +76,26 @@ int system_store_timezone_name(system_ctx_t *ctx, const char *timezone_name)
 		goto error_out;
 	}
 
-	error = access(path_buffer, F_OK);
+	// the link target stays absolute to the system root - only the files themselves are looked up under the root
+	if (system_root_path(zone_path_buffer, sizeof(zone_path_buffer), path_buffer) || system_root_path(localtime_path_buffer, sizeof(localtime_path_buffer), SYSTEM_LOCALTIME_FILE)) {
+		goto error_out;
+	}
+
+	error = access(zone_path_buffer, F_OK);
 	if (error != 0) {
 		SRPLG_LOG_ERR(PLUGIN_NAME, "access() failed (%d)", error);
 		goto error_out;
 	}
 
-	if (access(SYSTEM_LOCALTIME_FILE, F_OK) == 0) {
-		error = unlink(SYSTEM_LOCALTIME_FILE);
+	if (access(localtime_path_buffer, F_OK) == 0) {
+		error = unlink(localtime_path_buffer);
 		if (error != 0) {
 			SRPLG_LOG_ERR(PLUGIN_NAME, "unlink() failed (%d)", error);
 			goto error_out;
 		}
 	}
 
-	error = symlink(path_buffer, SYSTEM_LOCALTIME_FILE);
+	error = symlink(path_buffer, localtime_path_buffer);
 	if (error != 0) {
 		SRPLG_LOG_ERR(PLUGIN_NAME, "symlink() failed (%d)", error);
 		goto error_out;
@@ -109,5 +108,7 @@ error_out:
 
 out:
 
+	SYSTEM_STATS_END(error != 0);
+
 	return error;
-}
\ No newline at end of file
+}
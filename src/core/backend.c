@@ -0,0 +1,228 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "backend.h"
+#include "common.h"
+#include "log.h"
+#include "root.h"
+
+#include "core/api/system/hostname/kernel.h"
+#include "core/api/system/hostname/hostnamed.h"
+#include "core/api/system/dns_resolver/resolv_conf.h"
+#include "core/api/system/dns_resolver/resolved.h"
+#include "core/api/system/ntp/augeas.h"
+#include "core/api/system/authentication/txn.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef SYSTEMD
+#include <systemd/sd-bus.h>
+#endif
+
+#include <sysrepo.h>
+
+// candidates in the order they are probed - the last one of each is always available; the hostname is only probed
+// for a requested backend, as hostnamed would also persist /etc/hostname and report the static hostname
+static const system_hostname_backend_t *const system_backend_hostname_table[] = {
+#if defined(SYSTEM_HOSTNAME_BACKEND_KERNEL)
+	&system_hostname_kernel_backend,
+#elif defined(SYSTEM_HOSTNAME_BACKEND_HOSTNAMED)
+	&system_hostname_hostnamed_backend,
+#else
+#ifdef SYSTEMD
+	&system_hostname_hostnamed_backend,
+#endif
+	&system_hostname_kernel_backend,
+#endif
+};
+
+static const system_dns_resolver_backend_t *const system_backend_dns_resolver_table[] = {
+#if defined(SYSTEM_DNS_RESOLVER_BACKEND_RESOLV_CONF)
+	&system_dns_resolver_resolv_conf_backend,
+#elif defined(SYSTEM_DNS_RESOLVER_BACKEND_RESOLVED)
+	&system_dns_resolver_resolved_backend,
+#else
+#ifdef SYSTEMD
+	&system_dns_resolver_resolved_backend,
+#endif
+	&system_dns_resolver_resolv_conf_backend,
+#endif
+};
+
+static const system_ntp_backend_t *const system_backend_ntp_table[] = {
+	&system_ntp_augeas_backend,
+};
+
+static const system_accounts_backend_t *const system_backend_accounts_table[] = {
+	&system_accounts_umgmt_backend,
+};
+
+#define SYSTEM_BACKEND_COUNT(table) (sizeof(table) / sizeof(table[0]))
+
+// the requested backend, otherwise the first one available - the last one of the table when neither is found
+#define SYSTEM_BACKEND_SELECT(table, selected, env, subsystem)                                                                      \
+	do {                                                                                                                            \
+		(selected) = (table)[SYSTEM_BACKEND_COUNT(table) - 1];                                                                      \
+		for (size_t i = 0; i < SYSTEM_BACKEND_COUNT(table); i++) {                                                                  \
+			if (system_backend_requested(env, (table)[i]->name) || (!getenv(env) && system_backend_available((table)[i]->probe))) { \
+				(selected) = (table)[i];                                                                                            \
+				break;                                                                                                              \
+			}                                                                                                                       \
+		}                                                                                                                           \
+		if (getenv(env) && !system_backend_requested(env, (selected)->name)) {                                                      \
+			SRPLG_LOG_WRN(PLUGIN_NAME, "Unknown " subsystem " backend in %s - using %s", env, (selected)->name);                    \
+		}                                                                                                                           \
+	} while (0)
+
+static pthread_once_t system_backend_once = PTHREAD_ONCE_INIT;
+static const system_hostname_backend_t *system_backend_hostname_selected = NULL;
+static const system_dns_resolver_backend_t *system_backend_dns_resolver_selected = NULL;
+static const system_ntp_backend_t *system_backend_ntp_selected = NULL;
+static const system_accounts_backend_t *system_backend_accounts_selected = NULL;
+
+static void system_backend_select(void);
+static bool system_backend_requested(const char *env, const char *name);
+static bool system_backend_available(bool (*probe)(void));
+
+void system_backend_init(void)
+{
+	pthread_once(&system_backend_once, system_backend_select);
+}
+
+const system_hostname_backend_t *system_backend_hostname(void)
+{
+	system_backend_init();
+
+	return system_backend_hostname_selected;
+}
+
+const system_dns_resolver_backend_t *system_backend_dns_resolver(void)
+{
+	system_backend_init();
+
+	return system_backend_dns_resolver_selected;
+}
+
+const system_ntp_backend_t *system_backend_ntp(void)
+{
+	system_backend_init();
+
+	return system_backend_ntp_selected;
+}
+
+const system_accounts_backend_t *system_backend_accounts(void)
+{
+	system_backend_init();
+
+	return system_backend_accounts_selected;
+}
+
+#ifdef SYSTEMD
+bool system_backend_bus_name_available(const char *name)
+{
+	int r;
+	sd_bus *bus = NULL;
+	sd_bus_error sdb_err = SD_BUS_ERROR_NULL;
+	sd_bus_message *reply = NULL;
+	const char *activatable = NULL;
+	int has_owner = 0;
+	bool available = false;
+
+	r = sd_bus_open_system(&bus);
+	if (r < 0) {
+		SYSTEM_LOG_DBG("System bus unavailable: %s", strerror(-r));
+		return false;
+	}
+
+	// a running service owns its name, a stopped one is started by the bus on the first call
+	r = sd_bus_call_method(bus, "org.freedesktop.DBus", "/org/freedesktop/DBus", "org.freedesktop.DBus", "NameHasOwner", &sdb_err, &reply, "s", name);
+	if (r >= 0 && sd_bus_message_read(reply, "b", &has_owner) >= 0 && has_owner) {
+		available = true;
+		goto out;
+	}
+
+	reply = sd_bus_message_unref(reply);
+	sd_bus_error_free(&sdb_err);
+
+	r = sd_bus_call_method(bus, "org.freedesktop.DBus", "/org/freedesktop/DBus", "org.freedesktop.DBus", "ListActivatableNames", &sdb_err, &reply, NULL);
+	if (r < 0 || sd_bus_message_enter_container(reply, 'a', "s") < 0) {
+		goto out;
+	}
+
+	while (sd_bus_message_read(reply, "s", &activatable) > 0) {
+		if (!strcmp(activatable, name)) {
+			available = true;
+			break;
+		}
+	}
+
+out:
+	sd_bus_message_unref(reply);
+	sd_bus_error_free(&sdb_err);
+	sd_bus_flush_close_unref(bus);
+
+	return available;
+}
+#endif
+
+static void system_backend_select(void)
+{
+	const size_t hostname_count = SYSTEM_BACKEND_COUNT(system_backend_hostname_table);
+	bool hostname_known = false;
+
+	// the last backend is kept when nothing else is requested or found
+	system_backend_hostname_selected = system_backend_hostname_table[hostname_count - 1];
+
+	// the kernel keeps the hostname unless another backend is requested and available
+	for (size_t i = 0; i < hostname_count; i++) {
+		if (!system_backend_requested(SYSTEM_HOSTNAME_BACKEND_ENV, system_backend_hostname_table[i]->name)) {
+			continue;
+		}
+
+		hostname_known = true;
+		if (system_backend_available(system_backend_hostname_table[i]->probe)) {
+			system_backend_hostname_selected = system_backend_hostname_table[i];
+		} else {
+			SRPLG_LOG_WRN(PLUGIN_NAME, "Hostname backend %s is not available - using %s", system_backend_hostname_table[i]->name, system_backend_hostname_selected->name);
+		}
+		break;
+	}
+
+	if (getenv(SYSTEM_HOSTNAME_BACKEND_ENV) && !hostname_known) {
+		SRPLG_LOG_WRN(PLUGIN_NAME, "Unknown hostname backend in %s - using %s", SYSTEM_HOSTNAME_BACKEND_ENV, system_backend_hostname_selected->name);
+	}
+
+	SYSTEM_BACKEND_SELECT(system_backend_dns_resolver_table, system_backend_dns_resolver_selected, SYSTEM_DNS_RESOLVER_BACKEND_ENV, "DNS resolver");
+	SYSTEM_BACKEND_SELECT(system_backend_ntp_table, system_backend_ntp_selected, SYSTEM_NTP_BACKEND_ENV, "NTP");
+	SYSTEM_BACKEND_SELECT(system_backend_accounts_table, system_backend_accounts_selected, SYSTEM_ACCOUNTS_BACKEND_ENV, "accounts");
+
+	SYSTEM_LOG_INF("Hostname backend: %s, DNS resolver backend: %s, NTP backend: %s, accounts backend: %s", system_backend_hostname_selected->name, system_backend_dns_resolver_selected->name, system_backend_ntp_selected->name, system_backend_accounts_selected->name);
+}
+
+static bool system_backend_requested(const char *env, const char *name)
+{
+	const char *value = getenv(env);
+
+	return value && !strcmp(value, name);
+}
+
+static bool system_backend_available(bool (*probe)(void))
+{
+	// the services of the live system are not asked about a separate root - it keeps everything in files
+	if (probe && system_root_active()) {
+		return false;
+	}
+
+	return !probe || probe();
+}
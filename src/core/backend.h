@@ -0,0 +1,87 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_BACKEND_H
+#define SYSTEM_PLUGIN_BACKEND_H
+
+#include "core/types.h"
+
+#include <stdbool.h>
+
+/**
+ * Backends of the subsystems which can be managed in more than one way. The hostname is kept by the kernel or by
+ * systemd-hostnamed, the DNS resolver by systemd-resolved or in /etc/resolv.conf. NTP servers are written through the
+ * augeas datastore plugin and user accounts through umgmt - the only backends of these two so far, behind the same
+ * kind of table so that others can be added.
+ *
+ * By default (SYSTEM_HOSTNAME_BACKEND and SYSTEM_DNS_RESOLVER_BACKEND set to "auto" at configure time) every backend
+ * is compiled in and chosen once by system_backend_init(). The hostname stays with the kernel unless
+ * SYSTEM_PLUGIN_HOSTNAME_BACKEND requests hostnamed and it is available. For the DNS resolver the first one available
+ * on the system is taken - resolved when its name is owned or activatable, resolv.conf otherwise - unless
+ * SYSTEM_PLUGIN_DNS_RESOLVER_BACKEND names another, and likewise for NTP (SYSTEM_NTP_BACKEND,
+ * SYSTEM_PLUGIN_NTP_BACKEND) and accounts (SYSTEM_ACCOUNTS_BACKEND, SYSTEM_PLUGIN_ACCOUNTS_BACKEND). A separate system
+ * root always uses the file based ones.
+ *
+ * A backend fixed at configure time is the only one compiled in and called directly, without the table.
+ */
+void system_backend_init(void);
+const system_hostname_backend_t *system_backend_hostname(void);
+const system_dns_resolver_backend_t *system_backend_dns_resolver(void);
+const system_ntp_backend_t *system_backend_ntp(void);
+const system_accounts_backend_t *system_backend_accounts(void);
+
+#ifdef SYSTEMD
+bool system_backend_bus_name_available(const char *name);
+#endif
+
+#if defined(SYSTEM_HOSTNAME_BACKEND_KERNEL)
+#include "core/api/system/hostname/kernel.h"
+#define SYSTEM_HOSTNAME_BACKEND_CALL(op, ...) system_hostname_kernel_##op(__VA_ARGS__)
+#elif defined(SYSTEM_HOSTNAME_BACKEND_HOSTNAMED)
+#ifndef SYSTEMD
+#error "the hostnamed backend requires SYSTEMD"
+#endif
+#include "core/api/system/hostname/hostnamed.h"
+#define SYSTEM_HOSTNAME_BACKEND_CALL(op, ...) system_hostname_hostnamed_##op(__VA_ARGS__)
+#else
+#define SYSTEM_HOSTNAME_BACKEND_CALL(op, ...) system_backend_hostname()->op(__VA_ARGS__)
+#endif
+
+#if defined(SYSTEM_DNS_RESOLVER_BACKEND_RESOLV_CONF)
+#include "core/api/system/dns_resolver/resolv_conf.h"
+#define SYSTEM_DNS_RESOLVER_BACKEND_CALL(op, ...) system_dns_resolver_resolv_conf_##op(__VA_ARGS__)
+#elif defined(SYSTEM_DNS_RESOLVER_BACKEND_RESOLVED)
+#ifndef SYSTEMD
+#error "the resolved backend requires SYSTEMD"
+#endif
+#include "core/api/system/dns_resolver/resolved.h"
+#define SYSTEM_DNS_RESOLVER_BACKEND_CALL(op, ...) system_dns_resolver_resolved_##op(__VA_ARGS__)
+#else
+#define SYSTEM_DNS_RESOLVER_BACKEND_CALL(op, ...) system_backend_dns_resolver()->op(__VA_ARGS__)
+#endif
+
+#if defined(SYSTEM_NTP_BACKEND_AUGEAS)
+#include "core/api/system/ntp/augeas.h"
+#define SYSTEM_NTP_BACKEND_CALL(op, ...) system_ntp_augeas_##op(__VA_ARGS__)
+#else
+#define SYSTEM_NTP_BACKEND_CALL(op, ...) system_backend_ntp()->op(__VA_ARGS__)
+#endif
+
+// the transaction functions of umgmt keep their names - the backend is the account transaction
+#if defined(SYSTEM_ACCOUNTS_BACKEND_UMGMT)
+#include "core/api/system/authentication/txn.h"
+#define SYSTEM_ACCOUNTS_BACKEND_CALL(op, ...) system_authentication_txn_##op(__VA_ARGS__)
+#else
+#define SYSTEM_ACCOUNTS_BACKEND_CALL(op, ...) system_backend_accounts()->op(__VA_ARGS__)
+#endif
+
+#endif // SYSTEM_PLUGIN_BACKEND_H
@@ -20,6 +20,12 @@ extern const char *const PLUGIN_NAME;
 
 #define IETF_SYSTEM_YANG_MODULE "ietf-system"
 
+// plugin runtime statistics - optional module
+#define SYSTEM_STATS_YANG_MODULE "sysrepo-plugin-system-stats"
+#define SYSTEM_STATS_YANG_PATH "/" SYSTEM_STATS_YANG_MODULE ":stats"
+#define SYSTEM_STATS_SET_TRACE_RPC_YANG_PATH "/" SYSTEM_STATS_YANG_MODULE ":set-trace"
+#define SYSTEM_STATS_DUMP_TRACE_RPC_YANG_PATH "/" SYSTEM_STATS_YANG_MODULE ":dump-trace"
+
 #define SYSTEM_SYSTEM_CONTAINER_YANG_PATH "/" BASE_YANG_MODULE ":system"
 
 // rpc
@@ -58,15 +64,30 @@ extern const char *const PLUGIN_NAME;
 #define SYSTEM_DNS_RESOLVER_TIMEOUT_YANG_PATH SYSTEM_SYSTEM_CONTAINER_YANG_PATH "/dns-resolver/options/timeout"
 #define SYSTEM_DNS_RESOLVER_ATTEMPTS_YANG_PATH SYSTEM_SYSTEM_CONTAINER_YANG_PATH "/dns-resolver/options/attempts"
 
+// systemd-resolved D-Bus API
+#define SYSTEM_RESOLVED_SERVICE "org.freedesktop.resolve1"
+#define SYSTEM_RESOLVED_OBJECT_PATH "/org/freedesktop/resolve1"
+#define SYSTEM_RESOLVED_MANAGER_INTERFACE "org.freedesktop.resolve1.Manager"
+
+// systemd-hostnamed D-Bus API
+#define SYSTEM_HOSTNAMED_SERVICE "org.freedesktop.hostname1"
+#define SYSTEM_HOSTNAMED_OBJECT_PATH "/org/freedesktop/hostname1"
+#define SYSTEM_HOSTNAMED_INTERFACE "org.freedesktop.hostname1"
+
 // authentication //
 #define SYSTEM_AUTHENTICATION_USER_AUTHENTICATION_ORDER_YANG_PATH SYSTEM_SYSTEM_CONTAINER_YANG_PATH "/authentication/user-authentication-order"
 #define SYSTEM_AUTHENTICATION_USER_YANG_PATH SYSTEM_SYSTEM_CONTAINER_YANG_PATH "/authentication/user"
 
+// configuration nodes of the subsystems which have more than one
+#define SYSTEM_HOSTNAME_SUBSYSTEM_XPATH SYSTEM_HOSTNAME_YANG_PATH " | " SYSTEM_CONTACT_YANG_PATH " | " SYSTEM_LOCATION_YANG_PATH
+#define SYSTEM_DNS_RESOLVER_SUBSYSTEM_XPATH SYSTEM_DNS_RESOLVER_SEARCH_YANG_PATH " | " SYSTEM_DNS_RESOLVER_SERVER_YANG_PATH
+
 #define SYSTEM_DATETIME_BUFFER_SIZE 30
 #define SYSTEM_UTS_LEN 64
 
 #define SYSTEM_TIMEZONE_DIR "/usr/share/zoneinfo"
 #define SYSTEM_LOCALTIME_FILE "/etc/localtime"
+#define SYSTEM_HOSTNAME_FILE "/etc/hostname"
 
 #define SYSTEM_HOSTNAME_LENGTH_MAX 64
 #define SYSTEM_TIMEZONE_NAME_LENGTH_MAX (14 * 3)
@@ -74,9 +95,78 @@ extern const char *const PLUGIN_NAME;
 #define SYSTEM_AUTHENTICATION_PASSWD_PATH "/etc/passwd"
 #define SYSTEM_AUTHENTICATION_DEFAULT_SHELL "/bin/bash"
 #define SYSTEM_AUTHENTICATION_DEFAULT_GECOS "ietf-system user"
+#define SYSTEM_AUTHENTICATION_GROUP_PASSWORD_LOCKED "!"
 #define SYSTEM_AUTHENTICATION_SKEL_DIRECTORY "/etc/skel"
 
+// ID ranges for new users and their groups - match UID_MIN/UID_MAX and GID_MIN/GID_MAX from login.defs
+#define SYSTEM_AUTHENTICATION_UID_MIN 1000
+#define SYSTEM_AUTHENTICATION_UID_MAX 60000
+#define SYSTEM_AUTHENTICATION_GID_MIN 1000
+#define SYSTEM_AUTHENTICATION_GID_MAX 60000
+
 #define SYSTEM_AUTHENTICATION_SHADOW_PATH "/etc/shadow"
+#define SYSTEM_AUTHENTICATION_GROUP_PATH "/etc/group"
+
+// plugin state kept outside of the sysrepo datastores
+#define SYSTEM_PLUGIN_STATE_DIRECTORY "/var/lib/sysrepo-plugin-system"
+
+// per-user authorized keys index read by the AuthorizedKeysCommand helper
+#define SYSTEM_AUTHENTICATION_KEY_INDEX_DIRECTORY SYSTEM_PLUGIN_STATE_DIRECTORY "/authorized_keys"
+#define SYSTEM_AUTHENTICATION_AUTHORIZED_KEYS_FILE "authorized_keys"
+
+// iana-crypt-hash values with this prefix carry a cleartext password - hashed in SR_EV_UPDATE before they are stored
+#define SYSTEM_AUTHENTICATION_PASSWORD_CLEARTEXT_PREFIX "$0$"
+#define SYSTEM_AUTHENTICATION_PASSWORD_HASH_PREFIX "$6$"
+#define SYSTEM_AUTHENTICATION_PASSWORD_SALT_LENGTH 16
+
+// upper bound of the password hashing threads - defaults to the number of online CPUs capped at the maximum
+#define SYSTEM_AUTHENTICATION_PASSWORD_WORKERS_ENV "SYSTEM_PLUGIN_PASSWORD_WORKERS"
+#define SYSTEM_AUTHENTICATION_PASSWORD_WORKERS_MAX 8
+
+// batched filesystem operations of user provisioning - "threads" skips io_uring, the thread count is capped as above
+#define SYSTEM_FS_BATCH_BACKEND_ENV "SYSTEM_PLUGIN_FS_BACKEND"
+#define SYSTEM_FS_BATCH_WORKERS_ENV "SYSTEM_PLUGIN_FS_WORKERS"
+#define SYSTEM_FS_BATCH_WORKERS_MAX 8
+#define SYSTEM_FS_BATCH_QUEUE_DEPTH 256
+
+// directory under which the system files are resolved instead of / - unset on a live system
+#define SYSTEM_ROOT_ENV "SYSTEM_PLUGIN_ROOT"
+
+// span tracing - enabled at startup when the variable is set to 1, dumped by default into the plugin state directory
+#define SYSTEM_TRACE_ENV "SYSTEM_PLUGIN_TRACE"
+#define SYSTEM_TRACE_DEFAULT_NAME "trace.json"
+#define SYSTEM_TRACE_DEFAULT_FILE SYSTEM_PLUGIN_STATE_DIRECTORY "/" SYSTEM_TRACE_DEFAULT_NAME
+
+// last loaded system values with the validators of their source files - subsystems with unchanged sources are taken from it at start
+#define SYSTEM_SNAPSHOT_FILE SYSTEM_PLUGIN_STATE_DIRECTORY "/snapshot"
+#define SYSTEM_SNAPSHOT_MAGIC "sysrepo-plugin-system-snapshot 1"
+
+// planned filesystem operations of user changes with their progress - unfinished ones are completed at start
+#define SYSTEM_JOURNAL_FILE SYSTEM_PLUGIN_STATE_DIRECTORY "/journal"
+#define SYSTEM_JOURNAL_MAGIC "sysrepo-plugin-system-journal 2\n"
+
+// resolved rewrites its file whenever its DNS configuration changes, the resolv.conf backend writes /etc/resolv.conf
+#define SYSTEM_RESOLVED_RESOLV_CONF_FILE "/run/systemd/resolve/resolv.conf"
+#define SYSTEM_RESOLV_CONF_FILE "/etc/resolv.conf"
+
+// backend of a subsystem by name instead of the first one found on the system - see core/backend.h
+#define SYSTEM_HOSTNAME_BACKEND_ENV "SYSTEM_PLUGIN_HOSTNAME_BACKEND"
+#define SYSTEM_DNS_RESOLVER_BACKEND_ENV "SYSTEM_PLUGIN_DNS_RESOLVER_BACKEND"
+#define SYSTEM_NTP_BACKEND_ENV "SYSTEM_PLUGIN_NTP_BACKEND"
+#define SYSTEM_ACCOUNTS_BACKEND_ENV "SYSTEM_PLUGIN_ACCOUNTS_BACKEND"
+
+// first line of a change set recording of the standalone executable
+#define SYSTEM_RECORD_MAGIC "sysrepo-plugin-system-recording 1"
+
+// subscription threads grouping: "subsystem" (default) - a thread per subsystem, operational data and RPCs;
+// "split" - one thread for all configuration changes, one for operational data and one for RPCs; "single" - one thread
+#define SYSTEM_SUBSCRIPTION_GROUPS_ENV "SYSTEM_PLUGIN_SUBSCRIPTION_GROUPS"
+
+// schema paths of the nodes compared by startup reconciliation
+#define SYSTEM_RECONCILE_PATH_LENGTH_MAX 256
+
+// set of subsystems (system_subsystem_t) handled by one call
+#define SYSTEM_SUBSYSTEM_MASK(subsystem) (1U << (subsystem))
 
 #define ARRAY_SIZE(arr) (sizeof(arr) / sizeof(arr[0]))
 
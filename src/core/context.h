@@ -18,26 +18,30 @@
 #include "umgmt/types.h"
 #include <sysrepo_types.h>
 
+#include <pthread.h>
+#include <stdatomic.h>
+
 #include <umgmt.h>
 
-typedef struct system_ctx_s system_ctx_t;
+typedef struct system_transaction_s system_transaction_t;
+
+struct system_transaction_s {
+	system_ctx_t *ctx;				///< Plugin context.
+	system_dns_search_element_t *dns_search;	///< Allocated before changes iteration and free'd after.
+	system_dns_server_element_t *dns_servers;	///< Allocated before changes iteration and free'd after.
+	system_ntp_server_element_t *ntp_servers;	///< Allocated before changes iteration and free'd after.
+	system_local_user_change_t *user_changes;	///< Changes of each user gathered during change callbacks. After changes they are applied on the system values.
+};
 
 struct system_ctx_s {
 	sr_session_ctx_t *startup_session;
-	system_dns_search_element_t *temp_dns_search;	  ///< Allocated before changes iteration and free'd after.
-	system_dns_server_element_t *temp_dns_servers;	  ///< Allocated before changes iteration and free'd after.
-	system_ntp_server_element_t *temp_ntp_servers;	  ///< Allocated before changes iteration and free'd after.
+	sr_subscription_ctx_t *subscriptions[SYSTEM_SUBSCRIPTION_GROUP_COUNT]; ///< Subscription contexts of the subscription groups.
+	pthread_mutex_t startup_lock;			  ///< Serializes use of the startup session between callbacks.
 	srpc_feature_status_hash_t *ietf_system_features; ///< IETF System YANG module features.
-	struct {
-		system_local_user_element_t *created;
-		system_local_user_element_t *modified;
-		system_local_user_element_t *deleted;
-		struct {
-			system_local_user_element_t *created;
-			system_local_user_element_t *modified;
-			system_local_user_element_t *deleted;
-		} keys;
-	} temp_users; ///< Users created/modified/deleted during change callbacks. After changes the user modifications are applied on the system values.
+	pthread_rwlock_t features_lock;			  ///< Guards the features hash - reloaded by callbacks, read by all.
+	_Atomic int drift_writers[SYSTEM_SUBSYSTEM_COUNT];		   ///< Change callbacks currently writing a subsystem into the system.
+	_Atomic int64_t drift_quiet_after[SYSTEM_SUBSYSTEM_COUNT]; ///< Monotonic time (ms) after which system file events of an idle subsystem are no longer treated as plugin writes.
+	system_watcher_t *watcher;								   ///< Out-of-band system changes watcher.
 };
 
 #endif // SYSTEM_PLUGIN_CONTEXT_H
\ No newline at end of file
@@ -11,9 +11,26 @@
  * SPDX-License-Identifier: BSD-3-Clause
  */
 #include "authorized_key.h"
+#include "core/ssh/base64.h"
+#include "core/ssh/sha256.h"
+
 #include <stdlib.h>
 #include <string.h>
 
+static int system_authorized_key_decode(system_authorized_key_t *key, const char *data);
+static const char *system_authorized_key_type(const char *algorithm);
+
+// RSA signature algorithms - the blob of such a key carries the ssh-rsa key type
+static const struct {
+	const char *algorithm;
+	const char *type;
+} system_authorized_key_signature_types[] = {
+	{"rsa-sha2-256", "ssh-rsa"},
+	{"rsa-sha2-512", "ssh-rsa"},
+	{"rsa-sha2-256-cert-v01@openssh.com", "ssh-rsa-cert-v01@openssh.com"},
+	{"rsa-sha2-512-cert-v01@openssh.com", "ssh-rsa-cert-v01@openssh.com"},
+};
+
 void system_authorized_key_init(system_authorized_key_t *key)
 {
 	*key = (system_authorized_key_t){0};
@@ -56,7 +73,15 @@ int system_authorized_key_set_data(system_authorized_key_t *key, const char *dat
 		key->data = 0;
 	}
 
+	memset(key->fingerprint, 0, sizeof(key->fingerprint));
+	memset(key->blob_algorithm, 0, sizeof(key->blob_algorithm));
+
 	if (data) {
+		// decode once - reject malformed key data and keep the fingerprint for comparisons
+		if (system_authorized_key_decode(key, data)) {
+			return -1;
+		}
+
 		key->data = strdup(data);
 		return key->data == NULL;
 	}
@@ -64,6 +89,31 @@ int system_authorized_key_set_data(system_authorized_key_t *key, const char *dat
 	return 0;
 }
 
+int system_authorized_key_set_options(system_authorized_key_t *key, const char *options)
+{
+	if (key->options) {
+		free(key->options);
+		key->options = 0;
+	}
+
+	if (options) {
+		key->options = strdup(options);
+		return key->options == NULL;
+	}
+
+	return 0;
+}
+
+int system_authorized_key_check_algorithm(const system_authorized_key_t *key)
+{
+	if (!key->algorithm || !key->data) {
+		return -1;
+	}
+
+	// configured algorithm has to match the key type embedded in the blob
+	return strcmp(system_authorized_key_type(key->algorithm), key->blob_algorithm) != 0;
+}
+
 void system_authorized_key_free(system_authorized_key_t *key)
 {
 	if (key->name) {
@@ -78,6 +128,10 @@ void system_authorized_key_free(system_authorized_key_t *key)
 		free(key->data);
 	}
 
+	if (key->options) {
+		free(key->options);
+	}
+
 	system_authorized_key_init(key);
 }
 
@@ -87,4 +141,69 @@ int system_authorized_key_cmp_fn(const void *e1, const void *e2)
 	system_authorized_key_t *k2 = (system_authorized_key_t *) e2;
 
 	return strcmp(k1->name, k2->name);
-}
\ No newline at end of file
+}
+
+int system_authorized_key_fingerprint_cmp_fn(const void *e1, const void *e2)
+{
+	system_authorized_key_t *k1 = (system_authorized_key_t *) e1;
+	system_authorized_key_t *k2 = (system_authorized_key_t *) e2;
+
+	return memcmp(k1->fingerprint, k2->fingerprint, sizeof(k1->fingerprint));
+}
+
+static int system_authorized_key_decode(system_authorized_key_t *key, const char *data)
+{
+	int error = 0;
+	const size_t data_length = strlen(data);
+	uint8_t *blob = NULL;
+	size_t blob_length = 0;
+	uint32_t name_length = 0;
+
+	blob = (uint8_t *) malloc(SYSTEM_BASE64_DECODED_SIZE(data_length) + 1);
+	if (!blob) {
+		return -1;
+	}
+
+	error = system_base64_decode(data, data_length, blob, SYSTEM_BASE64_DECODED_SIZE(data_length) + 1, &blob_length);
+	if (error || blob_length < 4) {
+		goto error_out;
+	}
+
+	// blob starts with the key type as an SSH string - uint32 length followed by the name, key material follows
+	name_length = (uint32_t) blob[0] << 24 | (uint32_t) blob[1] << 16 | (uint32_t) blob[2] << 8 | (uint32_t) blob[3];
+	if (!name_length || name_length >= sizeof(key->blob_algorithm) || name_length >= blob_length - 4) {
+		goto error_out;
+	}
+
+	memcpy(key->blob_algorithm, blob + 4, name_length);
+	key->blob_algorithm[name_length] = 0;
+	if (strlen(key->blob_algorithm) != name_length) {
+		goto error_out;
+	}
+
+	// same fingerprint as ssh-keygen -l -E sha256
+	system_sha256(blob, blob_length, key->fingerprint);
+
+	error = 0;
+	goto out;
+
+error_out:
+	error = -1;
+	memset(key->blob_algorithm, 0, sizeof(key->blob_algorithm));
+
+out:
+	free(blob);
+
+	return error;
+}
+
+static const char *system_authorized_key_type(const char *algorithm)
+{
+	for (size_t i = 0; i < sizeof(system_authorized_key_signature_types) / sizeof(system_authorized_key_signature_types[0]); i++) {
+		if (!strcmp(algorithm, system_authorized_key_signature_types[i].algorithm)) {
+			return system_authorized_key_signature_types[i].type;
+		}
+	}
+
+	return algorithm;
+}
@@ -19,8 +19,11 @@ void system_authorized_key_init(system_authorized_key_t *key);
 int system_authorized_key_set_name(system_authorized_key_t *key, const char *name);
 int system_authorized_key_set_algorithm(system_authorized_key_t *key, const char *algorithm);
 int system_authorized_key_set_data(system_authorized_key_t *key, const char *data);
+int system_authorized_key_set_options(system_authorized_key_t *key, const char *options);
+int system_authorized_key_check_algorithm(const system_authorized_key_t *key);
 void system_authorized_key_free(system_authorized_key_t *key);
 
 int system_authorized_key_cmp_fn(const void *e1, const void *e2);
+int system_authorized_key_fingerprint_cmp_fn(const void *e1, const void *e2);
 
 #endif // SYSTEM_PLUGIN_DATA_AUTHENTICATION_AUTHORIZED_KEY_H
\ No newline at end of file
@@ -32,14 +32,30 @@ int system_authorized_key_list_add(system_authorized_key_element_t **head, syste
 
 	// copy value
 	system_authorized_key_init(&new_el->key);
-	system_authorized_key_set_name(&new_el->key, key.name);
-	system_authorized_key_set_algorithm(&new_el->key, key.algorithm);
-	system_authorized_key_set_data(&new_el->key, key.data);
+	if (system_authorized_key_set_name(&new_el->key, key.name) || system_authorized_key_set_algorithm(&new_el->key, key.algorithm) || system_authorized_key_set_options(&new_el->key, key.options)) {
+		goto error_out;
+	}
+
+	// data has already been validated - copy it together with the fingerprint instead of decoding it again
+	if (key.data) {
+		new_el->key.data = strdup(key.data);
+		if (!new_el->key.data) {
+			goto error_out;
+		}
+		memcpy(new_el->key.fingerprint, key.fingerprint, sizeof(key.fingerprint));
+		memcpy(new_el->key.blob_algorithm, key.blob_algorithm, sizeof(key.blob_algorithm));
+	}
 
 	// add to list
 	LL_APPEND(*head, new_el);
 
 	return 0;
+
+error_out:
+	system_authorized_key_free(&new_el->key);
+	free(new_el);
+
+	return -1;
 }
 
 system_authorized_key_element_t *system_authorized_key_list_find(system_authorized_key_element_t *head, const char *name)
@@ -80,6 +96,14 @@ int system_authorized_key_element_cmp_fn(void *e1, void *e2)
 	return strcmp(s1->key.name, s2->key.name);
 }
 
+int system_authorized_key_element_fingerprint_cmp_fn(void *e1, void *e2)
+{
+	system_authorized_key_element_t *s1 = (system_authorized_key_element_t *) e1;
+	system_authorized_key_element_t *s2 = (system_authorized_key_element_t *) e2;
+
+	return system_authorized_key_fingerprint_cmp_fn(&s1->key, &s2->key);
+}
+
 void system_authorized_key_list_free(system_authorized_key_element_t **head)
 {
 	system_authorized_key_element_t *iter_el = NULL, *tmp_el = NULL;
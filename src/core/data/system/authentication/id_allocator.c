@@ -0,0 +1,163 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "id_allocator.h"
+
+#include <stdlib.h>
+
+#define SYSTEM_ID_ALLOCATOR_WORD_BITS 64
+
+static size_t system_id_allocator_word_count(const system_id_allocator_t *alloc);
+static int system_id_allocator_find_free(const system_id_allocator_t *alloc, uint64_t start, uint32_t *offset);
+
+int system_id_allocator_init(system_id_allocator_t *alloc, uint32_t min, uint32_t max)
+{
+	size_t words = 0;
+	size_t bits = 0;
+
+	*alloc = (system_id_allocator_t){0};
+
+	if (min > max) {
+		return -1;
+	}
+
+	alloc->min = min;
+	alloc->max = max;
+	alloc->next = min;
+
+	words = system_id_allocator_word_count(alloc);
+	alloc->bitmap = (uint64_t *) calloc(words, sizeof(uint64_t));
+	if (!alloc->bitmap) {
+		return -1;
+	}
+
+	// mark bits past the end of the range as used so they are never handed out
+	bits = (size_t) (max - min) + 1;
+	if (bits % SYSTEM_ID_ALLOCATOR_WORD_BITS) {
+		alloc->bitmap[words - 1] = ~UINT64_C(0) << (bits % SYSTEM_ID_ALLOCATOR_WORD_BITS);
+	}
+
+	return 0;
+}
+
+void system_id_allocator_mark(system_id_allocator_t *alloc, uint32_t id)
+{
+	uint32_t offset = 0;
+
+	if (id < alloc->min || id > alloc->max) {
+		return;
+	}
+
+	offset = id - alloc->min;
+	alloc->bitmap[offset / SYSTEM_ID_ALLOCATOR_WORD_BITS] |= UINT64_C(1) << (offset % SYSTEM_ID_ALLOCATOR_WORD_BITS);
+
+	// new IDs are handed out above the highest used one - same as useradd
+	if (id >= alloc->next) {
+		alloc->next = (uint64_t) id + 1;
+	}
+}
+
+bool system_id_allocator_is_free(const system_id_allocator_t *alloc, uint32_t id)
+{
+	uint32_t offset = 0;
+
+	if (id < alloc->min || id > alloc->max) {
+		return false;
+	}
+
+	offset = id - alloc->min;
+
+	return (alloc->bitmap[offset / SYSTEM_ID_ALLOCATOR_WORD_BITS] & (UINT64_C(1) << (offset % SYSTEM_ID_ALLOCATOR_WORD_BITS))) == 0;
+}
+
+int system_id_allocator_get(system_id_allocator_t *alloc, uint32_t *id)
+{
+	uint32_t offset = 0;
+
+	// search above the last handed out ID first and wrap around to the holes only when the range is exhausted
+	if (system_id_allocator_find_free(alloc, alloc->next - alloc->min, &offset) != 0 && system_id_allocator_find_free(alloc, 0, &offset) != 0) {
+		return -1;
+	}
+
+	*id = alloc->min + offset;
+	system_id_allocator_mark(alloc, *id);
+
+	return 0;
+}
+
+int system_id_allocator_take(system_id_allocator_t *alloc, uint32_t id)
+{
+	if (!system_id_allocator_is_free(alloc, id)) {
+		return -1;
+	}
+
+	system_id_allocator_mark(alloc, id);
+
+	return 0;
+}
+
+void system_id_allocator_release(system_id_allocator_t *alloc, uint32_t id)
+{
+	uint32_t offset = 0;
+
+	if (id < alloc->min || id > alloc->max) {
+		return;
+	}
+
+	offset = id - alloc->min;
+	alloc->bitmap[offset / SYSTEM_ID_ALLOCATOR_WORD_BITS] &= ~(UINT64_C(1) << (offset % SYSTEM_ID_ALLOCATOR_WORD_BITS));
+
+	// the last handed out ID is given again to the next request
+	if ((uint64_t) id + 1 == alloc->next) {
+		alloc->next = id;
+	}
+}
+
+void system_id_allocator_free(system_id_allocator_t *alloc)
+{
+	if (alloc->bitmap) {
+		free(alloc->bitmap);
+	}
+
+	*alloc = (system_id_allocator_t){0};
+}
+
+static size_t system_id_allocator_word_count(const system_id_allocator_t *alloc)
+{
+	const size_t bits = (size_t) (alloc->max - alloc->min) + 1;
+
+	return (bits + SYSTEM_ID_ALLOCATOR_WORD_BITS - 1) / SYSTEM_ID_ALLOCATOR_WORD_BITS;
+}
+
+static int system_id_allocator_find_free(const system_id_allocator_t *alloc, uint64_t start, uint32_t *offset)
+{
+	const size_t words = system_id_allocator_word_count(alloc);
+	size_t word = (size_t) (start / SYSTEM_ID_ALLOCATOR_WORD_BITS);
+	uint64_t free_bits = 0;
+
+	if (word >= words) {
+		return -1;
+	}
+
+	// skip whole words of used IDs - each full word is visited at most once per search
+	free_bits = ~alloc->bitmap[word] & (~UINT64_C(0) << (start % SYSTEM_ID_ALLOCATOR_WORD_BITS));
+	while (!free_bits) {
+		if (++word == words) {
+			return -1;
+		}
+		free_bits = ~alloc->bitmap[word];
+	}
+
+	*offset = (uint32_t) (word * SYSTEM_ID_ALLOCATOR_WORD_BITS + (size_t) __builtin_ctzll(free_bits));
+
+	return 0;
+}
@@ -0,0 +1,28 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_DATA_AUTHENTICATION_ID_ALLOCATOR_H
+#define SYSTEM_PLUGIN_DATA_AUTHENTICATION_ID_ALLOCATOR_H
+
+#include "core/types.h"
+
+#include <stdbool.h>
+
+int system_id_allocator_init(system_id_allocator_t *alloc, uint32_t min, uint32_t max);
+void system_id_allocator_mark(system_id_allocator_t *alloc, uint32_t id);
+bool system_id_allocator_is_free(const system_id_allocator_t *alloc, uint32_t id);
+int system_id_allocator_get(system_id_allocator_t *alloc, uint32_t *id);
+int system_id_allocator_take(system_id_allocator_t *alloc, uint32_t id);
+void system_id_allocator_release(system_id_allocator_t *alloc, uint32_t id);
+void system_id_allocator_free(system_id_allocator_t *alloc);
+
+#endif // SYSTEM_PLUGIN_DATA_AUTHENTICATION_ID_ALLOCATOR_H
@@ -51,6 +51,21 @@ int system_local_user_set_password(system_local_user_t *user, const char *passwo
 	return 0;
 }
 
+int system_local_user_set_home(system_local_user_t *user, const char *home)
+{
+	if (user->home) {
+		free(user->home);
+		user->home = 0;
+	}
+
+	if (home) {
+		user->home = strdup(home);
+		return user->home == NULL;
+	}
+
+	return 0;
+}
+
 void system_local_user_free(system_local_user_t *user)
 {
 	if (user->name) {
@@ -61,6 +76,10 @@ void system_local_user_free(system_local_user_t *user)
 		free(user->password);
 	}
 
+	if (user->home) {
+		free(user->home);
+	}
+
 	if (user->key_head) {
 		system_authorized_key_list_free(&user->key_head);
 	}
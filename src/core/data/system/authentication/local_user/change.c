@@ -0,0 +1,125 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "change.h"
+#include "core/data/system/authentication/authorized_key.h"
+#include "core/data/system/authentication/authorized_key/list.h"
+#include "core/data/system/authentication/local_user.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <utlist.h>
+
+system_local_user_change_t *system_local_user_change_get(system_local_user_change_t **map, const char *name)
+{
+	system_local_user_change_t *change = NULL;
+
+	HASH_FIND_STR(*map, name, change);
+	if (change) {
+		return change;
+	}
+
+	change = calloc(1, sizeof(*change));
+	if (!change) {
+		return NULL;
+	}
+
+	system_local_user_init(&change->user);
+	if (system_local_user_set_name(&change->user, name)) {
+		free(change);
+		return NULL;
+	}
+
+	HASH_ADD_KEYPTR(hh, *map, change->user.name, strlen(change->user.name), change);
+
+	return change;
+}
+
+system_authorized_key_element_t *system_local_user_change_get_key(system_authorized_key_element_t **head, const char *name)
+{
+	system_authorized_key_element_t *key_el = system_authorized_key_list_find(*head, name);
+
+	if (!key_el && !system_authorized_key_list_add(head, (system_authorized_key_t){.name = (char *) name})) {
+		key_el = system_authorized_key_list_find(*head, name);
+	}
+
+	return key_el;
+}
+
+bool system_local_user_change_has_keys(const system_local_user_change_t *change)
+{
+	return change->keys_created || change->keys_modified || change->keys_deleted;
+}
+
+int system_local_user_change_merge_keys(system_local_user_change_t *change)
+{
+	system_authorized_key_element_t *key_iter = NULL;
+	system_authorized_key_element_t *found = NULL;
+
+	LL_FOREACH(change->keys_deleted, key_iter)
+	{
+		system_authorized_key_list_remove(&change->user.key_head, key_iter->key.name);
+	}
+
+	LL_FOREACH(change->keys_modified, key_iter)
+	{
+		found = system_authorized_key_list_find(change->user.key_head, key_iter->key.name);
+		if (!found) {
+			return -1;
+		}
+
+		if (key_iter->key.algorithm && system_authorized_key_set_algorithm(&found->key, key_iter->key.algorithm)) {
+			return -1;
+		}
+
+		// data has already been validated - take it together with the fingerprint instead of decoding it again
+		if (key_iter->key.data) {
+			free(found->key.data);
+			found->key.data = strdup(key_iter->key.data);
+			if (!found->key.data) {
+				return -1;
+			}
+
+			memcpy(found->key.fingerprint, key_iter->key.fingerprint, sizeof(found->key.fingerprint));
+			memcpy(found->key.blob_algorithm, key_iter->key.blob_algorithm, sizeof(found->key.blob_algorithm));
+		}
+	}
+
+	// a key with the name of one already in the file replaces it
+	LL_FOREACH(change->keys_created, key_iter)
+	{
+		system_authorized_key_list_remove(&change->user.key_head, key_iter->key.name);
+
+		if (system_authorized_key_list_add(&change->user.key_head, key_iter->key)) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+void system_local_user_change_map_free(system_local_user_change_t **map)
+{
+	system_local_user_change_t *change = NULL, *tmp = NULL;
+
+	HASH_ITER(hh, *map, change, tmp)
+	{
+		HASH_DEL(*map, change);
+
+		system_authorized_key_list_free(&change->keys_created);
+		system_authorized_key_list_free(&change->keys_modified);
+		system_authorized_key_list_free(&change->keys_deleted);
+		system_local_user_free(&change->user);
+
+		free(change);
+	}
+}
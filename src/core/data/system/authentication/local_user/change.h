@@ -0,0 +1,24 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_DATA_AUTHENTICATION_LOCAL_USER_CHANGE_H
+#define SYSTEM_PLUGIN_DATA_AUTHENTICATION_LOCAL_USER_CHANGE_H
+
+#include "core/types.h"
+
+system_local_user_change_t *system_local_user_change_get(system_local_user_change_t **map, const char *name);
+system_authorized_key_element_t *system_local_user_change_get_key(system_authorized_key_element_t **head, const char *name);
+bool system_local_user_change_has_keys(const system_local_user_change_t *change);
+int system_local_user_change_merge_keys(system_local_user_change_t *change);
+void system_local_user_change_map_free(system_local_user_change_t **map);
+
+#endif // SYSTEM_PLUGIN_DATA_AUTHENTICATION_LOCAL_USER_CHANGE_H
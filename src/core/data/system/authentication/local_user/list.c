@@ -32,8 +32,12 @@ int system_local_user_list_add(system_local_user_element_t **head, system_local_
 
 	// copy value
 	system_local_user_init(&new_el->user);
-	system_local_user_set_name(&new_el->user, user.name);
-	system_local_user_set_password(&new_el->user, user.password);
+	if (system_local_user_set_name(&new_el->user, user.name) || system_local_user_set_password(&new_el->user, user.password) ||
+		system_local_user_set_home(&new_el->user, user.home)) {
+		system_local_user_free(&new_el->user);
+		free(new_el);
+		return -1;
+	}
 
 	// add to list
 	LL_APPEND(*head, new_el);
@@ -35,14 +35,8 @@ int system_dns_server_set_name(system_dns_server_t *server, const char *name)
 int system_dns_server_set_address(system_dns_server_t *server, system_ip_address_t address)
 {
 	int error = 0;
-#ifdef SYSTEMD
+
 	server->address = address;
-#else
-	if (server->address.value) {
-		free((void *) server->address.value);
-	}
-	server->address.value = strdup(address.value);
-#endif
 
 	return error;
 }
@@ -62,11 +56,5 @@ void system_dns_server_free(system_dns_server_t *server)
 		free((void *) server->name);
 	}
 
-#ifndef SYSTEMD
-	if (server->address.value) {
-		free((void *) server->address.value);
-	}
-#endif
-
 	system_dns_server_init(server);
 }
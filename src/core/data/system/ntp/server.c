@@ -64,6 +64,36 @@ int system_ntp_server_set_port(system_ntp_server_t *server, const char *port)
 	return error;
 }
 
+int system_ntp_server_set_word(system_ntp_server_t *server, const char *word)
+{
+	int error = 0;
+	char *address = NULL;
+	const char *delimiter = strchr(word, ':');
+
+	// ntp.conf word is used as the server name and holds the address with an optional port
+	error = system_ntp_server_set_name(server, word);
+	if (error) {
+		return error;
+	}
+
+	if (!delimiter) {
+		return system_ntp_server_set_address(server, word);
+	}
+
+	address = strndup(word, (size_t) (delimiter - word));
+	if (!address) {
+		return -1;
+	}
+
+	error = system_ntp_server_set_address(server, address);
+	free(address);
+	if (error) {
+		return error;
+	}
+
+	return system_ntp_server_set_port(server, delimiter + 1);
+}
+
 int system_ntp_server_set_association_type(system_ntp_server_t *server, const char *association_type)
 {
 	int error = 0;
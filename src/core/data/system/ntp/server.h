@@ -19,6 +19,7 @@ void system_ntp_server_init(system_ntp_server_t *server);
 int system_ntp_server_set_name(system_ntp_server_t *server, const char *name);
 int system_ntp_server_set_address(system_ntp_server_t *server, const char *address);
 int system_ntp_server_set_port(system_ntp_server_t *server, const char *port);
+int system_ntp_server_set_word(system_ntp_server_t *server, const char *word);
 int system_ntp_server_set_association_type(system_ntp_server_t *server, const char *association_type);
 int system_ntp_server_set_iburst(system_ntp_server_t *server, const char *iburst);
 int system_ntp_server_set_prefer(system_ntp_server_t *server, const char *prefer);
@@ -0,0 +1,114 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "drift.h"
+
+#include <limits.h>
+#include <string.h>
+#include <time.h>
+
+#include <sysrepo.h>
+
+int64_t system_drift_now_ms(void)
+{
+	struct timespec ts = {0};
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (int64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+void system_drift_begin(system_ctx_t *ctx, system_subsystem_t subsystem)
+{
+	// callbacks of different requests may write the same subsystem at the same time
+	atomic_fetch_add(&ctx->drift_writers[subsystem], 1);
+}
+
+void system_drift_end(system_ctx_t *ctx, system_subsystem_t subsystem)
+{
+	// the window is set before the writer leaves - an idle subsystem is never seen with a stale window
+	atomic_store(&ctx->drift_quiet_after[subsystem], system_drift_now_ms() + SYSTEM_DRIFT_SUPPRESS_MS);
+	atomic_fetch_sub(&ctx->drift_writers[subsystem], 1);
+}
+
+int64_t system_drift_suppressed_until(system_ctx_t *ctx, system_subsystem_t subsystem, int64_t now)
+{
+	// the end of a write in progress is not known yet - the subsystem is looked at again one window later
+	if (atomic_load(&ctx->drift_writers[subsystem]) > 0) {
+		return now + SYSTEM_DRIFT_SUPPRESS_MS;
+	}
+
+	return atomic_load(&ctx->drift_quiet_after[subsystem]);
+}
+
+bool system_drift_is_own_change(sr_session_ctx_t *session)
+{
+	const char *orig_name = sr_session_get_orig_name(session);
+
+	// running already matches the system for edits made by the watcher
+	return orig_name && !strcmp(orig_name, SYSTEM_DRIFT_ORIGINATOR);
+}
+
+void system_drift_schedule_mark(system_ctx_t *ctx, system_drift_schedule_t *schedule, system_subsystem_t subsystem, int64_t delay, int64_t now)
+{
+	const uint32_t bit = 1u << subsystem;
+	const int64_t suppressed_until = system_drift_suppressed_until(ctx, subsystem, now);
+
+	// a burst of events is handled by a single reload
+	if (!(schedule->pending & bit)) {
+		schedule->due[subsystem] = now + delay;
+		schedule->pending |= bit;
+	}
+
+	// events caused by the plugin writes are looked at only after the writes are done - the reload then finds no difference
+	if (schedule->due[subsystem] < suppressed_until) {
+		schedule->due[subsystem] = suppressed_until;
+	}
+}
+
+int system_drift_schedule_timeout(const system_drift_schedule_t *schedule, int64_t now)
+{
+	int64_t timeout = -1;
+
+	for (int i = 0; i < SYSTEM_SUBSYSTEM_COUNT; i++) {
+		if (schedule->pending & (1u << i)) {
+			const int64_t left = schedule->due[i] > now ? schedule->due[i] - now : 0;
+
+			if (timeout == -1 || left < timeout) {
+				timeout = left;
+			}
+		}
+	}
+
+	return timeout > INT_MAX ? INT_MAX : (int) timeout;
+}
+
+bool system_drift_schedule_take(system_ctx_t *ctx, system_drift_schedule_t *schedule, system_subsystem_t subsystem, int64_t now)
+{
+	const uint32_t bit = 1u << subsystem;
+	int64_t suppressed_until = 0;
+
+	if (!(schedule->pending & bit) || schedule->due[subsystem] > now) {
+		return false;
+	}
+
+	// the plugin started writing the subsystem in the meantime
+	suppressed_until = system_drift_suppressed_until(ctx, subsystem, now);
+	if (suppressed_until > now) {
+		schedule->due[subsystem] = suppressed_until;
+		return false;
+	}
+
+	schedule->pending &= ~bit;
+
+	return true;
+}
@@ -0,0 +1,41 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_DRIFT_H
+#define SYSTEM_PLUGIN_DRIFT_H
+
+#include "core/context.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// originator name of the running datastore edits made by the watcher
+#define SYSTEM_DRIFT_ORIGINATOR "sysrepo-plugin-system-drift"
+
+// system file events up to this long after the last plugin write ended are treated as caused by the plugin
+#define SYSTEM_DRIFT_SUPPRESS_MS 1000
+
+// events of one subsystem are batched for this long before the subsystem is reloaded
+#define SYSTEM_DRIFT_DEBOUNCE_MS 200
+
+int64_t system_drift_now_ms(void);
+void system_drift_begin(system_ctx_t *ctx, system_subsystem_t subsystem);
+void system_drift_end(system_ctx_t *ctx, system_subsystem_t subsystem);
+int64_t system_drift_suppressed_until(system_ctx_t *ctx, system_subsystem_t subsystem, int64_t now);
+bool system_drift_is_own_change(sr_session_ctx_t *session);
+
+// reload scheduling of the watcher
+void system_drift_schedule_mark(system_ctx_t *ctx, system_drift_schedule_t *schedule, system_subsystem_t subsystem, int64_t delay, int64_t now);
+int system_drift_schedule_timeout(const system_drift_schedule_t *schedule, int64_t now);
+bool system_drift_schedule_take(system_ctx_t *ctx, system_drift_schedule_t *schedule, system_subsystem_t subsystem, int64_t now);
+
+#endif // SYSTEM_PLUGIN_DRIFT_H
@@ -0,0 +1,38 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "features.h"
+#include "core/common.h"
+
+#include <srpc.h>
+
+int system_features_reload(system_ctx_t *ctx, sr_session_ctx_t *session)
+{
+	int error = 0;
+
+	pthread_rwlock_wrlock(&ctx->features_lock);
+	error = srpc_feature_status_hash_reload(&ctx->ietf_system_features, session, IETF_SYSTEM_YANG_MODULE);
+	pthread_rwlock_unlock(&ctx->features_lock);
+
+	return error;
+}
+
+bool system_features_check(system_ctx_t *ctx, const char *feature)
+{
+	bool enabled = false;
+
+	pthread_rwlock_rdlock(&ctx->features_lock);
+	enabled = srpc_feature_status_hash_check(ctx->ietf_system_features, feature);
+	pthread_rwlock_unlock(&ctx->features_lock);
+
+	return enabled;
+}
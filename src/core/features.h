@@ -0,0 +1,24 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_FEATURES_H
+#define SYSTEM_PLUGIN_FEATURES_H
+
+#include "core/context.h"
+
+#include <stdbool.h>
+
+// ietf-system features hash access - safe to use from concurrent callbacks
+int system_features_reload(system_ctx_t *ctx, sr_session_ctx_t *session);
+bool system_features_check(system_ctx_t *ctx, const char *feature);
+
+#endif // SYSTEM_PLUGIN_FEATURES_H
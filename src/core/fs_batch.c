@@ -0,0 +1,903 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "fs_batch.h"
+#include "core/common.h"
+#include "core/log.h"
+#include "core/stats.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef SYSTEM_HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+#include <sysrepo.h>
+
+static void system_fs_chain_start(system_fs_chain_t *chain);
+static void system_fs_chain_next(system_fs_chain_t *chain);
+static void system_fs_chain_abort(system_fs_chain_t *chain, int error);
+static void system_fs_chain_run(system_fs_batch_t *batch, system_fs_chain_t *chain);
+static void system_fs_chain_finish(system_fs_batch_t *batch, system_fs_chain_t *chain);
+static int system_fs_step_execute(system_fs_chain_t *chain);
+static void system_fs_step_complete(system_fs_batch_t *batch, system_fs_chain_t *chain, int result);
+static const char *system_fs_chain_name(const system_fs_chain_t *chain, const char *path);
+static int system_fs_dir_open(const system_fs_op_t *op);
+static int system_fs_dir_repair(const system_fs_chain_t *chain, const system_fs_op_t *op);
+static int system_fs_remove_tree(int dir_fd, const char *name);
+static system_fs_step_t system_fs_op_step(const system_fs_op_t *op);
+static bool system_fs_op_has_owner(const system_fs_op_t *op);
+static const char *system_fs_op_str(system_fs_op_type_t type);
+static void system_fs_op_free(system_fs_op_t *op);
+static size_t system_fs_batch_workers(size_t chains);
+static void *system_fs_batch_worker(void *arg);
+
+#ifdef SYSTEM_HAVE_LIBURING
+static int system_fs_batch_run_uring(system_fs_batch_t *batch);
+static bool system_fs_batch_uring_supported(struct io_uring *ring);
+static bool system_fs_step_is_sync(system_fs_step_t step);
+static void system_fs_step_prepare(system_fs_chain_t *chain, struct io_uring_sqe *sqe);
+#endif
+
+// temporary files of atomic writes - unique within the process, the pid makes them unique between processes
+static _Atomic size_t system_fs_temp_counter;
+
+int system_fs_batch_chain(system_fs_batch_t *batch, size_t *chain)
+{
+	system_fs_chain_t *chains = NULL;
+
+	if (batch->count == batch->capacity) {
+		const size_t capacity = batch->capacity ? batch->capacity * 2 : 8;
+
+		chains = realloc(batch->chains, capacity * sizeof(*chains));
+		if (!chains) {
+			return -1;
+		}
+
+		batch->chains = chains;
+		batch->capacity = capacity;
+	}
+
+	batch->chains[batch->count] = (system_fs_chain_t){.fd = -1, .dir_fd = AT_FDCWD};
+	*chain = batch->count++;
+
+	return 0;
+}
+
+int system_fs_batch_set_account(system_fs_batch_t *batch, size_t chain, const char *account, bool deleted)
+{
+	system_fs_chain_t *target = &batch->chains[chain];
+
+	free(target->account);
+	target->account = strdup(account);
+	target->account_deleted = deleted;
+
+	return target->account ? 0 : -1;
+}
+
+int system_fs_batch_add(system_fs_batch_t *batch, size_t chain, const system_fs_op_t *op)
+{
+	system_fs_chain_t *target = &batch->chains[chain];
+	system_fs_op_t *ops = NULL;
+	system_fs_op_t *added = NULL;
+
+	if (target->count == target->capacity) {
+		const size_t capacity = target->capacity ? target->capacity * 2 : 4;
+
+		ops = realloc(target->ops, capacity * sizeof(*ops));
+		if (!ops) {
+			return -1;
+		}
+
+		target->ops = ops;
+		target->capacity = capacity;
+	}
+
+	added = &target->ops[target->count];
+	*added = *op;
+	added->data = NULL;
+	added->source = NULL;
+
+	// the batch is usually run after the buffers of the caller are gone
+	added->path = strdup(op->path);
+	if (op->size) {
+		added->data = malloc(op->size);
+		if (added->data) {
+			memcpy(added->data, op->data, op->size);
+		}
+	}
+	if (op->source) {
+		added->source = strdup(op->source);
+	}
+
+	if (!added->path || (op->size && !added->data) || (op->source && !added->source)) {
+		system_fs_op_free(added);
+		return -1;
+	}
+
+	target->count++;
+
+	return 0;
+}
+
+int system_fs_batch_run(system_fs_batch_t *batch)
+{
+	int error = 0;
+	pthread_t threads[SYSTEM_FS_BATCH_WORKERS_MAX] = {0};
+	size_t workers = 0;
+	size_t started = 0;
+	size_t bytes = 0;
+
+	for (size_t i = 0; i < batch->count; i++) {
+		system_fs_chain_start(&batch->chains[i]);
+	}
+
+#ifdef SYSTEM_HAVE_LIBURING
+	const char *backend = getenv(SYSTEM_FS_BATCH_BACKEND_ENV);
+
+	// chains left unfinished by a failing ring are resumed by the threads where they stopped
+	if ((!backend || strcmp(backend, "threads")) && system_fs_batch_run_uring(batch)) {
+		SYSTEM_LOG_DBG("io_uring unavailable - executing filesystem operations in threads");
+	}
+#endif
+
+	workers = system_fs_batch_workers(batch->count);
+	atomic_store(&batch->next, 0);
+
+	// the calling thread is one of the workers - the others only help when there is more than one chain
+	for (started = 0; started + 1 < workers; started++) {
+		if (pthread_create(&threads[started], NULL, system_fs_batch_worker, batch)) {
+			SRPLG_LOG_WRN(PLUGIN_NAME, "Unable to start a filesystem thread - continuing with %zu", started + 1);
+			break;
+		}
+	}
+
+	system_fs_batch_worker(batch);
+
+	for (size_t i = 0; i < started; i++) {
+		pthread_join(threads[i], NULL);
+	}
+
+	for (size_t i = 0; i < batch->count; i++) {
+		const system_fs_chain_t *chain = &batch->chains[i];
+
+		// operations before the current one are done
+		for (size_t j = 0; j < chain->current && j < chain->count; j++) {
+			if (chain->ops[j].type == SYSTEM_FS_OP_WRITE) {
+				bytes += chain->ops[j].size;
+			}
+		}
+
+		if (chain->error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "%s failed (%d) for %s", system_fs_op_str(chain->ops[chain->current].type), chain->error, chain->ops[chain->current].path);
+			error = -1;
+		}
+	}
+
+	system_stats_add_bytes(bytes);
+
+	return error;
+}
+
+void system_fs_batch_free(system_fs_batch_t *batch)
+{
+	for (size_t i = 0; i < batch->count; i++) {
+		system_fs_chain_t *chain = &batch->chains[i];
+
+		for (size_t j = 0; j < chain->count; j++) {
+			system_fs_op_free(&chain->ops[j]);
+		}
+
+		free(chain->ops);
+		free(chain->temp_path);
+		free(chain->account);
+	}
+
+	free(batch->chains);
+
+	batch->chains = NULL;
+	batch->count = 0;
+	batch->capacity = 0;
+}
+
+int system_fs_write_file_atomic(const char *path, const void *data, size_t size, mode_t mode, uid_t uid, gid_t gid)
+{
+	int error = 0;
+	int fd = -1;
+	char temp_path[PATH_MAX] = {0};
+	const uint8_t *iter = (const uint8_t *) data;
+	bool temp_created = false;
+
+	if (snprintf(temp_path, sizeof(temp_path), "%s.XXXXXX", path) >= (int) sizeof(temp_path)) {
+		goto error_out;
+	}
+
+	fd = mkstemp(temp_path);
+	if (fd == -1) {
+		goto error_out;
+	}
+	temp_created = true;
+
+	while (size) {
+		const ssize_t written = write(fd, iter, size);
+
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			goto error_out;
+		}
+
+		iter += written;
+		size -= (size_t) written;
+	}
+
+	if (fchmod(fd, mode) != 0) {
+		goto error_out;
+	}
+
+	if ((uid != (uid_t) -1 || gid != (gid_t) -1) && fchown(fd, uid, gid) != 0) {
+		goto error_out;
+	}
+
+	// data has to reach the disk before the rename makes it visible
+	if (fsync(fd) != 0) {
+		goto error_out;
+	}
+
+	error = close(fd);
+	fd = -1;
+	if (error) {
+		goto error_out;
+	}
+
+	if (rename(temp_path, path) != 0) {
+		goto error_out;
+	}
+	temp_created = false;
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	if (fd != -1) {
+		close(fd);
+	}
+
+	if (temp_created) {
+		unlink(temp_path);
+	}
+
+	return error;
+}
+
+static void system_fs_chain_start(system_fs_chain_t *chain)
+{
+	const system_fs_op_t *op = NULL;
+
+	if (chain->error || chain->current >= chain->count) {
+		chain->step = SYSTEM_FS_STEP_DONE;
+		return;
+	}
+
+	op = &chain->ops[chain->current];
+
+	// an operation below owned directories is done relative to the last of them, opened first
+	chain->step = op->owned ? SYSTEM_FS_STEP_DIR : system_fs_op_step(op);
+
+	if (op->type == SYSTEM_FS_OP_WRITE) {
+		chain->written = 0;
+
+		if (op->atomic && asprintf(&chain->temp_path, "%s.%ld.%zu", op->path, (long) getpid(), atomic_fetch_add(&system_fs_temp_counter, 1)) < 0) {
+			chain->temp_path = NULL;
+			system_fs_chain_abort(chain, ENOMEM);
+		}
+	}
+}
+
+static void system_fs_chain_next(system_fs_chain_t *chain)
+{
+	free(chain->temp_path);
+	chain->temp_path = NULL;
+
+	if (chain->dir_fd != AT_FDCWD) {
+		close(chain->dir_fd);
+		chain->dir_fd = AT_FDCWD;
+	}
+
+	chain->current++;
+	system_fs_chain_start(chain);
+}
+
+static void system_fs_chain_abort(system_fs_chain_t *chain, int error)
+{
+	if (chain->fd != -1) {
+		close(chain->fd);
+		chain->fd = -1;
+	}
+
+	// a temporary file is never left behind - the target keeps its previous content
+	if (chain->temp_path) {
+		if (chain->step > SYSTEM_FS_STEP_OPEN) {
+			unlinkat(chain->dir_fd, system_fs_chain_name(chain, chain->temp_path), 0);
+		}
+		free(chain->temp_path);
+		chain->temp_path = NULL;
+	}
+
+	if (chain->dir_fd != AT_FDCWD) {
+		close(chain->dir_fd);
+		chain->dir_fd = AT_FDCWD;
+	}
+
+	chain->error = error;
+	chain->step = SYSTEM_FS_STEP_DONE;
+}
+
+static void system_fs_chain_run(system_fs_batch_t *batch, system_fs_chain_t *chain)
+{
+	while (chain->step != SYSTEM_FS_STEP_DONE) {
+		system_fs_step_complete(batch, chain, system_fs_step_execute(chain));
+	}
+}
+
+static void system_fs_chain_finish(system_fs_batch_t *batch, system_fs_chain_t *chain)
+{
+	// chains finished on io_uring are passed to the threads as well - they are reported only once
+	if (chain->finished || chain->step != SYSTEM_FS_STEP_DONE) {
+		return;
+	}
+
+	chain->finished = true;
+
+	if (!chain->error && batch->chain_done) {
+		batch->chain_done(batch->chain_done_arg, (size_t) (chain - batch->chains));
+	}
+}
+
+static int system_fs_step_execute(system_fs_chain_t *chain)
+{
+	const system_fs_op_t *op = &chain->ops[chain->current];
+	ssize_t written = 0;
+	int result = 0;
+
+	// results follow io_uring completions - a value or a negative errno
+	switch (chain->step) {
+		case SYSTEM_FS_STEP_DIR:
+			return system_fs_dir_open(op);
+		case SYSTEM_FS_STEP_MKDIR:
+			result = mkdirat(chain->dir_fd, system_fs_chain_name(chain, op->path), op->mode);
+			break;
+		case SYSTEM_FS_STEP_CHOWN:
+			result = fchownat(chain->dir_fd, system_fs_chain_name(chain, op->path), op->uid, op->gid, AT_SYMLINK_NOFOLLOW);
+			break;
+		case SYSTEM_FS_STEP_REPAIR:
+			return system_fs_dir_repair(chain, op);
+		case SYSTEM_FS_STEP_OPEN:
+			result = openat(chain->dir_fd, system_fs_chain_name(chain, op->atomic ? chain->temp_path : op->path), O_WRONLY | O_CREAT | O_NOFOLLOW | O_CLOEXEC | (op->atomic ? O_EXCL : O_TRUNC), op->mode);
+			break;
+		case SYSTEM_FS_STEP_WRITE:
+			written = write(chain->fd, (const char *) op->data + chain->written, op->size - chain->written);
+			return written < 0 ? -errno : (int) written;
+		case SYSTEM_FS_STEP_ATTRIBUTES:
+			// the mode given to open() is masked by the umask
+			result = fchmod(chain->fd, op->mode);
+			if (!result && system_fs_op_has_owner(op)) {
+				result = fchown(chain->fd, op->uid, op->gid);
+			}
+			break;
+		case SYSTEM_FS_STEP_FSYNC:
+			result = fsync(chain->fd);
+			break;
+		case SYSTEM_FS_STEP_CLOSE:
+			result = close(chain->fd);
+			break;
+		case SYSTEM_FS_STEP_RENAME:
+			result = renameat(chain->dir_fd, system_fs_chain_name(chain, chain->temp_path), chain->dir_fd, system_fs_chain_name(chain, op->path));
+			break;
+		case SYSTEM_FS_STEP_UNLINK:
+			result = unlinkat(chain->dir_fd, system_fs_chain_name(chain, op->path), 0);
+			break;
+		case SYSTEM_FS_STEP_REMOVE:
+			return system_fs_remove_tree(chain->dir_fd, system_fs_chain_name(chain, op->path));
+		case SYSTEM_FS_STEP_DONE:
+			break;
+	}
+
+	return result < 0 ? -errno : result;
+}
+
+static void system_fs_step_complete(system_fs_batch_t *batch, system_fs_chain_t *chain, int result)
+{
+	const system_fs_op_t *op = &chain->ops[chain->current];
+
+	// the descriptor is gone even when close() fails
+	if (chain->step == SYSTEM_FS_STEP_CLOSE) {
+		chain->fd = -1;
+	}
+
+	if (result < 0) {
+		if (chain->step == SYSTEM_FS_STEP_MKDIR && result == -EEXIST && op->repair) {
+			chain->step = SYSTEM_FS_STEP_REPAIR;
+		} else if (chain->step == SYSTEM_FS_STEP_MKDIR && result == -EEXIST && !op->exclusive) {
+			system_fs_chain_next(chain);
+		} else if ((chain->step == SYSTEM_FS_STEP_UNLINK || chain->step == SYSTEM_FS_STEP_REMOVE) && result == -ENOENT) {
+			system_fs_chain_next(chain);
+		} else if (chain->step == SYSTEM_FS_STEP_WRITE && (result == -EINTR || result == -EAGAIN)) {
+			// retried
+		} else {
+			system_fs_chain_abort(chain, -result);
+		}
+		return;
+	}
+
+	switch (chain->step) {
+		case SYSTEM_FS_STEP_DIR:
+			chain->dir_fd = result;
+			chain->step = system_fs_op_step(op);
+			break;
+		case SYSTEM_FS_STEP_MKDIR:
+			// a replay may only repair what was created here - an existing directory of someone else is not given away
+			if (batch->dir_created) {
+				batch->dir_created(batch->chain_done_arg, (size_t) (chain - batch->chains), chain->current);
+			}
+
+			// only a directory created here gets the owner
+			if (system_fs_op_has_owner(op)) {
+				chain->step = SYSTEM_FS_STEP_CHOWN;
+			} else {
+				system_fs_chain_next(chain);
+			}
+			break;
+		case SYSTEM_FS_STEP_OPEN:
+			chain->fd = result;
+			chain->step = op->size ? SYSTEM_FS_STEP_WRITE : SYSTEM_FS_STEP_ATTRIBUTES;
+			break;
+		case SYSTEM_FS_STEP_WRITE:
+			if (result == 0) {
+				system_fs_chain_abort(chain, EIO);
+				break;
+			}
+
+			chain->written += (size_t) result;
+			if (chain->written == op->size) {
+				chain->step = SYSTEM_FS_STEP_ATTRIBUTES;
+			}
+			break;
+		case SYSTEM_FS_STEP_ATTRIBUTES:
+			// data has to reach the disk before the rename makes it visible
+			chain->step = op->atomic ? SYSTEM_FS_STEP_FSYNC : SYSTEM_FS_STEP_CLOSE;
+			break;
+		case SYSTEM_FS_STEP_FSYNC:
+			chain->step = SYSTEM_FS_STEP_CLOSE;
+			break;
+		case SYSTEM_FS_STEP_CLOSE:
+			if (op->atomic) {
+				chain->step = SYSTEM_FS_STEP_RENAME;
+			} else {
+				system_fs_chain_next(chain);
+			}
+			break;
+		case SYSTEM_FS_STEP_CHOWN:
+		case SYSTEM_FS_STEP_REPAIR:
+		case SYSTEM_FS_STEP_UNLINK:
+		case SYSTEM_FS_STEP_REMOVE:
+			system_fs_chain_next(chain);
+			break;
+		case SYSTEM_FS_STEP_RENAME:
+			// the temporary file is the target now
+			free(chain->temp_path);
+			chain->temp_path = NULL;
+			system_fs_chain_next(chain);
+			break;
+		case SYSTEM_FS_STEP_DONE:
+			break;
+	}
+}
+
+static const char *system_fs_chain_name(const system_fs_chain_t *chain, const char *path)
+{
+	// relative to the opened directory - the entry is the last component of the path
+	return chain->dir_fd == AT_FDCWD ? path : strrchr(path, '/') + 1;
+}
+
+static int system_fs_dir_open(const system_fs_op_t *op)
+{
+	char buffer[PATH_MAX] = {0};
+	char *slash = NULL;
+	const char *name = NULL;
+	struct stat st = {0};
+	int fd = -1;
+	int next = -1;
+	int error = 0;
+
+	if (strlen(op->path) >= sizeof(buffer)) {
+		return -ENAMETOOLONG;
+	}
+	strcpy(buffer, op->path);
+
+	// split the owned directories above the entry off the path - the part above them is resolved as usual
+	slash = strrchr(buffer, '/');
+	for (uint8_t i = 0; slash && i < op->owned; i++) {
+		*slash = 0;
+		slash = memrchr(buffer, '/', (size_t) (slash - buffer));
+	}
+	if (!slash) {
+		return -EINVAL;
+	}
+	*slash = 0;
+
+	fd = open(buffer[0] ? buffer : "/", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (fd == -1) {
+		return -errno;
+	}
+
+	// a user may replace a directory it owns with a symlink to one it may not write to
+	name = slash + 1;
+	for (uint8_t i = 0; i < op->owned; i++, name += strlen(name) + 1) {
+		next = openat(fd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+		error = next == -1 ? -errno : 0;
+		close(fd);
+		fd = next;
+
+		if (!error && fstat(fd, &st) != 0) {
+			error = -errno;
+		}
+
+		if (!error && op->uid != (uid_t) -1 && st.st_uid != op->uid) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "%s above %s is not owned by uid %u", name, op->path, (unsigned int) op->uid);
+			error = -EPERM;
+		}
+
+		if (error) {
+			if (fd != -1) {
+				close(fd);
+			}
+			return error;
+		}
+	}
+
+	return fd;
+}
+
+static int system_fs_dir_repair(const system_fs_chain_t *chain, const system_fs_op_t *op)
+{
+	struct stat st = {0};
+	int result = 0;
+	int fd = openat(chain->dir_fd, system_fs_chain_name(chain, op->path), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+
+	if (fd == -1) {
+		return -errno;
+	}
+
+	if (fstat(fd, &st) != 0) {
+		result = -errno;
+	} else if (st.st_uid == geteuid() || (system_fs_op_has_owner(op) && st.st_uid == op->uid)) {
+		// created before an interruption, maybe without its owner and mode yet
+		if (fchmod(fd, op->mode) != 0 || (system_fs_op_has_owner(op) && fchown(fd, op->uid, op->gid) != 0)) {
+			result = -errno;
+		}
+	} else if (op->exclusive) {
+		// someone else's directory is still not given away
+		result = -EEXIST;
+	}
+
+	close(fd);
+
+	return result;
+}
+
+static int system_fs_remove_tree(int dir_fd, const char *name)
+{
+	struct stat st = {0};
+	struct dirent *entry = NULL;
+	DIR *dir = NULL;
+	int result = 0;
+	int fd = -1;
+
+	if (fstatat(dir_fd, name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+		return -errno;
+	}
+
+	// a symlink is removed itself - whatever it points to stays
+	if (!S_ISDIR(st.st_mode)) {
+		return unlinkat(dir_fd, name, 0) == 0 ? 0 : -errno;
+	}
+
+	// the entries are removed relative to the opened directory, so a directory replaced meanwhile is not followed
+	fd = openat(dir_fd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+	if (fd == -1) {
+		return -errno;
+	}
+
+	dir = fdopendir(fd);
+	if (!dir) {
+		result = -errno;
+		close(fd);
+		return result;
+	}
+
+	while ((entry = readdir(dir)) != NULL) {
+		if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, "..")) {
+			continue;
+		}
+
+		result = system_fs_remove_tree(dirfd(dir), entry->d_name);
+		if (result == -ENOENT) {
+			result = 0;
+		} else if (result) {
+			break;
+		}
+	}
+
+	closedir(dir);
+
+	if (result) {
+		return result;
+	}
+
+	return unlinkat(dir_fd, name, AT_REMOVEDIR) == 0 ? 0 : -errno;
+}
+
+static system_fs_step_t system_fs_op_step(const system_fs_op_t *op)
+{
+	switch (op->type) {
+		case SYSTEM_FS_OP_MKDIR:
+			return SYSTEM_FS_STEP_MKDIR;
+		case SYSTEM_FS_OP_WRITE:
+			return SYSTEM_FS_STEP_OPEN;
+		case SYSTEM_FS_OP_UNLINK:
+			return SYSTEM_FS_STEP_UNLINK;
+		case SYSTEM_FS_OP_REMOVE:
+			return SYSTEM_FS_STEP_REMOVE;
+	}
+
+	return SYSTEM_FS_STEP_DONE;
+}
+
+static bool system_fs_op_has_owner(const system_fs_op_t *op)
+{
+	return op->uid != (uid_t) -1 || op->gid != (gid_t) -1;
+}
+
+static const char *system_fs_op_str(system_fs_op_type_t type)
+{
+	switch (type) {
+		case SYSTEM_FS_OP_MKDIR:
+			return "mkdir";
+		case SYSTEM_FS_OP_WRITE:
+			return "write";
+		case SYSTEM_FS_OP_UNLINK:
+			return "unlink";
+		case SYSTEM_FS_OP_REMOVE:
+			return "remove";
+	}
+
+	return "unknown";
+}
+
+static void system_fs_op_free(system_fs_op_t *op)
+{
+	free(op->path);
+	free(op->source);
+
+	// written files may be private keys or account data
+	if (op->data) {
+		explicit_bzero(op->data, op->size);
+		free(op->data);
+	}
+
+	*op = (system_fs_op_t){0};
+}
+
+static size_t system_fs_batch_workers(size_t chains)
+{
+	const char *env = getenv(SYSTEM_FS_BATCH_WORKERS_ENV);
+	long workers = 0;
+
+	if (env && *env) {
+		workers = strtol(env, NULL, 10);
+	} else {
+		workers = sysconf(_SC_NPROCESSORS_ONLN);
+	}
+
+	if (workers < 1) {
+		workers = 1;
+	} else if (workers > SYSTEM_FS_BATCH_WORKERS_MAX) {
+		workers = SYSTEM_FS_BATCH_WORKERS_MAX;
+	}
+
+	return (size_t) workers < chains ? (size_t) workers : (chains ? chains : 1);
+}
+
+static void *system_fs_batch_worker(void *arg)
+{
+	system_fs_batch_t *batch = arg;
+
+	for (size_t i = atomic_fetch_add(&batch->next, 1); i < batch->count; i = atomic_fetch_add(&batch->next, 1)) {
+		system_fs_chain_run(batch, &batch->chains[i]);
+		system_fs_chain_finish(batch, &batch->chains[i]);
+	}
+
+	return NULL;
+}
+
+#ifdef SYSTEM_HAVE_LIBURING
+
+static int system_fs_batch_run_uring(system_fs_batch_t *batch)
+{
+	int error = 0;
+	struct io_uring ring;
+	struct io_uring_sqe *sqe = NULL;
+	struct io_uring_cqe *cqe = NULL;
+	unsigned int pending = 0;
+	size_t rounds = 0;
+
+	if (!batch->count) {
+		return 0;
+	}
+
+	error = io_uring_queue_init(batch->count < SYSTEM_FS_BATCH_QUEUE_DEPTH ? (unsigned int) batch->count : SYSTEM_FS_BATCH_QUEUE_DEPTH, &ring, 0);
+	if (error < 0) {
+		// e.g. disabled by a seccomp filter or kernel.io_uring_disabled
+		return -1;
+	}
+
+	if (!system_fs_batch_uring_supported(&ring)) {
+		io_uring_queue_exit(&ring);
+		return -1;
+	}
+
+	// each round submits the next system call of every chain - chains beyond the queue depth wait for the next one
+	for (;;) {
+		pending = 0;
+
+		for (size_t i = 0; i < batch->count; i++) {
+			system_fs_chain_t *chain = &batch->chains[i];
+
+			// steps without an io_uring operation (opening the owned directories, fchmod, fchown, chown, repairs, removing
+			// directory trees) are executed in place
+			while (chain->step != SYSTEM_FS_STEP_DONE && system_fs_step_is_sync(chain->step)) {
+				system_fs_step_complete(batch, chain, system_fs_step_execute(chain));
+			}
+
+			if (chain->step == SYSTEM_FS_STEP_DONE) {
+				system_fs_chain_finish(batch, chain);
+				continue;
+			}
+
+			sqe = io_uring_get_sqe(&ring);
+			if (!sqe) {
+				break;
+			}
+
+			system_fs_step_prepare(chain, sqe);
+			io_uring_sqe_set_data(sqe, chain);
+			pending++;
+		}
+
+		if (!pending) {
+			break;
+		}
+
+		error = io_uring_submit_and_wait(&ring, pending);
+		if (error < 0 || (unsigned int) error != pending) {
+			// entries which were not submitted leave their chains where they were
+			SRPLG_LOG_WRN(PLUGIN_NAME, "io_uring_submit_and_wait() error (%d)", error);
+			pending = error < 0 ? 0 : (unsigned int) error;
+			error = -1;
+		} else {
+			error = 0;
+		}
+
+		for (unsigned int i = 0; i < pending; i++) {
+			if (io_uring_wait_cqe(&ring, &cqe) < 0) {
+				error = -1;
+				break;
+			}
+
+			system_fs_chain_t *chain = io_uring_cqe_get_data(cqe);
+
+			system_fs_step_complete(batch, chain, cqe->res);
+			system_fs_chain_finish(batch, chain);
+
+			io_uring_cqe_seen(&ring, cqe);
+		}
+
+		if (error) {
+			break;
+		}
+
+		rounds++;
+	}
+
+	io_uring_queue_exit(&ring);
+
+	SYSTEM_LOG_DBG("Executed %zu filesystem operation chains in %zu io_uring rounds", batch->count, rounds);
+
+	return error;
+}
+
+static bool system_fs_batch_uring_supported(struct io_uring *ring)
+{
+	const int opcodes[] = {
+		IORING_OP_MKDIRAT, IORING_OP_OPENAT, IORING_OP_WRITE, IORING_OP_FSYNC, IORING_OP_CLOSE, IORING_OP_RENAMEAT, IORING_OP_UNLINKAT,
+	};
+	struct io_uring_probe *probe = io_uring_get_probe_ring(ring);
+	bool supported = probe != NULL;
+
+	// mkdirat needs 5.15
+	for (size_t i = 0; supported && i < ARRAY_SIZE(opcodes); i++) {
+		supported = io_uring_opcode_supported(probe, opcodes[i]);
+	}
+
+	if (probe) {
+		io_uring_free_probe(probe);
+	}
+
+	return supported;
+}
+
+static bool system_fs_step_is_sync(system_fs_step_t step)
+{
+	return step == SYSTEM_FS_STEP_DIR || step == SYSTEM_FS_STEP_CHOWN || step == SYSTEM_FS_STEP_REPAIR || step == SYSTEM_FS_STEP_ATTRIBUTES || step == SYSTEM_FS_STEP_REMOVE;
+}
+
+static void system_fs_step_prepare(system_fs_chain_t *chain, struct io_uring_sqe *sqe)
+{
+	const system_fs_op_t *op = &chain->ops[chain->current];
+
+	switch (chain->step) {
+		case SYSTEM_FS_STEP_MKDIR:
+			io_uring_prep_mkdirat(sqe, chain->dir_fd, system_fs_chain_name(chain, op->path), op->mode);
+			break;
+		case SYSTEM_FS_STEP_OPEN:
+			io_uring_prep_openat(sqe, chain->dir_fd, system_fs_chain_name(chain, op->atomic ? chain->temp_path : op->path), O_WRONLY | O_CREAT | O_NOFOLLOW | O_CLOEXEC | (op->atomic ? O_EXCL : O_TRUNC), op->mode);
+			break;
+		case SYSTEM_FS_STEP_WRITE:
+			io_uring_prep_write(sqe, chain->fd, (const char *) op->data + chain->written, (unsigned int) (op->size - chain->written), (__u64) chain->written);
+			break;
+		case SYSTEM_FS_STEP_FSYNC:
+			io_uring_prep_fsync(sqe, chain->fd, 0);
+			break;
+		case SYSTEM_FS_STEP_CLOSE:
+			io_uring_prep_close(sqe, chain->fd);
+			break;
+		case SYSTEM_FS_STEP_RENAME:
+			io_uring_prep_renameat(sqe, chain->dir_fd, system_fs_chain_name(chain, chain->temp_path), chain->dir_fd, system_fs_chain_name(chain, op->path), 0);
+			break;
+		case SYSTEM_FS_STEP_UNLINK:
+			io_uring_prep_unlinkat(sqe, chain->dir_fd, system_fs_chain_name(chain, op->path), 0);
+			break;
+		case SYSTEM_FS_STEP_DIR:
+		case SYSTEM_FS_STEP_CHOWN:
+		case SYSTEM_FS_STEP_REPAIR:
+		case SYSTEM_FS_STEP_ATTRIBUTES:
+		case SYSTEM_FS_STEP_REMOVE:
+		case SYSTEM_FS_STEP_DONE:
+			break;
+	}
+}
+
+#endif
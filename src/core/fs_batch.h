@@ -0,0 +1,43 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_FS_BATCH_H
+#define SYSTEM_PLUGIN_FS_BATCH_H
+
+#include "core/types.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+/**
+ * Batch of filesystem operations split into chains - usually one per user. The operations of a chain are executed in
+ * order, chains are independent of each other. When built with liburing, every round submits the next system call of
+ * all chains to io_uring at once; without it, or when the kernel lacks the needed operations, the chains are spread
+ * over at most SYSTEM_FS_BATCH_WORKERS_MAX threads, the calling thread being one of them.
+ *
+ * system_fs_batch_set_account() names the user a chain is created or deleted for - the journal uses it to decide
+ * whether the chain of an interrupted change is completed.
+ */
+int system_fs_batch_chain(system_fs_batch_t *batch, size_t *chain);
+int system_fs_batch_set_account(system_fs_batch_t *batch, size_t chain, const char *account, bool deleted);
+int system_fs_batch_add(system_fs_batch_t *batch, size_t chain, const system_fs_op_t *op);
+int system_fs_batch_run(system_fs_batch_t *batch);
+void system_fs_batch_free(system_fs_batch_t *batch);
+
+/**
+ * Single file counterpart of an atomic SYSTEM_FS_OP_WRITE for callers outside of a batch: the data is written to a
+ * temporary file next to path, synced and renamed over it. The owner is kept when uid and gid are both (uid_t) -1.
+ */
+int system_fs_write_file_atomic(const char *path, const void *data, size_t size, mode_t mode, uid_t uid, gid_t gid);
+
+#endif // SYSTEM_PLUGIN_FS_BATCH_H
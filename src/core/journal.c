@@ -0,0 +1,682 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "journal.h"
+#include "core/common.h"
+#include "core/fs_batch.h"
+#include "core/log.h"
+#include "core/root.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <linux/limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sysrepo.h>
+
+// record types - BEGIN holds the whole batch, COMMIT, DONE and CREATED refer to it by its ID
+enum {
+	SYSTEM_JOURNAL_RECORD_BEGIN = 1,
+	SYSTEM_JOURNAL_RECORD_COMMIT,
+	SYSTEM_JOURNAL_RECORD_DONE,
+	SYSTEM_JOURNAL_RECORD_CREATED,
+};
+
+typedef struct {
+	uint32_t type;
+	uint32_t size;	   ///< Size of the payload following the header.
+	uint32_t checksum; ///< FNV-1a of the type and the payload - a torn record ends the journal.
+} system_journal_record_t;
+
+static int system_journal_open(system_journal_t *journal, bool create);
+static int system_journal_append(system_journal_t *journal, uint32_t type, const void *payload, size_t size, const char *prefix);
+static uint32_t system_journal_checksum(uint32_t type, const void *payload, size_t size);
+static void system_journal_chain_done(void *arg, size_t chain);
+static void system_journal_dir_created(void *arg, size_t chain, size_t op);
+static int system_journal_batch_write(FILE *stream, const system_fs_batch_t *batch);
+static int system_journal_batch_read(const char *payload, size_t size, const bool *done, uint64_t (*created)[2], size_t created_count, bool committed, system_fs_batch_t *batch);
+static bool system_journal_created(uint64_t (*created)[2], size_t created_count, size_t chain, size_t op);
+static bool system_journal_account_exists(const char *account);
+static int system_journal_source_read(const char *path, char **data, size_t *size);
+static int system_journal_read(const char **iter, const char *end, void *value, size_t size);
+
+int system_journal_begin(system_journal_t *journal, system_fs_batch_t *batch, bool committed)
+{
+	int error = 0;
+	struct timespec now = {0};
+	struct stat st = {0};
+	FILE *stream = NULL;
+	char *payload = NULL;
+	size_t payload_size = 0;
+	uint32_t committed_value = committed;
+
+	error = system_journal_open(journal, true);
+	if (error) {
+		goto error_out;
+	}
+
+	// recovery only runs at start - records found here were left by a process which could not end its batch
+	if (fstat(journal->fd, &st) == 0 && st.st_size > 0) {
+		SRPLG_LOG_WRN(PLUGIN_NAME, "Discarding %jd bytes of stale journal records", (intmax_t) st.st_size);
+		if (ftruncate(journal->fd, 0) != 0) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "ftruncate() failed (%d) for the journal", errno);
+			goto error_out;
+		}
+	}
+
+	clock_gettime(CLOCK_REALTIME, &now);
+	journal->id = (uint64_t) now.tv_sec * 1000000000u + (uint64_t) now.tv_nsec;
+
+	stream = open_memstream(&payload, &payload_size);
+	if (!stream) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "open_memstream() failed");
+		goto error_out;
+	}
+
+	fwrite(&journal->id, sizeof(journal->id), 1, stream);
+	fwrite(&committed_value, sizeof(committed_value), 1, stream);
+
+	error = system_journal_batch_write(stream, batch);
+	if (fclose(stream) || error) {
+		stream = NULL;
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to serialize the filesystem batch");
+		goto error_out;
+	}
+	stream = NULL;
+
+	// the intents have to be on the disk before any of them is carried out
+	error = system_journal_append(journal, SYSTEM_JOURNAL_RECORD_BEGIN, payload, payload_size, SYSTEM_JOURNAL_MAGIC);
+	if (error || fdatasync(journal->fd) != 0) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to write the journal (%d)", errno);
+		goto error_out;
+	}
+
+	batch->chain_done = system_journal_chain_done;
+	batch->dir_created = system_journal_dir_created;
+	batch->chain_done_arg = journal;
+
+	goto out;
+
+error_out:
+	error = -1;
+
+	if (stream) {
+		fclose(stream);
+	}
+
+	system_journal_end(journal);
+
+out:
+	// the operations may carry key material
+	if (payload) {
+		explicit_bzero(payload, payload_size);
+		free(payload);
+	}
+
+	return error;
+}
+
+int system_journal_commit(system_journal_t *journal)
+{
+	// a batch without a durable commit is dropped at start - the commit is synced like the intents
+	if (system_journal_append(journal, SYSTEM_JOURNAL_RECORD_COMMIT, &journal->id, sizeof(journal->id), NULL) || fdatasync(journal->fd) != 0) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to write the journal commit (%d)", errno);
+		return -1;
+	}
+
+	return 0;
+}
+
+void system_journal_end(system_journal_t *journal)
+{
+	if (journal->fd == -1) {
+		return;
+	}
+
+	// not synced - a lost truncation only repeats finished operations
+	if (ftruncate(journal->fd, 0) != 0) {
+		SRPLG_LOG_WRN(PLUGIN_NAME, "ftruncate() failed (%d) for the journal", errno);
+	}
+
+	// releases the lock as well
+	close(journal->fd);
+	journal->fd = -1;
+}
+
+int system_journal_recover(void)
+{
+	int error = 0;
+	system_journal_t journal = {.fd = -1};
+	system_fs_batch_t batch = {0};
+	system_journal_record_t record = {0};
+	struct stat st = {0};
+	char *data = NULL;
+	const char *iter = NULL, *end = NULL;
+	const char *begin = NULL;
+	size_t begin_size = 0;
+	ssize_t read_size = 0;
+	uint64_t id = 0;
+	uint64_t value = 0;
+	uint32_t committed = 0;
+	uint32_t chain_count = 0;
+	bool *done = NULL;
+	uint64_t (*created)[2] = NULL;
+	size_t created_count = 0;
+	void *created_new = NULL;
+
+	error = system_journal_open(&journal, false);
+	if (error) {
+		// nothing was journaled yet
+		return error > 0 ? 0 : -1;
+	}
+
+	if (fstat(journal.fd, &st) != 0) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "fstat() failed (%d) for the journal", errno);
+		goto error_out;
+	}
+
+	if (st.st_size == 0) {
+		goto out;
+	}
+
+	data = malloc((size_t) st.st_size);
+	if (!data) {
+		goto error_out;
+	}
+
+	for (size_t offset = 0; offset < (size_t) st.st_size; offset += (size_t) read_size) {
+		read_size = pread(journal.fd, data + offset, (size_t) st.st_size - offset, (off_t) offset);
+		if (read_size <= 0) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "pread() failed (%d) for the journal", errno);
+			goto error_out;
+		}
+	}
+
+	iter = data;
+	end = data + st.st_size;
+
+	if ((size_t) st.st_size < sizeof(SYSTEM_JOURNAL_MAGIC) - 1 || memcmp(iter, SYSTEM_JOURNAL_MAGIC, sizeof(SYSTEM_JOURNAL_MAGIC) - 1)) {
+		SRPLG_LOG_WRN(PLUGIN_NAME, "The journal has an unknown format - discarding it");
+		goto out;
+	}
+	iter += sizeof(SYSTEM_JOURNAL_MAGIC) - 1;
+
+	// records are read up to the first incomplete one - it was being appended when the process stopped
+	while (!system_journal_read(&iter, end, &record, sizeof(record))) {
+		if (record.size > (size_t) (end - iter) || record.checksum != system_journal_checksum(record.type, iter, record.size)) {
+			break;
+		}
+
+		switch (record.type) {
+			case SYSTEM_JOURNAL_RECORD_BEGIN:
+				if (begin || record.size < sizeof(id) + sizeof(committed) + sizeof(chain_count)) {
+					break;
+				}
+
+				begin = iter;
+				begin_size = record.size;
+				memcpy(&id, begin, sizeof(id));
+				memcpy(&committed, begin + sizeof(id), sizeof(committed));
+				memcpy(&chain_count, begin + sizeof(id) + sizeof(committed), sizeof(chain_count));
+
+				if (chain_count > begin_size) {
+					begin = NULL;
+					break;
+				}
+
+				done = calloc(chain_count ? chain_count : 1, sizeof(*done));
+				if (!done) {
+					goto error_out;
+				}
+				break;
+			case SYSTEM_JOURNAL_RECORD_COMMIT:
+				if (begin && record.size == sizeof(value) && !memcmp(&id, iter, sizeof(id))) {
+					committed = 1;
+				}
+				break;
+			case SYSTEM_JOURNAL_RECORD_DONE:
+				if (begin && record.size == sizeof(id) + sizeof(value) && !memcmp(&id, iter, sizeof(id))) {
+					memcpy(&value, iter + sizeof(id), sizeof(value));
+					if (value < chain_count) {
+						done[value] = true;
+					}
+				}
+				break;
+			case SYSTEM_JOURNAL_RECORD_CREATED:
+				if (begin && record.size == sizeof(id) + sizeof(*created) && !memcmp(&id, iter, sizeof(id))) {
+					created_new = realloc(created, (created_count + 1) * sizeof(*created));
+					if (!created_new) {
+						goto error_out;
+					}
+					created = created_new;
+					memcpy(created[created_count++], iter + sizeof(id), sizeof(*created));
+				}
+				break;
+			default:
+				break;
+		}
+
+		iter += record.size;
+	}
+
+	if (!begin) {
+		goto out;
+	}
+
+	error = system_journal_batch_read(begin, begin_size, done, created, created_count, committed, &batch);
+	if (error) {
+		SRPLG_LOG_WRN(PLUGIN_NAME, "The journaled filesystem batch is damaged - discarding it");
+		goto out;
+	}
+
+	if (!batch.count) {
+		if (!committed) {
+			SYSTEM_LOG_INF("Dropping the journaled filesystem operations of a user change which did not reach the system");
+		}
+		goto out;
+	}
+
+	SYSTEM_LOG_INF("Completing %zu unfinished filesystem operation chains of the last user change", batch.count);
+
+	error = system_fs_batch_run(&batch);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to complete the journaled filesystem operations");
+		goto error_out;
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	// a failed recovery is not repeated on every start - the operations are logged above
+	system_journal_end(&journal);
+	system_fs_batch_free(&batch);
+
+	if (data) {
+		explicit_bzero(data, (size_t) st.st_size);
+		free(data);
+	}
+
+	free(done);
+	free(created);
+
+	return error;
+}
+
+static int system_journal_open(system_journal_t *journal, bool create)
+{
+	char state_path_buffer[PATH_MAX] = {0};
+	char path_buffer[PATH_MAX] = {0};
+	int dir_fd = -1;
+
+	journal->fd = -1;
+
+	if (system_root_path(state_path_buffer, sizeof(state_path_buffer), SYSTEM_PLUGIN_STATE_DIRECTORY) || system_root_path(path_buffer, sizeof(path_buffer), SYSTEM_JOURNAL_FILE)) {
+		return -1;
+	}
+
+	journal->fd = open(path_buffer, O_RDWR | O_APPEND | O_CLOEXEC);
+	if (journal->fd == -1 && errno == ENOENT) {
+		if (!create) {
+			return 1;
+		}
+
+		if (mkdir(state_path_buffer, 0755) != 0 && errno != EEXIST) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "mkdir() failed (%d) for %s", errno, state_path_buffer);
+			return -1;
+		}
+
+		// the file is kept once created - its directory entry is synced only here
+		journal->fd = open(path_buffer, O_RDWR | O_APPEND | O_CLOEXEC | O_CREAT, 0600);
+		if (journal->fd != -1) {
+			dir_fd = open(state_path_buffer, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+			if (dir_fd != -1) {
+				fsync(dir_fd);
+				close(dir_fd);
+			}
+		}
+	}
+
+	if (journal->fd == -1) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "open() failed (%d) for %s", errno, path_buffer);
+		return -1;
+	}
+
+	// one batch at a time, also between the plugin and the standalone executable
+	while (flock(journal->fd, LOCK_EX) != 0) {
+		if (errno != EINTR) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "flock() failed (%d) for %s", errno, path_buffer);
+			close(journal->fd);
+			journal->fd = -1;
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static int system_journal_append(system_journal_t *journal, uint32_t type, const void *payload, size_t size, const char *prefix)
+{
+	const size_t prefix_size = prefix ? strlen(prefix) : 0;
+	const system_journal_record_t record = {
+		.type = type,
+		.size = (uint32_t) size,
+		.checksum = system_journal_checksum(type, payload, size),
+	};
+	char *buffer = NULL;
+	size_t buffer_size = prefix_size + sizeof(record) + size;
+	ssize_t written = 0;
+
+	if (size > UINT32_MAX) {
+		return -1;
+	}
+
+	buffer = malloc(buffer_size);
+	if (!buffer) {
+		return -1;
+	}
+
+	if (prefix_size) {
+		memcpy(buffer, prefix, prefix_size);
+	}
+	memcpy(buffer + prefix_size, &record, sizeof(record));
+	memcpy(buffer + prefix_size + sizeof(record), payload, size);
+
+	// a single write per record - records of concurrently finished chains do not interleave
+	for (size_t offset = 0; offset < buffer_size; offset += (size_t) written) {
+		written = write(journal->fd, buffer + offset, buffer_size - offset);
+		if (written < 0 && errno == EINTR) {
+			written = 0;
+		} else if (written <= 0) {
+			break;
+		}
+	}
+
+	explicit_bzero(buffer, buffer_size);
+	free(buffer);
+
+	return written <= 0 ? -1 : 0;
+}
+
+static uint32_t system_journal_checksum(uint32_t type, const void *payload, size_t size)
+{
+	const unsigned char *iter = payload;
+	uint32_t hash = 2166136261u;
+
+	for (size_t i = 0; i < sizeof(type); i++) {
+		hash = (hash ^ ((type >> (i * 8)) & 0xff)) * 16777619u;
+	}
+
+	for (size_t i = 0; i < size; i++) {
+		hash = (hash ^ iter[i]) * 16777619u;
+	}
+
+	return hash;
+}
+
+static void system_journal_chain_done(void *arg, size_t chain)
+{
+	system_journal_t *journal = arg;
+	char payload[sizeof(uint64_t) * 2] = {0};
+	const uint64_t index = chain;
+
+	memcpy(payload, &journal->id, sizeof(journal->id));
+	memcpy(payload + sizeof(journal->id), &index, sizeof(index));
+
+	// not synced - a lost record only repeats the chain
+	if (system_journal_append(journal, SYSTEM_JOURNAL_RECORD_DONE, payload, sizeof(payload), NULL)) {
+		SRPLG_LOG_WRN(PLUGIN_NAME, "Unable to record a finished filesystem chain in the journal (%d)", errno);
+	}
+}
+
+static void system_journal_dir_created(void *arg, size_t chain, size_t op)
+{
+	system_journal_t *journal = arg;
+	char payload[sizeof(uint64_t) * 3] = {0};
+	const uint64_t index[2] = {chain, op};
+
+	memcpy(payload, &journal->id, sizeof(journal->id));
+	memcpy(payload + sizeof(journal->id), index, sizeof(index));
+
+	// not synced - without the record, the directory is not repaired but refused like one which existed before
+	if (system_journal_append(journal, SYSTEM_JOURNAL_RECORD_CREATED, payload, sizeof(payload), NULL)) {
+		SRPLG_LOG_WRN(PLUGIN_NAME, "Unable to record a created directory in the journal (%d)", errno);
+	}
+}
+
+static int system_journal_batch_write(FILE *stream, const system_fs_batch_t *batch)
+{
+	const uint32_t chain_count = (uint32_t) batch->count;
+
+	fwrite(&chain_count, sizeof(chain_count), 1, stream);
+
+	for (size_t i = 0; i < batch->count; i++) {
+		const system_fs_chain_t *chain = &batch->chains[i];
+		const uint32_t op_count = (uint32_t) chain->count;
+		const uint32_t account_fields[] = {
+			chain->account ? (uint32_t) strlen(chain->account) + 1 : 0,
+			chain->account_deleted,
+		};
+		const uint32_t account_size = account_fields[0];
+
+		fwrite(&op_count, sizeof(op_count), 1, stream);
+		fwrite(account_fields, sizeof(account_fields), 1, stream);
+		if (account_size) {
+			fwrite(chain->account, 1, account_size, stream);
+		}
+
+		for (size_t j = 0; j < chain->count; j++) {
+			const system_fs_op_t *op = &chain->ops[j];
+			const uint32_t fields[] = {
+				op->type,
+				op->mode,
+				op->uid,
+				op->gid,
+				(uint32_t) op->exclusive | (uint32_t) op->atomic << 1 | (uint32_t) (op->source != NULL) << 2 | (uint32_t) op->owned << 8,
+				(uint32_t) strlen(op->path) + 1,
+			};
+			// content copied from another file is recorded by the path of that file - /etc/skel is not repeated for
+			// every created user
+			const uint64_t size = op->source ? strlen(op->source) + 1 : op->size;
+
+			fwrite(fields, sizeof(fields), 1, stream);
+			fwrite(&size, sizeof(size), 1, stream);
+			fwrite(op->path, 1, fields[5], stream);
+			if (size) {
+				fwrite(op->source ? op->source : op->data, 1, size, stream);
+			}
+		}
+	}
+
+	return ferror(stream) ? -1 : 0;
+}
+
+static int system_journal_batch_read(const char *payload, size_t size, const bool *done, uint64_t (*created)[2], size_t created_count, bool committed, system_fs_batch_t *batch)
+{
+	const char *iter = payload + sizeof(uint64_t) + sizeof(uint32_t);
+	const char *end = payload + size;
+	uint32_t chain_count = 0;
+	uint32_t op_count = 0;
+	uint32_t account_fields[2] = {0};
+	uint32_t fields[6] = {0};
+	uint64_t data_size = 0;
+	size_t chain = 0;
+
+	if (system_journal_read(&iter, end, &chain_count, sizeof(chain_count))) {
+		return -1;
+	}
+
+	for (uint32_t i = 0; i < chain_count; i++) {
+		const char *account = NULL;
+		bool skip = done[i];
+
+		if (system_journal_read(&iter, end, &op_count, sizeof(op_count)) || system_journal_read(&iter, end, account_fields, sizeof(account_fields))) {
+			return -1;
+		}
+
+		if (account_fields[0]) {
+			if (account_fields[0] > (size_t) (end - iter) || iter[account_fields[0] - 1] != 0) {
+				return -1;
+			}
+			account = iter;
+			iter += account_fields[0];
+		}
+
+		// without a commit the account database may still have been written before the interruption - created users
+		// found in it get their home directories and deleted users missing from it lose theirs, the rest is dropped
+		if (!committed && !skip) {
+			skip = !account || system_journal_account_exists(account) == (account_fields[1] != 0);
+		}
+
+		// finished chains are only skipped
+		if (!skip && system_fs_batch_chain(batch, &chain)) {
+			return -1;
+		}
+
+		for (uint32_t j = 0; j < op_count; j++) {
+			const char *path = NULL;
+			const char *data = NULL;
+			char *source_data = NULL;
+			size_t source_size = 0;
+			int error = 0;
+
+			if (system_journal_read(&iter, end, fields, sizeof(fields)) || system_journal_read(&iter, end, &data_size, sizeof(data_size))) {
+				return -1;
+			}
+
+			if (fields[0] > SYSTEM_FS_OP_REMOVE || !fields[5] || fields[5] > (size_t) (end - iter) || iter[fields[5] - 1] != 0) {
+				return -1;
+			}
+			path = iter;
+			iter += fields[5];
+
+			if (data_size > (size_t) (end - iter)) {
+				return -1;
+			}
+			data = iter;
+			iter += data_size;
+
+			if (skip) {
+				continue;
+			}
+
+			if (fields[4] & 4) {
+				if (!data_size || data[data_size - 1] != 0) {
+					return -1;
+				}
+
+				// the source is read as it is now - a file removed meanwhile is not written
+				if (system_journal_source_read(data, &source_data, &source_size)) {
+					SRPLG_LOG_WRN(PLUGIN_NAME, "Unable to read %s again - %s is not written", data, path);
+					continue;
+				}
+			}
+
+			// a directory created before the interruption may still be without its owner - only such a one is repaired
+			error = system_fs_batch_add(batch, chain, &(system_fs_op_t){.type = (system_fs_op_type_t) fields[0], .path = (char *) path, .data = (fields[4] & 4) ? source_data : (void *) data, .size = (fields[4] & 4) ? source_size : (size_t) data_size, .mode = (mode_t) fields[1], .uid = (uid_t) fields[2], .gid = (gid_t) fields[3], .exclusive = (fields[4] & 1) != 0, .atomic = (fields[4] & 2) != 0, .repair = system_journal_created(created, created_count, i, j), .owned = (uint8_t) (fields[4] >> 8)});
+			free(source_data);
+			if (error) {
+				return -1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+static bool system_journal_created(uint64_t (*created)[2], size_t created_count, size_t chain, size_t op)
+{
+	for (size_t i = 0; i < created_count; i++) {
+		if (created[i][0] == chain && created[i][1] == op) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool system_journal_account_exists(const char *account)
+{
+	struct passwd pw = {0};
+	char pw_buffer[4096] = {0};
+
+	return system_root_getpwnam(account, &pw, pw_buffer, sizeof(pw_buffer)) == 0;
+}
+
+static int system_journal_source_read(const char *path, char **data, size_t *size)
+{
+	struct stat st = {0};
+	ssize_t read_size = 0;
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+
+	*data = NULL;
+	*size = 0;
+
+	if (fd == -1) {
+		return -1;
+	}
+
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+		close(fd);
+		return -1;
+	}
+
+	if (st.st_size) {
+		*data = malloc((size_t) st.st_size);
+		if (!*data) {
+			close(fd);
+			return -1;
+		}
+	}
+
+	for (*size = 0; *size < (size_t) st.st_size; *size += (size_t) read_size) {
+		read_size = read(fd, *data + *size, (size_t) st.st_size - *size);
+		if (read_size < 0 && errno == EINTR) {
+			read_size = 0;
+		} else if (read_size <= 0) {
+			break;
+		}
+	}
+
+	close(fd);
+
+	// a file shrunk meanwhile is written as far as it was read
+	if (read_size < 0) {
+		free(*data);
+		*data = NULL;
+		*size = 0;
+		return -1;
+	}
+
+	return 0;
+}
+
+static int system_journal_read(const char **iter, const char *end, void *value, size_t size)
+{
+	if ((size_t) (end - *iter) < size) {
+		return -1;
+	}
+
+	memcpy(value, *iter, size);
+	*iter += size;
+
+	return 0;
+}
@@ -0,0 +1,40 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_JOURNAL_H
+#define SYSTEM_PLUGIN_JOURNAL_H
+
+#include "core/types.h"
+
+#include <stdbool.h>
+
+/**
+ * Write-ahead journal of filesystem batches, kept in SYSTEM_JOURNAL_FILE. Before a batch is run, all of its operations
+ * are appended and synced. A batch which depends on the account database is begun uncommitted and committed once the
+ * database is written. Every chain finished while the batch runs is recorded as done, and the journal is emptied when
+ * the batch ends. Every directory a batch creates is recorded as well. The journal is locked between begin and end, so
+ * only one batch is recorded at a time.
+ *
+ * At start, system_journal_recover() runs the unfinished chains of a committed batch again. Writes, renames and unlinks
+ * are repeatable as they are; a directory recorded as created is given its owner and mode again when it belongs to the
+ * plugin or to that owner, since the interruption may have come between mkdir and chown. Other existing directories
+ * are kept as they are - an exclusive one still fails. The operations of an uncommitted batch are dropped, since the
+ * change they belong to did not reach the system - except for chains of a created account
+ * (system_fs_batch_set_account()) found in passwd and of a deleted one missing from it: the database was written, only
+ * the commit is missing.
+ */
+int system_journal_begin(system_journal_t *journal, system_fs_batch_t *batch, bool committed);
+int system_journal_commit(system_journal_t *journal);
+void system_journal_end(system_journal_t *journal);
+int system_journal_recover(void);
+
+#endif // SYSTEM_PLUGIN_JOURNAL_H
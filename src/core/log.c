@@ -0,0 +1,57 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "log.h"
+
+#include <stdatomic.h>
+#include <time.h>
+
+static int64_t system_log_now_ms(void);
+
+bool system_log_enabled(sr_log_level_t level)
+{
+	// sysrepo keeps the levels in plain variables - two calls are cheaper than formatting a dropped message
+	return level <= sr_log_get_stderr() || level <= sr_log_get_syslog();
+}
+
+bool system_log_ratelimit(system_log_ratelimit_t *site, const char *file, int line)
+{
+	int64_t now = system_log_now_ms();
+	int64_t window_start = atomic_load(&site->window_start);
+	uint32_t suppressed = 0;
+
+	// the thread which moves the window reports what the previous one dropped
+	if (now - window_start >= SYSTEM_LOG_RATELIMIT_INTERVAL_MS && atomic_compare_exchange_strong(&site->window_start, &window_start, now)) {
+		atomic_store(&site->count, 0);
+		suppressed = atomic_exchange(&site->suppressed, 0);
+		if (suppressed) {
+			SRPLG_LOG_WRN(PLUGIN_NAME, "%u messages logged at %s:%d were suppressed", suppressed, file, line);
+		}
+	}
+
+	if (atomic_fetch_add(&site->count, 1) < SYSTEM_LOG_RATELIMIT_BURST) {
+		return true;
+	}
+
+	atomic_fetch_add(&site->suppressed, 1);
+
+	return false;
+}
+
+static int64_t system_log_now_ms(void)
+{
+	struct timespec ts = {0};
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (int64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
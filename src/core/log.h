@@ -0,0 +1,67 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_LOG_H
+#define SYSTEM_PLUGIN_LOG_H
+
+#include "core/common.h"
+#include "core/types.h"
+
+#include <stdbool.h>
+
+#include <sysrepo.h>
+
+/**
+ * Level-gated logging for the informational and debug messages of the plugin. The arguments of SYSTEM_LOG_INF() and
+ * SYSTEM_LOG_DBG() are evaluated only when the level is enabled for the sysrepo stderr or syslog output, and levels
+ * less severe than SYSTEM_LOG_LEVEL_MIN (the SYSTEM_LOG_LEVEL CMake option) are not compiled in at all. Loops which
+ * only log are guarded with SYSTEM_LOG_ENABLED(). Errors and warnings keep using SRPLG_LOG_ERR/WRN.
+ */
+#ifndef SYSTEM_LOG_LEVEL_MIN
+#define SYSTEM_LOG_LEVEL_MIN SR_LL_DBG
+#endif
+
+// messages per call site and window of SYSTEM_LOG_RATELIMITED()
+#define SYSTEM_LOG_RATELIMIT_BURST 10
+#define SYSTEM_LOG_RATELIMIT_INTERVAL_MS 5000
+
+// printed instead of passwords and password hashes
+#define SYSTEM_LOG_REDACTED "<redacted>"
+
+#define SYSTEM_LOG_ENABLED(level) ((level) <= SYSTEM_LOG_LEVEL_MIN && system_log_enabled(level))
+
+#define SYSTEM_LOG(level, ...)                          \
+	do {                                                \
+		if (SYSTEM_LOG_ENABLED(level)) {                \
+			srplg_log(PLUGIN_NAME, level, __VA_ARGS__); \
+		}                                               \
+	} while (0)
+
+#define SYSTEM_LOG_INF(...) SYSTEM_LOG(SR_LL_INF, __VA_ARGS__)
+#define SYSTEM_LOG_DBG(...) SYSTEM_LOG(SR_LL_DBG, __VA_ARGS__)
+
+// at most SYSTEM_LOG_RATELIMIT_BURST messages of the call site per window - for messages caused by external events
+#define SYSTEM_LOG_RATELIMITED(level, ...)                                                                       \
+	do {                                                                                                         \
+		static system_log_ratelimit_t system_log_ratelimit_site = {0};                                           \
+		if (SYSTEM_LOG_ENABLED(level) && system_log_ratelimit(&system_log_ratelimit_site, __FILE__, __LINE__)) { \
+			srplg_log(PLUGIN_NAME, level, __VA_ARGS__);                                                          \
+		}                                                                                                        \
+	} while (0)
+
+// secrets are never logged - only whether one is set
+#define SYSTEM_LOG_SECRET(value) ((value) ? SYSTEM_LOG_REDACTED : "(null)")
+
+bool system_log_enabled(sr_log_level_t level);
+bool system_log_ratelimit(system_log_ratelimit_t *site, const char *file, int line);
+
+#endif // SYSTEM_PLUGIN_LOG_H
@@ -0,0 +1,186 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "loop.h"
+#include "common.h"
+#include "log.h"
+#include "trace.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+
+#include <sysrepo.h>
+
+#define SYSTEM_LOOP_MAX_EVENTS 16
+
+// one loop per process - only the standalone executable creates it
+static struct {
+	int epoll_fd;
+	int signal_fd;
+} system_loop = {
+	.epoll_fd = -1,
+	.signal_fd = -1,
+};
+
+int system_loop_init(void)
+{
+	int error = 0;
+	sigset_t mask;
+	struct epoll_event event = {0};
+
+	// block the signals before any thread is created - every thread inherits the mask and the signals are read only from the signalfd
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGINT);
+	sigaddset(&mask, SIGTERM);
+	sigaddset(&mask, SIGHUP);
+	sigaddset(&mask, SIGUSR1);
+
+	error = pthread_sigmask(SIG_BLOCK, &mask, NULL);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "pthread_sigmask() error (%d)", error);
+		goto error_out;
+	}
+
+	// a closed peer should fail the write instead of killing the process
+	signal(SIGPIPE, SIG_IGN);
+
+	system_loop.signal_fd = signalfd(-1, &mask, SFD_CLOEXEC | SFD_NONBLOCK);
+	system_loop.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (system_loop.signal_fd == -1 || system_loop.epoll_fd == -1) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to create event loop descriptors (%d)", errno);
+		goto error_out;
+	}
+
+	// the signalfd is the only source with a NULL pointer
+	event.events = EPOLLIN;
+	event.data.ptr = NULL;
+	if (epoll_ctl(system_loop.epoll_fd, EPOLL_CTL_ADD, system_loop.signal_fd, &event) == -1) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "epoll_ctl() failed (%d) for the signalfd", errno);
+		goto error_out;
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+	system_loop_free();
+
+out:
+	return error;
+}
+
+bool system_loop_active(void)
+{
+	return system_loop.epoll_fd != -1;
+}
+
+sr_subscr_options_t system_loop_subscr_options(void)
+{
+	return system_loop_active() ? SR_SUBSCR_NO_THREAD : SR_SUBSCR_DEFAULT;
+}
+
+int system_loop_add_subscription(sr_subscription_ctx_t *subscription)
+{
+	int error = 0;
+	int event_pipe = -1;
+	struct epoll_event event = {0};
+
+	error = sr_get_event_pipe(subscription, &event_pipe);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_get_event_pipe() error (%d): %s", error, sr_strerror(error));
+		goto error_out;
+	}
+
+	event.events = EPOLLIN;
+	event.data.ptr = subscription;
+	if (epoll_ctl(system_loop.epoll_fd, EPOLL_CTL_ADD, event_pipe, &event) == -1) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "epoll_ctl() failed (%d) for a subscription event pipe", errno);
+		goto error_out;
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	return error;
+}
+
+int system_loop_run(void)
+{
+	int error = 0;
+	int sr_error = SR_ERR_OK;
+	struct epoll_event events[SYSTEM_LOOP_MAX_EVENTS];
+	struct signalfd_siginfo info = {0};
+	int count = 0;
+
+	while (1) {
+		count = epoll_wait(system_loop.epoll_fd, events, SYSTEM_LOOP_MAX_EVENTS, -1);
+		if (count == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			SRPLG_LOG_ERR(PLUGIN_NAME, "epoll_wait() failed (%d)", errno);
+			goto error_out;
+		}
+
+		for (int i = 0; i < count; i++) {
+			sr_subscription_ctx_t *subscription = (sr_subscription_ctx_t *) events[i].data.ptr;
+
+			if (!subscription) {
+				if (read(system_loop.signal_fd, &info, sizeof(info)) == sizeof(info)) {
+					// SIGUSR1 dumps the recorded spans and keeps running
+					if (info.ssi_signo == SIGUSR1) {
+						if (system_trace_dump(NULL)) {
+							SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to write trace to %s", SYSTEM_TRACE_DEFAULT_FILE);
+						} else {
+							SYSTEM_LOG_INF("Trace written to %s", SYSTEM_TRACE_DEFAULT_FILE);
+						}
+						continue;
+					}
+					SYSTEM_LOG_INF("Signal %u received, exiting...", info.ssi_signo);
+					goto out;
+				}
+				continue;
+			}
+
+			sr_error = sr_subscription_process_events(subscription, NULL, NULL);
+			if (sr_error) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "sr_subscription_process_events() error (%d): %s", sr_error, sr_strerror(sr_error));
+			}
+		}
+	}
+
+error_out:
+	error = -1;
+
+out:
+	return error;
+}
+
+void system_loop_free(void)
+{
+	if (system_loop.epoll_fd != -1) {
+		close(system_loop.epoll_fd);
+		system_loop.epoll_fd = -1;
+	}
+
+	if (system_loop.signal_fd != -1) {
+		close(system_loop.signal_fd);
+		system_loop.signal_fd = -1;
+	}
+}
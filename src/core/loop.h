@@ -0,0 +1,32 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_LOOP_H
+#define SYSTEM_PLUGIN_LOOP_H
+
+#include <stdbool.h>
+
+#include <sysrepo_types.h>
+
+/**
+ * Event loop of the standalone executable. Once created, the plugin subscribes with SR_SUBSCR_NO_THREAD and adds its
+ * subscriptions to the loop, which processes their events on the thread calling system_loop_run(). Inside
+ * sysrepo-plugind no loop exists and sysrepo handles the subscriptions in its own threads.
+ */
+int system_loop_init(void);
+bool system_loop_active(void);
+sr_subscr_options_t system_loop_subscr_options(void);
+int system_loop_add_subscription(sr_subscription_ctx_t *subscription);
+int system_loop_run(void);
+void system_loop_free(void);
+
+#endif // SYSTEM_PLUGIN_LOOP_H
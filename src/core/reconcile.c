@@ -0,0 +1,224 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "reconcile.h"
+#include "core/common.h"
+#include "core/log.h"
+#include "core/transaction.h"
+
+#include <string.h>
+
+#include <sysrepo.h>
+
+static int system_reconcile_subsystem(system_transaction_t *transaction, const struct lyd_node *diff, const system_reconcile_subsystem_t *subsystem);
+static int system_reconcile_node(system_transaction_t *transaction, const system_reconcile_subsystem_t *subsystem, const struct lyd_node *node, size_t *changes);
+static bool system_reconcile_node_change(const struct lyd_node *node, const char *retain_path, srpc_change_ctx_t *change_ctx);
+static const system_reconcile_hook_t *system_reconcile_find_hook(const system_reconcile_subsystem_t *subsystem, const char *path);
+static const char *system_reconcile_operation_str(sr_change_oper_t operation);
+
+int system_reconcile(system_ctx_t *ctx, const struct lyd_node *system_node, const struct lyd_node *desired_node, const system_reconcile_subsystem_t *subsystems, size_t subsystem_count)
+{
+	int error = 0;
+	struct lyd_node *diff = NULL;
+	system_transaction_t transaction = {.ctx = ctx};
+
+	// defaults are compared as well - a default value of the desired tree equals the same value loaded from the system
+	error = lyd_diff_siblings(system_node, desired_node, LYD_DIFF_DEFAULTS, &diff);
+	if (error != LY_SUCCESS) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "lyd_diff_siblings() error (%d)", error);
+		goto error_out;
+	}
+
+	if (!diff) {
+		SYSTEM_LOG_INF("System values already match the desired values");
+		goto out;
+	}
+
+	for (size_t i = 0; i < subsystem_count; i++) {
+		const system_reconcile_subsystem_t *subsystem = &subsystems[i];
+
+		if (subsystem->enabled && !subsystem->enabled(ctx)) {
+			SYSTEM_LOG_DBG("Skipping %s - disabled", subsystem->name);
+			continue;
+		}
+
+		error = system_reconcile_subsystem(&transaction, diff, subsystem);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "Reconciliation of %s failed (%d)", subsystem->name, error);
+			goto error_out;
+		}
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	system_transaction_cleanup(&transaction);
+
+	if (diff) {
+		lyd_free_all(diff);
+	}
+
+	return error;
+}
+
+static int system_reconcile_subsystem(system_transaction_t *transaction, const struct lyd_node *diff, const system_reconcile_subsystem_t *subsystem)
+{
+	int error = 0;
+	const struct lyd_node *root = NULL;
+	struct lyd_node *node = NULL;
+	size_t changes = 0;
+
+	LY_LIST_FOR(diff, root)
+	{
+		LYD_TREE_DFS_BEGIN(root, node)
+		{
+			error = system_reconcile_node(transaction, subsystem, node, &changes);
+			if (error) {
+				return error;
+			}
+
+			LYD_TREE_DFS_END(root, node);
+		}
+	}
+
+	if (!changes) {
+		SYSTEM_LOG_DBG("System values of %s already match the desired values", subsystem->name);
+		return 0;
+	}
+
+	SYSTEM_LOG_INF("Applying %zu changes of %s", changes, subsystem->name);
+
+	if (subsystem->apply) {
+		error = subsystem->apply(transaction);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "Applying changes of %s failed (%d)", subsystem->name, error);
+			return error;
+		}
+	}
+
+	return 0;
+}
+
+static int system_reconcile_node(system_transaction_t *transaction, const system_reconcile_subsystem_t *subsystem, const struct lyd_node *node, size_t *changes)
+{
+	int error = 0;
+	char path[SYSTEM_RECONCILE_PATH_LENGTH_MAX] = {0};
+	const system_reconcile_hook_t *hook = NULL;
+	srpc_change_ctx_t change_ctx = {0};
+
+	if (!lysc_path(node->schema, LYSC_PATH_DATA, path, sizeof(path))) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "lysc_path() failed for node %s", LYD_NAME(node));
+		return -1;
+	}
+
+	hook = system_reconcile_find_hook(subsystem, path);
+	if (!hook || !system_reconcile_node_change(node, subsystem->retain_path, &change_ctx)) {
+		return 0;
+	}
+
+	// system values are loaded only for subsystems which differ
+	if (*changes == 0 && subsystem->prepare) {
+		error = subsystem->prepare(transaction);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "Loading system values of %s failed (%d)", subsystem->name, error);
+			return error;
+		}
+	}
+
+	(*changes)++;
+
+	SYSTEM_LOG_DBG("%s: %s %s", subsystem->name, system_reconcile_operation_str(change_ctx.operation), path);
+
+	error = hook->cb(transaction, NULL, &change_ctx);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Change callback failed for %s (%d)", path, error);
+		return error;
+	}
+
+	return 0;
+}
+
+static bool system_reconcile_node_change(const struct lyd_node *node, const char *retain_path, srpc_change_ctx_t *change_ctx)
+{
+	const struct lyd_node *iter = NULL;
+	struct lyd_meta *meta = NULL;
+	const char *operation = NULL;
+	char path[SYSTEM_RECONCILE_PATH_LENGTH_MAX] = {0};
+
+	// the diff operation of a node is the one of its closest ancestor which has one
+	for (iter = node; iter; iter = lyd_parent(iter)) {
+		meta = lyd_find_meta(iter->meta, NULL, "yang:operation");
+		if (meta) {
+			break;
+		}
+	}
+
+	if (!meta) {
+		return false;
+	}
+
+	operation = lyd_get_meta_value(meta);
+	*change_ctx = (srpc_change_ctx_t){.node = node};
+
+	if (!strcmp(operation, "create")) {
+		change_ctx->operation = SR_OP_CREATED;
+	} else if (!strcmp(operation, "delete")) {
+		if (retain_path && lysc_path(iter->schema, LYSC_PATH_DATA, path, sizeof(path)) && !strcmp(path, retain_path)) {
+			return false;
+		}
+
+		change_ctx->operation = SR_OP_DELETED;
+	} else if (!strcmp(operation, "replace") && iter == node && node->schema->nodetype == LYS_LEAF) {
+		meta = lyd_find_meta(node->meta, NULL, "yang:orig-value");
+
+		change_ctx->operation = SR_OP_MODIFIED;
+		change_ctx->previous_value = meta ? lyd_get_meta_value(meta) : NULL;
+	} else {
+		// "none" of the parents of changed nodes and moves of user-ordered instances - order is not kept on the system
+		return false;
+	}
+
+	return true;
+}
+
+static const system_reconcile_hook_t *system_reconcile_find_hook(const system_reconcile_subsystem_t *subsystem, const char *path)
+{
+	for (size_t i = 0; i < subsystem->hook_count; i++) {
+		const system_reconcile_hook_t *hook = &subsystem->hooks[i];
+		const size_t length = strlen(hook->path);
+
+		if (!strncmp(path, hook->path, length) && (path[length] == 0 || path[length] == '/')) {
+			return hook;
+		}
+	}
+
+	return NULL;
+}
+
+static const char *system_reconcile_operation_str(sr_change_oper_t operation)
+{
+	switch (operation) {
+		case SR_OP_CREATED:
+			return "create";
+		case SR_OP_MODIFIED:
+			return "modify";
+		case SR_OP_DELETED:
+			return "delete";
+		case SR_OP_MOVED:
+			return "move";
+	}
+
+	return "unknown";
+}
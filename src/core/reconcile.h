@@ -0,0 +1,49 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_RECONCILE_H
+#define SYSTEM_PLUGIN_RECONCILE_H
+
+#include "core/context.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <libyang/libyang.h>
+#include <srpc.h>
+
+typedef struct system_reconcile_hook_s system_reconcile_hook_t;
+typedef struct system_reconcile_subsystem_s system_reconcile_subsystem_t;
+
+struct system_reconcile_hook_s {
+	const char *path; ///< Schema path of the changed nodes - nodes below it are passed to the callback as well.
+	srpc_change_cb cb; ///< Change callback called with the transaction and a NULL session.
+};
+
+struct system_reconcile_subsystem_s {
+	const char *name;
+	bool (*enabled)(system_ctx_t *ctx);		  ///< Optional - disabled subsystems are skipped.
+	int (*prepare)(system_transaction_t *transaction); ///< Optional - loads the system values the hooks modify. Called only when something differs.
+	int (*apply)(system_transaction_t *transaction);   ///< Optional - stores the values gathered by the hooks.
+	const char *retain_path;			  ///< Optional - list instances at this path which exist only on the system are not deleted.
+	const system_reconcile_hook_t *hooks;
+	size_t hook_count;
+};
+
+/**
+ * Reconciliation of the system with a desired data tree. Both trees are compared with lyd_diff_siblings() and every
+ * changed node is passed to the hook of its subsystem as a created, modified or deleted node, the same way sysrepo
+ * changes are passed to the change callbacks. Subsystems without differences are not touched.
+ */
+int system_reconcile(system_ctx_t *ctx, const struct lyd_node *system_node, const struct lyd_node *desired_node, const system_reconcile_subsystem_t *subsystems, size_t subsystem_count);
+
+#endif // SYSTEM_PLUGIN_RECONCILE_H
@@ -0,0 +1,572 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "record.h"
+#include "common.h"
+#include "log.h"
+#include "loop.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <sysrepo.h>
+
+// the recorder sees every change first - also the ones rejected by the plugin callbacks
+#define SYSTEM_RECORD_PRIORITY UINT32_MAX
+
+#define SYSTEM_RECORD_KIND_CONFIG "config"
+#define SYSTEM_RECORD_KIND_DIFF "diff"
+#define SYSTEM_RECORD_KIND_EDIT "edit"
+
+// longest sleep between two checks of the replay stop flag
+#define SYSTEM_REPLAY_SLEEP_SLICE_US 100000
+
+// one recorder and one replay per process - only the standalone executable uses them
+static struct {
+	FILE *file;
+	LYD_FORMAT format;
+	sr_subscription_ctx_t *subscription;
+} system_record = {
+	.file = NULL,
+	.format = LYD_LYB,
+	.subscription = NULL,
+};
+
+static struct {
+	pthread_t thread;
+	bool started;
+	sr_conn_ctx_t *connection;
+	char **paths;
+	size_t path_count;
+	double speed;
+	atomic_bool stop;
+	int result;
+} system_replay = {0};
+
+static int system_record_change_cb(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data);
+static int system_record_write(const char *kind, uint32_t request_id, const struct lyd_node *tree);
+static const char *system_record_format_name(LYD_FORMAT format);
+static LYD_FORMAT system_record_format_parse(const char *name);
+static int64_t system_record_realtime_us(void);
+static int64_t system_record_monotonic_us(void);
+
+static void *system_replay_thread(void *arg);
+static int system_replay_file(sr_session_ctx_t *session, const char *path, size_t *applied, size_t *rejected);
+static int system_replay_record_read(FILE *file, char kind[16], int64_t *timestamp, uint32_t *request_id, LYD_FORMAT *format, char **data);
+static int system_replay_apply(sr_session_ctx_t *session, const char *kind, LYD_FORMAT format, const char *data);
+static char *system_replay_file_read(FILE *file);
+
+int system_record_start(sr_session_ctx_t *session, const char *path, LYD_FORMAT format)
+{
+	int error = 0;
+	sr_data_t *config = NULL;
+	int fd = -1;
+
+	system_record.format = format;
+
+	// the recording holds the whole configuration with the password hashes - readable by its owner only
+	fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW | O_CLOEXEC, 0600);
+	if (fd == -1 || fchmod(fd, 0600) != 0) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to open %s for recording (%d)", path, errno);
+		goto error_out;
+	}
+
+	system_record.file = fdopen(fd, "w");
+	if (!system_record.file) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "fdopen() failed (%d) for %s", errno, path);
+		goto error_out;
+	}
+	fd = -1;
+
+	fprintf(system_record.file, "%s\n", SYSTEM_RECORD_MAGIC);
+
+	// replay starts from the configuration the recording started from
+	error = sr_get_data(session, "/" BASE_YANG_MODULE ":*", 0, 0, 0, &config);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_get_data() error (%d): %s", error, sr_strerror(error));
+		goto error_out;
+	}
+
+	error = system_record_write(SYSTEM_RECORD_KIND_CONFIG, 0, config ? config->tree : NULL);
+	if (error) {
+		goto error_out;
+	}
+
+	error = sr_module_change_subscribe(session, BASE_YANG_MODULE, NULL, system_record_change_cb, NULL, SYSTEM_RECORD_PRIORITY, system_loop_subscr_options() | SR_SUBSCR_PASSIVE, &system_record.subscription);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_module_change_subscribe() error (%d): %s", error, sr_strerror(error));
+		goto error_out;
+	}
+
+	if (system_loop_active() && system_loop_add_subscription(system_record.subscription)) {
+		goto error_out;
+	}
+
+	SYSTEM_LOG_INF("Recording change sets to %s", path);
+
+	goto out;
+
+error_out:
+	error = -1;
+	system_record_stop();
+
+out:
+	if (fd != -1) {
+		close(fd);
+	}
+
+	if (config) {
+		sr_release_data(config);
+	}
+
+	return error;
+}
+
+void system_record_stop(void)
+{
+	if (system_record.subscription) {
+		sr_unsubscribe(system_record.subscription);
+		system_record.subscription = NULL;
+	}
+
+	if (system_record.file) {
+		fclose(system_record.file);
+		system_record.file = NULL;
+	}
+}
+
+int system_replay_start(sr_conn_ctx_t *connection, char **paths, size_t path_count, double speed)
+{
+	int error = 0;
+
+	system_replay.connection = connection;
+	system_replay.paths = paths;
+	system_replay.path_count = path_count;
+	system_replay.speed = speed;
+	system_replay.result = 0;
+	atomic_store(&system_replay.stop, false);
+
+	// the changes are applied from another thread - the loop thread has to be free to run the plugin callbacks
+	error = pthread_create(&system_replay.thread, NULL, system_replay_thread, NULL);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "pthread_create() error (%d)", error);
+		return -1;
+	}
+	system_replay.started = true;
+
+	return 0;
+}
+
+int system_replay_finish(void)
+{
+	if (!system_replay.started) {
+		return 0;
+	}
+
+	// the loop may have been stopped before the replay finished
+	atomic_store(&system_replay.stop, true);
+	pthread_join(system_replay.thread, NULL);
+	system_replay.started = false;
+
+	return system_replay.result;
+}
+
+static int system_record_change_cb(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data)
+{
+	const struct lyd_node *diff = NULL;
+
+	// the change set as it is offered to the plugin callbacks - whether it is applied is up to them
+	if (event != SR_EV_CHANGE) {
+		return SR_ERR_OK;
+	}
+
+	diff = sr_get_change_diff(session);
+	if (!diff) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_get_change_diff() failed for request %" PRIu32, request_id);
+		return SR_ERR_OK;
+	}
+
+	// a failed write only loses the record - never the change
+	if (system_record_write(SYSTEM_RECORD_KIND_DIFF, request_id, diff)) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to record the change set of request %" PRIu32, request_id);
+	}
+
+	return SR_ERR_OK;
+}
+
+static int system_record_write(const char *kind, uint32_t request_id, const struct lyd_node *tree)
+{
+	int error = 0;
+	char *data = NULL;
+	size_t size = 0;
+
+	if (tree && lyd_print_mem(&data, tree, system_record.format, LYD_PRINT_WITHSIBLINGS) != LY_SUCCESS) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "lyd_print_mem() failed");
+		goto error_out;
+	}
+
+	// LYB data is binary and may contain zero bytes - its length is read from the LYB header
+	if (data && system_record.format == LYD_LYB) {
+		int length = lyd_lyb_data_length(data);
+		if (length < 0) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "lyd_lyb_data_length() failed");
+			goto error_out;
+		}
+		size = (size_t) length;
+	} else if (data) {
+		size = strlen(data);
+	}
+
+	fprintf(system_record.file, "%s %" PRId64 " %" PRIu32 " %s %zu\n", kind, system_record_realtime_us(), request_id, system_record_format_name(system_record.format), size);
+	if (size && fwrite(data, 1, size, system_record.file) != size) {
+		goto error_out;
+	}
+	fputc('\n', system_record.file);
+
+	// a crashing plugin still leaves the records of the changes before the crash
+	if (fflush(system_record.file)) {
+		goto error_out;
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	free(data);
+
+	return error;
+}
+
+static const char *system_record_format_name(LYD_FORMAT format)
+{
+	return format == LYD_LYB ? "lyb" : "xml";
+}
+
+static LYD_FORMAT system_record_format_parse(const char *name)
+{
+	if (!strcmp(name, "lyb")) {
+		return LYD_LYB;
+	} else if (!strcmp(name, "xml")) {
+		return LYD_XML;
+	}
+
+	return LYD_UNKNOWN;
+}
+
+static int64_t system_record_realtime_us(void)
+{
+	struct timespec ts = {0};
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+
+	return (int64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int64_t system_record_monotonic_us(void)
+{
+	struct timespec ts = {0};
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (int64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void *system_replay_thread(void *arg)
+{
+	int error = 0;
+	sr_session_ctx_t *session = NULL;
+	size_t applied = 0;
+	size_t rejected = 0;
+	int64_t start = system_record_monotonic_us();
+
+	error = sr_session_start(system_replay.connection, SR_DS_RUNNING, &session);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_session_start() error (%d): %s", error, sr_strerror(error));
+		goto error_out;
+	}
+
+	for (size_t i = 0; i < system_replay.path_count && !atomic_load(&system_replay.stop); i++) {
+		error = system_replay_file(session, system_replay.paths[i], &applied, &rejected);
+		if (error) {
+			goto error_out;
+		}
+	}
+
+	SYSTEM_LOG_INF("Replay done: %zu change sets applied, %zu rejected in %.3f ms", applied, rejected, (double) (system_record_monotonic_us() - start) / 1000.0);
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	if (session) {
+		sr_session_stop(session);
+	}
+
+	system_replay.result = error;
+
+	// stop the loop - the replay is what the executable was started for
+	kill(getpid(), SIGTERM);
+
+	return NULL;
+}
+
+static int system_replay_file(sr_session_ctx_t *session, const char *path, size_t *applied, size_t *rejected)
+{
+	int error = 0;
+	FILE *file = NULL;
+	char magic[sizeof(SYSTEM_RECORD_MAGIC) + 1] = {0};
+	char kind[16] = {0};
+	int64_t timestamp = 0;
+	int64_t first_timestamp = -1;
+	int64_t first_replayed = 0;
+	int64_t start = 0;
+	uint32_t request_id = 0;
+	LYD_FORMAT format = LYD_UNKNOWN;
+	char *data = NULL;
+
+	file = fopen(path, "r");
+	if (!file) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to open %s (%d)", path, errno);
+		goto error_out;
+	}
+
+	// anything other than a recording is an XML edit
+	if (!fgets(magic, sizeof(magic), file) || strcmp(magic, SYSTEM_RECORD_MAGIC "\n")) {
+		rewind(file);
+
+		data = system_replay_file_read(file);
+		if (!data) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to read %s", path);
+			goto error_out;
+		}
+
+		start = system_record_monotonic_us();
+		if (system_replay_apply(session, SYSTEM_RECORD_KIND_EDIT, LYD_XML, data)) {
+			SRPLG_LOG_WRN(PLUGIN_NAME, "Edit %s rejected", path);
+			(*rejected)++;
+		} else {
+			SYSTEM_LOG_INF("Replayed edit %s in %.3f ms", path, (double) (system_record_monotonic_us() - start) / 1000.0);
+			(*applied)++;
+		}
+
+		goto out;
+	}
+
+	while (!atomic_load(&system_replay.stop) && (error = system_replay_record_read(file, kind, &timestamp, &request_id, &format, &data)) == 1) {
+		// keep the recorded spacing of the changes, scaled by the speed - speed 0 replays as fast as possible
+		if (first_timestamp < 0) {
+			first_timestamp = timestamp;
+			first_replayed = system_record_monotonic_us();
+		} else if (system_replay.speed > 0) {
+			int64_t due = first_replayed + (int64_t) ((double) (timestamp - first_timestamp) / system_replay.speed);
+			int64_t now = system_record_monotonic_us();
+
+			while (due > now && !atomic_load(&system_replay.stop)) {
+				usleep((useconds_t) (due - now < SYSTEM_REPLAY_SLEEP_SLICE_US ? due - now : SYSTEM_REPLAY_SLEEP_SLICE_US));
+				now = system_record_monotonic_us();
+			}
+		}
+
+		// stopped with a record read but not applied - not an error
+		if (atomic_load(&system_replay.stop)) {
+			error = 0;
+			break;
+		}
+
+		start = system_record_monotonic_us();
+		if (system_replay_apply(session, kind, format, data)) {
+			SRPLG_LOG_WRN(PLUGIN_NAME, "Replayed %s of request %" PRIu32 " rejected", kind, request_id);
+			(*rejected)++;
+		} else {
+			SYSTEM_LOG_INF("Replayed %s of request %" PRIu32 " in %.3f ms", kind, request_id, (double) (system_record_monotonic_us() - start) / 1000.0);
+			(*applied)++;
+		}
+
+		free(data);
+		data = NULL;
+	}
+
+	// a loop stopped by the flag after applying its last record leaves 1 - only -1 is a malformed record
+	if (error < 0) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Malformed record in %s", path);
+		goto error_out;
+	}
+
+	error = 0;
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	free(data);
+	if (file) {
+		fclose(file);
+	}
+
+	return error;
+}
+
+static int system_replay_record_read(FILE *file, char kind[16], int64_t *timestamp, uint32_t *request_id, LYD_FORMAT *format, char **data)
+{
+	char format_name[8] = {0};
+	size_t size = 0;
+	int count = 0;
+
+	count = fscanf(file, "%15s %" SCNd64 " %" SCNu32 " %7s %zu", kind, timestamp, request_id, format_name, &size);
+	if (count == EOF) {
+		return 0;
+	}
+
+	*format = system_record_format_parse(format_name);
+	if (count != 5 || *format == LYD_UNKNOWN || fgetc(file) != '\n') {
+		return -1;
+	}
+
+	// terminated for the XML parser
+	*data = malloc(size + 1);
+	if (!*data) {
+		return -1;
+	}
+
+	if (fread(*data, 1, size, file) != size || fgetc(file) != '\n') {
+		free(*data);
+		*data = NULL;
+		return -1;
+	}
+	(*data)[size] = 0;
+
+	return 1;
+}
+
+static int system_replay_apply(sr_session_ctx_t *session, const char *kind, LYD_FORMAT format, const char *data)
+{
+	int error = 0;
+	const struct ly_ctx *ly_ctx = NULL;
+	struct lyd_node *tree = NULL;
+	struct lyd_node *config = NULL;
+	sr_data_t *running = NULL;
+
+	ly_ctx = sr_acquire_context(sr_session_get_connection(session));
+	if (!ly_ctx) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_acquire_context() failed");
+		return -1;
+	}
+
+	if (*data && lyd_parse_data_mem(ly_ctx, data, format, LYD_PARSE_ONLY | LYD_PARSE_STRICT, 0, &tree) != LY_SUCCESS) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "lyd_parse_data_mem() failed");
+		goto error_out;
+	}
+
+	if (!strcmp(kind, SYSTEM_RECORD_KIND_CONFIG)) {
+		// the whole configuration of the module - consumed by sysrepo
+		error = sr_replace_config(session, BASE_YANG_MODULE, tree, 0);
+		tree = NULL;
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "sr_replace_config() error (%d): %s", error, sr_strerror(error));
+			goto error_out;
+		}
+	} else if (!strcmp(kind, SYSTEM_RECORD_KIND_DIFF)) {
+		// apply the recorded diff on the current configuration - sysrepo then offers the callbacks the same change set
+		error = sr_get_data(session, "/" BASE_YANG_MODULE ":*", 0, 0, 0, &running);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "sr_get_data() error (%d): %s", error, sr_strerror(error));
+			goto error_out;
+		}
+
+		if (running && lyd_dup_siblings(running->tree, NULL, LYD_DUP_RECURSIVE, &config) != LY_SUCCESS) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "lyd_dup_siblings() failed");
+			goto error_out;
+		}
+
+		if (lyd_diff_apply_all(&config, tree) != LY_SUCCESS) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "lyd_diff_apply_all() failed - running differs from the recorded configuration");
+			goto error_out;
+		}
+
+		error = sr_replace_config(session, BASE_YANG_MODULE, config, 0);
+		config = NULL;
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "sr_replace_config() error (%d): %s", error, sr_strerror(error));
+			goto error_out;
+		}
+	} else if (!strcmp(kind, SYSTEM_RECORD_KIND_EDIT)) {
+		error = sr_edit_batch(session, tree, "merge");
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "sr_edit_batch() error (%d): %s", error, sr_strerror(error));
+			goto error_out;
+		}
+
+		error = sr_apply_changes(session, 0);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "sr_apply_changes() error (%d): %s", error, sr_strerror(error));
+			sr_discard_changes(session);
+			goto error_out;
+		}
+	} else {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Unknown record kind \"%s\"", kind);
+		goto error_out;
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	lyd_free_all(config);
+	lyd_free_all(tree);
+	if (running) {
+		sr_release_data(running);
+	}
+	sr_release_context(sr_session_get_connection(session));
+
+	return error;
+}
+
+static char *system_replay_file_read(FILE *file)
+{
+	char *data = NULL;
+	long size = 0;
+
+	if (fseek(file, 0, SEEK_END) || (size = ftell(file)) < 0 || fseek(file, 0, SEEK_SET)) {
+		return NULL;
+	}
+
+	data = malloc((size_t) size + 1);
+	if (!data) {
+		return NULL;
+	}
+
+	if (fread(data, 1, (size_t) size, file) != (size_t) size) {
+		free(data);
+		return NULL;
+	}
+	data[size] = 0;
+
+	return data;
+}
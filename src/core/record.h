@@ -0,0 +1,37 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_RECORD_H
+#define SYSTEM_PLUGIN_RECORD_H
+
+#include <stddef.h>
+
+#include <libyang/libyang.h>
+#include <sysrepo_types.h>
+
+/**
+ * Recording of the change sets received by the standalone executable and their replay. A recording starts with the
+ * SYSTEM_RECORD_MAGIC line followed by records, each a "<kind> <timestamp-us> <request-id> <format> <size>" header line,
+ * <size> bytes of data printed by libyang and a newline. The first record holds the configuration of the module when
+ * the recording started ("config"), every following one the change diff of a request ("diff").
+ *
+ * Replay applies the records in order from its own session, so the changes go through the subscription callbacks of
+ * the running plugin. Files without the magic line are taken as XML edits - the fixtures in examples/ and
+ * tests/integration/data - and merged into running.
+ */
+int system_record_start(sr_session_ctx_t *session, const char *path, LYD_FORMAT format);
+void system_record_stop(void);
+
+int system_replay_start(sr_conn_ctx_t *connection, char **paths, size_t path_count, double speed);
+int system_replay_finish(void);
+
+#endif // SYSTEM_PLUGIN_RECORD_H
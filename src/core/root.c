@@ -0,0 +1,136 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "root.h"
+#include "common.h"
+#include "log.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/limits.h>
+
+#include <sysrepo.h>
+
+// empty - the system root
+static char system_root[PATH_MAX] = {0};
+
+void system_root_init(void)
+{
+	const char *value = getenv(SYSTEM_ROOT_ENV);
+
+	if (value && system_root_set(value)) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Invalid %s value \"%s\" - using /", SYSTEM_ROOT_ENV, value);
+		system_root_set(NULL);
+	}
+
+	if (system_root_active()) {
+		SYSTEM_LOG_INF("System files are resolved under %s", system_root);
+	}
+}
+
+int system_root_set(const char *root)
+{
+	size_t len = 0;
+
+	system_root[0] = 0;
+
+	if (!root || !*root) {
+		return 0;
+	}
+
+	// only absolute roots - relative ones would depend on the working directory of sysrepo-plugind
+	len = strlen(root);
+	if (root[0] != '/' || len >= sizeof(system_root)) {
+		return -1;
+	}
+
+	// "/" and trailing slashes are dropped so that the root can be prepended to absolute paths as is
+	while (len > 0 && root[len - 1] == '/') {
+		len--;
+	}
+
+	memcpy(system_root, root, len);
+	system_root[len] = 0;
+
+	return 0;
+}
+
+bool system_root_active(void)
+{
+	return system_root[0] != 0;
+}
+
+const char *system_root_get(void)
+{
+	return system_root;
+}
+
+int system_root_path(char *buffer, size_t size, const char *path)
+{
+	const int written = snprintf(buffer, size, "%s%s", system_root, path);
+
+	if (written < 0 || (size_t) written >= size) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Path %s%s is too long", system_root, path);
+		return -1;
+	}
+
+	return 0;
+}
+
+int system_root_getpwnam(const char *user, struct passwd *pw, char *buffer, size_t size)
+{
+	int error = 0;
+	char path_buffer[PATH_MAX] = {0};
+	struct passwd *result = NULL;
+	FILE *file = NULL;
+
+	if (!system_root_active()) {
+		error = getpwnam_r(user, pw, buffer, size, &result);
+		return (error || !result) ? -1 : 0;
+	}
+
+	// NSS knows only the system root - read the passwd file of the root directly
+	if (system_root_path(path_buffer, sizeof(path_buffer), SYSTEM_AUTHENTICATION_PASSWD_PATH)) {
+		return -1;
+	}
+
+	file = fopen(path_buffer, "re");
+	if (!file) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "fopen() failed (%d) for %s", errno, path_buffer);
+		return -1;
+	}
+
+	error = -1;
+	while (fgetpwent_r(file, pw, buffer, size, &result) == 0) {
+		if (!strcmp(result->pw_name, user)) {
+			error = 0;
+			break;
+		}
+	}
+
+	fclose(file);
+
+	return error;
+}
+
+int system_root_chown(const char *path, uid_t uid, gid_t gid)
+{
+	// the root is populated and used by an unprivileged user - the files stay owned by it
+	if (system_root_active()) {
+		return 0;
+	}
+
+	return chown(path, uid, gid);
+}
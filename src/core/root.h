@@ -0,0 +1,37 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_ROOT_H
+#define SYSTEM_PLUGIN_ROOT_H
+
+#include <pwd.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+/**
+ * Runtime root of the system files. When set (SYSTEM_PLUGIN_ROOT or system_root_set()), every file the plugin reads
+ * or writes is resolved under it instead of /, the hostname is kept in <root>/etc/hostname, users are looked up in
+ * <root>/etc/passwd and file ownership is left to the running user. Values written into the files (symlink targets,
+ * home directories) stay absolute to the system root. User accounts are not created, changed or deleted under a root:
+ * umgmt writes only /etc. Set it before any callback runs - it is not changed afterwards.
+ */
+void system_root_init(void);
+int system_root_set(const char *root);
+bool system_root_active(void);
+const char *system_root_get(void);
+
+int system_root_path(char *buffer, size_t size, const char *path);
+int system_root_getpwnam(const char *user, struct passwd *pw, char *buffer, size_t size);
+int system_root_chown(const char *path, uid_t uid, gid_t gid);
+
+#endif // SYSTEM_PLUGIN_ROOT_H
@@ -0,0 +1,389 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "snapshot.h"
+#include "core/backend.h"
+#include "core/common.h"
+#include "core/fs_batch.h"
+#include "core/log.h"
+#include "core/root.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <linux/limits.h>
+#include <pwd.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <sysrepo.h>
+
+typedef struct {
+	const char *path;
+	bool rooted; ///< Resolved under the system root - the account databases are always used from /etc by umgmt.
+} system_snapshot_file_t;
+
+// files the cached subsystems are loaded from - authentication also has the authorized keys of every loaded user,
+// the DNS resolver the file of its backend
+static const system_snapshot_file_t system_snapshot_files[SYSTEM_SUBSYSTEM_COUNT][3] = {
+	[SYSTEM_SUBSYSTEM_CLOCK] = {
+		{SYSTEM_LOCALTIME_FILE, true},
+	},
+	[SYSTEM_SUBSYSTEM_AUTHENTICATION] = {
+		{SYSTEM_AUTHENTICATION_PASSWD_PATH, false},
+		{SYSTEM_AUTHENTICATION_SHADOW_PATH, false},
+		{SYSTEM_AUTHENTICATION_GROUP_PATH, false},
+	},
+};
+
+static int system_snapshot_source_add(FILE *stream, const char *path, bool rooted);
+static int system_snapshot_authentication_sources(FILE *stream);
+static int system_snapshot_header_line(const char **iter, const char *end, char *line, size_t line_size);
+
+int system_snapshot_sources_collect(uint32_t subsystems, system_snapshot_sources_t *sources)
+{
+	FILE *stream = NULL;
+
+	*sources = (system_snapshot_sources_t){0};
+
+	for (size_t i = 0; i < SYSTEM_SUBSYSTEM_COUNT; i++) {
+		if (!(subsystems & SYSTEM_SUBSYSTEM_MASK(i)) || (!system_snapshot_files[i][0].path && i != SYSTEM_SUBSYSTEM_DNS_RESOLVER)) {
+			continue;
+		}
+
+		stream = open_memstream(&sources->data[i], &sources->length[i]);
+		if (!stream) {
+			goto error_out;
+		}
+
+		for (size_t j = 0; j < ARRAY_SIZE(system_snapshot_files[i]) && system_snapshot_files[i][j].path; j++) {
+			if (system_snapshot_source_add(stream, system_snapshot_files[i][j].path, system_snapshot_files[i][j].rooted)) {
+				goto error_out;
+			}
+		}
+
+		if (i == SYSTEM_SUBSYSTEM_AUTHENTICATION && system_snapshot_authentication_sources(stream)) {
+			goto error_out;
+		}
+
+		if (i == SYSTEM_SUBSYSTEM_DNS_RESOLVER && system_snapshot_source_add(stream, system_backend_dns_resolver()->source_file, system_backend_dns_resolver()->source_rooted)) {
+			goto error_out;
+		}
+
+		if (fclose(stream)) {
+			stream = NULL;
+			goto error_out;
+		}
+		stream = NULL;
+	}
+
+	return 0;
+
+error_out:
+	SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to collect the system snapshot validators");
+
+	if (stream) {
+		fclose(stream);
+	}
+
+	system_snapshot_sources_free(sources);
+
+	return -1;
+}
+
+void system_snapshot_sources_free(system_snapshot_sources_t *sources)
+{
+	for (size_t i = 0; i < SYSTEM_SUBSYSTEM_COUNT; i++) {
+		free(sources->data[i]);
+	}
+
+	*sources = (system_snapshot_sources_t){0};
+}
+
+int system_snapshot_load(const struct ly_ctx *ly_ctx, const system_snapshot_sources_t *sources, uint32_t subsystems, struct lyd_node **tree, uint32_t *fresh)
+{
+	int error = 0;
+	char path_buffer[PATH_MAX] = {0};
+	char line[64] = {0};
+	int fd = -1;
+	struct stat st = {0};
+	char *map = NULL;
+	const char *iter = NULL, *end = NULL;
+	unsigned int subsystem = 0;
+	size_t length = 0;
+	uint32_t matching = 0;
+
+	*tree = NULL;
+	*fresh = 0;
+
+	if (system_root_path(path_buffer, sizeof(path_buffer), SYSTEM_SNAPSHOT_FILE)) {
+		goto error_out;
+	}
+
+	fd = open(path_buffer, O_RDONLY | O_CLOEXEC);
+	if (fd == -1) {
+		if (errno == ENOENT) {
+			SYSTEM_LOG_INF("No system snapshot in %s", path_buffer);
+			goto out;
+		}
+		SRPLG_LOG_ERR(PLUGIN_NAME, "open() failed (%d) for %s", errno, path_buffer);
+		goto error_out;
+	}
+
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		goto invalid_out;
+	}
+
+	map = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (map == MAP_FAILED) {
+		map = NULL;
+		SRPLG_LOG_ERR(PLUGIN_NAME, "mmap() failed (%d) for %s", errno, path_buffer);
+		goto error_out;
+	}
+
+	iter = map;
+	end = map + st.st_size;
+
+	if (system_snapshot_header_line(&iter, end, line, sizeof(line)) || strcmp(line, SYSTEM_SNAPSHOT_MAGIC)) {
+		goto invalid_out;
+	}
+
+	// validators of each subsystem, as collected when the snapshot was taken, followed by the LYB data
+	for (;;) {
+		if (system_snapshot_header_line(&iter, end, line, sizeof(line))) {
+			goto invalid_out;
+		}
+
+		if (sscanf(line, "sources %u %zu", &subsystem, &length) == 2) {
+			if (subsystem >= SYSTEM_SUBSYSTEM_COUNT || length > (size_t) (end - iter)) {
+				goto invalid_out;
+			}
+
+			if ((subsystems & SYSTEM_SUBSYSTEM_MASK(subsystem)) && sources->data[subsystem] && sources->length[subsystem] == length && !memcmp(sources->data[subsystem], iter, length)) {
+				matching |= SYSTEM_SUBSYSTEM_MASK(subsystem);
+			}
+
+			iter += length;
+		} else if (sscanf(line, "lyb %zu", &length) == 1) {
+			break;
+		} else {
+			goto invalid_out;
+		}
+	}
+
+	if (!matching) {
+		SYSTEM_LOG_INF("System snapshot is stale");
+		goto out;
+	}
+
+	if (length > (size_t) (end - iter) || lyd_lyb_data_length(iter) != (int) length) {
+		goto invalid_out;
+	}
+
+	// parsed straight from the mapping - the data is not copied
+	if (lyd_parse_data_mem(ly_ctx, iter, LYD_LYB, LYD_PARSE_ONLY | LYD_PARSE_STRICT, 0, tree) != LY_SUCCESS) {
+		// e.g. the module changed since the snapshot was taken
+		goto invalid_out;
+	}
+
+	*fresh = matching;
+
+	goto out;
+
+invalid_out:
+	SRPLG_LOG_WRN(PLUGIN_NAME, "Ignoring invalid system snapshot %s", path_buffer);
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	if (map) {
+		munmap(map, (size_t) st.st_size);
+	}
+
+	if (fd != -1) {
+		close(fd);
+	}
+
+	return error;
+}
+
+int system_snapshot_save(const system_snapshot_sources_t *sources, const struct lyd_node *tree)
+{
+	int error = 0;
+	char state_path_buffer[PATH_MAX] = {0};
+	char path_buffer[PATH_MAX] = {0};
+	char *lyb = NULL;
+	int lyb_length = 0;
+	char *data = NULL;
+	size_t size = 0;
+	FILE *stream = NULL;
+
+	if (lyd_print_mem(&lyb, tree, LYD_LYB, LYD_PRINT_WITHSIBLINGS) != LY_SUCCESS) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "lyd_print_mem() failed");
+		goto error_out;
+	}
+
+	// LYB data is binary and may contain zero bytes - its length is read from the LYB header
+	lyb_length = lyd_lyb_data_length(lyb);
+	if (lyb_length < 0) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "lyd_lyb_data_length() failed");
+		goto error_out;
+	}
+
+	stream = open_memstream(&data, &size);
+	if (!stream) {
+		goto error_out;
+	}
+
+	fprintf(stream, "%s\n", SYSTEM_SNAPSHOT_MAGIC);
+
+	for (size_t i = 0; i < SYSTEM_SUBSYSTEM_COUNT; i++) {
+		if (sources->data[i]) {
+			fprintf(stream, "sources %zu %zu\n", i, sources->length[i]);
+			fwrite(sources->data[i], 1, sources->length[i], stream);
+		}
+	}
+
+	fprintf(stream, "lyb %d\n", lyb_length);
+	fwrite(lyb, 1, (size_t) lyb_length, stream);
+
+	if (fclose(stream)) {
+		stream = NULL;
+		goto error_out;
+	}
+	stream = NULL;
+
+	if (system_root_path(state_path_buffer, sizeof(state_path_buffer), SYSTEM_PLUGIN_STATE_DIRECTORY) || system_root_path(path_buffer, sizeof(path_buffer), SYSTEM_SNAPSHOT_FILE)) {
+		goto error_out;
+	}
+
+	if (mkdir(state_path_buffer, 0755) != 0 && errno != EEXIST) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "mkdir() failed (%d) for %s", errno, state_path_buffer);
+		goto error_out;
+	}
+
+	// the snapshot holds the password hashes - readable by the plugin only
+	error = system_fs_write_file_atomic(path_buffer, data, size, 0600, (uid_t) -1, (gid_t) -1);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_fs_write_file_atomic() failed for %s", path_buffer);
+		goto error_out;
+	}
+
+	SYSTEM_LOG_DBG("Saved system snapshot of %zu bytes", size);
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	if (stream) {
+		fclose(stream);
+	}
+
+	free(data);
+	free(lyb);
+
+	return error;
+}
+
+static int system_snapshot_source_add(FILE *stream, const char *path, bool rooted)
+{
+	char path_buffer[PATH_MAX] = {0};
+	struct stat st = {0};
+
+	if (rooted && system_root_path(path_buffer, sizeof(path_buffer), path)) {
+		return -1;
+	}
+
+	if (lstat(rooted ? path_buffer : path, &st) != 0) {
+		if (errno != ENOENT && errno != ENOTDIR && errno != EACCES) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "lstat() failed (%d) for %s", errno, path);
+			return -1;
+		}
+
+		// a missing file is a state of its own - creating it makes the snapshot stale
+		fprintf(stream, "- %s\n", path);
+		return 0;
+	}
+
+	// ctime changes with every write and can't be set back, mtime catches files replaced together with their times
+	fprintf(stream, "%ju %ju %jd %jd.%09ld %jd.%09ld %s\n", (uintmax_t) st.st_dev, (uintmax_t) st.st_ino, (intmax_t) st.st_size, (intmax_t) st.st_mtim.tv_sec, st.st_mtim.tv_nsec, (intmax_t) st.st_ctim.tv_sec, st.st_ctim.tv_nsec, path);
+
+	return 0;
+}
+
+static int system_snapshot_authentication_sources(FILE *stream)
+{
+	int error = 0;
+	char keys_path_buffer[PATH_MAX] = {0};
+	char pw_buffer[4096] = {0};
+	struct passwd pw = {0};
+	struct passwd *result = NULL;
+	FILE *file = NULL;
+
+	file = fopen(SYSTEM_AUTHENTICATION_PASSWD_PATH, "re");
+	if (!file) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "fopen() failed (%d) for %s", errno, SYSTEM_AUTHENTICATION_PASSWD_PATH);
+		return -1;
+	}
+
+	while (fgetpwent_r(file, &pw, pw_buffer, sizeof(pw_buffer), &result) == 0) {
+		// the users loaded by system_authentication_load_user()
+		if (pw.pw_uid != 0 && (pw.pw_uid < 1000 || pw.pw_uid >= 65534)) {
+			continue;
+		}
+
+		if (snprintf(keys_path_buffer, sizeof(keys_path_buffer), "%s/.ssh/%s", pw.pw_dir, SYSTEM_AUTHENTICATION_AUTHORIZED_KEYS_FILE) >= (int) sizeof(keys_path_buffer)) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() failed for the home directory of user %s", pw.pw_name);
+			error = -1;
+			break;
+		}
+
+		error = system_snapshot_source_add(stream, keys_path_buffer, true);
+		if (error) {
+			break;
+		}
+	}
+
+	fclose(file);
+
+	return error;
+}
+
+static int system_snapshot_header_line(const char **iter, const char *end, char *line, size_t line_size)
+{
+	const char *newline = memchr(*iter, '\n', (size_t) (end - *iter));
+	size_t length = 0;
+
+	if (!newline) {
+		return -1;
+	}
+
+	length = (size_t) (newline - *iter);
+	if (length >= line_size) {
+		return -1;
+	}
+
+	memcpy(line, *iter, length);
+	line[length] = 0;
+	*iter = newline + 1;
+
+	return 0;
+}
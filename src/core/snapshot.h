@@ -0,0 +1,34 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_SNAPSHOT_H
+#define SYSTEM_PLUGIN_SNAPSHOT_H
+
+#include "core/types.h"
+
+#include <stdint.h>
+
+#include <libyang/libyang.h>
+
+/**
+ * Snapshot of the system values loaded at start, kept as LYB in SYSTEM_SNAPSHOT_FILE together with validators of
+ * the files each subsystem is loaded from (device, inode, size and modification time). A subsystem whose validators
+ * still match the system is taken from the snapshot instead of being loaded again. Hostname is always loaded - the
+ * kernel value has no file to validate it with - and so are the subsystems missing from the snapshot.
+ */
+int system_snapshot_sources_collect(uint32_t subsystems, system_snapshot_sources_t *sources);
+void system_snapshot_sources_free(system_snapshot_sources_t *sources);
+
+int system_snapshot_load(const struct ly_ctx *ly_ctx, const system_snapshot_sources_t *sources, uint32_t subsystems, struct lyd_node **tree, uint32_t *fresh);
+int system_snapshot_save(const system_snapshot_sources_t *sources, const struct lyd_node *tree);
+
+#endif // SYSTEM_PLUGIN_SNAPSHOT_H
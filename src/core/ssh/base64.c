@@ -0,0 +1,95 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "base64.h"
+
+#define SYSTEM_BASE64_INVALID 0xff
+
+// decoding table - SYSTEM_BASE64_INVALID for every character outside of the base64 alphabet
+static const uint8_t system_base64_table[256] = {
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x3e, 0xff, 0xff, 0xff, 0x3f,
+	0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e,
+	0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+	0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f, 0x30, 0x31, 0x32, 0x33, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+};
+
+int system_base64_decode(const char *in, size_t in_length, uint8_t *out, size_t out_size, size_t *out_length)
+{
+	const uint8_t *input = (const uint8_t *) in;
+	size_t length = 0;
+	size_t i = 0;
+	size_t tail = 0;
+
+	// padding is optional - SHA256 fingerprints printed by OpenSSH omit it
+	while (in_length && in[in_length - 1] == '=') {
+		in_length--;
+	}
+
+	tail = in_length % 4;
+	if (tail == 1 || (in_length / 4) * 3 + (tail ? tail - 1 : 0) > out_size) {
+		return -1;
+	}
+
+	// decode whole 4 character blocks into 3 bytes - one branch per block validates all four characters since every
+	// invalid character maps to a value with the top bit set
+	for (i = 0; i + 4 <= in_length; i += 4) {
+		const uint32_t a = system_base64_table[input[i]];
+		const uint32_t b = system_base64_table[input[i + 1]];
+		const uint32_t c = system_base64_table[input[i + 2]];
+		const uint32_t d = system_base64_table[input[i + 3]];
+		uint32_t block = 0;
+
+		if ((a | b | c | d) & 0x80) {
+			return -1;
+		}
+
+		block = a << 18 | b << 12 | c << 6 | d;
+		out[length] = (uint8_t) (block >> 16);
+		out[length + 1] = (uint8_t) (block >> 8);
+		out[length + 2] = (uint8_t) block;
+		length += 3;
+	}
+
+	// remaining 2 or 3 characters
+	if (tail) {
+		const uint32_t a = system_base64_table[input[i]];
+		const uint32_t b = system_base64_table[input[i + 1]];
+		const uint32_t c = tail == 3 ? system_base64_table[input[i + 2]] : 0;
+		uint32_t block = 0;
+
+		if ((a | b | c) & 0x80) {
+			return -1;
+		}
+
+		block = a << 18 | b << 12 | c << 6;
+		out[length++] = (uint8_t) (block >> 16);
+		if (tail == 3) {
+			out[length++] = (uint8_t) (block >> 8);
+		}
+	}
+
+	*out_length = length;
+
+	return 0;
+}
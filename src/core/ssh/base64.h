@@ -0,0 +1,24 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_SSH_BASE64_H
+#define SYSTEM_PLUGIN_SSH_BASE64_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// upper bound of the decoded size for the given encoded length
+#define SYSTEM_BASE64_DECODED_SIZE(length) ((((length) + 3) / 4) * 3)
+
+int system_base64_decode(const char *in, size_t in_length, uint8_t *out, size_t out_size, size_t *out_length);
+
+#endif // SYSTEM_PLUGIN_SSH_BASE64_H
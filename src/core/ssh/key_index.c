@@ -0,0 +1,209 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "key_index.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static uint32_t system_ssh_key_index_hash(const uint8_t fingerprint[32]);
+
+int system_ssh_key_index_render(const system_ssh_key_line_t *keys, size_t key_count, uint8_t **index, size_t *index_size)
+{
+	int error = 0;
+	uint8_t *buffer = NULL;
+	size_t buffer_size = 0;
+	size_t lines_size = 0;
+	uint32_t bucket_count = 1;
+	system_ssh_key_index_header_t *header = NULL;
+	system_ssh_key_index_entry_t *buckets = NULL;
+	char *lines = NULL;
+	uint32_t offset = 0;
+
+	for (size_t i = 0; i < key_count; i++) {
+		lines_size += keys[i].length;
+	}
+
+	if (lines_size > UINT32_MAX || key_count > UINT32_MAX / 2) {
+		goto error_out;
+	}
+
+	// keep the table at most half full so that probe sequences stay short
+	while (bucket_count < key_count * 2) {
+		bucket_count <<= 1;
+	}
+
+	buffer_size = sizeof(system_ssh_key_index_header_t) + bucket_count * sizeof(system_ssh_key_index_entry_t) + lines_size;
+	buffer = (uint8_t *) calloc(1, buffer_size);
+	if (!buffer) {
+		goto error_out;
+	}
+
+	header = (system_ssh_key_index_header_t *) buffer;
+	buckets = (system_ssh_key_index_entry_t *) (buffer + sizeof(system_ssh_key_index_header_t));
+	lines = (char *) (buckets + bucket_count);
+
+	memcpy(header->magic, SYSTEM_SSH_KEY_INDEX_MAGIC, sizeof(header->magic));
+	header->bucket_count = bucket_count;
+	header->key_count = (uint32_t) key_count;
+	header->lines_size = (uint32_t) lines_size;
+
+	for (size_t i = 0; i < key_count; i++) {
+		uint32_t bucket = system_ssh_key_index_hash(keys[i].fingerprint) & (bucket_count - 1);
+
+		// empty lines can't be looked up - the length marks used buckets
+		if (!keys[i].length) {
+			continue;
+		}
+
+		while (buckets[bucket].length) {
+			// duplicate key - the first line wins, same as sshd reading authorized_keys
+			if (!memcmp(buckets[bucket].fingerprint, keys[i].fingerprint, sizeof(buckets[bucket].fingerprint))) {
+				break;
+			}
+			bucket = (bucket + 1) & (bucket_count - 1);
+		}
+
+		memcpy(lines + offset, keys[i].line, keys[i].length);
+
+		if (!buckets[bucket].length) {
+			memcpy(buckets[bucket].fingerprint, keys[i].fingerprint, sizeof(buckets[bucket].fingerprint));
+			buckets[bucket].offset = offset;
+			buckets[bucket].length = (uint32_t) keys[i].length;
+		}
+
+		offset += (uint32_t) keys[i].length;
+	}
+
+	*index = buffer;
+	*index_size = buffer_size;
+
+	goto out;
+
+error_out:
+	error = -1;
+
+	if (buffer) {
+		free(buffer);
+	}
+
+out:
+	return error;
+}
+
+int system_ssh_key_index_open(system_ssh_key_index_t *index, const char *path)
+{
+	int error = 0;
+	int fd = -1;
+	struct stat st = {0};
+	size_t table_size = 0;
+
+	*index = (system_ssh_key_index_t){0};
+
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd == -1) {
+		goto error_out;
+	}
+
+	if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(system_ssh_key_index_header_t)) {
+		goto error_out;
+	}
+
+	index->map_size = (size_t) st.st_size;
+	index->map = mmap(NULL, index->map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (index->map == MAP_FAILED) {
+		index->map = NULL;
+		goto error_out;
+	}
+
+	index->header = (const system_ssh_key_index_header_t *) index->map;
+	if (memcmp(index->header->magic, SYSTEM_SSH_KEY_INDEX_MAGIC, sizeof(index->header->magic))) {
+		goto error_out;
+	}
+
+	// bucket count has to be a power of two and the whole file has to be mapped
+	if (!index->header->bucket_count || (index->header->bucket_count & (index->header->bucket_count - 1))) {
+		goto error_out;
+	}
+
+	table_size = sizeof(system_ssh_key_index_header_t) + (size_t) index->header->bucket_count * sizeof(system_ssh_key_index_entry_t);
+	if (table_size + index->header->lines_size > index->map_size) {
+		goto error_out;
+	}
+
+	index->buckets = (const system_ssh_key_index_entry_t *) ((const uint8_t *) index->map + sizeof(system_ssh_key_index_header_t));
+	index->lines = (const char *) (index->buckets + index->header->bucket_count);
+
+	goto out;
+
+error_out:
+	error = -1;
+	system_ssh_key_index_close(index);
+
+out:
+	if (fd != -1) {
+		close(fd);
+	}
+
+	return error;
+}
+
+const char *system_ssh_key_index_find(const system_ssh_key_index_t *index, const uint8_t fingerprint[32], size_t *length)
+{
+	const uint32_t mask = index->header->bucket_count - 1;
+	uint32_t bucket = system_ssh_key_index_hash(fingerprint) & mask;
+
+	for (uint32_t probes = 0; probes < index->header->bucket_count; probes++) {
+		const system_ssh_key_index_entry_t *entry = &index->buckets[bucket];
+
+		if (!entry->length) {
+			break;
+		}
+
+		if (!memcmp(entry->fingerprint, fingerprint, sizeof(entry->fingerprint))) {
+			if ((size_t) entry->offset + entry->length > index->header->lines_size) {
+				break;
+			}
+
+			*length = entry->length;
+			return index->lines + entry->offset;
+		}
+
+		bucket = (bucket + 1) & mask;
+	}
+
+	return NULL;
+}
+
+void system_ssh_key_index_close(system_ssh_key_index_t *index)
+{
+	if (index->map) {
+		munmap(index->map, index->map_size);
+	}
+
+	*index = (system_ssh_key_index_t){0};
+}
+
+static uint32_t system_ssh_key_index_hash(const uint8_t fingerprint[32])
+{
+	uint32_t hash = 0;
+
+	// the fingerprint is already a cryptographic hash - its first bytes are uniformly distributed
+	memcpy(&hash, fingerprint, sizeof(hash));
+
+	return hash;
+}
@@ -0,0 +1,38 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_SSH_KEY_INDEX_H
+#define SYSTEM_PLUGIN_SSH_KEY_INDEX_H
+
+#include "core/types.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SYSTEM_SSH_KEY_INDEX_MAGIC "SRPKIDX1"
+
+/*
+ * Per-user authorized keys index.
+ *
+ * The index file is an open addressing hash table of the user's keys indexed by the SHA256 fingerprint of the key blob,
+ * followed by the authorized_keys lines themselves. It is written by the plugin next to ~/.ssh/authorized_keys and read
+ * by the AuthorizedKeysCommand helper which resolves the key offered by the client with a single table lookup.
+ *
+ * This file must not depend on sysrepo - it is linked into the helper binary as well.
+ */
+
+int system_ssh_key_index_render(const system_ssh_key_line_t *keys, size_t key_count, uint8_t **index, size_t *index_size);
+int system_ssh_key_index_open(system_ssh_key_index_t *index, const char *path);
+const char *system_ssh_key_index_find(const system_ssh_key_index_t *index, const uint8_t fingerprint[32], size_t *length);
+void system_ssh_key_index_close(system_ssh_key_index_t *index);
+
+#endif // SYSTEM_PLUGIN_SSH_KEY_INDEX_H
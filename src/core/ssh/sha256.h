@@ -0,0 +1,23 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_SSH_SHA256_H
+#define SYSTEM_PLUGIN_SSH_SHA256_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SYSTEM_SHA256_DIGEST_LENGTH 32
+
+void system_sha256(const void *data, size_t size, uint8_t digest[SYSTEM_SHA256_DIGEST_LENGTH]);
+
+#endif // SYSTEM_PLUGIN_SSH_SHA256_H
@@ -12,8 +12,10 @@
  */
 #include "load.h"
 #include "core/common.h"
+#include "core/log.h"
 #include "core/context.h"
 #include "core/ly_tree.h"
+#include "core/features.h"
 
 // API for getting system data
 #include "srpc/common.h"
@@ -98,7 +100,7 @@ int system_startup_load_data(system_ctx_t *ctx, sr_session_ctx_t *session)
 	}
 
 	// reload features hash before adding all system values
-	SRPC_SAFE_CALL_ERR(error, srpc_feature_status_hash_reload(&ctx->ietf_system_features, session, IETF_SYSTEM_YANG_MODULE), error_out);
+	SRPC_SAFE_CALL_ERR(error, system_features_reload(ctx, session), error_out);
 
 	// load system container info
 	error = system_ly_tree_create_system(ly_ctx, &system_container_node);
@@ -191,7 +193,7 @@ static int system_startup_load_timezone_name(void *priv, sr_session_ctx_t *sessi
 	struct lyd_node *clock_container_node = NULL;
 	bool timezone_name_enabled = false;
 
-	timezone_name_enabled = srpc_feature_status_hash_check(ctx->ietf_system_features, "timezone-name");
+	timezone_name_enabled = system_features_check(ctx, "timezone-name");
 
 	if (timezone_name_enabled) {
 		error = system_load_timezone_name(ctx, timezone_name_buffer);
@@ -237,7 +239,7 @@ static int system_startup_load_dns_resolver(void *priv, sr_session_ctx_t *sessio
 		goto error_out;
 	}
 
-	SRPLG_LOG_INF(PLUGIN_NAME, "Loading DNS search values from the system");
+	SYSTEM_LOG_INF("Loading DNS search values from the system");
 
 	// load values
 
@@ -247,7 +249,7 @@ static int system_startup_load_dns_resolver(void *priv, sr_session_ctx_t *sessio
 		goto error_out;
 	}
 
-	SRPLG_LOG_INF(PLUGIN_NAME, "Loading DNS server values from the system");
+	SYSTEM_LOG_INF("Loading DNS server values from the system");
 
 	error = system_dns_resolver_load_server(ctx, &servers_head);
 	if (error) {
@@ -255,7 +257,7 @@ static int system_startup_load_dns_resolver(void *priv, sr_session_ctx_t *sessio
 		goto error_out;
 	}
 
-	SRPLG_LOG_INF(PLUGIN_NAME, "Saving search values to the datastore");
+	SYSTEM_LOG_INF("Saving search values to the datastore");
 
 	LL_FOREACH(search_head, search_iter_el)
 	{
@@ -266,8 +268,8 @@ static int system_startup_load_dns_resolver(void *priv, sr_session_ctx_t *sessio
 		}
 	}
 
-	SRPLG_LOG_INF(PLUGIN_NAME, "Saved search values to the datastore");
-	SRPLG_LOG_INF(PLUGIN_NAME, "Saving server values to the datastore");
+	SYSTEM_LOG_INF("Saved search values to the datastore");
+	SYSTEM_LOG_INF("Saving server values to the datastore");
 
 	LL_FOREACH(servers_head, servers_iter_el)
 	{
@@ -306,7 +308,7 @@ static int system_startup_load_dns_resolver(void *priv, sr_session_ctx_t *sessio
 		}
 	}
 
-	SRPLG_LOG_INF(PLUGIN_NAME, "Saved server values to the datastore");
+	SYSTEM_LOG_INF("Saved server values to the datastore");
 
 	goto out;
 
@@ -330,8 +332,8 @@ static int system_startup_load_authentication(void *priv, sr_session_ctx_t *sess
 	system_local_user_element_t *user_head = NULL, *user_iter = NULL;
 	system_authorized_key_element_t *key_iter = NULL;
 
-	bool enabled_authentication = srpc_feature_status_hash_check(ctx->ietf_system_features, "authentication");
-	bool enabled_local_users = srpc_feature_status_hash_check(ctx->ietf_system_features, "local-users");
+	bool enabled_authentication = system_features_check(ctx, "authentication");
+	bool enabled_local_users = system_features_check(ctx, "local-users");
 
 	if (enabled_authentication) {
 		// create authentication container
@@ -342,7 +344,7 @@ static int system_startup_load_authentication(void *priv, sr_session_ctx_t *sess
 		}
 
 		if (enabled_local_users) {
-			SRPLG_LOG_INF(PLUGIN_NAME, "Loading users from the system");
+			SYSTEM_LOG_INF("Loading users from the system");
 
 			// init list first
 			system_local_user_list_init(&user_head);
@@ -354,20 +356,20 @@ static int system_startup_load_authentication(void *priv, sr_session_ctx_t *sess
 				goto error_out;
 			}
 
-			SRPLG_LOG_INF(PLUGIN_NAME, "Loading user authorized keys");
+			SYSTEM_LOG_INF("Loading user authorized keys");
 
 			LL_FOREACH(user_head, user_iter)
 			{
 				system_authorized_key_list_init(&user_iter->user.key_head);
 
-				error = system_authentication_load_user_authorized_key(ctx, user_iter->user.name, &user_iter->user.key_head);
+				error = system_authentication_load_user_authorized_key(ctx, user_iter->user.name, user_iter->user.home, &user_iter->user.key_head);
 				if (error) {
 					SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_load_user_authorized_key() error (%d)", error);
 					goto error_out;
 				}
 			}
 
-			SRPLG_LOG_INF(PLUGIN_NAME, "Saving users and their keys to the datastore");
+			SYSTEM_LOG_INF("Saving users and their keys to the datastore");
 
 			LL_FOREACH(user_head, user_iter)
 			{
@@ -382,7 +384,7 @@ static int system_startup_load_authentication(void *priv, sr_session_ctx_t *sess
 				if (user_iter->user.password && strcmp(user_iter->user.password, "")) {
 					error = system_ly_tree_create_authentication_user_password(ly_ctx, user_list_node, user_iter->user.password);
 					if (error) {
-						SRPLG_LOG_ERR(PLUGIN_NAME, "system_ly_tree_create_authentication_user_password() error (%d) for %s", error, user_iter->user.password);
+						SRPLG_LOG_ERR(PLUGIN_NAME, "system_ly_tree_create_authentication_user_password() error (%d) for %s", error, user_iter->user.name);
 						goto error_out;
 					}
 				}
@@ -415,7 +417,7 @@ static int system_startup_load_authentication(void *priv, sr_session_ctx_t *sess
 						if (key_iter->key.data) {
 							error = system_ly_tree_create_authentication_user_authorized_key_data(ly_ctx, authorized_key_list_node, key_iter->key.data);
 							if (error) {
-								SRPLG_LOG_ERR(PLUGIN_NAME, "system_ly_tree_create_authentication_user_authorized_key_data() error (%d) for %s", error, key_iter->key.data);
+								SRPLG_LOG_ERR(PLUGIN_NAME, "system_ly_tree_create_authentication_user_authorized_key_data() error (%d) for key %s of user %s", error, key_iter->key.name, user_iter->user.name);
 								goto error_out;
 							}
 						}
@@ -423,7 +425,7 @@ static int system_startup_load_authentication(void *priv, sr_session_ctx_t *sess
 				}
 			}
 
-			SRPLG_LOG_INF(PLUGIN_NAME, "Saved users to the datastore");
+			SYSTEM_LOG_INF("Saved users to the datastore");
 		}
 	}
 
@@ -12,8 +12,10 @@
  */
 #include "store.h"
 #include "core/common.h"
+#include "core/log.h"
 #include "libyang/printer_data.h"
 #include "core/ly_tree.h"
+#include "core/features.h"
 
 // API for getting system data
 #include "srpc/common.h"
@@ -112,7 +114,7 @@ int system_startup_store_data(system_ctx_t *ctx, sr_session_ctx_t *session)
 	};
 
 	// reload feature status hash before storing system data
-	SRPC_SAFE_CALL_ERR(error, srpc_feature_status_hash_reload(&ctx->ietf_system_features, session, IETF_SYSTEM_YANG_MODULE), error_out);
+	SRPC_SAFE_CALL_ERR(error, system_features_reload(ctx, session), error_out);
 
 	for (size_t i = 0; i < ARRAY_SIZE(store_values); i++) {
 		const srpc_startup_store_t *store = &store_values[i];
@@ -148,7 +150,7 @@ static int system_startup_store_hostname(void *priv, const struct lyd_node *syst
 	if (hostname_node) {
 		const char *hostname = lyd_get_value(hostname_node);
 
-		SRPLG_LOG_INF(PLUGIN_NAME, "Checking system hostname value");
+		SYSTEM_LOG_INF("Checking system hostname value");
 		check_status = system_check_hostname(ctx, hostname);
 
 		switch (check_status) {
@@ -161,7 +163,7 @@ static int system_startup_store_hostname(void *priv, const struct lyd_node *syst
 				goto error_out;
 				break;
 			case srpc_check_status_non_existant:
-				SRPLG_LOG_INF(PLUGIN_NAME, "Storing hostname value %s", hostname);
+				SYSTEM_LOG_INF("Storing hostname value %s", hostname);
 
 				error = system_store_hostname(ctx, hostname);
 				if (error) {
@@ -199,7 +201,7 @@ static int system_startup_store_contact(void *priv, const struct lyd_node *syste
 	if (contact_node) {
 		const char *contact = lyd_get_value(contact_node);
 
-		SRPLG_LOG_INF(PLUGIN_NAME, "contact value: %s", contact);
+		SYSTEM_LOG_INF("contact value: %s", contact);
 
 		error = system_store_contact(ctx, contact);
 		if (error) {
@@ -221,7 +223,7 @@ static int system_startup_store_location(void *priv, const struct lyd_node *syst
 	if (location_node) {
 		const char *location = lyd_get_value(location_node);
 
-		SRPLG_LOG_INF(PLUGIN_NAME, "location value: %s", location);
+		SYSTEM_LOG_INF("location value: %s", location);
 
 		error = system_store_location(ctx, location);
 		if (error) {
@@ -238,7 +240,7 @@ static int system_startup_store_timezone_name(void *priv, const struct lyd_node
 	int error = 0;
 	system_ctx_t *ctx = (system_ctx_t *) priv;
 	srpc_check_status_t check_status = srpc_check_status_none;
-	bool timezone_name_enabled = srpc_feature_status_hash_check(ctx->ietf_system_features, "timezone-name");
+	bool timezone_name_enabled = system_features_check(ctx, "timezone-name");
 
 	struct lyd_node *clock_container_node = NULL, *timezone_name_node = NULL;
 
@@ -250,7 +252,7 @@ static int system_startup_store_timezone_name(void *priv, const struct lyd_node
 			if (timezone_name_node) {
 				const char *timezone_name = lyd_get_value(timezone_name_node);
 
-				SRPLG_LOG_INF(PLUGIN_NAME, "Checking system timezone-name value");
+				SYSTEM_LOG_INF("Checking system timezone-name value");
 				check_status = system_check_timezone_name(ctx, timezone_name);
 
 				switch (check_status) {
@@ -263,7 +265,7 @@ static int system_startup_store_timezone_name(void *priv, const struct lyd_node
 						goto error_out;
 						break;
 					case srpc_check_status_non_existant:
-						SRPLG_LOG_INF(PLUGIN_NAME, "Storing timezone-name value %s", timezone_name);
+						SYSTEM_LOG_INF("Storing timezone-name value %s", timezone_name);
 
 						error = system_store_timezone_name(ctx, timezone_name);
 						if (error) {
@@ -307,14 +309,14 @@ static int system_startup_store_ntp(void *priv, const struct lyd_node *system_co
 	struct lyd_node *udp_container_node = NULL;
 	system_ntp_server_element_t *ntp_server_head = NULL;
 
-	bool ntp_enabled = srpc_feature_status_hash_check(ctx->ietf_system_features, "ntp");
-	bool ntp_udp_port_enabled = srpc_feature_status_hash_check(ctx->ietf_system_features, "ntp-udp-port");
+	bool ntp_enabled = system_features_check(ctx, "ntp");
+	bool ntp_udp_port_enabled = system_features_check(ctx, "ntp-udp-port");
 
 	system_ntp_server_t temp_server = {0};
 	srpc_check_status_t server_check_status = srpc_check_status_none;
 
 	if (ntp_enabled) {
-		SRPLG_LOG_INF(PLUGIN_NAME, "Storing NTP startup data");
+		SYSTEM_LOG_INF("Storing NTP startup data");
 
 		ntp_container_node = srpc_ly_tree_get_child_container(system_container_node, "ntp");
 		if (ntp_container_node) {
@@ -355,7 +357,7 @@ static int system_startup_store_ntp(void *priv, const struct lyd_node *system_co
 						}
 					} else {
 						// no address node -> unable to continue
-						SRPLG_LOG_INF(PLUGIN_NAME, "srpc_ly_tree_get_child_leaf() failed for leaf address");
+						SYSTEM_LOG_INF("srpc_ly_tree_get_child_leaf() failed for leaf address");
 						goto error_out;
 					}
 
@@ -369,7 +371,7 @@ static int system_startup_store_ntp(void *priv, const struct lyd_node *system_co
 							// set port
 							error = system_ntp_server_set_port(&temp_server, port);
 							if (error) {
-								SRPLG_LOG_INF(PLUGIN_NAME, "system_ntp_server_set_port() error (%d)", error);
+								SYSTEM_LOG_INF("system_ntp_server_set_port() error (%d)", error);
 								goto error_out;
 							}
 						}
@@ -415,7 +417,7 @@ static int system_startup_store_ntp(void *priv, const struct lyd_node *system_co
 					// append to the list
 					error = system_ntp_server_list_add(&ntp_server_head, temp_server);
 					if (error) {
-						SRPLG_LOG_INF(PLUGIN_NAME, "system_ntp_server_list_add() error (%d)", error);
+						SYSTEM_LOG_INF("system_ntp_server_list_add() error (%d)", error);
 						goto error_out;
 					}
 
@@ -426,11 +428,11 @@ static int system_startup_store_ntp(void *priv, const struct lyd_node *system_co
 				}
 			}
 
-			SRPLG_LOG_INF(PLUGIN_NAME, "Checking NTP server list status on the system");
+			SYSTEM_LOG_INF("Checking NTP server list status on the system");
 
 			server_check_status = system_ntp_check_server(ctx, ntp_server_head);
 
-			SRPLG_LOG_INF(PLUGIN_NAME, "Recieved check status: %d", server_check_status);
+			SYSTEM_LOG_INF("Recieved check status: %d", server_check_status);
 
 			switch (server_check_status) {
 				case srpc_check_status_none:
@@ -442,7 +444,7 @@ static int system_startup_store_ntp(void *priv, const struct lyd_node *system_co
 					goto error_out;
 					break;
 				case srpc_check_status_non_existant:
-					SRPLG_LOG_INF(PLUGIN_NAME, "NTP server list values don\'t exist on the system - applying values");
+					SYSTEM_LOG_INF("NTP server list values don\'t exist on the system - applying values");
 
 					error = system_ntp_store_server(ctx, ntp_server_head);
 					if (error) {
@@ -450,10 +452,10 @@ static int system_startup_store_ntp(void *priv, const struct lyd_node *system_co
 						goto error_out;
 					}
 
-					SRPLG_LOG_INF(PLUGIN_NAME, "Applied NTP server startup values to the system");
+					SYSTEM_LOG_INF("Applied NTP server startup values to the system");
 					break;
 				case srpc_check_status_equal:
-					SRPLG_LOG_INF(PLUGIN_NAME, "NTP server startup values already exist on the system - no need to apply anything");
+					SYSTEM_LOG_INF("NTP server startup values already exist on the system - no need to apply anything");
 					break;
 				case srpc_check_status_partial:
 					// TODO: implement
@@ -461,7 +463,7 @@ static int system_startup_store_ntp(void *priv, const struct lyd_node *system_co
 			}
 		}
 	} else {
-		SRPLG_LOG_INF(PLUGIN_NAME, "\"ntp\" feature disabled - skipping NTP startup configuration");
+		SYSTEM_LOG_INF("\"ntp\" feature disabled - skipping NTP startup configuration");
 	}
 
 	goto out;
@@ -497,7 +499,7 @@ static int system_startup_store_dns_resolver(void *priv, const struct lyd_node *
 	system_ip_address_t tmp_ip = {0};
 	srpc_check_status_t search_check_status = srpc_check_status_none, server_check_status = srpc_check_status_none;
 
-	SRPLG_LOG_INF(PLUGIN_NAME, "Storing dns-resolver startup data");
+	SYSTEM_LOG_INF("Storing dns-resolver startup data");
 
 	dns_resolver_container_node = srpc_ly_tree_get_child_container(system_container_node, "dns-resolver");
 	if (dns_resolver_container_node) {
@@ -512,7 +514,7 @@ static int system_startup_store_dns_resolver(void *priv, const struct lyd_node *
 
 				const char *domain = lyd_get_value(search_leaf_list_node);
 
-				// SRPLG_LOG_INF(PLUGIN_NAME, "Adding DNS search value %s", domain);
+				// SYSTEM_LOG_INF("Adding DNS search value %s", domain);
 
 				error = system_dns_search_set_domain(&tmp_search, domain);
 				if (error) {
@@ -544,9 +546,9 @@ static int system_startup_store_dns_resolver(void *priv, const struct lyd_node *
 				search_leaf_list_node = srpc_ly_tree_get_leaf_list_next(search_leaf_list_node);
 			}
 
-			SRPLG_LOG_INF(PLUGIN_NAME, "Checking DNS search values on the system");
+			SYSTEM_LOG_INF("Checking DNS search values on the system");
 			search_check_status = system_dns_resolver_check_search(ctx, search_head);
-			SRPLG_LOG_INF(PLUGIN_NAME, "Recieved check status = %d", search_check_status);
+			SYSTEM_LOG_INF("Recieved check status = %d", search_check_status);
 
 			switch (search_check_status) {
 				case srpc_check_status_none:
@@ -560,16 +562,16 @@ static int system_startup_store_dns_resolver(void *priv, const struct lyd_node *
 					break;
 				case srpc_check_status_non_existant:
 					// values don't exist - apply them to the system
-					SRPLG_LOG_INF(PLUGIN_NAME, "Storing DNS search values from the datastore to the system");
+					SYSTEM_LOG_INF("Storing DNS search values from the datastore to the system");
 
 					// apply search values to the system
 					error = system_dns_resolver_store_search(ctx, search_head);
 					if (error) {
-						SRPLG_LOG_INF(PLUGIN_NAME, "system_dns_resolver_store_search() error (%d)", error);
+						SYSTEM_LOG_INF("system_dns_resolver_store_search() error (%d)", error);
 						goto error_out;
 					}
 
-					SRPLG_LOG_INF(PLUGIN_NAME, "Stored DNS search values from the datastore to the system");
+					SYSTEM_LOG_INF("Stored DNS search values from the datastore to the system");
 					break;
 				case srpc_check_status_equal:
 					// values exist - don't do anything
@@ -589,7 +591,7 @@ static int system_startup_store_dns_resolver(void *priv, const struct lyd_node *
 				udp_and_tcp_container_node = srpc_ly_tree_get_child_container(server_list_node, "udp-and-tcp");
 
 				const char *name = lyd_get_value(server_name_leaf_node);
-				// SRPLG_LOG_INF(PLUGIN_NAME, "Adding DNS server %s", name);
+				// SYSTEM_LOG_INF("Adding DNS server %s", name);
 
 				// set name
 				system_dns_server_set_name(&tmp_server, name);
@@ -621,7 +623,7 @@ static int system_startup_store_dns_resolver(void *priv, const struct lyd_node *
 					}
 				} else {
 					// no address node -> unable to continue
-					SRPLG_LOG_INF(PLUGIN_NAME, "srpc_ly_tree_get_child_leaf() failed for leaf address");
+					SYSTEM_LOG_INF("srpc_ly_tree_get_child_leaf() failed for leaf address");
 					goto error_out;
 				}
 
@@ -634,7 +636,7 @@ static int system_startup_store_dns_resolver(void *priv, const struct lyd_node *
 					// set port
 					error = system_dns_server_set_port(&tmp_server, port_i32);
 					if (error) {
-						SRPLG_LOG_INF(PLUGIN_NAME, "system_dns_server_set_port() error (%d)", error);
+						SYSTEM_LOG_INF("system_dns_server_set_port() error (%d)", error);
 						goto error_out;
 					}
 				}
@@ -642,7 +644,7 @@ static int system_startup_store_dns_resolver(void *priv, const struct lyd_node *
 				// append to the list
 				error = system_dns_server_list_add(&servers_head, tmp_server);
 				if (error) {
-					SRPLG_LOG_INF(PLUGIN_NAME, "system_dns_server_list_add() error (%d)", error);
+					SYSTEM_LOG_INF("system_dns_server_list_add() error (%d)", error);
 					goto error_out;
 				}
 
@@ -651,9 +653,9 @@ static int system_startup_store_dns_resolver(void *priv, const struct lyd_node *
 				server_list_node = srpc_ly_tree_get_list_next(server_list_node);
 			}
 
-			SRPLG_LOG_INF(PLUGIN_NAME, "Checking DNS server values on the system");
+			SYSTEM_LOG_INF("Checking DNS server values on the system");
 			server_check_status = system_dns_resolver_check_server(ctx, servers_head);
-			SRPLG_LOG_INF(PLUGIN_NAME, "Recieved check status = %d", server_check_status);
+			SYSTEM_LOG_INF("Recieved check status = %d", server_check_status);
 
 			switch (server_check_status) {
 				case srpc_check_status_none:
@@ -666,20 +668,20 @@ static int system_startup_store_dns_resolver(void *priv, const struct lyd_node *
 					goto error_out;
 					break;
 				case srpc_check_status_non_existant:
-					SRPLG_LOG_INF(PLUGIN_NAME, "Storing DNS server values from the datastore to the system");
+					SYSTEM_LOG_INF("Storing DNS server values from the datastore to the system");
 
 					// gathered all servers - store them to the system
 					error = system_dns_resolver_store_server(ctx, servers_head);
 					if (error) {
-						SRPLG_LOG_INF(PLUGIN_NAME, "system_dns_resolver_store_server() error (%d)", error);
+						SYSTEM_LOG_INF("system_dns_resolver_store_server() error (%d)", error);
 						goto error_out;
 					}
 
-					SRPLG_LOG_INF(PLUGIN_NAME, "Stored DNS server values from the datastore to the system");
+					SYSTEM_LOG_INF("Stored DNS server values from the datastore to the system");
 					break;
 				case srpc_check_status_equal:
 					// don't do anything
-					SRPLG_LOG_INF(PLUGIN_NAME, "DNS server values already exist on the system - no need to apply anything");
+					SYSTEM_LOG_INF("DNS server values already exist on the system - no need to apply anything");
 					break;
 				case srpc_check_status_partial:
 					// TODO: implement
@@ -724,19 +726,19 @@ static int system_startup_store_authentication(void *priv, const struct lyd_node
 	system_authorized_key_t temp_key = {0};
 
 	// features
-	bool authentication_enabled = srpc_feature_status_hash_check(ctx->ietf_system_features, "authentication");
-	bool local_users_enabled = srpc_feature_status_hash_check(ctx->ietf_system_features, "local-users");
+	bool authentication_enabled = system_features_check(ctx, "authentication");
+	bool local_users_enabled = system_features_check(ctx, "local-users");
 
 	// srpc
 	srpc_check_status_t user_check_status = srpc_check_status_none, key_check_status = srpc_check_status_none;
 
 	if (authentication_enabled) {
-		SRPLG_LOG_INF(PLUGIN_NAME, "Storing authentication startup data");
+		SYSTEM_LOG_INF("Storing authentication startup data");
 
 		authentication_container_node = srpc_ly_tree_get_child_container(system_container_node, "authentication");
 		if (authentication_container_node) {
 			if (local_users_enabled) {
-				SRPLG_LOG_INF(PLUGIN_NAME, "Storing local-users startup data");
+				SYSTEM_LOG_INF("Storing local-users startup data");
 
 				local_user_list_node = srpc_ly_tree_get_child_list(authentication_container_node, "user");
 				while (local_user_list_node) {
@@ -836,9 +838,9 @@ static int system_startup_store_authentication(void *priv, const struct lyd_node
 				system_local_user_list_init(&system_user_head);
 
 				// check if all users exist on the system
-				SRPLG_LOG_INF(PLUGIN_NAME, "Checking startup local user system values");
+				SYSTEM_LOG_INF("Checking startup local user system values");
 				user_check_status = system_authentication_check_user(ctx, user_head, &system_user_head);
-				SRPLG_LOG_INF(PLUGIN_NAME, "Recieved local users check status: %d", user_check_status);
+				SYSTEM_LOG_INF("Recieved local users check status: %d", user_check_status);
 
 				switch (user_check_status) {
 					case srpc_check_status_none:
@@ -850,7 +852,7 @@ static int system_startup_store_authentication(void *priv, const struct lyd_node
 						goto error_out;
 						break;
 					case srpc_check_status_non_existant:
-						SRPLG_LOG_INF(PLUGIN_NAME, "Startup local users don\'t exist on the system - starting to store startup local users");
+						SYSTEM_LOG_INF("Startup local users don\'t exist on the system - starting to store startup local users");
 						error = system_authentication_store_user(ctx, user_head);
 						if (error) {
 							SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_store_user() error (%d)", error);
@@ -858,10 +860,10 @@ static int system_startup_store_authentication(void *priv, const struct lyd_node
 						}
 						break;
 					case srpc_check_status_equal:
-						SRPLG_LOG_INF(PLUGIN_NAME, "Startup local users already exist on the system - no need to store anything");
+						SYSTEM_LOG_INF("Startup local users already exist on the system - no need to store anything");
 						break;
 					case srpc_check_status_partial:
-						SRPLG_LOG_INF(PLUGIN_NAME, "Some startup local users exist while others don\'t - creating non existant users");
+						SYSTEM_LOG_INF("Some startup local users exist while others don\'t - creating non existant users");
 
 						// get complement of startup without system
 						complement_user_head = system_local_user_list_complement(user_head, system_user_head);
@@ -870,7 +872,7 @@ static int system_startup_store_authentication(void *priv, const struct lyd_node
 							goto error_out;
 						}
 
-						SRPLG_LOG_INF(PLUGIN_NAME, "Storing missing local users from startup to the system");
+						SYSTEM_LOG_INF("Storing missing local users from startup to the system");
 
 						// add complement users to system
 						error = system_authentication_store_user(ctx, complement_user_head);
@@ -879,18 +881,18 @@ static int system_startup_store_authentication(void *priv, const struct lyd_node
 							goto error_out;
 						}
 
-						SRPLG_LOG_INF(PLUGIN_NAME, "Missing local users from startup are stored in the system");
+						SYSTEM_LOG_INF("Missing local users from startup are stored in the system");
 						break;
 				}
 
 				// after matching startup and system values for users - match key lists for all users
-				SRPLG_LOG_INF(PLUGIN_NAME, "Checking startup local user authorized key system values");
+				SYSTEM_LOG_INF("Checking startup local user authorized key system values");
 				LL_FOREACH(user_head, user_iter)
 				{
 					// check first if any keys exist in startup
 					if (user_iter->user.key_head) {
 						key_check_status = system_authentication_check_user_authorized_key(ctx, user_iter->user.name, user_iter->user.key_head);
-						SRPLG_LOG_INF(PLUGIN_NAME, "Recieved authorized-key check status %d for user %s", user_check_status, user_iter->user.name);
+						SYSTEM_LOG_INF("Recieved authorized-key check status %d for user %s", user_check_status, user_iter->user.name);
 
 						switch (key_check_status) {
 							case srpc_check_status_none:
@@ -902,7 +904,7 @@ static int system_startup_store_authentication(void *priv, const struct lyd_node
 								goto error_out;
 								break;
 							case srpc_check_status_non_existant:
-								SRPLG_LOG_INF(PLUGIN_NAME, "Startup authorized keys don\'t exist on the system for user %s - storing authorized keys for user %s", user_iter->user.name, user_iter->user.name);
+								SYSTEM_LOG_INF("Startup authorized keys don\'t exist on the system for user %s - storing authorized keys for user %s", user_iter->user.name, user_iter->user.name);
 								error = system_authentication_store_user_authorized_key(ctx, user_iter->user.name, user_iter->user.key_head);
 								if (error) {
 									SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_store_user_authorized_key() error (%d) for user %s", error, user_iter->user.name);
@@ -910,7 +912,7 @@ static int system_startup_store_authentication(void *priv, const struct lyd_node
 								}
 								break;
 							case srpc_check_status_equal:
-								SRPLG_LOG_INF(PLUGIN_NAME, "Startup authorized keys already exist for local user %s - no need to store anything", user_iter->user.name);
+								SYSTEM_LOG_INF("Startup authorized keys already exist for local user %s - no need to store anything", user_iter->user.name);
 								break;
 							case srpc_check_status_partial:
 								// TODO
@@ -0,0 +1,219 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "stats.h"
+#include "trace.h"
+
+#include <stdatomic.h>
+#include <time.h>
+
+// log-linear histogram: values below 8 us have their own buckets, every further power of two is split into 8 buckets
+#define SYSTEM_STATS_SUB_BITS 3
+#define SYSTEM_STATS_SUB_COUNT (1u << SYSTEM_STATS_SUB_BITS)
+#define SYSTEM_STATS_MAX_BIT 27 // ~134 s - longer operations land in the last bucket
+#define SYSTEM_STATS_BUCKET_COUNT ((SYSTEM_STATS_MAX_BIT - SYSTEM_STATS_SUB_BITS + 2) * SYSTEM_STATS_SUB_COUNT)
+
+struct system_stats_op_data {
+	_Atomic uint64_t calls;
+	_Atomic uint64_t errors;
+	_Atomic uint64_t bytes_written;
+	_Atomic uint64_t forks;
+	_Atomic uint64_t total_us;
+	_Atomic uint64_t max_us;
+	_Atomic uint64_t buckets[SYSTEM_STATS_BUCKET_COUNT];
+};
+
+static const char *const system_stats_op_names[SYSTEM_STATS_OP_COUNT] = {
+	[SYSTEM_STATS_OP_CHANGE_CONTACT] = "change-contact",
+	[SYSTEM_STATS_OP_CHANGE_HOSTNAME] = "change-hostname",
+	[SYSTEM_STATS_OP_CHANGE_LOCATION] = "change-location",
+	[SYSTEM_STATS_OP_CHANGE_TIMEZONE_NAME] = "change-timezone-name",
+	[SYSTEM_STATS_OP_CHANGE_TIMEZONE_UTC_OFFSET] = "change-timezone-utc-offset",
+	[SYSTEM_STATS_OP_CHANGE_NTP_ENABLED] = "change-ntp-enabled",
+	[SYSTEM_STATS_OP_CHANGE_NTP_SERVER] = "change-ntp-server",
+	[SYSTEM_STATS_OP_CHANGE_DNS_RESOLVER_SEARCH] = "change-dns-resolver-search",
+	[SYSTEM_STATS_OP_CHANGE_DNS_RESOLVER_SERVER] = "change-dns-resolver-server",
+	[SYSTEM_STATS_OP_CHANGE_DNS_RESOLVER_TIMEOUT] = "change-dns-resolver-timeout",
+	[SYSTEM_STATS_OP_CHANGE_DNS_RESOLVER_ATTEMPTS] = "change-dns-resolver-attempts",
+	[SYSTEM_STATS_OP_CHANGE_AUTHENTICATION_ORDER] = "change-authentication-order",
+	[SYSTEM_STATS_OP_CHANGE_AUTHENTICATION_USER] = "change-authentication-user",
+	[SYSTEM_STATS_OP_UPDATE_AUTHENTICATION_PASSWORD] = "update-authentication-password",
+	[SYSTEM_STATS_OP_OPERATIONAL_PLATFORM] = "operational-platform",
+	[SYSTEM_STATS_OP_OPERATIONAL_CLOCK] = "operational-clock",
+	[SYSTEM_STATS_OP_RPC_SET_CURRENT_DATETIME] = "rpc-set-current-datetime",
+	[SYSTEM_STATS_OP_RPC_RESTART] = "rpc-restart",
+	[SYSTEM_STATS_OP_RPC_SHUTDOWN] = "rpc-shutdown",
+	[SYSTEM_STATS_OP_LOAD_HOSTNAME] = "load-hostname",
+	[SYSTEM_STATS_OP_LOAD_TIMEZONE_NAME] = "load-timezone-name",
+	[SYSTEM_STATS_OP_LOAD_NTP_SERVER] = "load-ntp-server",
+	[SYSTEM_STATS_OP_LOAD_DNS_RESOLVER_SEARCH] = "load-dns-resolver-search",
+	[SYSTEM_STATS_OP_LOAD_DNS_RESOLVER_SERVER] = "load-dns-resolver-server",
+	[SYSTEM_STATS_OP_LOAD_AUTHENTICATION_USER] = "load-authentication-user",
+	[SYSTEM_STATS_OP_LOAD_AUTHORIZED_KEY] = "load-authorized-key",
+	[SYSTEM_STATS_OP_CHECK_HOSTNAME] = "check-hostname",
+	[SYSTEM_STATS_OP_CHECK_TIMEZONE_NAME] = "check-timezone-name",
+	[SYSTEM_STATS_OP_CHECK_NTP_SERVER] = "check-ntp-server",
+	[SYSTEM_STATS_OP_CHECK_DNS_RESOLVER_SEARCH] = "check-dns-resolver-search",
+	[SYSTEM_STATS_OP_CHECK_DNS_RESOLVER_SERVER] = "check-dns-resolver-server",
+	[SYSTEM_STATS_OP_CHECK_AUTHENTICATION_USER] = "check-authentication-user",
+	[SYSTEM_STATS_OP_CHECK_AUTHORIZED_KEY] = "check-authorized-key",
+	[SYSTEM_STATS_OP_STORE_HOSTNAME] = "store-hostname",
+	[SYSTEM_STATS_OP_STORE_TIMEZONE_NAME] = "store-timezone-name",
+	[SYSTEM_STATS_OP_STORE_NTP_SERVER] = "store-ntp-server",
+	[SYSTEM_STATS_OP_STORE_DNS_RESOLVER_SEARCH] = "store-dns-resolver-search",
+	[SYSTEM_STATS_OP_STORE_DNS_RESOLVER_SERVER] = "store-dns-resolver-server",
+	[SYSTEM_STATS_OP_STORE_AUTHENTICATION_USER] = "store-authentication-user",
+	[SYSTEM_STATS_OP_STORE_AUTHORIZED_KEY] = "store-authorized-key",
+	[SYSTEM_STATS_OP_COMMIT_AUTHENTICATION_DATABASE] = "commit-authentication-database",
+};
+
+// written from every callback thread - only atomic operations are used
+static struct system_stats_op_data system_stats_data[SYSTEM_STATS_OP_COUNT];
+
+// innermost operation running on the calling thread
+static _Thread_local int system_stats_current = -1;
+
+static int64_t system_stats_now_ns(void);
+static size_t system_stats_bucket(uint64_t value);
+static uint64_t system_stats_bucket_upper(size_t bucket);
+
+system_stats_scope_t system_stats_begin(system_stats_op_t op)
+{
+	system_stats_scope_t scope = {
+		.start = system_stats_now_ns(),
+		.op = op,
+		.previous = system_stats_current,
+	};
+
+	system_stats_current = (int) op;
+
+	return scope;
+}
+
+void system_stats_end(const system_stats_scope_t *scope, bool failed)
+{
+	struct system_stats_op_data *data = &system_stats_data[scope->op];
+	const int64_t end = system_stats_now_ns();
+	const int64_t elapsed = end - scope->start;
+	const uint64_t us = elapsed > 0 ? (uint64_t) elapsed / 1000 : 0;
+	uint64_t max = atomic_load_explicit(&data->max_us, memory_order_relaxed);
+
+	system_stats_current = scope->previous;
+
+	system_trace_record(system_stats_op_names[scope->op], NULL, scope->start, end);
+
+	atomic_fetch_add_explicit(&data->calls, 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&data->total_us, us, memory_order_relaxed);
+	atomic_fetch_add_explicit(&data->buckets[system_stats_bucket(us)], 1, memory_order_relaxed);
+
+	if (failed) {
+		atomic_fetch_add_explicit(&data->errors, 1, memory_order_relaxed);
+	}
+
+	while (us > max && !atomic_compare_exchange_weak_explicit(&data->max_us, &max, us, memory_order_relaxed, memory_order_relaxed))
+		;
+}
+
+void system_stats_add_bytes(size_t bytes)
+{
+	if (system_stats_current >= 0) {
+		atomic_fetch_add_explicit(&system_stats_data[system_stats_current].bytes_written, bytes, memory_order_relaxed);
+	}
+}
+
+void system_stats_add_fork(void)
+{
+	if (system_stats_current >= 0) {
+		atomic_fetch_add_explicit(&system_stats_data[system_stats_current].forks, 1, memory_order_relaxed);
+	}
+}
+
+const char *system_stats_op_name(system_stats_op_t op)
+{
+	return system_stats_op_names[op];
+}
+
+void system_stats_summary(system_stats_op_t op, system_stats_summary_t *summary)
+{
+	struct system_stats_op_data *data = &system_stats_data[op];
+	uint64_t counts[SYSTEM_STATS_BUCKET_COUNT] = {0};
+	uint64_t recorded = 0;
+	uint64_t seen = 0;
+	const uint64_t percentiles[] = {50, 90, 99};
+	uint64_t *results[] = {&summary->p50_us, &summary->p90_us, &summary->p99_us};
+	size_t next = 0;
+
+	*summary = (system_stats_summary_t){
+		.calls = atomic_load_explicit(&data->calls, memory_order_relaxed),
+		.errors = atomic_load_explicit(&data->errors, memory_order_relaxed),
+		.bytes_written = atomic_load_explicit(&data->bytes_written, memory_order_relaxed),
+		.forks = atomic_load_explicit(&data->forks, memory_order_relaxed),
+		.total_us = atomic_load_explicit(&data->total_us, memory_order_relaxed),
+		.max_us = atomic_load_explicit(&data->max_us, memory_order_relaxed),
+	};
+
+	// the buckets keep changing while they are read - percentiles are taken from one copy
+	for (size_t i = 0; i < SYSTEM_STATS_BUCKET_COUNT; i++) {
+		counts[i] = atomic_load_explicit(&data->buckets[i], memory_order_relaxed);
+		recorded += counts[i];
+	}
+
+	for (size_t i = 0; i < SYSTEM_STATS_BUCKET_COUNT && next < sizeof(percentiles) / sizeof(percentiles[0]); i++) {
+		seen += counts[i];
+
+		while (next < sizeof(percentiles) / sizeof(percentiles[0]) && recorded && seen * 100 >= recorded * percentiles[next]) {
+			*results[next++] = system_stats_bucket_upper(i);
+		}
+	}
+}
+
+static int64_t system_stats_now_ns(void)
+{
+	struct timespec ts = {0};
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (int64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static size_t system_stats_bucket(uint64_t value)
+{
+	unsigned int bit = 0;
+
+	if (value < SYSTEM_STATS_SUB_COUNT) {
+		return (size_t) value;
+	}
+
+	if (value >= (UINT64_C(1) << (SYSTEM_STATS_MAX_BIT + 1))) {
+		return SYSTEM_STATS_BUCKET_COUNT - 1;
+	}
+
+	bit = 63u - (unsigned int) __builtin_clzll(value);
+
+	return (size_t) (bit - SYSTEM_STATS_SUB_BITS + 1) * SYSTEM_STATS_SUB_COUNT + (size_t) ((value >> (bit - SYSTEM_STATS_SUB_BITS)) & (SYSTEM_STATS_SUB_COUNT - 1));
+}
+
+static uint64_t system_stats_bucket_upper(size_t bucket)
+{
+	const size_t octave = bucket / SYSTEM_STATS_SUB_COUNT;
+	const uint64_t sub = bucket % SYSTEM_STATS_SUB_COUNT;
+	unsigned int shift = 0;
+
+	if (octave == 0) {
+		return sub;
+	}
+
+	// octave n covers [2^(n + 2), 2^(n + 3)) in buckets 2^(n - 1) wide
+	shift = (unsigned int) octave - 1;
+
+	return ((SYSTEM_STATS_SUB_COUNT + sub + 1) << shift) - 1;
+}
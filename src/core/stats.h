@@ -0,0 +1,41 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_STATS_H
+#define SYSTEM_PLUGIN_STATS_H
+
+#include "types.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Start timing an operation - declares the scope used by SYSTEM_STATS_END() in the same function. Bytes written and
+ * processes forked while the operation runs are accounted to it unless a nested operation is running.
+ */
+#define SYSTEM_STATS_BEGIN(op) system_stats_scope_t system_stats_scope = system_stats_begin(op)
+
+/**
+ * Stop timing the operation started by SYSTEM_STATS_BEGIN() and record its latency.
+ */
+#define SYSTEM_STATS_END(failed) system_stats_end(&system_stats_scope, (failed))
+
+system_stats_scope_t system_stats_begin(system_stats_op_t op);
+void system_stats_end(const system_stats_scope_t *scope, bool failed);
+void system_stats_add_bytes(size_t bytes);
+void system_stats_add_fork(void);
+
+const char *system_stats_op_name(system_stats_op_t op);
+void system_stats_summary(system_stats_op_t op, system_stats_summary_t *summary);
+
+#endif // SYSTEM_PLUGIN_STATS_H
@@ -12,19 +12,23 @@
  */
 #include "change.h"
 #include "core/common.h"
+#include "core/log.h"
 #include "core/context.h"
 #include "libyang/printer_data.h"
 #include "core/ly_tree.h"
+#include "core/features.h"
+#include "core/stats.h"
+#include "core/trace.h"
+#include "core/transaction.h"
 #include "srpc/common.h"
 #include "srpc/feature_status.h"
 #include "srpc/ly_tree.h"
 #include "sysrepo_types.h"
-#include "core/api/system/authentication/load.h"
-#include "core/data/system/authentication/local_user/list.h"
 #include "core/data/system/dns_resolver/search/list.h"
 #include "core/data/system/dns_resolver/server/list.h"
 #include "core/data/system/ntp/server/list.h"
 #include "core/types.h"
+#include "core/drift.h"
 #include "umgmt/db.h"
 
 // Load API
@@ -37,6 +41,7 @@
 #include "core/api/system/dns_resolver/change.h"
 #include "core/api/system/ntp/change.h"
 #include "core/api/system/authentication/change.h"
+#include "core/api/system/authentication/password.h"
 
 // Store API
 #include "core/api/system/store.h"
@@ -45,7 +50,6 @@
 
 #include <sysrepo.h>
 #include <sysrepo/xpath.h>
-#include <assert.h>
 #include <errno.h>
 #include <pwd.h>
 #include <linux/limits.h>
@@ -54,16 +58,25 @@
 
 #include <utlist.h>
 
+static int system_subscription_iterate_changes(void *priv, sr_session_ctx_t *session, const char *xpath, srpc_change_cb cb);
+
 int system_subscription_change_contact(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data)
 {
 	int error = SR_ERR_OK;
 	system_ctx_t *ctx = (system_ctx_t *) private_data;
 
+	SYSTEM_STATS_BEGIN(SYSTEM_STATS_OP_CHANGE_CONTACT);
+	system_trace_set_request(request_id);
+
+	if (system_drift_is_own_change(session)) {
+		goto out;
+	}
+
 	if (event == SR_EV_ABORT) {
 		SRPLG_LOG_ERR(PLUGIN_NAME, "Aborting changes for %s", xpath);
 		goto error_out;
 	} else if (event == SR_EV_CHANGE) {
-		error = srpc_iterate_changes(ctx, session, xpath, system_change_contact, NULL, NULL);
+		error = system_subscription_iterate_changes(ctx, session, xpath, system_change_contact);
 		if (error) {
 			SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_iterate_changes() error (%d)", error);
 			goto error_out;
@@ -76,19 +89,32 @@ error_out:
 	error = SR_ERR_CALLBACK_FAILED;
 
 out:
+	SYSTEM_STATS_END(error != SR_ERR_OK);
+
 	return error;
 }
 
 int system_subscription_change_hostname(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data)
 {
 	int error = SR_ERR_OK;
+	bool drift_writing = false;
 	system_ctx_t *ctx = (system_ctx_t *) private_data;
 
+	SYSTEM_STATS_BEGIN(SYSTEM_STATS_OP_CHANGE_HOSTNAME);
+	system_trace_set_request(request_id);
+
+	if (system_drift_is_own_change(session)) {
+		goto out;
+	}
+
+	system_drift_begin(ctx, SYSTEM_SUBSYSTEM_HOSTNAME);
+	drift_writing = true;
+
 	if (event == SR_EV_ABORT) {
 		SRPLG_LOG_ERR(PLUGIN_NAME, "Aborting changes for %s", xpath);
 		goto error_out;
 	} else if (event == SR_EV_CHANGE) {
-		error = srpc_iterate_changes(ctx, session, xpath, system_change_hostname, NULL, NULL);
+		error = system_subscription_iterate_changes(ctx, session, xpath, system_change_hostname);
 		if (error) {
 			SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_iterate_changes() error (%d)", error);
 			goto error_out;
@@ -101,6 +127,12 @@ error_out:
 	error = SR_ERR_CALLBACK_FAILED;
 
 out:
+	if (drift_writing) {
+		system_drift_end(ctx, SYSTEM_SUBSYSTEM_HOSTNAME);
+	}
+
+	SYSTEM_STATS_END(error != SR_ERR_OK);
+
 	return error;
 }
 
@@ -109,11 +141,18 @@ int system_subscription_change_location(sr_session_ctx_t *session, uint32_t subs
 	int error = SR_ERR_OK;
 	system_ctx_t *ctx = (system_ctx_t *) private_data;
 
+	SYSTEM_STATS_BEGIN(SYSTEM_STATS_OP_CHANGE_LOCATION);
+	system_trace_set_request(request_id);
+
+	if (system_drift_is_own_change(session)) {
+		goto out;
+	}
+
 	if (event == SR_EV_ABORT) {
 		SRPLG_LOG_ERR(PLUGIN_NAME, "Aborting changes for %s", xpath);
 		goto error_out;
 	} else if (event == SR_EV_CHANGE) {
-		error = srpc_iterate_changes(ctx, session, xpath, system_change_location, NULL, NULL);
+		error = system_subscription_iterate_changes(ctx, session, xpath, system_change_location);
 		if (error) {
 			SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_iterate_changes() error (%d)", error);
 			goto error_out;
@@ -126,29 +165,42 @@ error_out:
 	error = SR_ERR_CALLBACK_FAILED;
 
 out:
+	SYSTEM_STATS_END(error != SR_ERR_OK);
+
 	return error;
 }
 
 int system_subscription_change_timezone_name(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data)
 {
 	int error = SR_ERR_OK;
+	bool drift_writing = false;
 	system_ctx_t *ctx = (system_ctx_t *) private_data;
 
 	// feature
 	bool timezone_name_enabled = false;
 
+	SYSTEM_STATS_BEGIN(SYSTEM_STATS_OP_CHANGE_TIMEZONE_NAME);
+	system_trace_set_request(request_id);
+
+	if (system_drift_is_own_change(session)) {
+		goto out;
+	}
+
+	system_drift_begin(ctx, SYSTEM_SUBSYSTEM_CLOCK);
+	drift_writing = true;
+
 	if (event == SR_EV_ABORT) {
 		SRPLG_LOG_ERR(PLUGIN_NAME, "aborting changes for: %s", xpath);
 		goto error_out;
 	} else if (event == SR_EV_CHANGE) {
 		// reload features in case of changes during plugin runtime
-		SRPC_SAFE_CALL_ERR(error, srpc_feature_status_hash_reload(&ctx->ietf_system_features, session, IETF_SYSTEM_YANG_MODULE), error_out);
+		SRPC_SAFE_CALL_ERR(error, system_features_reload(ctx, session), error_out);
 
 		// get feature
-		timezone_name_enabled = srpc_feature_status_hash_check(ctx->ietf_system_features, "timezone-name");
+		timezone_name_enabled = system_features_check(ctx, "timezone-name");
 
 		if (timezone_name_enabled) {
-			error = srpc_iterate_changes(ctx, session, xpath, system_change_timezone_name, NULL, NULL);
+			error = system_subscription_iterate_changes(ctx, session, xpath, system_change_timezone_name);
 			if (error) {
 				SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_iterate_changes() error (%d)", error);
 				goto error_out;
@@ -162,6 +214,12 @@ error_out:
 	error = SR_ERR_CALLBACK_FAILED;
 
 out:
+	if (drift_writing) {
+		system_drift_end(ctx, SYSTEM_SUBSYSTEM_CLOCK);
+	}
+
+	SYSTEM_STATS_END(error != SR_ERR_OK);
+
 	return error;
 }
 
@@ -170,6 +228,13 @@ int system_subscription_change_timezone_utc_offset(sr_session_ctx_t *session, ui
 	int error = SR_ERR_OK;
 	// system_ctx_t *ctx = (system_ctx_t *) private_data;
 
+	SYSTEM_STATS_BEGIN(SYSTEM_STATS_OP_CHANGE_TIMEZONE_UTC_OFFSET);
+	system_trace_set_request(request_id);
+
+	if (system_drift_is_own_change(session)) {
+		goto out;
+	}
+
 	if (event == SR_EV_ABORT) {
 		SRPLG_LOG_ERR(PLUGIN_NAME, "aborting changes for: %s", xpath);
 		goto error_out;
@@ -183,28 +248,42 @@ error_out:
 	error = SR_ERR_CALLBACK_FAILED;
 
 out:
+	SYSTEM_STATS_END(error != SR_ERR_OK);
+
 	return error;
 }
 
 int system_subscription_change_ntp_enabled(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data)
 {
 	int error = SR_ERR_OK;
+	bool drift_writing = false;
 
 	bool ntp_enabled = false;
 
 	system_ctx_t *ctx = (system_ctx_t *) private_data;
+
+	SYSTEM_STATS_BEGIN(SYSTEM_STATS_OP_CHANGE_NTP_ENABLED);
+	system_trace_set_request(request_id);
+
+	if (system_drift_is_own_change(session)) {
+		goto out;
+	}
+
+	system_drift_begin(ctx, SYSTEM_SUBSYSTEM_NTP);
+	drift_writing = true;
+
 	if (event == SR_EV_ABORT) {
 		SRPLG_LOG_ERR(PLUGIN_NAME, "aborting changes for: %s", xpath);
 		goto error_out;
 	} else if (event == SR_EV_CHANGE) {
 		// reload features in case of changes during plugin runtime
-		SRPC_SAFE_CALL_ERR(error, srpc_feature_status_hash_reload(&ctx->ietf_system_features, session, IETF_SYSTEM_YANG_MODULE), error_out);
+		SRPC_SAFE_CALL_ERR(error, system_features_reload(ctx, session), error_out);
 
 		// get feature
-		ntp_enabled = srpc_feature_status_hash_check(ctx->ietf_system_features, "ntp");
+		ntp_enabled = system_features_check(ctx, "ntp");
 
 		if (ntp_enabled) {
-			SRPC_SAFE_CALL_ERR(error, srpc_iterate_changes(ctx, session, xpath, system_ntp_change_enabled, NULL, NULL), error_out);
+			SRPC_SAFE_CALL_ERR(error, system_subscription_iterate_changes(ctx, session, xpath, system_ntp_change_enabled), error_out);
 		}
 	}
 
@@ -213,48 +292,65 @@ error_out:
 	error = SR_ERR_CALLBACK_FAILED;
 
 out:
+	if (drift_writing) {
+		system_drift_end(ctx, SYSTEM_SUBSYSTEM_NTP);
+	}
+
+	SYSTEM_STATS_END(error != SR_ERR_OK);
+
 	return error;
 }
 
 int system_subscription_change_ntp_server(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data)
 {
 	int error = SR_ERR_OK;
+	bool drift_writing = false;
 
 	char xpath_buffer[PATH_MAX] = {0};
 	system_ctx_t *ctx = (system_ctx_t *) private_data;
+	system_transaction_t transaction = {.ctx = ctx};
 	system_ntp_server_element_t *iter = NULL;
 
 	// features
 	bool ntp_enabled = false;
 	bool ntp_udp_port_enabled = false;
 
+	SYSTEM_STATS_BEGIN(SYSTEM_STATS_OP_CHANGE_NTP_SERVER);
+	system_trace_set_request(request_id);
+
+	if (system_drift_is_own_change(session)) {
+		goto out;
+	}
+
+	system_drift_begin(ctx, SYSTEM_SUBSYSTEM_NTP);
+	drift_writing = true;
+
 	if (event == SR_EV_ABORT) {
 		SRPLG_LOG_ERR(PLUGIN_NAME, "aborting changes for: %s", xpath);
 		goto error_out;
 	} else if (event == SR_EV_CHANGE) {
-		// make sure the last change servers were free'd and set to NULL
-		assert(ctx->temp_ntp_servers == NULL);
-
 		// reload features in case of changes during plugin runtime
-		SRPC_SAFE_CALL_ERR(error, srpc_feature_status_hash_reload(&ctx->ietf_system_features, session, IETF_SYSTEM_YANG_MODULE), error_out);
+		SRPC_SAFE_CALL_ERR(error, system_features_reload(ctx, session), error_out);
 
 		// get features
-		ntp_enabled = srpc_feature_status_hash_check(ctx->ietf_system_features, "ntp");
-		ntp_udp_port_enabled = srpc_feature_status_hash_check(ctx->ietf_system_features, "ntp-udp-port");
+		ntp_enabled = system_features_check(ctx, "ntp");
+		ntp_udp_port_enabled = system_features_check(ctx, "ntp-udp-port");
 
 		if (ntp_enabled) {
 			// load all system NTP servers
-			error = system_ntp_load_server(ctx, &ctx->temp_ntp_servers);
+			error = system_ntp_load_server(ctx, &transaction.ntp_servers);
 			if (error) {
 				SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_load_server() error (%d)", error);
 				goto error_out;
 			}
 
 			// process changes and use store API to store the configured list
-			SRPLG_LOG_DBG(PLUGIN_NAME, "Servers before changes:");
-			LL_FOREACH(ctx->temp_ntp_servers, iter)
-			{
-				SRPLG_LOG_DBG(PLUGIN_NAME, "\t<%s, %s, %s, %s, %s, %s>", iter->server.name, iter->server.address, iter->server.port, iter->server.association_type, iter->server.iburst, iter->server.prefer);
+			if (SYSTEM_LOG_ENABLED(SR_LL_DBG)) {
+				SYSTEM_LOG_DBG("Servers before changes:");
+				LL_FOREACH(transaction.ntp_servers, iter)
+				{
+					SYSTEM_LOG_DBG("\t<%s, %s, %s, %s, %s, %s>", iter->server.name, iter->server.address, iter->server.port, iter->server.association_type, iter->server.iburst, iter->server.prefer);
+				}
 			}
 
 			// name change
@@ -263,7 +359,7 @@ int system_subscription_change_ntp_server(sr_session_ctx_t *session, uint32_t su
 				SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error: %d", error);
 				goto error_out;
 			}
-			error = srpc_iterate_changes(ctx, session, xpath_buffer, system_ntp_change_server_name, NULL, NULL);
+			error = system_subscription_iterate_changes(&transaction, session, xpath_buffer, system_ntp_change_server_name);
 			if (error) {
 				SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_iterate_changes() for name failed: %d", error);
 				goto error_out;
@@ -275,7 +371,7 @@ int system_subscription_change_ntp_server(sr_session_ctx_t *session, uint32_t su
 				SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error: %d", error);
 				goto error_out;
 			}
-			error = srpc_iterate_changes(ctx, session, xpath_buffer, system_ntp_change_server_address, NULL, NULL);
+			error = system_subscription_iterate_changes(&transaction, session, xpath_buffer, system_ntp_change_server_address);
 			if (error) {
 				SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_iterate_changes() for address failed: %d", error);
 				goto error_out;
@@ -288,7 +384,7 @@ int system_subscription_change_ntp_server(sr_session_ctx_t *session, uint32_t su
 					SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error: %d", error);
 					goto error_out;
 				}
-				error = srpc_iterate_changes(ctx, session, xpath_buffer, system_ntp_change_server_port, NULL, NULL);
+				error = system_subscription_iterate_changes(&transaction, session, xpath_buffer, system_ntp_change_server_port);
 				if (error) {
 					SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_iterate_changes() for port failed: %d", error);
 					goto error_out;
@@ -301,7 +397,7 @@ int system_subscription_change_ntp_server(sr_session_ctx_t *session, uint32_t su
 				SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error: %d", error);
 				goto error_out;
 			}
-			error = srpc_iterate_changes(ctx, session, xpath_buffer, system_ntp_change_server_association_type, NULL, NULL);
+			error = system_subscription_iterate_changes(&transaction, session, xpath_buffer, system_ntp_change_server_association_type);
 			if (error) {
 				SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_iterate_changes() for association-type failed: %d", error);
 				goto error_out;
@@ -313,7 +409,7 @@ int system_subscription_change_ntp_server(sr_session_ctx_t *session, uint32_t su
 				SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error: %d", error);
 				goto error_out;
 			}
-			error = srpc_iterate_changes(ctx, session, xpath_buffer, system_ntp_change_server_iburst, NULL, NULL);
+			error = system_subscription_iterate_changes(&transaction, session, xpath_buffer, system_ntp_change_server_iburst);
 			if (error) {
 				SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_iterate_changes() for iburst failed: %d", error);
 				goto error_out;
@@ -325,34 +421,39 @@ int system_subscription_change_ntp_server(sr_session_ctx_t *session, uint32_t su
 				SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error: %d", error);
 				goto error_out;
 			}
-			error = srpc_iterate_changes(ctx, session, xpath_buffer, system_ntp_change_server_prefer, NULL, NULL);
+			error = system_subscription_iterate_changes(&transaction, session, xpath_buffer, system_ntp_change_server_prefer);
 			if (error) {
 				SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_iterate_changes() for prefer failed: %d", error);
 				goto error_out;
 			}
 
-			SRPLG_LOG_DBG(PLUGIN_NAME, "Servers after changes:");
-			LL_FOREACH(ctx->temp_ntp_servers, iter)
-			{
-				SRPLG_LOG_DBG(PLUGIN_NAME, "\t<%s, %s, %s, %s, %s, %s>", iter->server.name, iter->server.address, iter->server.port, iter->server.association_type, iter->server.iburst, iter->server.prefer);
+			if (SYSTEM_LOG_ENABLED(SR_LL_DBG)) {
+				SYSTEM_LOG_DBG("Servers after changes:");
+				LL_FOREACH(transaction.ntp_servers, iter)
+				{
+					SYSTEM_LOG_DBG("\t<%s, %s, %s, %s, %s, %s>", iter->server.name, iter->server.address, iter->server.port, iter->server.association_type, iter->server.iburst, iter->server.prefer);
+				}
 			}
 
 			// delete entries before applying changes - faster than searching for each server and changing libyang tree
+			pthread_mutex_lock(&ctx->startup_lock);
 			error = sr_delete_item(ctx->startup_session, "/ntp:ntp[config-file=\"/etc/ntp.conf\"]/config-entries", SR_EDIT_DEFAULT);
 			if (error) {
 				SRPLG_LOG_ERR(PLUGIN_NAME, "sr_delete_item() error (%d): %s", error, sr_strerror(error));
+				pthread_mutex_unlock(&ctx->startup_lock);
 				goto error_out;
 			}
 			error = sr_apply_changes(ctx->startup_session, 0);
+			pthread_mutex_unlock(&ctx->startup_lock);
 			if (error) {
 				SRPLG_LOG_ERR(PLUGIN_NAME, "sr_apply_changes() error (%d): %s", error, sr_strerror(error));
 				goto error_out;
 			}
 
-			SRPLG_LOG_INF(PLUGIN_NAME, "Deleted /etc/ntp.conf config file data");
+			SYSTEM_LOG_INF("Deleted /etc/ntp.conf config file data");
 
 			// store generated data
-			error = system_ntp_store_server(ctx, ctx->temp_ntp_servers);
+			error = system_ntp_store_server(ctx, transaction.ntp_servers);
 			if (error) {
 				SRPLG_LOG_ERR(PLUGIN_NAME, "system_ntp_store_server() error (%d)", error);
 				goto error_out;
@@ -365,8 +466,13 @@ error_out:
 	error = SR_ERR_CALLBACK_FAILED;
 
 out:
+	if (drift_writing) {
+		system_drift_end(ctx, SYSTEM_SUBSYSTEM_NTP);
+	}
 
-	system_ntp_server_list_free(&ctx->temp_ntp_servers);
+	system_transaction_cleanup(&transaction);
+
+	SYSTEM_STATS_END(error != SR_ERR_OK);
 
 	return error;
 }
@@ -374,42 +480,56 @@ out:
 int system_subscription_change_dns_resolver_search(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data)
 {
 	int error = SR_ERR_OK;
+	bool drift_writing = false;
 	system_dns_search_element_t *iter = NULL;
 
 	system_ctx_t *ctx = (system_ctx_t *) private_data;
+	system_transaction_t transaction = {.ctx = ctx};
+
+	SYSTEM_STATS_BEGIN(SYSTEM_STATS_OP_CHANGE_DNS_RESOLVER_SEARCH);
+	system_trace_set_request(request_id);
+
+	if (system_drift_is_own_change(session)) {
+		goto out;
+	}
+
+	system_drift_begin(ctx, SYSTEM_SUBSYSTEM_DNS_RESOLVER);
+	drift_writing = true;
+
 	if (event == SR_EV_ABORT) {
 		SRPLG_LOG_ERR(PLUGIN_NAME, "aborting changes for: %s", xpath);
 		goto error_out;
 	} else if (event == SR_EV_CHANGE) {
-		// make sure the last change search values were free'd and set to NULL
-		assert(ctx->temp_dns_search == NULL);
-
 		// load all system DNS search domains first
-		error = system_dns_resolver_load_search(ctx, &ctx->temp_dns_search);
+		error = system_dns_resolver_load_search(ctx, &transaction.dns_search);
 		if (error) {
 			SRPLG_LOG_ERR(PLUGIN_NAME, "system_dns_resolver_load_search() error (%d)", error);
 			goto error_out;
 		}
 
-		SRPLG_LOG_DBG(PLUGIN_NAME, "Search domains before changes:");
-		LL_FOREACH(ctx->temp_dns_search, iter)
-		{
-			SRPLG_LOG_DBG(PLUGIN_NAME, "\t<%s>", iter->search.domain);
+		if (SYSTEM_LOG_ENABLED(SR_LL_DBG)) {
+			SYSTEM_LOG_DBG("Search domains before changes:");
+			LL_FOREACH(transaction.dns_search, iter)
+			{
+				SYSTEM_LOG_DBG("\t<%s>", iter->search.domain);
+			}
 		}
 
-		error = srpc_iterate_changes(ctx, session, xpath, system_dns_resolver_change_search, NULL, NULL);
+		error = system_subscription_iterate_changes(&transaction, session, xpath, system_dns_resolver_change_search);
 		if (error) {
 			SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_iterate_changes() for name failed: %d", error);
 			goto error_out;
 		}
 
-		SRPLG_LOG_DBG(PLUGIN_NAME, "Search domains after changes:");
-		LL_FOREACH(ctx->temp_dns_search, iter)
-		{
-			SRPLG_LOG_DBG(PLUGIN_NAME, "\t<%s>", iter->search.domain);
+		if (SYSTEM_LOG_ENABLED(SR_LL_DBG)) {
+			SYSTEM_LOG_DBG("Search domains after changes:");
+			LL_FOREACH(transaction.dns_search, iter)
+			{
+				SYSTEM_LOG_DBG("\t<%s>", iter->search.domain);
+			}
 		}
 
-		error = system_dns_resolver_store_search(ctx, ctx->temp_dns_search);
+		error = system_dns_resolver_store_search(ctx, transaction.dns_search);
 		if (error) {
 			SRPLG_LOG_ERR(PLUGIN_NAME, "system_dns_resolver_store_search() error (%d)", error);
 			goto error_out;
@@ -422,8 +542,13 @@ error_out:
 	error = SR_ERR_CALLBACK_FAILED;
 
 out:
+	if (drift_writing) {
+		system_drift_end(ctx, SYSTEM_SUBSYSTEM_DNS_RESOLVER);
+	}
+
+	system_transaction_cleanup(&transaction);
 
-	system_dns_search_list_free(&ctx->temp_dns_search);
+	SYSTEM_STATS_END(error != SR_ERR_OK);
 
 	return error;
 }
@@ -431,29 +556,40 @@ out:
 int system_subscription_change_dns_resolver_server(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data)
 {
 	int error = SR_ERR_OK;
+	bool drift_writing = false;
 
 	char xpath_buffer[PATH_MAX] = {0};
 	system_ctx_t *ctx = (system_ctx_t *) private_data;
+	system_transaction_t transaction = {.ctx = ctx};
 	system_dns_server_element_t *iter = NULL;
 
+	SYSTEM_STATS_BEGIN(SYSTEM_STATS_OP_CHANGE_DNS_RESOLVER_SERVER);
+	system_trace_set_request(request_id);
+
+	if (system_drift_is_own_change(session)) {
+		goto out;
+	}
+
+	system_drift_begin(ctx, SYSTEM_SUBSYSTEM_DNS_RESOLVER);
+	drift_writing = true;
+
 	if (event == SR_EV_ABORT) {
 		SRPLG_LOG_ERR(PLUGIN_NAME, "aborting changes for: %s", xpath);
 		goto error_out;
 	} else if (event == SR_EV_CHANGE) {
-		// make sure the last change servers were free'd and set to NULL
-		assert(ctx->temp_dns_servers == NULL);
-
 		// load all system DNS servers first
-		error = system_dns_resolver_load_server(ctx, &ctx->temp_dns_servers);
+		error = system_dns_resolver_load_server(ctx, &transaction.dns_servers);
 		if (error) {
 			SRPLG_LOG_ERR(PLUGIN_NAME, "system_dns_resolver_load_server() error (%d)", error);
 			goto error_out;
 		}
 
-		SRPLG_LOG_DBG(PLUGIN_NAME, "Servers before changes:");
-		LL_FOREACH(ctx->temp_dns_servers, iter)
-		{
-			SRPLG_LOG_DBG(PLUGIN_NAME, "\t<%s>", iter->server.name);
+		if (SYSTEM_LOG_ENABLED(SR_LL_DBG)) {
+			SYSTEM_LOG_DBG("Servers before changes:");
+			LL_FOREACH(transaction.dns_servers, iter)
+			{
+				SYSTEM_LOG_DBG("\t<%s>", iter->server.name);
+			}
 		}
 
 		// process changes and use store API to store the configured list
@@ -464,7 +600,7 @@ int system_subscription_change_dns_resolver_server(sr_session_ctx_t *session, ui
 			SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error: %d", error);
 			goto error_out;
 		}
-		error = srpc_iterate_changes(ctx, session, xpath_buffer, system_dns_resolver_change_server_name, NULL, NULL);
+		error = system_subscription_iterate_changes(&transaction, session, xpath_buffer, system_dns_resolver_change_server_name);
 		if (error) {
 			SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_iterate_changes() for name failed: %d", error);
 			goto error_out;
@@ -476,7 +612,7 @@ int system_subscription_change_dns_resolver_server(sr_session_ctx_t *session, ui
 			SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error: %d", error);
 			goto error_out;
 		}
-		error = srpc_iterate_changes(ctx, session, xpath_buffer, system_dns_resolver_change_server_address, NULL, NULL);
+		error = system_subscription_iterate_changes(&transaction, session, xpath_buffer, system_dns_resolver_change_server_address);
 		if (error) {
 			SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_iterate_changes() for address failed: %d", error);
 			goto error_out;
@@ -488,20 +624,22 @@ int system_subscription_change_dns_resolver_server(sr_session_ctx_t *session, ui
 			SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error: %d", error);
 			goto error_out;
 		}
-		error = srpc_iterate_changes(ctx, session, xpath_buffer, system_dns_resolver_change_server_port, NULL, NULL);
+		error = system_subscription_iterate_changes(&transaction, session, xpath_buffer, system_dns_resolver_change_server_port);
 		if (error) {
 			SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_iterate_changes() for port failed: %d", error);
 			goto error_out;
 		}
 
-		SRPLG_LOG_DBG(PLUGIN_NAME, "Servers after changes:");
-		LL_FOREACH(ctx->temp_dns_servers, iter)
-		{
-			SRPLG_LOG_DBG(PLUGIN_NAME, "\t<%s>", iter->server.name);
+		if (SYSTEM_LOG_ENABLED(SR_LL_DBG)) {
+			SYSTEM_LOG_DBG("Servers after changes:");
+			LL_FOREACH(transaction.dns_servers, iter)
+			{
+				SYSTEM_LOG_DBG("\t<%s>", iter->server.name);
+			}
 		}
 
 		// store generated data
-		error = system_dns_resolver_store_server(ctx, ctx->temp_dns_servers);
+		error = system_dns_resolver_store_server(ctx, transaction.dns_servers);
 		if (error) {
 			SRPLG_LOG_ERR(PLUGIN_NAME, "system_dns_resolver_store_server() error (%d)", error);
 			goto error_out;
@@ -513,8 +651,13 @@ error_out:
 	error = SR_ERR_CALLBACK_FAILED;
 
 out:
+	if (drift_writing) {
+		system_drift_end(ctx, SYSTEM_SUBSYSTEM_DNS_RESOLVER);
+	}
+
+	system_transaction_cleanup(&transaction);
 
-	system_dns_server_list_free(&ctx->temp_dns_servers);
+	SYSTEM_STATS_END(error != SR_ERR_OK);
 
 	return error;
 }
@@ -523,6 +666,14 @@ int system_subscription_change_dns_resolver_timeout(sr_session_ctx_t *session, u
 {
 	int error = SR_ERR_OK;
 	// system_ctx_t *ctx = (system_ctx_t *) private_data;
+
+	SYSTEM_STATS_BEGIN(SYSTEM_STATS_OP_CHANGE_DNS_RESOLVER_TIMEOUT);
+	system_trace_set_request(request_id);
+
+	if (system_drift_is_own_change(session)) {
+		goto out;
+	}
+
 	if (event == SR_EV_ABORT) {
 		SRPLG_LOG_ERR(PLUGIN_NAME, "aborting changes for: %s", xpath);
 		goto error_out;
@@ -535,6 +686,8 @@ error_out:
 	error = SR_ERR_CALLBACK_FAILED;
 
 out:
+	SYSTEM_STATS_END(error != SR_ERR_OK);
+
 	return error;
 }
 
@@ -542,6 +695,14 @@ int system_subscription_change_dns_resolver_attempts(sr_session_ctx_t *session,
 {
 	int error = SR_ERR_OK;
 	// system_ctx_t *ctx = (system_ctx_t *) private_data;
+
+	SYSTEM_STATS_BEGIN(SYSTEM_STATS_OP_CHANGE_DNS_RESOLVER_ATTEMPTS);
+	system_trace_set_request(request_id);
+
+	if (system_drift_is_own_change(session)) {
+		goto out;
+	}
+
 	if (event == SR_EV_ABORT) {
 		SRPLG_LOG_ERR(PLUGIN_NAME, "aborting changes for: %s", xpath);
 		goto error_out;
@@ -555,6 +716,8 @@ error_out:
 	error = SR_ERR_CALLBACK_FAILED;
 
 out:
+	SYSTEM_STATS_END(error != SR_ERR_OK);
+
 	return error;
 }
 
@@ -562,6 +725,14 @@ int system_subscription_change_authentication_user_authentication_order(sr_sessi
 {
 	int error = SR_ERR_OK;
 	// system_ctx_t *ctx = (system_ctx_t *) private_data;
+
+	SYSTEM_STATS_BEGIN(SYSTEM_STATS_OP_CHANGE_AUTHENTICATION_ORDER);
+	system_trace_set_request(request_id);
+
+	if (system_drift_is_own_change(session)) {
+		goto out;
+	}
+
 	if (event == SR_EV_ABORT) {
 		SRPLG_LOG_ERR(PLUGIN_NAME, "aborting changes for: %s", xpath);
 		goto error_out;
@@ -574,124 +745,60 @@ error_out:
 	error = SR_ERR_CALLBACK_FAILED;
 
 out:
+	SYSTEM_STATS_END(error != SR_ERR_OK);
+
 	return error;
 }
 
 int system_subscription_change_authentication_user(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data)
 {
 	int error = SR_ERR_OK;
+	bool drift_writing = false;
 
 	char xpath_buffer[PATH_MAX] = {0};
 	system_ctx_t *ctx = (system_ctx_t *) private_data;
+	system_transaction_t transaction = {.ctx = ctx};
 
 	bool authentication_enabled = false;
 	bool local_users_enabled = false;
-	system_local_user_element_t *user_iter = NULL;
+
+	SYSTEM_STATS_BEGIN(SYSTEM_STATS_OP_CHANGE_AUTHENTICATION_USER);
+	system_trace_set_request(request_id);
+
+	if (system_drift_is_own_change(session)) {
+		goto out;
+	}
+
+	system_drift_begin(ctx, SYSTEM_SUBSYSTEM_AUTHENTICATION);
+	drift_writing = true;
 
 	if (event == SR_EV_ABORT) {
 		SRPLG_LOG_ERR(PLUGIN_NAME, "aborting changes for: %s", xpath);
 		error = -1;
 		goto error_out;
 	} else if (event == SR_EV_CHANGE) {
-		// assert user database is NULL from the last change
-		assert(ctx->temp_users.created == NULL);
-		assert(ctx->temp_users.modified == NULL);
-		assert(ctx->temp_users.deleted == NULL);
-
 		// reload features in case of changes during plugin runtime
-		SRPC_SAFE_CALL_ERR(error, srpc_feature_status_hash_reload(&ctx->ietf_system_features, session, IETF_SYSTEM_YANG_MODULE), error_out);
+		SRPC_SAFE_CALL_ERR(error, system_features_reload(ctx, session), error_out);
 
 		// get features
-		authentication_enabled = srpc_feature_status_hash_check(ctx->ietf_system_features, "authentication");
-		local_users_enabled = srpc_feature_status_hash_check(ctx->ietf_system_features, "local-users");
+		authentication_enabled = system_features_check(ctx, "authentication");
+		local_users_enabled = system_features_check(ctx, "local-users");
 
 		if (authentication_enabled && local_users_enabled) {
-			// load current users into modifed list so they can also be modified
-			error = system_authentication_load_user(ctx, &ctx->temp_users.modified);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_load_user() error (%d)", error);
-				goto error_out;
-			}
-
-			// also key users list
-			error = system_authentication_load_user(ctx, &ctx->temp_users.keys.modified);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_load_user() error (%d)", error);
-				goto error_out;
-			}
-
-			// load all keys for the modified list
-			LL_FOREACH(ctx->temp_users.keys.modified, user_iter)
-			{
-				error = system_authentication_load_user_authorized_key(ctx, user_iter->user.name, &user_iter->user.key_head);
-				if (error) {
-					SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_load_user_authorized_key() error (%d) for user %s", error, user_iter->user.name);
-					goto error_out;
-				}
-			}
-
-			// name change
-			error = snprintf(xpath_buffer, sizeof(xpath_buffer), "%s/name", xpath);
-			if (error < 0) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error: %d", error);
-				goto error_out;
-			}
-			error = srpc_iterate_changes(ctx, session, xpath_buffer, system_authentication_change_user_name, NULL, NULL);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_iterate_changes() for user:name failed: %d", error);
-				goto error_out;
-			}
-
-			// password change
-			error = snprintf(xpath_buffer, sizeof(xpath_buffer), "%s/password", xpath);
-			if (error < 0) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error: %d", error);
-				goto error_out;
-			}
-			error = srpc_iterate_changes(ctx, session, xpath_buffer, system_authentication_change_user_password, NULL, NULL);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_iterate_changes() for user:password failed: %d", error);
-				goto error_out;
-			}
-
-			// authorized-key name change
-			error = snprintf(xpath_buffer, sizeof(xpath_buffer), "%s/authorized-key//name", xpath);
-			if (error < 0) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error: %d", error);
-				goto error_out;
-			}
-			error = srpc_iterate_changes(ctx, session, xpath_buffer, system_authentication_user_change_authorized_key_name, NULL, NULL);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_iterate_changes() for user:authorized-key:name failed: %d", error);
-				goto error_out;
-			}
-
-			// authorized-key algorithm change
-			error = snprintf(xpath_buffer, sizeof(xpath_buffer), "%s/authorized-key//algorithm", xpath);
+			// one walk over the whole user subtree - every change is added to the record of its user
+			error = snprintf(xpath_buffer, sizeof(xpath_buffer), "%s//.", xpath);
 			if (error < 0) {
 				SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error: %d", error);
 				goto error_out;
 			}
-			error = srpc_iterate_changes(ctx, session, xpath_buffer, system_authentication_user_change_authorized_key_algorithm, NULL, NULL);
+			error = system_subscription_iterate_changes(&transaction, session, xpath_buffer, system_authentication_change_user);
 			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_iterate_changes() for user:authorized-key:algorithm failed: %d", error);
-				goto error_out;
-			}
-
-			// authorized-key key-data change
-			error = snprintf(xpath_buffer, sizeof(xpath_buffer), "%s/authorized-key//key-data", xpath);
-			if (error < 0) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error: %d", error);
-				goto error_out;
-			}
-			error = srpc_iterate_changes(ctx, session, xpath_buffer, system_authentication_user_change_authorized_key_key_data, NULL, NULL);
-			if (error) {
-				SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_iterate_changes() for user:authorized-key:key-data failed: %d", error);
+				SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_iterate_changes() for user failed: %d", error);
 				goto error_out;
 			}
 
 			// apply all changes regarding created/modified/deleted users
-			error = system_authentication_user_apply_changes(ctx);
+			error = system_authentication_user_apply_changes(&transaction);
 			if (error) {
 				SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_user_apply_changes() error (%d)", error);
 				goto error_out;
@@ -705,29 +812,77 @@ error_out:
 	error = SR_ERR_CALLBACK_FAILED;
 
 out:
-	if (ctx->temp_users.created) {
-		system_local_user_list_free(&ctx->temp_users.created);
+	if (drift_writing) {
+		system_drift_end(ctx, SYSTEM_SUBSYSTEM_AUTHENTICATION);
 	}
-	if (ctx->temp_users.modified) {
-		system_local_user_list_free(&ctx->temp_users.modified);
+
+	system_transaction_cleanup(&transaction);
+
+	SYSTEM_STATS_END(error != SR_ERR_OK);
+
+	return error;
+}
+
+int system_subscription_update_authentication_user_password(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data)
+{
+	int error = SR_ERR_OK;
+	system_password_batch_t batch = {0};
+
+	// the subscription sees the other events as well - those are handled by the user callback
+	if (event != SR_EV_UPDATE) {
+		return SR_ERR_OK;
 	}
-	if (ctx->temp_users.deleted) {
-		system_local_user_list_free(&ctx->temp_users.deleted);
+
+	SYSTEM_STATS_BEGIN(SYSTEM_STATS_OP_UPDATE_AUTHENTICATION_PASSWORD);
+	system_trace_set_request(request_id);
+
+	// collect the cleartext passwords of the edit
+	error = system_subscription_iterate_changes(&batch, session, xpath, system_authentication_change_user_password_cleartext);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_iterate_changes() for user:password failed: %d", error);
+		goto error_out;
 	}
 
-	// key lists
-	if (ctx->temp_users.keys.created) {
-		system_local_user_list_free(&ctx->temp_users.keys.created);
+	if (!batch.count) {
+		goto out;
 	}
-	if (ctx->temp_users.keys.modified) {
-		system_local_user_list_free(&ctx->temp_users.keys.modified);
+
+	error = system_authentication_password_batch_hash(&batch);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_password_batch_hash() error (%d)", error);
+		goto error_out;
 	}
-	if (ctx->temp_users.keys.deleted) {
-		system_local_user_list_free(&ctx->temp_users.keys.deleted);
+
+	// replace the cleartext values in the edit - only the hashes reach the datastore and the change callbacks
+	for (size_t i = 0; i < batch.count; i++) {
+		error = sr_set_item_str(session, batch.jobs[i].xpath, batch.jobs[i].hash, NULL, 0);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "sr_set_item_str() error (%d): %s", error, sr_strerror(error));
+			goto error_out;
+		}
 	}
 
-	ctx->temp_users.created = ctx->temp_users.modified = ctx->temp_users.deleted = NULL;
-	ctx->temp_users.keys.created = ctx->temp_users.keys.modified = ctx->temp_users.keys.deleted = NULL;
+	SYSTEM_LOG_INF("Hashed %zu cleartext passwords", batch.count);
+
+	goto out;
+
+error_out:
+	error = SR_ERR_CALLBACK_FAILED;
+
+out:
+	system_authentication_password_batch_free(&batch);
+
+	SYSTEM_STATS_END(error != SR_ERR_OK);
+
+	return error;
+}
+
+static int system_subscription_iterate_changes(void *priv, sr_session_ctx_t *session, const char *xpath, srpc_change_cb cb)
+{
+	const int64_t start = system_trace_begin();
+	int error = srpc_iterate_changes(priv, session, xpath, cb, NULL, NULL);
+
+	system_trace_end("srpc_iterate_changes", xpath, start);
 
 	return error;
 }
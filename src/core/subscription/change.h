@@ -35,5 +35,6 @@ int system_subscription_change_dns_resolver_attempts(sr_session_ctx_t *session,
 // authentication //
 int system_subscription_change_authentication_user_authentication_order(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data);
 int system_subscription_change_authentication_user(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data);
+int system_subscription_update_authentication_user_password(sr_session_ctx_t *session, uint32_t subscription_id, const char *module_name, const char *xpath, sr_event_t event, uint32_t request_id, void *private_data);
 
 #endif // SYSTEM_PLUGIN_SUBSCRIPTION_CHANGE_H
\ No newline at end of file
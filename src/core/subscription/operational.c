@@ -13,9 +13,13 @@
 #include "operational.h"
 #include "core/common.h"
 #include "core/ly_tree.h"
+#include "core/stats.h"
+#include "core/trace.h"
 
 #include <sys/sysinfo.h>
 #include <sys/utsname.h>
+#include <inttypes.h>
+#include <stdio.h>
 #include <string.h>
 #include <errno.h>
 
@@ -49,6 +53,9 @@ int system_subscription_operational_platform(sr_session_ctx_t *session, uint32_t
 	const struct ly_ctx *ly_ctx = NULL;
 	struct lyd_node *platform_container_node = *parent;
 
+	SYSTEM_STATS_BEGIN(SYSTEM_STATS_OP_OPERATIONAL_PLATFORM);
+	system_trace_set_request(request_id);
+
 	error = system_get_platform_info(&platform);
 	if (error) {
 		SRPLG_LOG_ERR(PLUGIN_NAME, "system_get_platform_info() error: %s", strerror(errno));
@@ -98,6 +105,8 @@ out:
 
 	system_free_platform_info(&platform);
 
+	SYSTEM_STATS_END(error != SR_ERR_OK);
+
 	return error;
 }
 
@@ -108,6 +117,9 @@ int system_subscription_operational_clock(sr_session_ctx_t *session, uint32_t su
 	const struct ly_ctx *ly_ctx = NULL;
 	struct lyd_node *clock_container_node = *parent;
 
+	SYSTEM_STATS_BEGIN(SYSTEM_STATS_OP_OPERATIONAL_CLOCK);
+	system_trace_set_request(request_id);
+
 	error = system_get_clock_info(&clock);
 	if (error) {
 		SRPLG_LOG_ERR(PLUGIN_NAME, "system_get_platform_info() error: %s", strerror(errno));
@@ -139,6 +151,75 @@ int system_subscription_operational_clock(sr_session_ctx_t *session, uint32_t su
 
 	goto out;
 
+error_out:
+	error = SR_ERR_CALLBACK_FAILED;
+out:
+
+	SYSTEM_STATS_END(error != SR_ERR_OK);
+
+	return error;
+}
+
+int system_subscription_operational_stats(sr_session_ctx_t *session, uint32_t sub_id, const char *module_name, const char *path, const char *request_xpath, uint32_t request_id, struct lyd_node **parent, void *private_data)
+{
+	int error = SR_ERR_OK;
+	LY_ERR ly_error = LY_SUCCESS;
+	system_stats_summary_t summary = {0};
+	char path_buffer[PATH_MAX] = {0};
+	char value_buffer[21] = {0};
+
+	// make sure the passed parent node is the stats container node - the one we subscribed to
+	assert(*parent && strcmp(LYD_NAME(*parent), "stats") == 0);
+
+	for (int i = 0; i < SYSTEM_STATS_OP_COUNT; i++) {
+		const system_stats_op_t op = (system_stats_op_t) i;
+
+		system_stats_summary(op, &summary);
+
+		// operations which never ran only add noise
+		if (!summary.calls) {
+			continue;
+		}
+
+		const struct {
+			const char *name;
+			uint64_t value;
+		} leaves[] = {
+			{"calls", summary.calls},
+			{"errors", summary.errors},
+			{"bytes-written", summary.bytes_written},
+			{"forks", summary.forks},
+			{"total-time", summary.total_us},
+			{"max-time", summary.max_us},
+			{"p50-time", summary.p50_us},
+			{"p90-time", summary.p90_us},
+			{"p99-time", summary.p99_us},
+		};
+
+		for (size_t j = 0; j < ARRAY_SIZE(leaves); j++) {
+			error = snprintf(path_buffer, sizeof(path_buffer), "operation[name='%s']/%s", system_stats_op_name(op), leaves[j].name);
+			if (error < 0) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error (%d)", error);
+				goto error_out;
+			}
+
+			error = snprintf(value_buffer, sizeof(value_buffer), "%" PRIu64, leaves[j].value);
+			if (error < 0) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "snprintf() error (%d)", error);
+				goto error_out;
+			}
+
+			ly_error = lyd_new_path(*parent, NULL, path_buffer, value_buffer, 0, NULL);
+			if (ly_error != LY_SUCCESS) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "lyd_new_path() error (%d) for %s", ly_error, path_buffer);
+				goto error_out;
+			}
+		}
+	}
+
+	error = SR_ERR_OK;
+	goto out;
+
 error_out:
 	error = SR_ERR_CALLBACK_FAILED;
 out:
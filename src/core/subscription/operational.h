@@ -21,4 +21,7 @@ int system_subscription_operational_platform(sr_session_ctx_t *session, uint32_t
 // clock //
 int system_subscription_operational_clock(sr_session_ctx_t *session, uint32_t sub_id, const char *module_name, const char *path, const char *request_xpath, uint32_t request_id, struct lyd_node **parent, void *private_data);
 
+// plugin stats //
+int system_subscription_operational_stats(sr_session_ctx_t *session, uint32_t sub_id, const char *module_name, const char *path, const char *request_xpath, uint32_t request_id, struct lyd_node **parent, void *private_data);
+
 #endif // SYSTEM_PLUGIN_SUBSCRIPTION_OPERATIONAL_H
\ No newline at end of file
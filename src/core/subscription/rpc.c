@@ -12,11 +12,15 @@
  */
 #include "rpc.h"
 #include "core/common.h"
+#include "core/log.h"
+#include "core/stats.h"
+#include "core/trace.h"
 
 #include <assert.h>
 #include <sysrepo.h>
 
 #include <time.h>
+#include <linux/limits.h>
 
 // helpers //
 
@@ -30,6 +34,9 @@ int system_subscription_rpc_set_current_datetime(sr_session_ctx_t *session, uint
 
 	const char *current_datetime = NULL;
 
+	SYSTEM_STATS_BEGIN(SYSTEM_STATS_OP_RPC_SET_CURRENT_DATETIME);
+	system_trace_set_request(request_id);
+
 	// assert only one input value - datetime
 	assert(input_cnt == 1);
 
@@ -41,7 +48,7 @@ int system_subscription_rpc_set_current_datetime(sr_session_ctx_t *session, uint
 		goto error_out;
 	}
 
-	SRPLG_LOG_INF(PLUGIN_NAME, "System time successfully set.");
+	SYSTEM_LOG_INF("System time successfully set.");
 
 	goto out;
 
@@ -50,6 +57,8 @@ error_out:
 	SRPLG_LOG_ERR(PLUGIN_NAME, "Failed to set system time.");
 
 out:
+	SYSTEM_STATS_END(error != SR_ERR_OK);
+
 	return error;
 }
 
@@ -57,9 +66,15 @@ int system_subscription_rpc_restart(sr_session_ctx_t *session, uint32_t subscrip
 {
 	int error = SR_ERR_OK;
 
+	SYSTEM_STATS_BEGIN(SYSTEM_STATS_OP_RPC_RESTART);
+	system_trace_set_request(request_id);
+
 	sync();
+	system_stats_add_fork();
 	system("shutdown -r");
-	SRPLG_LOG_INF(PLUGIN_NAME, "Restarting the system!");
+	SYSTEM_LOG_INF("Restarting the system!");
+
+	SYSTEM_STATS_END(error != SR_ERR_OK);
 
 	return error;
 }
@@ -68,10 +83,76 @@ int system_subscription_rpc_shutdown(sr_session_ctx_t *session, uint32_t subscri
 {
 	int error = SR_ERR_OK;
 
+	SYSTEM_STATS_BEGIN(SYSTEM_STATS_OP_RPC_SHUTDOWN);
+	system_trace_set_request(request_id);
+
 	sync();
+	system_stats_add_fork();
 	system("shutdown -P");
-	SRPLG_LOG_INF(PLUGIN_NAME, "Shutting down the system!");
+	SYSTEM_LOG_INF("Shutting down the system!");
+
+	SYSTEM_STATS_END(error != SR_ERR_OK);
+
+	return error;
+}
+
+int system_subscription_rpc_set_trace(sr_session_ctx_t *session, uint32_t subscription_id, const char *op_path, const sr_val_t *input, const size_t input_cnt, sr_event_t event, uint32_t request_id, sr_val_t **output, size_t *output_cnt, void *private_data)
+{
+	// assert only one input value - enabled
+	assert(input_cnt == 1);
 
+	system_trace_set_enabled(input[0].data.bool_val);
+
+	SYSTEM_LOG_INF("Tracing %s.", input[0].data.bool_val ? "enabled" : "disabled");
+
+	return SR_ERR_OK;
+}
+
+int system_subscription_rpc_dump_trace(sr_session_ctx_t *session, uint32_t subscription_id, const char *op_path, const sr_val_t *input, const size_t input_cnt, sr_event_t event, uint32_t request_id, sr_val_t **output, size_t *output_cnt, void *private_data)
+{
+	int error = SR_ERR_OK;
+
+	char file[PATH_MAX] = SYSTEM_TRACE_DEFAULT_FILE;
+
+	// optional input value - name of the file in the state directory
+	if (input_cnt == 1 && system_trace_path(file, sizeof(file), input[0].data.string_val)) {
+		goto error_out;
+	}
+
+	error = system_trace_dump(input_cnt == 1 ? file : NULL);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_trace_dump() error (%d) for %s", error, file);
+		goto error_out;
+	}
+
+	error = sr_new_values(1, output);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_new_values() error (%d): %s", error, sr_strerror(error));
+		goto error_out;
+	}
+
+	error = sr_val_set_xpath(*output, SYSTEM_STATS_DUMP_TRACE_RPC_YANG_PATH "/file");
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_val_set_xpath() error (%d): %s", error, sr_strerror(error));
+		goto error_out;
+	}
+
+	error = sr_val_set_str_data(*output, SR_STRING_T, file);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_val_set_str_data() error (%d): %s", error, sr_strerror(error));
+		goto error_out;
+	}
+
+	*output_cnt = 1;
+
+	SYSTEM_LOG_INF("Trace written to %s.", file);
+
+	goto out;
+
+error_out:
+	error = SR_ERR_CALLBACK_FAILED;
+
+out:
 	return error;
 }
 
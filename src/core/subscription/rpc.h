@@ -24,4 +24,10 @@ int system_subscription_rpc_restart(sr_session_ctx_t *session, uint32_t subscrip
 // shutdown //
 int system_subscription_rpc_shutdown(sr_session_ctx_t *session, uint32_t subscription_id, const char *op_path, const sr_val_t *input, const size_t input_cnt, sr_event_t event, uint32_t request_id, sr_val_t **output, size_t *output_cnt, void *private_data);
 
+// sysrepo-plugin-system-stats:set-trace //
+int system_subscription_rpc_set_trace(sr_session_ctx_t *session, uint32_t subscription_id, const char *op_path, const sr_val_t *input, const size_t input_cnt, sr_event_t event, uint32_t request_id, sr_val_t **output, size_t *output_cnt, void *private_data);
+
+// sysrepo-plugin-system-stats:dump-trace //
+int system_subscription_rpc_dump_trace(sr_session_ctx_t *session, uint32_t subscription_id, const char *op_path, const sr_val_t *input, const size_t input_cnt, sr_event_t event, uint32_t request_id, sr_val_t **output, size_t *output_cnt, void *private_data);
+
 #endif // SYSTEM_PLUGIN_SUBSCRIPTION_RPC_H
\ No newline at end of file
@@ -0,0 +1,317 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "trace.h"
+#include "common.h"
+#include "log.h"
+#include "root.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/limits.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#include <sysrepo.h>
+
+#define SYSTEM_TRACE_RING_SIZE 2048
+#define SYSTEM_TRACE_DETAIL_SIZE 96
+
+struct system_trace_span {
+	const char *name; ///< Static string - only the pointer is stored.
+	char detail[SYSTEM_TRACE_DETAIL_SIZE];
+	int64_t start; ///< Monotonic time (ns).
+	int64_t duration;
+	uint32_t request_id;
+};
+
+// written only by its thread - the dump reads it concurrently and drops the entries which could have been overwritten
+struct system_trace_ring {
+	struct system_trace_span spans[SYSTEM_TRACE_RING_SIZE];
+	_Atomic uint64_t head; ///< Number of spans ever written.
+	long tid;
+	struct system_trace_ring *next;
+};
+
+static atomic_bool system_trace_on = false;
+
+// rings of all threads which ever recorded a span - kept for the lifetime of the process
+static struct system_trace_ring *system_trace_rings = NULL;
+static pthread_mutex_t system_trace_rings_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static _Thread_local struct system_trace_ring *system_trace_thread_ring = NULL;
+static _Thread_local uint32_t system_trace_request_id = 0;
+
+static int64_t system_trace_now_ns(void);
+static struct system_trace_ring *system_trace_get_ring(void);
+static void system_trace_print_string(FILE *file, const char *value);
+
+void system_trace_init(void)
+{
+	const char *value = getenv(SYSTEM_TRACE_ENV);
+
+	system_trace_set_enabled(value && !strcmp(value, "1"));
+}
+
+void system_trace_set_enabled(bool enabled)
+{
+	atomic_store_explicit(&system_trace_on, enabled, memory_order_relaxed);
+
+	SYSTEM_LOG_INF("Span tracing %s", enabled ? "enabled" : "disabled");
+}
+
+bool system_trace_enabled(void)
+{
+	return atomic_load_explicit(&system_trace_on, memory_order_relaxed);
+}
+
+void system_trace_set_request(uint32_t request_id)
+{
+	system_trace_request_id = request_id;
+}
+
+int64_t system_trace_begin(void)
+{
+	return system_trace_enabled() ? system_trace_now_ns() : 0;
+}
+
+void system_trace_end(const char *name, const char *detail, int64_t start)
+{
+	// tracing was enabled in the middle of the span - it has no start
+	if (!start) {
+		return;
+	}
+
+	system_trace_record(name, detail, start, system_trace_now_ns());
+}
+
+void system_trace_record(const char *name, const char *detail, int64_t start, int64_t end)
+{
+	struct system_trace_ring *ring = NULL;
+	struct system_trace_span *span = NULL;
+	uint64_t head = 0;
+
+	if (!system_trace_enabled()) {
+		return;
+	}
+
+	ring = system_trace_get_ring();
+	if (!ring) {
+		return;
+	}
+
+	head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+	span = &ring->spans[head % SYSTEM_TRACE_RING_SIZE];
+
+	span->name = name;
+	span->start = start;
+	span->duration = end - start;
+	span->request_id = system_trace_request_id;
+	if (detail) {
+		strncpy(span->detail, detail, sizeof(span->detail) - 1);
+		span->detail[sizeof(span->detail) - 1] = 0;
+	} else {
+		span->detail[0] = 0;
+	}
+
+	atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+int system_trace_path(char *buffer, size_t size, const char *name)
+{
+	char directory_buffer[PATH_MAX] = {0};
+
+	// only a plain file name - the dump never leaves the state directory
+	if (!name || !*name || strchr(name, '/') || !strcmp(name, ".") || !strcmp(name, "..")) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Invalid trace file name \"%s\"", name ? name : "");
+		return -1;
+	}
+
+	// the state directory is the one of the files root, like every other file of the plugin
+	if (system_root_path(directory_buffer, sizeof(directory_buffer), SYSTEM_PLUGIN_STATE_DIRECTORY)) {
+		return -1;
+	}
+
+	if (snprintf(buffer, size, "%s/%s", directory_buffer, name) >= (int) size) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Trace file name \"%s\" is too long", name);
+		return -1;
+	}
+
+	if (mkdir(directory_buffer, 0755) != 0 && errno != EEXIST) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "mkdir() failed (%d) for %s", errno, directory_buffer);
+		return -1;
+	}
+
+	return 0;
+}
+
+int system_trace_dump(const char *path)
+{
+	int error = 0;
+	FILE *file = NULL;
+	struct system_trace_ring *rings = NULL;
+	struct system_trace_span *copy = NULL;
+	bool first = true;
+	const long pid = (long) getpid();
+	char default_path_buffer[PATH_MAX] = {0};
+	int fd = -1;
+
+	if (!path) {
+		if (system_trace_path(default_path_buffer, sizeof(default_path_buffer), SYSTEM_TRACE_DEFAULT_NAME)) {
+			goto error_out;
+		}
+		path = default_path_buffer;
+	}
+
+	// a previous dump is replaced by a new file - nothing existing is written through, the spans stay with root
+	if (unlink(path) != 0 && errno != ENOENT) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "unlink() failed (%d) for %s", errno, path);
+		goto error_out;
+	}
+
+	fd = open(path, O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0600);
+	if (fd == -1) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "open() failed (%d) for %s", errno, path);
+		goto error_out;
+	}
+
+	file = fdopen(fd, "w");
+	if (!file) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "fdopen() failed (%d) for %s", errno, path);
+		close(fd);
+		goto error_out;
+	}
+
+	copy = (struct system_trace_span *) malloc(sizeof(struct system_trace_span) * SYSTEM_TRACE_RING_SIZE);
+	if (!copy) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to dump trace into %s", path);
+		goto error_out;
+	}
+
+	pthread_mutex_lock(&system_trace_rings_lock);
+	rings = system_trace_rings;
+	pthread_mutex_unlock(&system_trace_rings_lock);
+
+	fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", file);
+
+	// rings are only ever prepended - the list read above stays valid without the lock
+	for (struct system_trace_ring *ring = rings; ring; ring = ring->next) {
+		const uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+		const uint64_t begin = head > SYSTEM_TRACE_RING_SIZE ? head - SYSTEM_TRACE_RING_SIZE : 0;
+		uint64_t valid = 0;
+
+		for (uint64_t i = begin; i < head; i++) {
+			copy[i - begin] = ring->spans[i % SYSTEM_TRACE_RING_SIZE];
+		}
+
+		// the slot of span i is reused by span i + SYSTEM_TRACE_RING_SIZE - skip the spans overwritten during the copy
+		valid = atomic_load_explicit(&ring->head, memory_order_acquire);
+		valid = valid >= SYSTEM_TRACE_RING_SIZE ? valid - SYSTEM_TRACE_RING_SIZE + 1 : 0;
+
+		for (uint64_t i = begin > valid ? begin : valid; i < head; i++) {
+			const struct system_trace_span *span = &copy[i - begin];
+
+			fprintf(file, "%s\n{\"ph\":\"X\",\"pid\":%ld,\"tid\":%ld,\"ts\":%" PRId64 ".%03" PRId64 ",\"dur\":%" PRId64 ".%03" PRId64 ",\"name\":", first ? "" : ",", pid, ring->tid, span->start / 1000, span->start % 1000, span->duration / 1000, span->duration % 1000);
+			system_trace_print_string(file, span->name);
+			fprintf(file, ",\"args\":{\"request_id\":%" PRIu32, span->request_id);
+			if (span->detail[0]) {
+				fputs(",\"detail\":", file);
+				system_trace_print_string(file, span->detail);
+			}
+			fputs("}}", file);
+			first = false;
+		}
+	}
+
+	fputs("\n]}\n", file);
+
+	if (ferror(file)) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to write trace into %s", path);
+		goto error_out;
+	}
+
+	SYSTEM_LOG_INF("Trace dumped into %s", path);
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	if (file && fclose(file) != 0) {
+		error = -1;
+	}
+
+	free(copy);
+
+	return error;
+}
+
+static int64_t system_trace_now_ns(void)
+{
+	struct timespec ts = {0};
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (int64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static struct system_trace_ring *system_trace_get_ring(void)
+{
+	struct system_trace_ring *ring = system_trace_thread_ring;
+
+	if (ring) {
+		return ring;
+	}
+
+	ring = (struct system_trace_ring *) calloc(1, sizeof(struct system_trace_ring));
+	if (!ring) {
+		return NULL;
+	}
+
+	ring->tid = syscall(SYS_gettid);
+
+	pthread_mutex_lock(&system_trace_rings_lock);
+	ring->next = system_trace_rings;
+	system_trace_rings = ring;
+	pthread_mutex_unlock(&system_trace_rings_lock);
+
+	system_trace_thread_ring = ring;
+
+	return ring;
+}
+
+static void system_trace_print_string(FILE *file, const char *value)
+{
+	fputc('"', file);
+
+	for (const char *iter = value; *iter; iter++) {
+		if (*iter == '"' || *iter == '\\') {
+			fputc('\\', file);
+			fputc(*iter, file);
+		} else if ((unsigned char) *iter < 0x20) {
+			fprintf(file, "\\u%04x", (unsigned int) (unsigned char) *iter);
+		} else {
+			fputc(*iter, file);
+		}
+	}
+
+	fputc('"', file);
+}
@@ -0,0 +1,42 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_TRACE_H
+#define SYSTEM_PLUGIN_TRACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Span tracing of callbacks, system API calls and the sysrepo, sd-bus and umgmt calls made by them. Spans are kept in
+ * a fixed-size ring buffer per thread and dumped as Chrome trace JSON, which Perfetto and chrome://tracing load. When
+ * tracing is disabled, system_trace_begin() is a single atomic load and nothing is recorded.
+ */
+void system_trace_init(void);
+void system_trace_set_enabled(bool enabled);
+bool system_trace_enabled(void);
+void system_trace_set_request(uint32_t request_id);
+
+int64_t system_trace_begin(void);
+void system_trace_end(const char *name, const char *detail, int64_t start);
+void system_trace_record(const char *name, const char *detail, int64_t start, int64_t end);
+
+/**
+ * Write the recorded spans into path - SYSTEM_TRACE_DEFAULT_FILE when NULL. The file is created anew with mode 0600,
+ * an existing one is replaced. Names received from clients are turned into a path under the plugin state directory
+ * by system_trace_path(), which refuses anything but a plain file name and creates the directory.
+ */
+int system_trace_path(char *buffer, size_t size, const char *name);
+int system_trace_dump(const char *path);
+
+#endif // SYSTEM_PLUGIN_TRACE_H
@@ -0,0 +1,26 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "transaction.h"
+#include "core/data/system/authentication/local_user/change.h"
+#include "core/data/system/dns_resolver/search/list.h"
+#include "core/data/system/dns_resolver/server/list.h"
+#include "core/data/system/ntp/server/list.h"
+
+void system_transaction_cleanup(system_transaction_t *txn)
+{
+	system_dns_search_list_free(&txn->dns_search);
+	system_dns_server_list_free(&txn->dns_servers);
+	system_ntp_server_list_free(&txn->ntp_servers);
+
+	system_local_user_change_map_free(&txn->user_changes);
+}
@@ -0,0 +1,25 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_TRANSACTION_H
+#define SYSTEM_PLUGIN_TRANSACTION_H
+
+#include "core/context.h"
+
+/**
+ * Change callbacks which collect temporary lists during changes iteration keep them in a transaction on their own stack
+ * instead of the plugin context. Callbacks of different subsystems can then run in parallel - each one only touches the
+ * lists of its own transaction. The same holds for startup reconciliation.
+ */
+void system_transaction_cleanup(system_transaction_t *txn);
+
+#endif // SYSTEM_PLUGIN_TRANSACTION_H
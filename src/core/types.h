@@ -13,6 +13,13 @@
 #ifndef SYSTEM_PLUGIN_TYPES_H
 #define SYSTEM_PLUGIN_TYPES_H
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <uthash.h>
+
 // DNS
 
 typedef struct system_ntp_server_s system_ntp_server_t;
@@ -27,6 +34,151 @@ typedef struct system_local_user_s system_local_user_t;
 typedef struct system_local_user_element_s system_local_user_element_t;
 typedef struct system_authorized_key_s system_authorized_key_t;
 typedef struct system_authorized_key_element_s system_authorized_key_element_t;
+typedef struct system_local_user_change_s system_local_user_change_t;
+typedef struct system_id_allocator_s system_id_allocator_t;
+
+// SSH
+
+typedef struct system_ssh_key_index_header_s system_ssh_key_index_header_t;
+typedef struct system_ssh_key_index_entry_s system_ssh_key_index_entry_t;
+typedef struct system_ssh_key_index_s system_ssh_key_index_t;
+typedef struct system_ssh_key_line_s system_ssh_key_line_t;
+
+// plugin
+
+typedef struct system_watcher_s system_watcher_t;
+
+// parts of the system configuration which are loaded and stored independently
+enum system_subsystem_e {
+	SYSTEM_SUBSYSTEM_HOSTNAME = 0,
+	SYSTEM_SUBSYSTEM_CLOCK,
+	SYSTEM_SUBSYSTEM_NTP,
+	SYSTEM_SUBSYSTEM_DNS_RESOLVER,
+	SYSTEM_SUBSYSTEM_AUTHENTICATION,
+	SYSTEM_SUBSYSTEM_COUNT,
+};
+
+typedef enum system_subsystem_e system_subsystem_t;
+
+// drift detection
+typedef struct system_drift_schedule_s system_drift_schedule_t;
+
+// subscriptions served by the same sysrepo subscription context - each context has its own handler thread
+enum system_subscription_group_e {
+	SYSTEM_SUBSCRIPTION_GROUP_BASICS = 0,
+	SYSTEM_SUBSCRIPTION_GROUP_NTP,
+	SYSTEM_SUBSCRIPTION_GROUP_DNS_RESOLVER,
+	SYSTEM_SUBSCRIPTION_GROUP_AUTHENTICATION,
+	SYSTEM_SUBSCRIPTION_GROUP_OPERATIONAL,
+	SYSTEM_SUBSCRIPTION_GROUP_RPC,
+	SYSTEM_SUBSCRIPTION_GROUP_COUNT,
+};
+
+typedef enum system_subscription_group_e system_subscription_group_t;
+
+// instrumented callbacks and system API calls
+enum system_stats_op_e {
+	SYSTEM_STATS_OP_CHANGE_CONTACT = 0,
+	SYSTEM_STATS_OP_CHANGE_HOSTNAME,
+	SYSTEM_STATS_OP_CHANGE_LOCATION,
+	SYSTEM_STATS_OP_CHANGE_TIMEZONE_NAME,
+	SYSTEM_STATS_OP_CHANGE_TIMEZONE_UTC_OFFSET,
+	SYSTEM_STATS_OP_CHANGE_NTP_ENABLED,
+	SYSTEM_STATS_OP_CHANGE_NTP_SERVER,
+	SYSTEM_STATS_OP_CHANGE_DNS_RESOLVER_SEARCH,
+	SYSTEM_STATS_OP_CHANGE_DNS_RESOLVER_SERVER,
+	SYSTEM_STATS_OP_CHANGE_DNS_RESOLVER_TIMEOUT,
+	SYSTEM_STATS_OP_CHANGE_DNS_RESOLVER_ATTEMPTS,
+	SYSTEM_STATS_OP_CHANGE_AUTHENTICATION_ORDER,
+	SYSTEM_STATS_OP_CHANGE_AUTHENTICATION_USER,
+	SYSTEM_STATS_OP_UPDATE_AUTHENTICATION_PASSWORD,
+	SYSTEM_STATS_OP_OPERATIONAL_PLATFORM,
+	SYSTEM_STATS_OP_OPERATIONAL_CLOCK,
+	SYSTEM_STATS_OP_RPC_SET_CURRENT_DATETIME,
+	SYSTEM_STATS_OP_RPC_RESTART,
+	SYSTEM_STATS_OP_RPC_SHUTDOWN,
+	SYSTEM_STATS_OP_LOAD_HOSTNAME,
+	SYSTEM_STATS_OP_LOAD_TIMEZONE_NAME,
+	SYSTEM_STATS_OP_LOAD_NTP_SERVER,
+	SYSTEM_STATS_OP_LOAD_DNS_RESOLVER_SEARCH,
+	SYSTEM_STATS_OP_LOAD_DNS_RESOLVER_SERVER,
+	SYSTEM_STATS_OP_LOAD_AUTHENTICATION_USER,
+	SYSTEM_STATS_OP_LOAD_AUTHORIZED_KEY,
+	SYSTEM_STATS_OP_CHECK_HOSTNAME,
+	SYSTEM_STATS_OP_CHECK_TIMEZONE_NAME,
+	SYSTEM_STATS_OP_CHECK_NTP_SERVER,
+	SYSTEM_STATS_OP_CHECK_DNS_RESOLVER_SEARCH,
+	SYSTEM_STATS_OP_CHECK_DNS_RESOLVER_SERVER,
+	SYSTEM_STATS_OP_CHECK_AUTHENTICATION_USER,
+	SYSTEM_STATS_OP_CHECK_AUTHORIZED_KEY,
+	SYSTEM_STATS_OP_STORE_HOSTNAME,
+	SYSTEM_STATS_OP_STORE_TIMEZONE_NAME,
+	SYSTEM_STATS_OP_STORE_NTP_SERVER,
+	SYSTEM_STATS_OP_STORE_DNS_RESOLVER_SEARCH,
+	SYSTEM_STATS_OP_STORE_DNS_RESOLVER_SERVER,
+	SYSTEM_STATS_OP_STORE_AUTHENTICATION_USER,
+	SYSTEM_STATS_OP_STORE_AUTHORIZED_KEY,
+	SYSTEM_STATS_OP_COMMIT_AUTHENTICATION_DATABASE,
+	SYSTEM_STATS_OP_COUNT,
+};
+
+typedef enum system_stats_op_e system_stats_op_t;
+typedef struct system_stats_scope_s system_stats_scope_t;
+typedef struct system_stats_summary_s system_stats_summary_t;
+
+// logging
+typedef struct system_log_ratelimit_s system_log_ratelimit_t;
+
+// password hashing
+typedef struct system_password_job_s system_password_job_t;
+typedef struct system_password_batch_s system_password_batch_t;
+
+// system state snapshot
+typedef struct system_snapshot_sources_s system_snapshot_sources_t;
+
+// batched filesystem operations
+enum system_fs_op_type_e {
+	SYSTEM_FS_OP_MKDIR,
+	SYSTEM_FS_OP_WRITE,
+	SYSTEM_FS_OP_UNLINK,
+	SYSTEM_FS_OP_REMOVE, ///< The path and everything below it, without following symlinks.
+};
+
+// system calls an operation is made of - executed one after another for each chain
+enum system_fs_step_e {
+	SYSTEM_FS_STEP_DIR,
+	SYSTEM_FS_STEP_MKDIR,
+	SYSTEM_FS_STEP_CHOWN,
+	SYSTEM_FS_STEP_REPAIR,
+	SYSTEM_FS_STEP_OPEN,
+	SYSTEM_FS_STEP_WRITE,
+	SYSTEM_FS_STEP_ATTRIBUTES,
+	SYSTEM_FS_STEP_FSYNC,
+	SYSTEM_FS_STEP_CLOSE,
+	SYSTEM_FS_STEP_RENAME,
+	SYSTEM_FS_STEP_UNLINK,
+	SYSTEM_FS_STEP_REMOVE,
+	SYSTEM_FS_STEP_DONE,
+};
+
+typedef enum system_fs_op_type_e system_fs_op_type_t;
+typedef enum system_fs_step_e system_fs_step_t;
+typedef struct system_fs_op_s system_fs_op_t;
+typedef struct system_fs_chain_s system_fs_chain_t;
+typedef struct system_fs_batch_s system_fs_batch_t;
+
+// intent journal
+typedef struct system_journal_s system_journal_t;
+
+// subsystem backends
+typedef struct system_hostname_backend_s system_hostname_backend_t;
+typedef struct system_dns_resolver_backend_s system_dns_resolver_backend_t;
+typedef struct system_ntp_backend_s system_ntp_backend_t;
+typedef struct system_accounts_backend_s system_accounts_backend_t;
+
+// plugin context and account transaction - defined by core/context.h and the accounts backend
+typedef struct system_ctx_s system_ctx_t;
+typedef struct system_authentication_txn_s system_authentication_txn_t;
 
 union system_ip_address_value_u {
 	unsigned char v4[4];
@@ -34,12 +186,8 @@ union system_ip_address_value_u {
 };
 
 struct system_ip_address_s {
-#ifdef SYSTEMD
 	int family;
 	system_ip_address_value_t value;
-#else
-	const char *value;
-#endif
 };
 
 struct system_ntp_server_s {
@@ -81,6 +229,7 @@ struct system_dns_server_element_s {
 struct system_local_user_s {
 	char *name;
 	char *password;
+	char *home;
 	system_authorized_key_element_t *key_head;
 };
 
@@ -93,6 +242,9 @@ struct system_authorized_key_s {
 	char *name;
 	char *algorithm;
 	char *data;
+	char *options;				///< sshd options preceding the key in authorized_keys - not in the YANG model, kept from the file.
+	uint8_t fingerprint[32];	///< SHA256 of the decoded key blob - set together with data.
+	char blob_algorithm[64];	///< Algorithm name embedded in the key blob.
 };
 
 struct system_authorized_key_element_s {
@@ -100,4 +252,202 @@ struct system_authorized_key_element_s {
 	system_authorized_key_element_t *next;
 };
 
+// everything a change does to one user - collected in a single walk of the changes, keyed by the user name
+struct system_local_user_change_s {
+	system_local_user_t user; ///< Name, new password and - once merged - the keys of the user after the change.
+	bool created;
+	bool deleted;
+	bool password_changed;				///< user.password holds the new value - NULL if the leaf was deleted.
+	system_authorized_key_element_t *keys_created;	///< Keys added by the change.
+	system_authorized_key_element_t *keys_modified; ///< Existing keys - only the changed algorithm and key-data are set.
+	system_authorized_key_element_t *keys_deleted;	///< Only the key names are set.
+	UT_hash_handle hh;
+};
+
+// authentication helpers
+
+struct system_id_allocator_s {
+	uint64_t *bitmap; ///< One bit per ID in the [min, max] range - a set bit marks a used ID.
+	uint32_t min;
+	uint32_t max;
+	uint64_t next; ///< ID from which the search for the next free ID starts - max + 1 once the top of the range is used.
+};
+
+// SSH
+
+struct system_ssh_key_index_header_s {
+	char magic[8];
+	uint32_t bucket_count; ///< Power of two - the table is at most half full.
+	uint32_t key_count;
+	uint32_t lines_size; ///< Size of the authorized_keys lines area which follows the bucket table.
+	uint32_t reserved;
+};
+
+struct system_ssh_key_index_entry_s {
+	uint8_t fingerprint[32]; ///< SHA256 of the decoded key blob.
+	uint32_t offset;	 ///< Line offset in the lines area.
+	uint32_t length;	 ///< Line length - 0 marks an empty bucket.
+};
+
+struct system_ssh_key_index_s {
+	void *map;
+	size_t map_size;
+	const system_ssh_key_index_header_t *header;
+	const system_ssh_key_index_entry_t *buckets;
+	const char *lines;
+};
+
+struct system_ssh_key_line_s {
+	uint8_t fingerprint[32];
+	const char *line;
+	size_t length;
+};
+
+// stats
+
+struct system_stats_scope_s {
+	int64_t start;	     ///< Monotonic time (ns) at which the operation started.
+	system_stats_op_t op;
+	int previous;	     ///< Operation running on this thread before this one started - -1 if none.
+};
+
+struct system_stats_summary_s {
+	uint64_t calls;
+	uint64_t errors;
+	uint64_t bytes_written;
+	uint64_t forks;
+	uint64_t total_us;
+	uint64_t max_us;
+	uint64_t p50_us; ///< Percentiles are upper bounds of the histogram buckets - within 12.5% of the real value.
+	uint64_t p90_us;
+	uint64_t p99_us;
+};
+
+// logging
+
+struct system_log_ratelimit_s {
+	_Atomic int64_t window_start; ///< Monotonic time (ms) at which the current window of the call site started.
+	_Atomic uint32_t count;	      ///< Messages of the call site in the current window.
+	_Atomic uint32_t suppressed;  ///< Messages dropped in the current window - reported when the next one starts.
+};
+
+// password hashing
+
+struct system_password_job_s {
+	char *xpath;	 ///< Path of the password leaf in the edit.
+	char *cleartext; ///< Value after the "$0$" prefix - cleared before it is freed.
+	char *hash;	 ///< SHA-512-crypt hash of the value.
+	int error;
+};
+
+struct system_password_batch_s {
+	system_password_job_t *jobs;
+	size_t count;
+	size_t capacity;
+	_Atomic size_t next; ///< Next job to be taken by a hashing thread.
+};
+
+// system state snapshot
+
+struct system_snapshot_sources_s {
+	char *data[SYSTEM_SUBSYSTEM_COUNT]; ///< Validators of the files the subsystem is loaded from, one line per file - NULL for subsystems which are always loaded.
+	size_t length[SYSTEM_SUBSYSTEM_COUNT];
+};
+
+// drift detection
+
+struct system_drift_schedule_s {
+	uint32_t pending;					 ///< Bitmask of subsystems waiting for a reload.
+	int64_t due[SYSTEM_SUBSYSTEM_COUNT]; ///< Monotonic time (ms) of the reload of a pending subsystem.
+};
+
+// batched filesystem operations
+
+struct system_fs_op_s {
+	system_fs_op_type_t type;
+	char *path;
+	void *data; ///< WRITE: content of the file.
+	size_t size;
+	char *source; ///< WRITE: file the content was read from - journaled instead of the content and read again on replay.
+	mode_t mode;
+	uid_t uid; ///< Owner of created directories and written files - (uid_t) -1 keeps the one of the plugin.
+	gid_t gid;
+	bool exclusive; ///< MKDIR: fail when the directory exists - otherwise it is kept as it is, owner included.
+	bool atomic;	///< WRITE: written into a temporary file which is synced and renamed over the path.
+	bool repair;	///< MKDIR: created before an interruption - when it exists and belongs to the plugin or the owner, it gets owner and mode again.
+	uint8_t owned;	///< Trailing directories of the path owned by uid - opened one by one without following symlinks.
+};
+
+struct system_fs_chain_s {
+	system_fs_op_t *ops; ///< Executed in order - the operations after a failed one are not executed.
+	size_t count;
+	size_t capacity;
+	size_t current;
+	system_fs_step_t step;
+	int fd;
+	int dir_fd; ///< Last owned directory of the current operation, AT_FDCWD without one.
+	size_t written;
+	char *temp_path;
+	int error; ///< errno of the failed operation.
+	bool finished; ///< Already reported to the observer of the batch.
+	char *account; ///< User whose account the chain completes - NULL for chains of existing accounts.
+	bool account_deleted; ///< The chain removes what the deleted account left, instead of setting up a created one.
+};
+
+struct system_fs_batch_s {
+	system_fs_chain_t *chains; ///< Independent of each other - executed concurrently.
+	size_t count;
+	size_t capacity;
+	_Atomic size_t next; ///< Next chain to be taken by a worker thread.
+	void (*chain_done)(void *arg, size_t chain); ///< Called once for every chain finished without an error, from the thread which ran it.
+	void (*dir_created)(void *arg, size_t chain, size_t op); ///< Called for every directory a MKDIR operation created, before its owner is set.
+	void *chain_done_arg; ///< Argument of both callbacks.
+};
+
+// intent journal
+
+struct system_journal_s {
+	int fd;	     ///< Open and locked between begin and end, -1 otherwise.
+	uint64_t id; ///< Batch the records are written for.
+};
+
+// subsystem backends
+
+struct system_hostname_backend_s {
+	const char *name;
+	bool (*probe)(void); ///< Usable on this system - NULL for the fallback.
+	int (*load)(char *buffer, size_t size);
+	int (*store)(const char *hostname);
+};
+
+struct system_dns_resolver_backend_s {
+	const char *name;
+	const char *source_file; ///< File the values are loaded from - validates the snapshot.
+	bool source_rooted;	 ///< Source file is resolved under the system root.
+	bool (*probe)(void);	 ///< Usable on this system - NULL for the fallback.
+	int (*load_search)(system_dns_search_element_t **head);
+	int (*load_server)(system_dns_server_element_t **head);
+	int (*store_search)(system_dns_search_element_t *head);
+	int (*store_server)(system_dns_server_element_t *head);
+};
+
+struct system_ntp_backend_s {
+	const char *name;
+	bool (*probe)(void); ///< Usable on this system - NULL for the fallback.
+	int (*load_server)(system_ctx_t *ctx, system_ntp_server_element_t **head);
+	int (*store_server)(system_ctx_t *ctx, system_ntp_server_element_t *head);
+};
+
+struct system_accounts_backend_s {
+	const char *name;
+	bool (*probe)(void); ///< Usable on this system - NULL for the fallback.
+	int (*load_users)(system_local_user_element_t **head);
+	int (*begin)(system_authentication_txn_t *txn); ///< Changes are collected in the transaction and written on commit.
+	int (*add_user)(system_authentication_txn_t *txn, const char *username, const char *password);
+	int (*set_password)(system_authentication_txn_t *txn, const char *username, const char *password);
+	int (*delete_user)(system_authentication_txn_t *txn, const char *username);
+	int (*commit)(system_authentication_txn_t *txn);
+	void (*free)(system_authentication_txn_t *txn);
+};
+
 #endif // SYSTEM_PLUGIN_TYPES_H
\ No newline at end of file
@@ -10,28 +10,101 @@
  *
  * SPDX-License-Identifier: BSD-3-Clause
  */
-#include <sysrepo.h>
-#include <signal.h>
-#include <unistd.h>
+#include "core/common.h"
+#include "core/loop.h"
+#include "core/record.h"
+#include "core/root.h"
+
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
-volatile int exit_application = 0;
+#include <sysrepo.h>
 
 // extern needed data to build the plugin executable
-extern const char *PLUGIN_NAME;
 extern int sr_plugin_init_cb(sr_session_ctx_t *session, void **private_data);
 extern void sr_plugin_cleanup_cb(sr_session_ctx_t *session, void *private_data);
 
-static void sigint_handler(__attribute__((unused)) int signum);
+static void usage(const char *name)
+{
+	fprintf(stderr, "Usage: %s [--root DIR] [--record FILE [--record-format xml|lyb]] [--replay [--replay-speed FACTOR] FILE...]\n", name);
+}
 
-int main(void)
+int main(int argc, char **argv)
 {
 	int error = SR_ERR_OK;
 	sr_conn_ctx_t *connection = NULL;
 	sr_session_ctx_t *session = NULL;
 	void *private_data = NULL;
+	const char *record = NULL;
+	LYD_FORMAT record_format = LYD_LYB;
+	bool replay = false;
+	double replay_speed = 1.0;
+	int opt = 0;
+	const struct option long_options[] = {
+		{"root", required_argument, NULL, 'R'},
+		{"record", required_argument, NULL, 'r'},
+		{"record-format", required_argument, NULL, 'f'},
+		{"replay", no_argument, NULL, 'p'},
+		{"replay-speed", required_argument, NULL, 's'},
+		{NULL, 0, NULL, 0},
+	};
+
+	while ((opt = getopt_long(argc, argv, "R:r:f:ps:", long_options, NULL)) != -1) {
+		switch (opt) {
+			case 'R':
+				// the plugin resolves its root from the environment when it is initialized
+				setenv(SYSTEM_ROOT_ENV, optarg, 1);
+				break;
+			case 'r':
+				record = optarg;
+				break;
+			case 'f':
+				if (!strcmp(optarg, "xml")) {
+					record_format = LYD_XML;
+				} else if (!strcmp(optarg, "lyb")) {
+					record_format = LYD_LYB;
+				} else {
+					usage(argv[0]);
+					return -1;
+				}
+				break;
+			case 'p':
+				replay = true;
+				break;
+			case 's':
+				// 0 - as fast as possible
+				replay_speed = strtod(optarg, NULL);
+				break;
+			default:
+				usage(argv[0]);
+				return -1;
+		}
+	}
+
+	if (replay != (optind < argc) || replay_speed < 0) {
+		usage(argv[0]);
+		return -1;
+	}
 
 	sr_log_stderr(SR_LL_INF);
 
+	// replayed changes are applied to the system files - never those of the live system
+	system_root_init();
+	if (replay && !system_root_active()) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Replay needs a sandbox root - set it with --root or %s", SYSTEM_ROOT_ENV);
+		return -1;
+	}
+
+	/* signals and subscription events are handled by the loop - create it before the plugin subscribes */
+	error = system_loop_init();
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_loop_init error");
+		goto out;
+	}
+
 	/* connect to sysrepo */
 	error = sr_connect(SR_CONN_DEFAULT, &connection);
 	if (error) {
@@ -51,22 +124,38 @@ int main(void)
 		goto out;
 	}
 
-	/* loop until ctrl-c is pressed / SIGINT is received */
-	signal(SIGINT, sigint_handler);
-	signal(SIGPIPE, SIG_IGN);
-	while (!exit_application) {
-		sleep(1);
+	/* the plugin is subscribed - from here on the recorder sees the same changes as the plugin callbacks */
+	if (record) {
+		error = system_record_start(session, record, record_format);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_record_start error");
+			goto out;
+		}
+	}
+
+	/* the replay stops the loop once all files are applied */
+	if (replay) {
+		error = system_replay_start(connection, argv + optind, (size_t) (argc - optind), replay_speed);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "system_replay_start error");
+			goto out;
+		}
+	}
+
+	/* loop until ctrl-c is pressed / SIGINT or SIGTERM is received */
+	error = system_loop_run();
+
+	if (system_replay_finish()) {
+		error = -1;
 	}
 
 out:
-	sr_plugin_cleanup_cb(session, private_data);
+	system_record_stop();
+	if (private_data) {
+		sr_plugin_cleanup_cb(session, private_data);
+	}
 	sr_disconnect(connection);
+	system_loop_free();
 
 	return error ? -1 : 0;
 }
-
-static void sigint_handler(__attribute__((unused)) int signum)
-{
-	SRPLG_LOG_INF(PLUGIN_NAME, "Sigint called, exiting...");
-	exit_application = 1;
-}
@@ -8,6 +8,7 @@
 
 // core library
 #include "core/ly_tree.h"
+#include "core/log.h"
 #include "core/api/system/load.h"
 #include "core/api/system/ntp/load.h"
 #include "core/data/system/ntp/server/list.h"
@@ -131,7 +132,7 @@ static int system_aug_running_load_ntp(void *priv, sr_session_ctx_t *session, co
 	// load list
 	system_ntp_server_element_t *ntp_server_head = NULL, *ntp_server_iter = NULL;
 
-	SRPLG_LOG_INF(PLUGIN_NAME, "Loading NTP data");
+	SYSTEM_LOG_INF("Loading NTP data");
 
 	if (ntp_enabled) {
 		error = system_ly_tree_create_ntp(ly_ctx, parent_node, &ntp_container_node);
@@ -157,7 +158,7 @@ static int system_aug_running_load_ntp(void *priv, sr_session_ctx_t *session, co
 				goto error_out;
 			}
 
-			SRPLG_LOG_INF(PLUGIN_NAME, "Setting address %s", ntp_server_iter->server.address);
+			SYSTEM_LOG_INF("Setting address %s", ntp_server_iter->server.address);
 
 			// address
 			error = system_ly_tree_create_ntp_server_address(ly_ctx, server_list_node, ntp_server_iter->server.address);
@@ -166,7 +167,7 @@ static int system_aug_running_load_ntp(void *priv, sr_session_ctx_t *session, co
 				goto error_out;
 			}
 
-			SRPLG_LOG_INF(PLUGIN_NAME, "Setting port \"%s\"", ntp_server_iter->server.port);
+			SYSTEM_LOG_INF("Setting port \"%s\"", ntp_server_iter->server.port);
 
 			// port
 			if (ntp_server_iter->server.port && ntp_udp_port_enabled) {
@@ -6,6 +6,7 @@
 
 // core library
 #include "core/ly_tree.h"
+#include "core/log.h"
 #include "core/api/system/ntp/store.h"
 #include "core/api/system/ntp/check.h"
 #include "core/api/system/store.h"
@@ -77,7 +78,7 @@ static int system_aug_running_store_hostname(void *priv, const struct lyd_node *
 	if (hostname_node) {
 		const char *hostname = lyd_get_value(hostname_node);
 
-		SRPLG_LOG_INF(PLUGIN_NAME, "Checking system hostname value");
+		SYSTEM_LOG_INF("Checking system hostname value");
 		check_status = system_check_hostname(ctx, hostname);
 
 		switch (check_status) {
@@ -90,7 +91,7 @@ static int system_aug_running_store_hostname(void *priv, const struct lyd_node *
 				goto error_out;
 				break;
 			case srpc_check_status_non_existant:
-				SRPLG_LOG_INF(PLUGIN_NAME, "Storing hostname value %s", hostname);
+				SYSTEM_LOG_INF("Storing hostname value %s", hostname);
 
 				error = system_store_hostname(ctx, hostname);
 				if (error) {
@@ -142,7 +143,7 @@ static int system_aug_running_store_ntp(void *priv, const struct lyd_node *syste
 	srpc_check_status_t server_check_status = srpc_check_status_none;
 
 	if (ntp_enabled) {
-		SRPLG_LOG_INF(PLUGIN_NAME, "Storing NTP startup data");
+		SYSTEM_LOG_INF("Storing NTP startup data");
 
 		ntp_container_node = srpc_ly_tree_get_child_container(system_container_node, "ntp");
 		if (ntp_container_node) {
@@ -183,7 +184,7 @@ static int system_aug_running_store_ntp(void *priv, const struct lyd_node *syste
 						}
 					} else {
 						// no address node -> unable to continue
-						SRPLG_LOG_INF(PLUGIN_NAME, "srpc_ly_tree_get_child_leaf() failed for leaf address");
+						SYSTEM_LOG_INF("srpc_ly_tree_get_child_leaf() failed for leaf address");
 						goto error_out;
 					}
 
@@ -197,7 +198,7 @@ static int system_aug_running_store_ntp(void *priv, const struct lyd_node *syste
 							// set port
 							error = system_ntp_server_set_port(&temp_server, port);
 							if (error) {
-								SRPLG_LOG_INF(PLUGIN_NAME, "system_ntp_server_set_port() error (%d)", error);
+								SYSTEM_LOG_INF("system_ntp_server_set_port() error (%d)", error);
 								goto error_out;
 							}
 						}
@@ -243,7 +244,7 @@ static int system_aug_running_store_ntp(void *priv, const struct lyd_node *syste
 					// append to the list
 					error = system_ntp_server_list_add(&ntp_server_head, temp_server);
 					if (error) {
-						SRPLG_LOG_INF(PLUGIN_NAME, "system_ntp_server_list_add() error (%d)", error);
+						SYSTEM_LOG_INF("system_ntp_server_list_add() error (%d)", error);
 						goto error_out;
 					}
 
@@ -254,11 +255,11 @@ static int system_aug_running_store_ntp(void *priv, const struct lyd_node *syste
 				}
 			}
 
-			SRPLG_LOG_INF(PLUGIN_NAME, "Checking NTP server list status on the system");
+			SYSTEM_LOG_INF("Checking NTP server list status on the system");
 
 			server_check_status = system_ntp_check_server(ctx, ntp_server_head);
 
-			SRPLG_LOG_INF(PLUGIN_NAME, "Recieved check status: %d", server_check_status);
+			SYSTEM_LOG_INF("Recieved check status: %d", server_check_status);
 
 			switch (server_check_status) {
 				case srpc_check_status_none:
@@ -270,7 +271,7 @@ static int system_aug_running_store_ntp(void *priv, const struct lyd_node *syste
 					goto error_out;
 					break;
 				case srpc_check_status_non_existant:
-					SRPLG_LOG_INF(PLUGIN_NAME, "NTP server list values don\'t exist on the system - applying values");
+					SYSTEM_LOG_INF("NTP server list values don\'t exist on the system - applying values");
 
 					error = system_ntp_store_server(ctx, ntp_server_head);
 					if (error) {
@@ -278,10 +279,10 @@ static int system_aug_running_store_ntp(void *priv, const struct lyd_node *syste
 						goto error_out;
 					}
 
-					SRPLG_LOG_INF(PLUGIN_NAME, "Applied NTP server startup values to the system");
+					SYSTEM_LOG_INF("Applied NTP server startup values to the system");
 					break;
 				case srpc_check_status_equal:
-					SRPLG_LOG_INF(PLUGIN_NAME, "NTP server startup values already exist on the system - no need to apply anything");
+					SYSTEM_LOG_INF("NTP server startup values already exist on the system - no need to apply anything");
 					break;
 				case srpc_check_status_partial:
 					// TODO: implement
@@ -289,7 +290,7 @@ static int system_aug_running_store_ntp(void *priv, const struct lyd_node *syste
 			}
 		}
 	} else {
-		SRPLG_LOG_INF(PLUGIN_NAME, "\"ntp\" feature disabled - skipping NTP startup configuration");
+		SYSTEM_LOG_INF("\"ntp\" feature disabled - skipping NTP startup configuration");
 	}
 
 	goto out;
@@ -12,7 +12,11 @@
  */
 #include "plugin.h"
 #include "core/common.h"
+#include "core/log.h"
 #include "core/context.h"
+#include "core/loop.h"
+#include "core/root.h"
+#include "core/trace.h"
 
 // stdlib
 #include <stdbool.h>
@@ -47,7 +51,6 @@ int sr_plugin_init_cb(sr_session_ctx_t *running_session, void **private_data)
 	// sysrepo
 	sr_session_ctx_t *startup_session = NULL;
 	sr_conn_ctx_t *connection = NULL;
-	sr_subscription_ctx_t *subscription = NULL;
 
 	// plugin
 	system_ctx_t *ctx = NULL;
@@ -56,6 +59,14 @@ int sr_plugin_init_cb(sr_session_ctx_t *running_session, void **private_data)
 	ctx = malloc(sizeof(*ctx));
 	*ctx = (system_ctx_t){0};
 
+	// callbacks may run concurrently - guard the shared state
+	pthread_mutex_init(&ctx->startup_lock, NULL);
+	pthread_rwlock_init(&ctx->features_lock, NULL);
+
+	// the system files root and tracing are taken from the environment before any callback runs
+	system_root_init();
+	system_trace_init();
+
 	*private_data = ctx;
 
 	// module changes
@@ -91,12 +102,12 @@ int sr_plugin_init_cb(sr_session_ctx_t *running_session, void **private_data)
 		"dns-udp-tcp-port",
 	};
 
-	SRPLG_LOG_INF(PLUGIN_NAME, "Checking ietf-system YANG module used features");
+	SYSTEM_LOG_INF("Checking ietf-system YANG module used features");
 
 	for (size_t i = 0; i < ARRAY_SIZE(features); i++) {
 		const char *feature = features[i];
 
-		SRPLG_LOG_INF(PLUGIN_NAME, "ietf-system feature \"%s\" status = %s", feature, srpc_feature_status_hash_check(ctx->ietf_system_features, feature) ? "enabled" : "disabled");
+		SYSTEM_LOG_INF("ietf-system feature \"%s\" status = %s", feature, srpc_feature_status_hash_check(ctx->ietf_system_features, feature) ? "enabled" : "disabled");
 	}
 
 	connection = sr_session_get_connection(running_session);
@@ -115,8 +126,8 @@ int sr_plugin_init_cb(sr_session_ctx_t *running_session, void **private_data)
 	}
 
 	if (empty_startup) {
-		SRPLG_LOG_INF(PLUGIN_NAME, "Running datastore is empty");
-		SRPLG_LOG_INF(PLUGIN_NAME, "Loading initial system data");
+		SYSTEM_LOG_INF("Running datastore is empty");
+		SYSTEM_LOG_INF("Loading initial system data");
 
 		// load data only into running DS - do not use startup unless said explicitly
 		error = system_aug_running_ds_load(ctx, running_session);
@@ -126,8 +137,8 @@ int sr_plugin_init_cb(sr_session_ctx_t *running_session, void **private_data)
 		}
 	} else {
 		// make sure the data from startup DS is stored in the system
-		SRPLG_LOG_INF(PLUGIN_NAME, "Running datastore contains data");
-		SRPLG_LOG_INF(PLUGIN_NAME, "Storing running datastore data in the system");
+		SYSTEM_LOG_INF("Running datastore contains data");
+		SYSTEM_LOG_INF("Storing running datastore data in the system");
 
 		// check and apply if needed data from startup to the system
 		error = system_aug_running_ds_store(ctx, startup_session);
@@ -143,7 +154,7 @@ int sr_plugin_init_cb(sr_session_ctx_t *running_session, void **private_data)
 
 		// in case of work on a specific callback set it to NULL
 		if (change->cb) {
-			error = sr_module_change_subscribe(running_session, BASE_YANG_MODULE, change->path, change->cb, *private_data, 0, SR_SUBSCR_DEFAULT, &subscription);
+			error = sr_module_change_subscribe(running_session, BASE_YANG_MODULE, change->path, change->cb, *private_data, 0, system_loop_subscr_options(), &ctx->subscriptions[SYSTEM_SUBSCRIPTION_GROUP_BASICS]);
 			if (error) {
 				SRPLG_LOG_ERR(PLUGIN_NAME, "sr_module_change_subscribe() error for \"%s\" (%d): %s", change->path, error, sr_strerror(error));
 				goto error_out;
@@ -151,6 +162,12 @@ int sr_plugin_init_cb(sr_session_ctx_t *running_session, void **private_data)
 		}
 	}
 
+	// the standalone executable processes the subscription events in its own loop
+	if (system_loop_active() && system_loop_add_subscription(ctx->subscriptions[SYSTEM_SUBSCRIPTION_GROUP_BASICS])) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to add the subscription to the event loop");
+		goto error_out;
+	}
+
 	goto out;
 
 error_out:
@@ -165,9 +182,18 @@ void sr_plugin_cleanup_cb(sr_session_ctx_t *running_session, void *private_data)
 {
 	system_ctx_t *ctx = (system_ctx_t *) private_data;
 
+	// no callbacks may run while the context is being freed
+	if (ctx->subscriptions[SYSTEM_SUBSCRIPTION_GROUP_BASICS]) {
+		sr_unsubscribe(ctx->subscriptions[SYSTEM_SUBSCRIPTION_GROUP_BASICS]);
+		ctx->subscriptions[SYSTEM_SUBSCRIPTION_GROUP_BASICS] = NULL;
+	}
+
 	if (ctx->ietf_system_features) {
 		srpc_feature_status_hash_free(&ctx->ietf_system_features);
 	}
 
+	pthread_rwlock_destroy(&ctx->features_lock);
+	pthread_mutex_destroy(&ctx->startup_lock);
+
 	free(ctx);
 }
@@ -12,8 +12,11 @@
  */
 #include "load.h"
 #include "core/common.h"
+#include "core/log.h"
 #include "core/context.h"
 #include "core/ly_tree.h"
+#include "core/features.h"
+#include "core/snapshot.h"
 
 // API for getting system data
 #include "srpc/common.h"
@@ -35,6 +38,7 @@
 #include <sysrepo.h>
 #include <unistd.h>
 #include <errno.h>
+#include <string.h>
 
 #include <sysrepo.h>
 
@@ -42,43 +46,32 @@
 
 #include <utlist.h>
 
+static int system_running_load_hostname(void *priv, sr_session_ctx_t *session, const struct ly_ctx *ly_ctx, struct lyd_node *parent_node);
 static int system_running_load_contact(void *priv, sr_session_ctx_t *session, const struct ly_ctx *ly_ctx, struct lyd_node *parent_node);
 static int system_running_load_location(void *priv, sr_session_ctx_t *session, const struct ly_ctx *ly_ctx, struct lyd_node *parent_node);
 static int system_running_load_timezone_name(void *priv, sr_session_ctx_t *session, const struct ly_ctx *ly_ctx, struct lyd_node *parent_node);
 static int system_running_load_dns_resolver(void *priv, sr_session_ctx_t *session, const struct ly_ctx *ly_ctx, struct lyd_node *parent_node);
 static int system_running_load_authentication(void *priv, sr_session_ctx_t *session, const struct ly_ctx *ly_ctx, struct lyd_node *parent_node);
+static int system_running_ds_diff_to_edit(const struct lyd_node *diff, struct lyd_node **edit);
+static int system_running_ds_merge_snapshot(const struct lyd_node *snapshot_node, uint32_t subsystems, struct lyd_node **system_container_node);
 
-int system_running_ds_load(system_ctx_t *ctx, sr_session_ctx_t *session)
+// values of each subsystem kept in the system snapshot
+static const char *const system_running_snapshot_xpaths[SYSTEM_SUBSYSTEM_COUNT] = {
+	[SYSTEM_SUBSYSTEM_CLOCK] = SYSTEM_TIMEZONE_NAME_YANG_PATH,
+	[SYSTEM_SUBSYSTEM_DNS_RESOLVER] = SYSTEM_DNS_RESOLVER_SUBSYSTEM_XPATH,
+	[SYSTEM_SUBSYSTEM_AUTHENTICATION] = SYSTEM_AUTHENTICATION_USER_YANG_PATH,
+};
+
+int system_running_ds_load(system_ctx_t *ctx, sr_session_ctx_t *session, uint32_t subsystems)
 {
 	int error = 0;
 
 	const struct ly_ctx *ly_ctx = NULL;
 	struct lyd_node *system_container_node = NULL;
+	struct lyd_node *diff = NULL, *edit = NULL;
+	sr_data_t *running = NULL;
 	sr_conn_ctx_t *conn_ctx = NULL;
 
-	srpc_startup_load_t load_values[] = {
-		{
-			"contact",
-			system_running_load_contact,
-		},
-		{
-			"location",
-			system_running_load_location,
-		},
-		{
-			"timezone-name",
-			system_running_load_timezone_name,
-		},
-		{
-			"dns-resolver",
-			system_running_load_dns_resolver,
-		},
-		{
-			"authentication",
-			system_running_load_authentication,
-		},
-	};
-
 	conn_ctx = sr_session_get_connection(session);
 	ly_ctx = sr_acquire_context(conn_ctx);
 	if (ly_ctx == NULL) {
@@ -87,25 +80,44 @@ int system_running_ds_load(system_ctx_t *ctx, sr_session_ctx_t *session)
 	}
 
 	// reload features hash before adding all system values
-	SRPC_SAFE_CALL_ERR(error, srpc_feature_status_hash_reload(&ctx->ietf_system_features, session, IETF_SYSTEM_YANG_MODULE), error_out);
+	SRPC_SAFE_CALL_ERR(error, system_features_reload(ctx, session), error_out);
 
-	// load system container info
-	error = system_ly_tree_create_system(ly_ctx, &system_container_node);
-	for (size_t i = 0; i < ARRAY_SIZE(load_values); i++) {
-		const srpc_startup_load_t *load = &load_values[i];
+	// load system container info - unchanged subsystems are taken from the snapshot of the last start
+	error = system_running_ds_load_cached(ctx, session, ly_ctx, subsystems, &system_container_node);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_running_ds_load_cached() error (%d)", error);
+		goto error_out;
+	}
 
-		error = load->cb((void *) ctx, session, ly_ctx, system_container_node);
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "Node creation callback failed for value %s", load->name);
-			goto error_out;
-		}
+	error = sr_get_data(session, SYSTEM_SYSTEM_CONTAINER_YANG_PATH, 0, 0, 0, &running);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_get_data() error (%d): %s", error, sr_strerror(error));
+		goto error_out;
+	}
+
+	// only the values missing from running or differing from it are edited - sysrepo then validates and notifies just those
+	error = lyd_diff_siblings(running ? running->tree : NULL, system_container_node, 0, &diff);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "lyd_diff_siblings() error (%d)", error);
+		goto error_out;
+	}
+
+	error = system_running_ds_diff_to_edit(diff, &edit);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_running_ds_diff_to_edit() error (%d)", error);
+		goto error_out;
+	}
+
+	if (!edit) {
+		SYSTEM_LOG_INF("Running datastore already contains the system values");
+		goto out;
 	}
 
 // enable or disable storing into running - use when testing load functionality for now
 #define SYSTEM_PLUGIN_LOAD_STARTUP
 
 #ifdef SYSTEM_PLUGIN_LOAD_STARTUP
-	error = sr_edit_batch(session, system_container_node, "merge");
+	error = sr_edit_batch(session, edit, "merge");
 	if (error != SR_ERR_OK) {
 		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_edit_batch() error (%d): %s", error, sr_strerror(error));
 		goto error_out;
@@ -114,6 +126,7 @@ int system_running_ds_load(system_ctx_t *ctx, sr_session_ctx_t *session)
 	error = sr_apply_changes(session, 0);
 	if (error != 0) {
 		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_apply_changes() error (%d): %s", error, sr_strerror(error));
+		sr_discard_changes(session);
 		goto error_out;
 	}
 #endif
@@ -124,6 +137,18 @@ error_out:
 	error = -1;
 
 out:
+	if (edit) {
+		lyd_free_all(edit);
+	}
+
+	if (diff) {
+		lyd_free_all(diff);
+	}
+
+	if (running) {
+		sr_release_data(running);
+	}
+
 	if (system_container_node) {
 		lyd_free_tree(system_container_node);
 	}
@@ -133,6 +158,173 @@ out:
 	return error;
 }
 
+int system_running_ds_load_system(system_ctx_t *ctx, sr_session_ctx_t *session, const struct ly_ctx *ly_ctx, uint32_t subsystems, struct lyd_node **system_container_node)
+{
+	int error = 0;
+
+	// contact and location are part of the hostname subsystem - NTP servers are not loaded from the system
+	const struct {
+		system_subsystem_t subsystem;
+		srpc_startup_load_t load;
+	} load_values[] = {
+		{
+			SYSTEM_SUBSYSTEM_HOSTNAME,
+			{"hostname", system_running_load_hostname},
+		},
+		{
+			SYSTEM_SUBSYSTEM_HOSTNAME,
+			{"contact", system_running_load_contact},
+		},
+		{
+			SYSTEM_SUBSYSTEM_HOSTNAME,
+			{"location", system_running_load_location},
+		},
+		{
+			SYSTEM_SUBSYSTEM_CLOCK,
+			{"timezone-name", system_running_load_timezone_name},
+		},
+		{
+			SYSTEM_SUBSYSTEM_DNS_RESOLVER,
+			{"dns-resolver", system_running_load_dns_resolver},
+		},
+		{
+			SYSTEM_SUBSYSTEM_AUTHENTICATION,
+			{"authentication", system_running_load_authentication},
+		},
+	};
+
+	*system_container_node = NULL;
+
+	error = system_ly_tree_create_system(ly_ctx, system_container_node);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_ly_tree_create_system() error (%d)", error);
+		goto error_out;
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(load_values); i++) {
+		const srpc_startup_load_t *load = &load_values[i].load;
+
+		if (!(subsystems & SYSTEM_SUBSYSTEM_MASK(load_values[i].subsystem))) {
+			continue;
+		}
+
+		error = load->cb((void *) ctx, session, ly_ctx, *system_container_node);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "Node creation callback failed for value %s", load->name);
+			goto error_out;
+		}
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+	if (*system_container_node) {
+		lyd_free_tree(*system_container_node);
+		*system_container_node = NULL;
+	}
+
+out:
+	return error;
+}
+
+int system_running_ds_load_cached(system_ctx_t *ctx, sr_session_ctx_t *session, const struct ly_ctx *ly_ctx, uint32_t subsystems, struct lyd_node **system_container_node)
+{
+	int error = 0;
+	system_snapshot_sources_t sources = {0};
+	struct lyd_node *snapshot_node = NULL;
+	uint32_t fresh = 0;
+	bool stale = false;
+
+	*system_container_node = NULL;
+
+	// validators are collected before loading - a file changed while loading leaves the saved snapshot stale
+	if (system_snapshot_sources_collect(subsystems, &sources)) {
+		SRPLG_LOG_WRN(PLUGIN_NAME, "Unable to validate the system snapshot - loading all values from the system");
+		return system_running_ds_load_system(ctx, session, ly_ctx, subsystems, system_container_node);
+	}
+
+	if (system_snapshot_load(ly_ctx, &sources, subsystems, &snapshot_node, &fresh)) {
+		SRPLG_LOG_WRN(PLUGIN_NAME, "Unable to read the system snapshot - loading all values from the system");
+		fresh = 0;
+	}
+
+	error = system_running_ds_load_system(ctx, session, ly_ctx, subsystems & ~fresh, system_container_node);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_running_ds_load_system() error (%d)", error);
+		goto error_out;
+	}
+
+	error = system_running_ds_merge_snapshot(snapshot_node, fresh, system_container_node);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_running_ds_merge_snapshot() error (%d)", error);
+		goto error_out;
+	}
+
+	for (size_t i = 0; i < SYSTEM_SUBSYSTEM_COUNT; i++) {
+		if (sources.data[i] && !(fresh & SYSTEM_SUBSYSTEM_MASK(i))) {
+			stale = true;
+		}
+	}
+
+	// a snapshot which can't be saved only costs a full load on the next start
+	if (stale && system_snapshot_save(&sources, *system_container_node)) {
+		SRPLG_LOG_WRN(PLUGIN_NAME, "Unable to save the system snapshot");
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+	if (*system_container_node) {
+		lyd_free_tree(*system_container_node);
+		*system_container_node = NULL;
+	}
+
+out:
+	if (snapshot_node) {
+		lyd_free_all(snapshot_node);
+	}
+
+	system_snapshot_sources_free(&sources);
+
+	return error;
+}
+
+int system_running_ds_load_subsystem(system_ctx_t *ctx, sr_session_ctx_t *session, const struct ly_ctx *ly_ctx, system_subsystem_t subsystem, struct lyd_node **system_container_node)
+{
+	return system_running_ds_load_system(ctx, session, ly_ctx, SYSTEM_SUBSYSTEM_MASK(subsystem), system_container_node);
+}
+
+static int system_running_load_hostname(void *priv, sr_session_ctx_t *session, const struct ly_ctx *ly_ctx, struct lyd_node *parent_node)
+{
+	int error = 0;
+	system_ctx_t *ctx = (system_ctx_t *) priv;
+	char hostname_buffer[SYSTEM_HOSTNAME_LENGTH_MAX] = {0};
+
+	error = system_load_hostname(ctx, hostname_buffer);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_load_hostname() error (%d)", error);
+		goto error_out;
+	}
+
+	error = system_ly_tree_create_hostname(ly_ctx, parent_node, hostname_buffer);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_ly_tree_create_hostname() error (%d)", error);
+		goto error_out;
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	return error;
+}
+
 static int system_running_load_contact(void *priv, sr_session_ctx_t *session, const struct ly_ctx *ly_ctx, struct lyd_node *parent_node)
 {
 	int error = 0;
@@ -153,7 +345,7 @@ static int system_running_load_timezone_name(void *priv, sr_session_ctx_t *sessi
 	struct lyd_node *clock_container_node = NULL;
 	bool timezone_name_enabled = false;
 
-	timezone_name_enabled = srpc_feature_status_hash_check(ctx->ietf_system_features, "timezone-name");
+	timezone_name_enabled = system_features_check(ctx, "timezone-name");
 
 	if (timezone_name_enabled) {
 		error = system_load_timezone_name(ctx, timezone_name_buffer);
@@ -199,7 +391,7 @@ static int system_running_load_dns_resolver(void *priv, sr_session_ctx_t *sessio
 		goto error_out;
 	}
 
-	SRPLG_LOG_INF(PLUGIN_NAME, "Loading DNS search values from the system");
+	SYSTEM_LOG_INF("Loading DNS search values from the system");
 
 	// load values
 
@@ -209,7 +401,7 @@ static int system_running_load_dns_resolver(void *priv, sr_session_ctx_t *sessio
 		goto error_out;
 	}
 
-	SRPLG_LOG_INF(PLUGIN_NAME, "Loading DNS server values from the system");
+	SYSTEM_LOG_INF("Loading DNS server values from the system");
 
 	error = system_dns_resolver_load_server(ctx, &servers_head);
 	if (error) {
@@ -217,7 +409,7 @@ static int system_running_load_dns_resolver(void *priv, sr_session_ctx_t *sessio
 		goto error_out;
 	}
 
-	SRPLG_LOG_INF(PLUGIN_NAME, "Saving search values to the datastore");
+	SYSTEM_LOG_INF("Saving search values to the datastore");
 
 	LL_FOREACH(search_head, search_iter_el)
 	{
@@ -228,8 +420,8 @@ static int system_running_load_dns_resolver(void *priv, sr_session_ctx_t *sessio
 		}
 	}
 
-	SRPLG_LOG_INF(PLUGIN_NAME, "Saved search values to the datastore");
-	SRPLG_LOG_INF(PLUGIN_NAME, "Saving server values to the datastore");
+	SYSTEM_LOG_INF("Saved search values to the datastore");
+	SYSTEM_LOG_INF("Saving server values to the datastore");
 
 	LL_FOREACH(servers_head, servers_iter_el)
 	{
@@ -268,7 +460,7 @@ static int system_running_load_dns_resolver(void *priv, sr_session_ctx_t *sessio
 		}
 	}
 
-	SRPLG_LOG_INF(PLUGIN_NAME, "Saved server values to the datastore");
+	SYSTEM_LOG_INF("Saved server values to the datastore");
 
 	goto out;
 
@@ -292,8 +484,8 @@ static int system_running_load_authentication(void *priv, sr_session_ctx_t *sess
 	system_local_user_element_t *user_head = NULL, *user_iter = NULL;
 	system_authorized_key_element_t *key_iter = NULL;
 
-	bool enabled_authentication = srpc_feature_status_hash_check(ctx->ietf_system_features, "authentication");
-	bool enabled_local_users = srpc_feature_status_hash_check(ctx->ietf_system_features, "local-users");
+	bool enabled_authentication = system_features_check(ctx, "authentication");
+	bool enabled_local_users = system_features_check(ctx, "local-users");
 
 	if (enabled_authentication) {
 		// create authentication container
@@ -304,7 +496,7 @@ static int system_running_load_authentication(void *priv, sr_session_ctx_t *sess
 		}
 
 		if (enabled_local_users) {
-			SRPLG_LOG_INF(PLUGIN_NAME, "Loading users from the system");
+			SYSTEM_LOG_INF("Loading users from the system");
 
 			// init list first
 			system_local_user_list_init(&user_head);
@@ -316,20 +508,20 @@ static int system_running_load_authentication(void *priv, sr_session_ctx_t *sess
 				goto error_out;
 			}
 
-			SRPLG_LOG_INF(PLUGIN_NAME, "Loading user authorized keys");
+			SYSTEM_LOG_INF("Loading user authorized keys");
 
 			LL_FOREACH(user_head, user_iter)
 			{
 				system_authorized_key_list_init(&user_iter->user.key_head);
 
-				error = system_authentication_load_user_authorized_key(ctx, user_iter->user.name, &user_iter->user.key_head);
+				error = system_authentication_load_user_authorized_key(ctx, user_iter->user.name, user_iter->user.home, &user_iter->user.key_head);
 				if (error) {
 					SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_load_user_authorized_key() error (%d)", error);
 					goto error_out;
 				}
 			}
 
-			SRPLG_LOG_INF(PLUGIN_NAME, "Saving users and their keys to the datastore");
+			SYSTEM_LOG_INF("Saving users and their keys to the datastore");
 
 			LL_FOREACH(user_head, user_iter)
 			{
@@ -344,7 +536,7 @@ static int system_running_load_authentication(void *priv, sr_session_ctx_t *sess
 				if (user_iter->user.password && strcmp(user_iter->user.password, "")) {
 					error = system_ly_tree_create_authentication_user_password(ly_ctx, user_list_node, user_iter->user.password);
 					if (error) {
-						SRPLG_LOG_ERR(PLUGIN_NAME, "system_ly_tree_create_authentication_user_password() error (%d) for %s", error, user_iter->user.password);
+						SRPLG_LOG_ERR(PLUGIN_NAME, "system_ly_tree_create_authentication_user_password() error (%d) for %s", error, user_iter->user.name);
 						goto error_out;
 					}
 				}
@@ -377,7 +569,7 @@ static int system_running_load_authentication(void *priv, sr_session_ctx_t *sess
 						if (key_iter->key.data) {
 							error = system_ly_tree_create_authentication_user_authorized_key_data(ly_ctx, authorized_key_list_node, key_iter->key.data);
 							if (error) {
-								SRPLG_LOG_ERR(PLUGIN_NAME, "system_ly_tree_create_authentication_user_authorized_key_data() error (%d) for %s", error, key_iter->key.data);
+								SRPLG_LOG_ERR(PLUGIN_NAME, "system_ly_tree_create_authentication_user_authorized_key_data() error (%d) for key %s of user %s", error, key_iter->key.name, user_iter->user.name);
 								goto error_out;
 							}
 						}
@@ -385,7 +577,7 @@ static int system_running_load_authentication(void *priv, sr_session_ctx_t *sess
 				}
 			}
 
-			SRPLG_LOG_INF(PLUGIN_NAME, "Saved users to the datastore");
+			SYSTEM_LOG_INF("Saved users to the datastore");
 		}
 	}
 
@@ -398,4 +590,93 @@ out:
 	system_local_user_list_free(&user_head);
 
 	return error;
-}
\ No newline at end of file
+}
+
+static int system_running_ds_diff_to_edit(const struct lyd_node *diff, struct lyd_node **edit)
+{
+	const struct lyd_node *iter = NULL;
+	struct lyd_node *dup = NULL;
+	struct lyd_meta *meta = NULL;
+	const char *operation = NULL;
+
+	LY_LIST_FOR(diff, iter)
+	{
+		meta = lyd_find_meta(iter->meta, NULL, "yang:operation");
+		operation = meta ? lyd_get_meta_value(meta) : NULL;
+
+		if (operation && (!strcmp(operation, "create") || (!strcmp(operation, "replace") && iter->schema->nodetype == LYS_LEAF))) {
+			// the subtree with its parents and list keys, without the diff metadata
+			if (lyd_dup_single(iter, NULL, LYD_DUP_RECURSIVE | LYD_DUP_WITH_PARENTS | LYD_DUP_NO_META, &dup)) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "lyd_dup_single() failed for %s", LYD_NAME(iter));
+				return -1;
+			}
+
+			while (lyd_parent(dup)) {
+				dup = lyd_parent(dup);
+			}
+
+			if (lyd_merge_siblings(edit, dup, LYD_MERGE_DESTRUCT)) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "lyd_merge_siblings() failed for %s", LYD_NAME(iter));
+				lyd_free_all(dup);
+				return -1;
+			}
+		} else if (!operation || strcmp(operation, "delete")) {
+			// values only in running are kept, as with a merge of the whole tree - look for changes deeper only
+			if (system_running_ds_diff_to_edit(lyd_child(iter), edit)) {
+				return -1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+static int system_running_ds_merge_snapshot(const struct lyd_node *snapshot_node, uint32_t subsystems, struct lyd_node **system_container_node)
+{
+	int error = 0;
+	struct ly_set *set = NULL;
+	struct lyd_node *dup = NULL;
+
+	for (size_t i = 0; i < SYSTEM_SUBSYSTEM_COUNT; i++) {
+		if (!(subsystems & SYSTEM_SUBSYSTEM_MASK(i)) || !system_running_snapshot_xpaths[i]) {
+			continue;
+		}
+
+		SYSTEM_LOG_INF("Taking %s from the system snapshot", system_running_snapshot_xpaths[i]);
+
+		if (lyd_find_xpath(snapshot_node, system_running_snapshot_xpaths[i], &set)) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "lyd_find_xpath() failed for %s", system_running_snapshot_xpaths[i]);
+			goto error_out;
+		}
+
+		for (uint32_t j = 0; j < set->count; j++) {
+			if (lyd_dup_single(set->dnodes[j], NULL, LYD_DUP_RECURSIVE | LYD_DUP_WITH_PARENTS, &dup)) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "lyd_dup_single() failed for %s", LYD_NAME(set->dnodes[j]));
+				goto error_out;
+			}
+
+			while (lyd_parent(dup)) {
+				dup = lyd_parent(dup);
+			}
+
+			if (lyd_merge_siblings(system_container_node, dup, LYD_MERGE_DESTRUCT)) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "lyd_merge_siblings() failed for %s", LYD_NAME(set->dnodes[j]));
+				lyd_free_all(dup);
+				goto error_out;
+			}
+		}
+
+		ly_set_free(set, NULL);
+		set = NULL;
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	ly_set_free(set, NULL);
+
+	return error;
+}
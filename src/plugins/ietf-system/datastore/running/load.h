@@ -16,6 +16,9 @@
 #include <core/context.h>
 #include <core/common.h>
 
-int system_running_ds_load(system_ctx_t *ctx, sr_session_ctx_t *session);
+int system_running_ds_load(system_ctx_t *ctx, sr_session_ctx_t *session, uint32_t subsystems);
+int system_running_ds_load_system(system_ctx_t *ctx, sr_session_ctx_t *session, const struct ly_ctx *ly_ctx, uint32_t subsystems, struct lyd_node **system_container_node);
+int system_running_ds_load_cached(system_ctx_t *ctx, sr_session_ctx_t *session, const struct ly_ctx *ly_ctx, uint32_t subsystems, struct lyd_node **system_container_node);
+int system_running_ds_load_subsystem(system_ctx_t *ctx, sr_session_ctx_t *session, const struct ly_ctx *ly_ctx, system_subsystem_t subsystem, struct lyd_node **system_container_node);
 
 #endif // SYSTEM_PLUGIN_DATASTORE_RUNNING_LOAD_H
\ No newline at end of file
@@ -11,105 +11,169 @@
  * SPDX-License-Identifier: BSD-3-Clause
  */
 #include "store.h"
+#include "load.h"
 #include "core/common.h"
-#include "libyang/printer_data.h"
-#include "core/ly_tree.h"
+#include "core/log.h"
+#include "core/features.h"
+#include "core/reconcile.h"
 
-// API for getting system data
+// API for applying changes on the system
 #include "srpc/common.h"
-#include "srpc/feature_status.h"
-#include "srpc/ly_tree.h"
-#include "srpc/types.h"
-#include "core/api/system/authentication/check.h"
-#include "core/api/system/authentication/load.h"
-#include "core/api/system/check.h"
-#include "core/api/system/ntp/check.h"
-#include "core/api/system/ntp/store.h"
-#include "core/api/system/store.h"
+#include "core/api/system/change.h"
+#include "core/api/system/dns_resolver/change.h"
+#include "core/api/system/dns_resolver/load.h"
 #include "core/api/system/dns_resolver/store.h"
-#include "core/api/system/dns_resolver/check.h"
-#include "core/api/system/authentication/store.h"
-
-// data manipulation
-#include "core/data/system/authentication/authorized_key.h"
-#include "core/data/system/authentication/authorized_key/list.h"
-#include "core/data/system/authentication/local_user.h"
-#include "core/data/system/authentication/local_user/list.h"
-#include "core/data/system/ip_address.h"
-#include "core/data/system/dns_resolver/search.h"
-#include "core/data/system/dns_resolver/search/list.h"
-#include "core/data/system/dns_resolver/server.h"
-#include "core/data/system/dns_resolver/server/list.h"
-#include "core/data/system/ntp/server.h"
-#include "core/data/system/ntp/server/list.h"
-#include "core/types.h"
-
-#include <sysrepo.h>
-#include <stdlib.h>
-#include <unistd.h>
-#include <errno.h>
+#include "core/api/system/authentication/change.h"
 
 #include <sysrepo.h>
 #include <libyang/libyang.h>
-#include <libyang/tree.h>
-#include <libyang/tree_schema.h>
-#include <libyang/tree_data.h>
 
 #include <srpc.h>
 
-#include <utlist.h>
-
-static int system_running_store_contact(void *priv, const struct lyd_node *system_container_node);
-static int system_running_store_location(void *priv, const struct lyd_node *system_container_node);
-static int system_running_store_timezone_name(void *priv, const struct lyd_node *system_container_node);
-static int system_running_store_dns_resolver(void *priv, const struct lyd_node *system_container_node);
-static int system_running_store_authentication(void *priv, const struct lyd_node *system_container_node);
-
-int system_running_ds_store(system_ctx_t *ctx, sr_session_ctx_t *session)
-{
-	int error = 0;
-	sr_data_t *subtree = NULL;
-
-	error = sr_get_subtree(session, SYSTEM_SYSTEM_CONTAINER_YANG_PATH, 0, &subtree);
-	if (error) {
-		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_get_subtree() error (%d): %s", error, sr_strerror(error));
-		goto error_out;
-	}
-
-	srpc_startup_store_t store_values[] = {
+static int system_running_reconcile_contact(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx);
+static int system_running_reconcile_location(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx);
+static int system_running_reconcile_timezone_name(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx);
+static bool system_running_reconcile_timezone_name_enabled(system_ctx_t *ctx);
+static int system_running_reconcile_dns_search_prepare(system_transaction_t *transaction);
+static int system_running_reconcile_dns_search_apply(system_transaction_t *transaction);
+static int system_running_reconcile_dns_server_prepare(system_transaction_t *transaction);
+static int system_running_reconcile_dns_server_apply(system_transaction_t *transaction);
+static bool system_running_reconcile_authentication_enabled(system_ctx_t *ctx);
+
+static const system_reconcile_hook_t system_running_reconcile_contact_hooks[] = {
+	{SYSTEM_CONTACT_YANG_PATH, system_running_reconcile_contact},
+};
+
+static const system_reconcile_hook_t system_running_reconcile_location_hooks[] = {
+	{SYSTEM_LOCATION_YANG_PATH, system_running_reconcile_location},
+};
+
+static const system_reconcile_hook_t system_running_reconcile_timezone_name_hooks[] = {
+	{SYSTEM_TIMEZONE_NAME_YANG_PATH, system_running_reconcile_timezone_name},
+};
+
+static const system_reconcile_hook_t system_running_reconcile_dns_search_hooks[] = {
+	{SYSTEM_DNS_RESOLVER_SEARCH_YANG_PATH, system_dns_resolver_change_search},
+};
+
+// the key comes first in the diff - created servers exist before their address and port are set
+static const system_reconcile_hook_t system_running_reconcile_dns_server_hooks[] = {
+	{SYSTEM_DNS_RESOLVER_SERVER_YANG_PATH "/name", system_dns_resolver_change_server_name},
+	{SYSTEM_DNS_RESOLVER_SERVER_YANG_PATH "/udp-and-tcp/address", system_dns_resolver_change_server_address},
+	{SYSTEM_DNS_RESOLVER_SERVER_YANG_PATH "/udp-and-tcp/port", system_dns_resolver_change_server_port},
+};
+
+static const system_reconcile_hook_t system_running_reconcile_authentication_hooks[] = {
+	{SYSTEM_AUTHENTICATION_USER_YANG_PATH, system_authentication_change_user},
+};
+
+// hostname is not stored - the system value is the one loaded into running
+static const struct {
+	system_subsystem_t subsystem;
+	system_reconcile_subsystem_t reconcile;
+} system_running_reconcile_subsystems[] = {
+	{
+		SYSTEM_SUBSYSTEM_HOSTNAME,
+		{
+			.name = "contact",
+			.hooks = system_running_reconcile_contact_hooks,
+			.hook_count = ARRAY_SIZE(system_running_reconcile_contact_hooks),
+		},
+	},
+	{
+		SYSTEM_SUBSYSTEM_HOSTNAME,
 		{
-			"contact",
-			system_running_store_contact,
+			.name = "location",
+			.hooks = system_running_reconcile_location_hooks,
+			.hook_count = ARRAY_SIZE(system_running_reconcile_location_hooks),
 		},
+	},
+	{
+		SYSTEM_SUBSYSTEM_CLOCK,
 		{
-			"location",
-			system_running_store_location,
+			.name = "timezone-name",
+			.enabled = system_running_reconcile_timezone_name_enabled,
+			.hooks = system_running_reconcile_timezone_name_hooks,
+			.hook_count = ARRAY_SIZE(system_running_reconcile_timezone_name_hooks),
 		},
+	},
+	{
+		SYSTEM_SUBSYSTEM_DNS_RESOLVER,
 		{
-			"timezone-name",
-			system_running_store_timezone_name,
+			.name = "dns-resolver search",
+			.prepare = system_running_reconcile_dns_search_prepare,
+			.apply = system_running_reconcile_dns_search_apply,
+			.hooks = system_running_reconcile_dns_search_hooks,
+			.hook_count = ARRAY_SIZE(system_running_reconcile_dns_search_hooks),
 		},
+	},
+	{
+		SYSTEM_SUBSYSTEM_DNS_RESOLVER,
 		{
-			"dns-resolver",
-			system_running_store_dns_resolver,
+			.name = "dns-resolver server",
+			.prepare = system_running_reconcile_dns_server_prepare,
+			.apply = system_running_reconcile_dns_server_apply,
+			.hooks = system_running_reconcile_dns_server_hooks,
+			.hook_count = ARRAY_SIZE(system_running_reconcile_dns_server_hooks),
 		},
+	},
+	{
+		// users missing from the datastore are kept - root and the accounts of the distribution are loaded as well
+		SYSTEM_SUBSYSTEM_AUTHENTICATION,
 		{
-			"authentication",
-			system_running_store_authentication,
+			.name = "authentication",
+			.enabled = system_running_reconcile_authentication_enabled,
+			.apply = system_authentication_user_apply_changes,
+			.retain_path = SYSTEM_AUTHENTICATION_USER_YANG_PATH,
+			.hooks = system_running_reconcile_authentication_hooks,
+			.hook_count = ARRAY_SIZE(system_running_reconcile_authentication_hooks),
 		},
-	};
+	},
+};
+
+int system_running_ds_store(system_ctx_t *ctx, sr_session_ctx_t *session, uint32_t subsystems)
+{
+	int error = 0;
+	sr_data_t *subtree = NULL;
+	sr_conn_ctx_t *conn_ctx = NULL;
+	const struct ly_ctx *ly_ctx = NULL;
+	struct lyd_node *system_container_node = NULL;
+	system_reconcile_subsystem_t reconcile[ARRAY_SIZE(system_running_reconcile_subsystems)] = {0};
+	size_t reconcile_count = 0;
+
+	for (size_t i = 0; i < ARRAY_SIZE(system_running_reconcile_subsystems); i++) {
+		if (subsystems & SYSTEM_SUBSYSTEM_MASK(system_running_reconcile_subsystems[i].subsystem)) {
+			reconcile[reconcile_count++] = system_running_reconcile_subsystems[i].reconcile;
+		}
+	}
+
+	error = sr_get_subtree(session, SYSTEM_SYSTEM_CONTAINER_YANG_PATH, 0, &subtree);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_get_subtree() error (%d): %s", error, sr_strerror(error));
+		goto error_out;
+	}
 
 	// reload feature status hash before storing system data
-	SRPC_SAFE_CALL_ERR(error, srpc_feature_status_hash_reload(&ctx->ietf_system_features, session, IETF_SYSTEM_YANG_MODULE), error_out);
+	SRPC_SAFE_CALL_ERR(error, system_features_reload(ctx, session), error_out);
 
-	for (size_t i = 0; i < ARRAY_SIZE(store_values); i++) {
-		const srpc_startup_store_t *store = &store_values[i];
+	conn_ctx = sr_session_get_connection(session);
+	ly_ctx = sr_acquire_context(conn_ctx);
+	if (ly_ctx == NULL) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to get ly_ctx variable");
+		goto error_out;
+	}
 
-		error = store->cb(ctx, subtree->tree);
-		if (error != 0) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "Startup store callback failed for value %s", store->name);
-			goto error_out;
-		}
+	// current system values - the datastore values are compared against them
+	error = system_running_ds_load_system(ctx, session, ly_ctx, subsystems, &system_container_node);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_running_ds_load_system() error (%d)", error);
+		goto error_out;
+	}
+
+	error = system_reconcile(ctx, system_container_node, subtree->tree, reconcile, reconcile_count);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_reconcile() error (%d)", error);
+		goto error_out;
 	}
 
 	goto out;
@@ -118,6 +182,14 @@ error_out:
 	error = -1;
 
 out:
+	if (system_container_node) {
+		lyd_free_tree(system_container_node);
+	}
+
+	if (ly_ctx) {
+		sr_release_context(conn_ctx);
+	}
+
 	if (subtree) {
 		sr_release_data(subtree);
 	}
@@ -125,568 +197,53 @@ out:
 	return error;
 }
 
-static int system_running_store_contact(void *priv, const struct lyd_node *system_container_node)
+static int system_running_reconcile_contact(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx)
 {
-	int error = 0;
-	system_ctx_t *ctx = (system_ctx_t *) priv;
-
-	struct lyd_node *contact_node = srpc_ly_tree_get_child_leaf(system_container_node, "contact");
-
-	if (contact_node) {
-		const char *contact = lyd_get_value(contact_node);
+	system_transaction_t *transaction = (system_transaction_t *) priv;
 
-		SRPLG_LOG_INF(PLUGIN_NAME, "contact value: %s", contact);
-
-		error = system_store_contact(ctx, contact);
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "system_store_contact() failed (%d)", error);
-			return -1;
-		}
-	}
-
-	return 0;
+	return system_change_contact(transaction->ctx, session, change_ctx);
 }
 
-static int system_running_store_location(void *priv, const struct lyd_node *system_container_node)
+static int system_running_reconcile_location(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx)
 {
-	int error = 0;
-	system_ctx_t *ctx = (system_ctx_t *) priv;
-
-	struct lyd_node *location_node = srpc_ly_tree_get_child_leaf(system_container_node, "location");
+	system_transaction_t *transaction = (system_transaction_t *) priv;
 
-	if (location_node) {
-		const char *location = lyd_get_value(location_node);
-
-		SRPLG_LOG_INF(PLUGIN_NAME, "location value: %s", location);
-
-		error = system_store_location(ctx, location);
-		if (error) {
-			SRPLG_LOG_ERR(PLUGIN_NAME, "system_store_location() failed (%d)", error);
-			return -1;
-		}
-	}
-
-	return 0;
+	return system_change_location(transaction->ctx, session, change_ctx);
 }
 
-static int system_running_store_timezone_name(void *priv, const struct lyd_node *system_container_node)
+static int system_running_reconcile_timezone_name(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx)
 {
-	int error = 0;
-	system_ctx_t *ctx = (system_ctx_t *) priv;
-	srpc_check_status_t check_status = srpc_check_status_none;
-	bool timezone_name_enabled = srpc_feature_status_hash_check(ctx->ietf_system_features, "timezone-name");
-
-	struct lyd_node *clock_container_node = NULL, *timezone_name_node = NULL;
-
-	if (timezone_name_enabled) {
-		clock_container_node = srpc_ly_tree_get_child_container(system_container_node, "clock");
-
-		if (clock_container_node) {
-			timezone_name_node = srpc_ly_tree_get_child_leaf(clock_container_node, "timezone-name");
-			if (timezone_name_node) {
-				const char *timezone_name = lyd_get_value(timezone_name_node);
-
-				SRPLG_LOG_INF(PLUGIN_NAME, "Checking system timezone-name value");
-				check_status = system_check_timezone_name(ctx, timezone_name);
-
-				switch (check_status) {
-					case srpc_check_status_none:
-						SRPLG_LOG_ERR(PLUGIN_NAME, "Error loading current system timezone-name value");
-						goto error_out;
-						break;
-					case srpc_check_status_error:
-						SRPLG_LOG_ERR(PLUGIN_NAME, "Error loading current system timezone-name value");
-						goto error_out;
-						break;
-					case srpc_check_status_non_existant:
-						SRPLG_LOG_INF(PLUGIN_NAME, "Storing timezone-name value %s", timezone_name);
-
-						error = system_store_timezone_name(ctx, timezone_name);
-						if (error) {
-							SRPLG_LOG_ERR(PLUGIN_NAME, "system_store_timezone_name() failed (%d)", error);
-							return -1;
-						}
-						break;
-					case srpc_check_status_equal:
-						SRPLG_LOG_ERR(PLUGIN_NAME, "Startup timezone-name value is already applied on the system");
-						break;
-					case srpc_check_status_partial:
-						// should not be returned - treat as error
-						SRPLG_LOG_ERR(PLUGIN_NAME, "Error loading current system timezone-name value");
-						goto error_out;
-						break;
-				}
-			}
-		}
-	}
-
-	goto out;
-
-error_out:
-	error = -1;
+	system_transaction_t *transaction = (system_transaction_t *) priv;
 
-out:
-	return 0;
+	return system_change_timezone_name(transaction->ctx, session, change_ctx);
 }
 
-static int system_running_store_dns_resolver(void *priv, const struct lyd_node *system_container_node)
+static bool system_running_reconcile_timezone_name_enabled(system_ctx_t *ctx)
 {
-	int error = 0;
-	system_ctx_t *ctx = (system_ctx_t *) priv;
-	struct lyd_node *dns_resolver_container_node = NULL;
-	struct lyd_node *search_leaf_list_node = NULL;
-	struct lyd_node *server_list_node = NULL;
-	struct lyd_node *server_name_leaf_node = NULL;
-	struct lyd_node *server_address_leaf_node = NULL;
-	struct lyd_node *server_port_leaf_node = NULL;
-	struct lyd_node *udp_and_tcp_container_node = NULL;
-	system_dns_server_element_t *servers_head = NULL;
-	system_dns_search_element_t *search_head = NULL;
-	system_dns_server_t tmp_server = {0};
-	system_dns_search_t tmp_search = {0};
-	system_ip_address_t tmp_ip = {0};
-	srpc_check_status_t search_check_status = srpc_check_status_none, server_check_status = srpc_check_status_none;
-
-	SRPLG_LOG_INF(PLUGIN_NAME, "Storing dns-resolver running data");
-
-	dns_resolver_container_node = srpc_ly_tree_get_child_container(system_container_node, "dns-resolver");
-	if (dns_resolver_container_node) {
-		// get search leaf list
-		search_leaf_list_node = srpc_ly_tree_get_child_leaf_list(dns_resolver_container_node, "search");
-		server_list_node = srpc_ly_tree_get_child_list(dns_resolver_container_node, "server");
-
-		if (search_leaf_list_node) {
-			// store search list
-			while (search_leaf_list_node) {
-				system_dns_search_init(&tmp_search);
-
-				const char *domain = lyd_get_value(search_leaf_list_node);
-
-				// SRPLG_LOG_INF(PLUGIN_NAME, "Adding DNS search value %s", domain);
-
-				error = system_dns_search_set_domain(&tmp_search, domain);
-				if (error) {
-					SRPLG_LOG_ERR(PLUGIN_NAME, "system_dns_search_set_domain() error (%d)", error);
-					goto error_out;
-				}
-
-				error = system_dns_search_set_ifindex(&tmp_search, 0);
-				if (error) {
-					SRPLG_LOG_ERR(PLUGIN_NAME, "system_dns_search_set_ifindex() error (%d)", error);
-					goto error_out;
-				}
-
-				error = system_dns_search_set_search(&tmp_search, 0);
-				if (error) {
-					SRPLG_LOG_ERR(PLUGIN_NAME, "system_dns_search_set_search() error (%d)", error);
-					goto error_out;
-				}
-
-				// add to the list
-				error = system_dns_search_list_add(&search_head, tmp_search);
-				if (error) {
-					SRPLG_LOG_ERR(PLUGIN_NAME, "system_dns_search_list_add() error (%d)", error);
-					goto error_out;
-				}
-
-				system_dns_search_free(&tmp_search);
-
-				search_leaf_list_node = srpc_ly_tree_get_leaf_list_next(search_leaf_list_node);
-			}
-
-			SRPLG_LOG_INF(PLUGIN_NAME, "Checking DNS search values on the system");
-			search_check_status = system_dns_resolver_check_search(ctx, search_head);
-			SRPLG_LOG_INF(PLUGIN_NAME, "Recieved check status = %d", search_check_status);
-
-			switch (search_check_status) {
-				case srpc_check_status_none:
-					// should not be recieved - treat same as an error
-					SRPLG_LOG_ERR(PLUGIN_NAME, "Error occured while checking DNS search system values");
-					goto error_out;
-					break;
-				case srpc_check_status_error:
-					SRPLG_LOG_ERR(PLUGIN_NAME, "Error occured while checking DNS search system values");
-					goto error_out;
-					break;
-				case srpc_check_status_non_existant:
-					// values don't exist - apply them to the system
-					SRPLG_LOG_INF(PLUGIN_NAME, "Storing DNS search values from the datastore to the system");
-
-					// apply search values to the system
-					error = system_dns_resolver_store_search(ctx, search_head);
-					if (error) {
-						SRPLG_LOG_INF(PLUGIN_NAME, "system_dns_resolver_store_search() error (%d)", error);
-						goto error_out;
-					}
-
-					SRPLG_LOG_INF(PLUGIN_NAME, "Stored DNS search values from the datastore to the system");
-					break;
-				case srpc_check_status_equal:
-					// values exist - don't do anything
-					break;
-				case srpc_check_status_partial:
-					// TODO: create an union between running and system values and apply that list to the system
-					break;
-			}
-		}
-
-		if (server_list_node) {
-			while (server_list_node) {
-				// process server list node
-				system_dns_server_init(&tmp_server);
-
-				server_name_leaf_node = srpc_ly_tree_get_child_leaf(server_list_node, "name");
-				udp_and_tcp_container_node = srpc_ly_tree_get_child_container(server_list_node, "udp-and-tcp");
-
-				const char *name = lyd_get_value(server_name_leaf_node);
-				// SRPLG_LOG_INF(PLUGIN_NAME, "Adding DNS server %s", name);
-
-				// set name
-				system_dns_server_set_name(&tmp_server, name);
-
-				if (!udp_and_tcp_container_node) {
-					SRPLG_LOG_ERR(PLUGIN_NAME, "srpc_ly_tree_get_child_container() failed for udp-and-tcp");
-					goto error_out;
-				}
-
-				server_address_leaf_node = srpc_ly_tree_get_child_leaf(udp_and_tcp_container_node, "address");
-				server_port_leaf_node = srpc_ly_tree_get_child_leaf(udp_and_tcp_container_node, "port");
-
-				// address
-				if (server_address_leaf_node) {
-					const char *address = lyd_get_value(server_address_leaf_node);
-
-					// parse address
-					error = system_ip_address_from_str(&tmp_ip, address);
-					if (error) {
-						SRPLG_LOG_ERR(PLUGIN_NAME, "system_ip_address_from_str() error (%d)", error);
-						goto error_out;
-					}
-
-					// set address
-					error = system_dns_server_set_address(&tmp_server, tmp_ip);
-					if (error) {
-						SRPLG_LOG_ERR(PLUGIN_NAME, "system_dns_server_set_address() error (%d)", error);
-						goto error_out;
-					}
-				} else {
-					// no address node -> unable to continue
-					SRPLG_LOG_INF(PLUGIN_NAME, "srpc_ly_tree_get_child_leaf() failed for leaf address");
-					goto error_out;
-				}
-
-				if (server_port_leaf_node) {
-					const char *port = lyd_get_value(server_port_leaf_node);
-
-					// parse into int
-					const int port_i32 = atoi(port);
-
-					// set port
-					error = system_dns_server_set_port(&tmp_server, port_i32);
-					if (error) {
-						SRPLG_LOG_INF(PLUGIN_NAME, "system_dns_server_set_port() error (%d)", error);
-						goto error_out;
-					}
-				}
-
-				// append to the list
-				error = system_dns_server_list_add(&servers_head, tmp_server);
-				if (error) {
-					SRPLG_LOG_INF(PLUGIN_NAME, "system_dns_server_list_add() error (%d)", error);
-					goto error_out;
-				}
-
-				system_dns_server_free(&tmp_server);
-
-				server_list_node = srpc_ly_tree_get_list_next(server_list_node);
-			}
-
-			SRPLG_LOG_INF(PLUGIN_NAME, "Checking DNS server values on the system");
-			server_check_status = system_dns_resolver_check_server(ctx, servers_head);
-			SRPLG_LOG_INF(PLUGIN_NAME, "Recieved check status = %d", server_check_status);
-
-			switch (server_check_status) {
-				case srpc_check_status_none:
-					// should not be recieved - treat same as an error
-					SRPLG_LOG_ERR(PLUGIN_NAME, "Error occured while checking DNS server system values");
-					goto error_out;
-					break;
-				case srpc_check_status_error:
-					SRPLG_LOG_ERR(PLUGIN_NAME, "Error occured while checking DNS server system values");
-					goto error_out;
-					break;
-				case srpc_check_status_non_existant:
-					SRPLG_LOG_INF(PLUGIN_NAME, "Storing DNS server values from the datastore to the system");
-
-					// gathered all servers - store them to the system
-					error = system_dns_resolver_store_server(ctx, servers_head);
-					if (error) {
-						SRPLG_LOG_INF(PLUGIN_NAME, "system_dns_resolver_store_server() error (%d)", error);
-						goto error_out;
-					}
-
-					SRPLG_LOG_INF(PLUGIN_NAME, "Stored DNS server values from the datastore to the system");
-					break;
-				case srpc_check_status_equal:
-					// don't do anything
-					SRPLG_LOG_INF(PLUGIN_NAME, "DNS server values already exist on the system - no need to apply anything");
-					break;
-				case srpc_check_status_partial:
-					// TODO: implement
-					break;
-			}
-		}
-	}
-
-	goto out;
-
-error_out:
-	error = -1;
-
-out:
-	// remove temp values if something was interrupted
-	system_dns_search_free(&tmp_search);
-	system_dns_server_free(&tmp_server);
-
-	// free allocated lists
-	system_dns_search_list_free(&search_head);
-	system_dns_server_list_free(&servers_head);
-
-	return error;
+	return system_features_check(ctx, "timezone-name");
 }
 
-static int system_running_store_authentication(void *priv, const struct lyd_node *system_container_node)
+static int system_running_reconcile_dns_search_prepare(system_transaction_t *transaction)
 {
-	int error = 0;
-
-	system_ctx_t *ctx = (system_ctx_t *) priv;
-
-	// libyang
-	struct lyd_node *authentication_container_node = NULL;
-	struct lyd_node *local_user_list_node = NULL, *user_name_leaf_node = NULL, *user_password_leaf_node;
-	struct lyd_node *authorized_key_list_node = NULL, *key_name_leaf_node = NULL, *key_algorithm_leaf_node = NULL, *key_data_leaf_node = NULL;
-
-	// data
-	system_local_user_element_t *user_head = NULL, *found_user_el = NULL, *user_iter = NULL;
-	system_local_user_element_t *system_user_head = NULL;
-	system_local_user_element_t *complement_user_head = NULL;
-	system_local_user_t temp_user = {0};
-	system_authorized_key_t temp_key = {0};
-
-	// features
-	bool authentication_enabled = srpc_feature_status_hash_check(ctx->ietf_system_features, "authentication");
-	bool local_users_enabled = srpc_feature_status_hash_check(ctx->ietf_system_features, "local-users");
-
-	// srpc
-	srpc_check_status_t user_check_status = srpc_check_status_none, key_check_status = srpc_check_status_none;
-
-	if (authentication_enabled) {
-		SRPLG_LOG_INF(PLUGIN_NAME, "Storing authentication running data");
-
-		authentication_container_node = srpc_ly_tree_get_child_container(system_container_node, "authentication");
-		if (authentication_container_node) {
-			if (local_users_enabled) {
-				SRPLG_LOG_INF(PLUGIN_NAME, "Storing local-users running data");
-
-				local_user_list_node = srpc_ly_tree_get_child_list(authentication_container_node, "user");
-				while (local_user_list_node) {
-					// create user
-					system_local_user_init(&temp_user);
-
-					user_name_leaf_node = srpc_ly_tree_get_child_leaf(local_user_list_node, "name");
-					user_password_leaf_node = srpc_ly_tree_get_child_leaf(local_user_list_node, "password");
-
-					// a name has to exist for the list element
-					assert(user_name_leaf_node != NULL);
-
-					// set name
-					error = system_local_user_set_name(&temp_user, lyd_get_value(user_name_leaf_node));
-					if (error) {
-						SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_set_name() error (%d)", error);
-						goto error_out;
-					}
-
-					// set password
-					if (user_password_leaf_node) {
-						error = system_local_user_set_password(&temp_user, lyd_get_value(user_password_leaf_node));
-						if (error) {
-							SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_set_password() error (%d)", error);
-							goto error_out;
-						}
-					}
-
-					// add user to the list
-					error = system_local_user_list_add(&user_head, temp_user);
-					if (error) {
-						SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_list_add() error (%d)", error);
-						goto error_out;
-					}
-
-					// get current user
-					found_user_el = system_local_user_list_find(user_head, temp_user.name);
-					if (!found_user_el) {
-						SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_list_find() failed");
-						goto error_out;
-					}
-
-					// user found - setup keys if any
-					authorized_key_list_node = srpc_ly_tree_get_child_list(local_user_list_node, "authorized-key");
-					while (authorized_key_list_node) {
-						// add key to the current user (found_user_el)
-						system_authorized_key_init(&temp_key);
-
-						key_name_leaf_node = srpc_ly_tree_get_child_leaf(authorized_key_list_node, "name");
-						key_algorithm_leaf_node = srpc_ly_tree_get_child_leaf(authorized_key_list_node, "algorithm");
-						key_data_leaf_node = srpc_ly_tree_get_child_leaf(authorized_key_list_node, "key-data");
-
-						// key must have a name
-						assert(key_name_leaf_node != NULL);
-
-						error = system_authorized_key_set_name(&temp_key, lyd_get_value(key_name_leaf_node));
-						if (error) {
-							SRPLG_LOG_ERR(PLUGIN_NAME, "system_authorized_key_set_name() error (%d)", error);
-							goto error_out;
-						}
-
-						if (key_algorithm_leaf_node) {
-							// set algorithm
-							error = system_authorized_key_set_algorithm(&temp_key, lyd_get_value(key_algorithm_leaf_node));
-							if (error) {
-								SRPLG_LOG_ERR(PLUGIN_NAME, "system_authorized_key_set_algorithm() error (%d)", error);
-								goto error_out;
-							}
-						}
-
-						if (key_data_leaf_node) {
-							// set algorithm
-							error = system_authorized_key_set_data(&temp_key, lyd_get_value(key_data_leaf_node));
-							if (error) {
-								SRPLG_LOG_ERR(PLUGIN_NAME, "system_authorized_key_set_data() error (%d)", error);
-								goto error_out;
-							}
-						}
-
-						// add to the list of current user keys
-						error = system_authorized_key_list_add(&found_user_el->user.key_head, temp_key);
-						if (error) {
-							SRPLG_LOG_ERR(PLUGIN_NAME, "system_authorized_key_list_add() error (%d)", error);
-							goto error_out;
-						}
-
-						// free temp data
-						system_authorized_key_free(&temp_key);
-						authorized_key_list_node = srpc_ly_tree_get_list_next(authorized_key_list_node);
-					}
-
-					system_local_user_free(&temp_user);
-					local_user_list_node = srpc_ly_tree_get_list_next(local_user_list_node);
-				}
-
-				// get system users
-				system_local_user_list_init(&system_user_head);
-
-				// check if all users exist on the system
-				SRPLG_LOG_INF(PLUGIN_NAME, "Checking running local user system values");
-				user_check_status = system_authentication_check_user(ctx, user_head, &system_user_head);
-				SRPLG_LOG_INF(PLUGIN_NAME, "Recieved local users check status: %d", user_check_status);
-
-				switch (user_check_status) {
-					case srpc_check_status_none:
-						SRPLG_LOG_ERR(PLUGIN_NAME, "Error occured while checking local user system values");
-						goto error_out;
-						break;
-					case srpc_check_status_error:
-						SRPLG_LOG_ERR(PLUGIN_NAME, "Error occured while checking local user system values");
-						goto error_out;
-						break;
-					case srpc_check_status_non_existant:
-						SRPLG_LOG_INF(PLUGIN_NAME, "Startup local users don\'t exist on the system - starting to store running local users");
-						error = system_authentication_store_user(ctx, user_head);
-						if (error) {
-							SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_store_user() error (%d)", error);
-							goto error_out;
-						}
-						break;
-					case srpc_check_status_equal:
-						SRPLG_LOG_INF(PLUGIN_NAME, "Startup local users already exist on the system - no need to store anything");
-						break;
-					case srpc_check_status_partial:
-						SRPLG_LOG_INF(PLUGIN_NAME, "Some running local users exist while others don\'t - creating non existant users");
-
-						// get complement of running without system
-						complement_user_head = system_local_user_list_complement(user_head, system_user_head);
-						if (!complement_user_head) {
-							SRPLG_LOG_ERR(PLUGIN_NAME, "system_local_user_list_complement() failed");
-							goto error_out;
-						}
-
-						SRPLG_LOG_INF(PLUGIN_NAME, "Storing missing local users from running to the system");
-
-						// add complement users to system
-						error = system_authentication_store_user(ctx, complement_user_head);
-						if (error) {
-							SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_store_user() error (%d)", error);
-							goto error_out;
-						}
-
-						SRPLG_LOG_INF(PLUGIN_NAME, "Missing local users from running are stored in the system");
-						break;
-				}
-
-				// after matching running and system values for users - match key lists for all users
-				SRPLG_LOG_INF(PLUGIN_NAME, "Checking running local user authorized key system values");
-				LL_FOREACH(user_head, user_iter)
-				{
-					// check first if any keys exist in running
-					if (user_iter->user.key_head) {
-						key_check_status = system_authentication_check_user_authorized_key(ctx, user_iter->user.name, user_iter->user.key_head);
-						SRPLG_LOG_INF(PLUGIN_NAME, "Recieved authorized-key check status %d for user %s", user_check_status, user_iter->user.name);
-
-						switch (key_check_status) {
-							case srpc_check_status_none:
-								SRPLG_LOG_ERR(PLUGIN_NAME, "Error occured while checking local user authorized key system values");
-								goto error_out;
-								break;
-							case srpc_check_status_error:
-								SRPLG_LOG_ERR(PLUGIN_NAME, "Error occured while checking local user authorized key system values");
-								goto error_out;
-								break;
-							case srpc_check_status_non_existant:
-								SRPLG_LOG_INF(PLUGIN_NAME, "Startup authorized keys don\'t exist on the system for user %s - storing authorized keys for user %s", user_iter->user.name, user_iter->user.name);
-								error = system_authentication_store_user_authorized_key(ctx, user_iter->user.name, user_iter->user.key_head);
-								if (error) {
-									SRPLG_LOG_ERR(PLUGIN_NAME, "system_authentication_store_user_authorized_key() error (%d) for user %s", error, user_iter->user.name);
-									goto error_out;
-								}
-								break;
-							case srpc_check_status_equal:
-								SRPLG_LOG_INF(PLUGIN_NAME, "Startup authorized keys already exist for local user %s - no need to store anything", user_iter->user.name);
-								break;
-							case srpc_check_status_partial:
-								// TODO
-								break;
-						}
-					}
-				}
-			}
-		}
-	}
-
-	goto out;
-
-error_out:
-	error = -1;
+	return system_dns_resolver_load_search(transaction->ctx, &transaction->dns_search);
+}
 
-out:
+static int system_running_reconcile_dns_search_apply(system_transaction_t *transaction)
+{
+	return system_dns_resolver_store_search(transaction->ctx, transaction->dns_search);
+}
 
-	// free temp values if interrupted
-	system_local_user_free(&temp_user);
-	system_authorized_key_free(&temp_key);
+static int system_running_reconcile_dns_server_prepare(system_transaction_t *transaction)
+{
+	return system_dns_resolver_load_server(transaction->ctx, &transaction->dns_servers);
+}
 
-	// free lists
-	system_local_user_list_free(&user_head);
-	system_local_user_list_free(&system_user_head);
-	system_local_user_list_free(&complement_user_head);
+static int system_running_reconcile_dns_server_apply(system_transaction_t *transaction)
+{
+	return system_dns_resolver_store_server(transaction->ctx, transaction->dns_servers);
+}
 
-	return error;
-}
\ No newline at end of file
+static bool system_running_reconcile_authentication_enabled(system_ctx_t *ctx)
+{
+	return system_features_check(ctx, "authentication") && system_features_check(ctx, "local-users");
+}
@@ -16,6 +16,6 @@
 #include <core/context.h>
 #include <core/common.h>
 
-int system_running_ds_store(system_ctx_t *ctx, sr_session_ctx_t *session);
+int system_running_ds_store(system_ctx_t *ctx, sr_session_ctx_t *session, uint32_t subsystems);
 
 #endif // SYSTEM_PLUGIN_DATASTORE_RUNNING_STORE_H
\ No newline at end of file
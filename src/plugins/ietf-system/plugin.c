@@ -12,7 +12,13 @@
  */
 #include "plugin.h"
 #include "core/common.h"
+#include "core/log.h"
+#include "core/backend.h"
 #include "core/context.h"
+#include "core/journal.h"
+#include "core/loop.h"
+#include "core/root.h"
+#include "core/trace.h"
 
 // stdlib
 #include <stdbool.h>
@@ -21,6 +27,7 @@
 #include <sysrepo.h>
 
 // libyang
+#include <libyang/context.h>
 #include <libyang/tree_data.h>
 
 #include "srpc/common.h"
@@ -31,6 +38,9 @@
 #include "datastore/running/load.h"
 #include "datastore/running/store.h"
 
+// out-of-band changes
+#include "watcher.h"
+
 // subs
 #include "core/subscription/change.h"
 #include "core/subscription/operational.h"
@@ -38,16 +48,36 @@
 
 #include <srpc.h>
 
+#include <stdlib.h>
+#include <string.h>
+
+static system_subscription_group_t system_subscription_change_group(const char *path);
+static sr_subscription_ctx_t **system_subscription_context(system_ctx_t *ctx, const char *grouping, system_subscription_group_t group);
+static bool system_subscription_module_installed(sr_session_ctx_t *session, const char *module);
+static int system_startup_check_subsystems(sr_session_ctx_t *startup_session, uint32_t *populated, uint32_t *empty);
+
+// configuration of each subsystem in the startup datastore - NTP servers are neither loaded from nor stored to the system
+#define SYSTEM_STARTUP_SUBSYSTEMS_XPATH SYSTEM_HOSTNAME_SUBSYSTEM_XPATH " | " SYSTEM_TIMEZONE_NAME_YANG_PATH " | " SYSTEM_DNS_RESOLVER_SUBSYSTEM_XPATH " | " SYSTEM_AUTHENTICATION_USER_YANG_PATH
+
+static const char *const system_startup_subsystem_xpaths[SYSTEM_SUBSYSTEM_COUNT] = {
+	[SYSTEM_SUBSYSTEM_HOSTNAME] = SYSTEM_HOSTNAME_SUBSYSTEM_XPATH,
+	[SYSTEM_SUBSYSTEM_CLOCK] = SYSTEM_TIMEZONE_NAME_YANG_PATH,
+	[SYSTEM_SUBSYSTEM_NTP] = NULL,
+	[SYSTEM_SUBSYSTEM_DNS_RESOLVER] = SYSTEM_DNS_RESOLVER_SUBSYSTEM_XPATH,
+	[SYSTEM_SUBSYSTEM_AUTHENTICATION] = SYSTEM_AUTHENTICATION_USER_YANG_PATH,
+};
+
 int sr_plugin_init_cb(sr_session_ctx_t *running_session, void **private_data)
 {
 	int error = 0;
 
-	bool empty_startup = false;
+	uint32_t populated = 0, empty = 0;
 
 	// sysrepo
 	sr_session_ctx_t *startup_session = NULL;
 	sr_conn_ctx_t *connection = NULL;
-	sr_subscription_ctx_t *subscription = NULL;
+	sr_subscription_ctx_t **subscription = NULL;
+	const char *grouping = getenv(SYSTEM_SUBSCRIPTION_GROUPS_ENV);
 
 	// plugin
 	system_ctx_t *ctx = NULL;
@@ -56,6 +86,22 @@ int sr_plugin_init_cb(sr_session_ctx_t *running_session, void **private_data)
 	ctx = malloc(sizeof(*ctx));
 	*ctx = (system_ctx_t){0};
 
+	// callbacks may run concurrently - guard the shared state
+	pthread_mutex_init(&ctx->startup_lock, NULL);
+	pthread_rwlock_init(&ctx->features_lock, NULL);
+
+	// the system files root and tracing are taken from the environment before any callback runs
+	system_root_init();
+	system_trace_init();
+
+	// backends are chosen once the root is known - a separate root uses only the file based ones
+	system_backend_init();
+
+	// a user change interrupted by a crash is completed before the system is loaded or compared with startup
+	if (system_journal_recover()) {
+		SRPLG_LOG_WRN(PLUGIN_NAME, "Unable to recover the journal - continuing without it");
+	}
+
 	*private_data = ctx;
 
 	// module changes
@@ -129,6 +175,14 @@ int sr_plugin_init_cb(sr_session_ctx_t *running_session, void **private_data)
 			SYSTEM_SHUTDOWN_RPC_YANG_PATH,
 			system_subscription_rpc_shutdown,
 		},
+		{
+			SYSTEM_STATS_SET_TRACE_RPC_YANG_PATH,
+			system_subscription_rpc_set_trace,
+		},
+		{
+			SYSTEM_STATS_DUMP_TRACE_RPC_YANG_PATH,
+			system_subscription_rpc_dump_trace,
+		},
 	};
 
 	// operational getters
@@ -143,6 +197,11 @@ int sr_plugin_init_cb(sr_session_ctx_t *running_session, void **private_data)
 			SYSTEM_STATE_CLOCK_YANG_PATH "/*",
 			system_subscription_operational_clock,
 		},
+		{
+			SYSTEM_STATS_YANG_MODULE,
+			SYSTEM_STATS_YANG_PATH,
+			system_subscription_operational_stats,
+		},
 	};
 
 	ctx->ietf_system_features = srpc_feature_status_hash_new();
@@ -162,12 +221,12 @@ int sr_plugin_init_cb(sr_session_ctx_t *running_session, void **private_data)
 		"dns-udp-tcp-port",
 	};
 
-	SRPLG_LOG_INF(PLUGIN_NAME, "Checking ietf-system YANG module used features");
+	SYSTEM_LOG_INF("Checking ietf-system YANG module used features");
 
 	for (size_t i = 0; i < ARRAY_SIZE(features); i++) {
 		const char *feature = features[i];
 
-		SRPLG_LOG_INF(PLUGIN_NAME, "ietf-system feature \"%s\" status = %s", feature, srpc_feature_status_hash_check(ctx->ietf_system_features, feature) ? "enabled" : "disabled");
+		SYSTEM_LOG_INF("ietf-system feature \"%s\" status = %s", feature, srpc_feature_status_hash_check(ctx->ietf_system_features, feature) ? "enabled" : "disabled");
 	}
 
 	connection = sr_session_get_connection(running_session);
@@ -179,42 +238,48 @@ int sr_plugin_init_cb(sr_session_ctx_t *running_session, void **private_data)
 
 	ctx->startup_session = startup_session;
 
-	error = srpc_check_empty_datastore(startup_session, SYSTEM_HOSTNAME_YANG_PATH, &empty_startup);
+	// a partially configured startup datastore is completed from the system and the configured subsystems are applied
+	error = system_startup_check_subsystems(startup_session, &populated, &empty);
 	if (error) {
 		SRPLG_LOG_ERR(PLUGIN_NAME, "Failed checking datastore contents: %d", error);
 		goto error_out;
 	}
 
-	if (empty_startup) {
-		SRPLG_LOG_INF(PLUGIN_NAME, "Running datastore is empty");
-		SRPLG_LOG_INF(PLUGIN_NAME, "Loading initial system data");
+	if (empty) {
+		SYSTEM_LOG_INF("Loading initial system data of the subsystems missing from the startup datastore");
 
 		// load data only into running DS - do not use startup unless said explicitly
-		error = system_running_ds_load(ctx, running_session);
+		error = system_running_ds_load(ctx, running_session, empty);
 		if (error) {
 			SRPLG_LOG_ERR(PLUGIN_NAME, "Error loading initial data into the running datastore... exiting");
 			goto error_out;
 		}
-	} else {
+	}
+
+	if (populated) {
 		// make sure the data from startup DS is stored in the system
-		SRPLG_LOG_INF(PLUGIN_NAME, "Running datastore contains data");
-		SRPLG_LOG_INF(PLUGIN_NAME, "Storing running datastore data in the system");
+		SYSTEM_LOG_INF("Storing startup datastore data of the configured subsystems in the system");
 
 		// check and apply if needed data from startup to the system
-		error = system_running_ds_store(ctx, startup_session);
+		error = system_running_ds_store(ctx, startup_session, populated);
 		if (error) {
 			SRPLG_LOG_ERR(PLUGIN_NAME, "Error applying initial data from startup datastore to the system... exiting");
 			goto error_out;
 		}
 	}
 
+	if (grouping && strcmp(grouping, "subsystem") && strcmp(grouping, "split") && strcmp(grouping, "single")) {
+		SRPLG_LOG_WRN(PLUGIN_NAME, "Unknown %s value \"%s\" - using \"subsystem\"", SYSTEM_SUBSCRIPTION_GROUPS_ENV, grouping);
+	}
+
 	// subscribe every module change
 	for (size_t i = 0; i < ARRAY_SIZE(module_changes); i++) {
 		const srpc_module_change_t *change = &module_changes[i];
 
 		// in case of work on a specific callback set it to NULL
 		if (change->cb) {
-			error = sr_module_change_subscribe(running_session, BASE_YANG_MODULE, change->path, change->cb, *private_data, 0, SR_SUBSCR_DEFAULT, &subscription);
+			subscription = system_subscription_context(ctx, grouping, system_subscription_change_group(change->path));
+			error = sr_module_change_subscribe(running_session, BASE_YANG_MODULE, change->path, change->cb, *private_data, 0, system_loop_subscr_options(), subscription);
 			if (error) {
 				SRPLG_LOG_ERR(PLUGIN_NAME, "sr_module_change_subscribe() error for \"%s\" (%d): %s", change->path, error, sr_strerror(error));
 				goto error_out;
@@ -222,13 +287,28 @@ int sr_plugin_init_cb(sr_session_ctx_t *running_session, void **private_data)
 		}
 	}
 
+	// cleartext passwords are replaced by their hashes before the edit reaches the change callbacks
+	subscription = system_subscription_context(ctx, grouping, SYSTEM_SUBSCRIPTION_GROUP_AUTHENTICATION);
+	error = sr_module_change_subscribe(running_session, BASE_YANG_MODULE, SYSTEM_AUTHENTICATION_USER_YANG_PATH "/password", system_subscription_update_authentication_user_password, *private_data, 0, SR_SUBSCR_UPDATE | system_loop_subscr_options(), subscription);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_module_change_subscribe() error for password hashing (%d): %s", error, sr_strerror(error));
+		goto error_out;
+	}
+
 	// subscribe every rpc
 	for (size_t i = 0; i < ARRAY_SIZE(rpcs); i++) {
 		const srpc_rpc_t *rpc = &rpcs[i];
 
+		// the trace rpcs are part of the optional stats module
+		if (rpc->cb && !strncmp(rpc->path, "/" SYSTEM_STATS_YANG_MODULE ":", sizeof(SYSTEM_STATS_YANG_MODULE) + 1) && !system_subscription_module_installed(running_session, SYSTEM_STATS_YANG_MODULE)) {
+			SRPLG_LOG_WRN(PLUGIN_NAME, "YANG module %s is not installed - not providing %s", SYSTEM_STATS_YANG_MODULE, rpc->path);
+			continue;
+		}
+
 		// in case of work on a specific callback set it to NULL
 		if (rpc->cb) {
-			error = sr_rpc_subscribe(running_session, rpc->path, rpc->cb, *private_data, 0, SR_SUBSCR_DEFAULT, &subscription);
+			subscription = system_subscription_context(ctx, grouping, SYSTEM_SUBSCRIPTION_GROUP_RPC);
+			error = sr_rpc_subscribe(running_session, rpc->path, rpc->cb, *private_data, 0, system_loop_subscr_options(), subscription);
 			if (error) {
 				SRPLG_LOG_ERR(PLUGIN_NAME, "sr_rpc_subscribe error (%d): %s", error, sr_strerror(error));
 				goto error_out;
@@ -240,9 +320,16 @@ int sr_plugin_init_cb(sr_session_ctx_t *running_session, void **private_data)
 	for (size_t i = 0; i < ARRAY_SIZE(oper); i++) {
 		const srpc_operational_t *op = &oper[i];
 
+		// the stats module is optional - without it the plugin works as before
+		if (op->cb && !system_subscription_module_installed(running_session, op->module)) {
+			SRPLG_LOG_WRN(PLUGIN_NAME, "YANG module %s is not installed - not providing %s", op->module, op->path);
+			continue;
+		}
+
 		// in case of work on a specific callback set it to NULL
 		if (op->cb) {
-			error = sr_oper_get_subscribe(running_session, BASE_YANG_MODULE, op->path, op->cb, NULL, SR_SUBSCR_DEFAULT, &subscription);
+			subscription = system_subscription_context(ctx, grouping, SYSTEM_SUBSCRIPTION_GROUP_OPERATIONAL);
+			error = sr_oper_get_subscribe(running_session, op->module, op->path, op->cb, NULL, system_loop_subscr_options(), subscription);
 			if (error) {
 				SRPLG_LOG_ERR(PLUGIN_NAME, "sr_oper_get_subscribe() error (%d): %s", error, sr_strerror(error));
 				goto error_out;
@@ -250,6 +337,21 @@ int sr_plugin_init_cb(sr_session_ctx_t *running_session, void **private_data)
 		}
 	}
 
+	// the standalone executable processes the subscription events in its own loop
+	for (size_t i = 0; system_loop_active() && i < ARRAY_SIZE(ctx->subscriptions); i++) {
+		if (ctx->subscriptions[i] && system_loop_add_subscription(ctx->subscriptions[i])) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to add subscription group %zu to the event loop", i);
+			goto error_out;
+		}
+	}
+
+	// keep running in sync with changes made to the system outside of sysrepo
+	error = system_watcher_start(ctx, connection);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_watcher_start() error (%d)", error);
+		goto error_out;
+	}
+
 	goto out;
 
 error_out:
@@ -264,9 +366,129 @@ void sr_plugin_cleanup_cb(sr_session_ctx_t *running_session, void *private_data)
 {
 	system_ctx_t *ctx = (system_ctx_t *) private_data;
 
+	// no callbacks may run while the context is being freed
+	for (size_t i = 0; i < ARRAY_SIZE(ctx->subscriptions); i++) {
+		if (ctx->subscriptions[i]) {
+			sr_unsubscribe(ctx->subscriptions[i]);
+			ctx->subscriptions[i] = NULL;
+		}
+	}
+
+	// stop the watcher next - it uses the rest of the context
+	system_watcher_stop(ctx);
+
 	if (ctx->ietf_system_features) {
 		srpc_feature_status_hash_free(&ctx->ietf_system_features);
 	}
 
+	pthread_rwlock_destroy(&ctx->features_lock);
+	pthread_mutex_destroy(&ctx->startup_lock);
+
 	free(ctx);
 }
+
+static system_subscription_group_t system_subscription_change_group(const char *path)
+{
+	const struct {
+		const char *prefix;
+		system_subscription_group_t group;
+	} groups[] = {
+		{SYSTEM_SYSTEM_CONTAINER_YANG_PATH "/ntp", SYSTEM_SUBSCRIPTION_GROUP_NTP},
+		{SYSTEM_SYSTEM_CONTAINER_YANG_PATH "/dns-resolver", SYSTEM_SUBSCRIPTION_GROUP_DNS_RESOLVER},
+		{SYSTEM_SYSTEM_CONTAINER_YANG_PATH "/authentication", SYSTEM_SUBSCRIPTION_GROUP_AUTHENTICATION},
+	};
+
+	for (size_t i = 0; i < ARRAY_SIZE(groups); i++) {
+		if (!strncmp(path, groups[i].prefix, strlen(groups[i].prefix))) {
+			return groups[i].group;
+		}
+	}
+
+	// contact, hostname, location and clock
+	return SYSTEM_SUBSCRIPTION_GROUP_BASICS;
+}
+
+static sr_subscription_ctx_t **system_subscription_context(system_ctx_t *ctx, const char *grouping, system_subscription_group_t group)
+{
+	if (grouping && !strcmp(grouping, "single")) {
+		group = SYSTEM_SUBSCRIPTION_GROUP_BASICS;
+	} else if (grouping && !strcmp(grouping, "split")) {
+		if (group != SYSTEM_SUBSCRIPTION_GROUP_OPERATIONAL && group != SYSTEM_SUBSCRIPTION_GROUP_RPC) {
+			group = SYSTEM_SUBSCRIPTION_GROUP_BASICS;
+		}
+	}
+
+	// a NULL context is created by the first subscription and gets its own handler thread
+	return &ctx->subscriptions[group];
+}
+
+static bool system_subscription_module_installed(sr_session_ctx_t *session, const char *module)
+{
+	sr_conn_ctx_t *connection = sr_session_get_connection(session);
+	const struct ly_ctx *ly_ctx = sr_acquire_context(connection);
+	bool installed = false;
+
+	if (ly_ctx) {
+		installed = ly_ctx_get_module_implemented(ly_ctx, module) != NULL;
+		sr_release_context(connection);
+	}
+
+	return installed;
+}
+
+static int system_startup_check_subsystems(sr_session_ctx_t *startup_session, uint32_t *populated, uint32_t *empty)
+{
+	int error = 0;
+	sr_data_t *startup = NULL;
+	struct ly_set *set = NULL;
+
+	*populated = 0;
+	*empty = 0;
+
+	// all subsystem roots are fetched at once - only the nodes themselves are needed, not the whole user list contents
+	error = sr_get_data(startup_session, SYSTEM_STARTUP_SUBSYSTEMS_XPATH, 1, 0, 0, &startup);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_get_data() error (%d): %s", error, sr_strerror(error));
+		goto error_out;
+	}
+
+	for (size_t i = 0; i < SYSTEM_SUBSYSTEM_COUNT; i++) {
+		if (!system_startup_subsystem_xpaths[i]) {
+			continue;
+		}
+
+		if (!startup || !startup->tree) {
+			*empty |= SYSTEM_SUBSYSTEM_MASK(i);
+			continue;
+		}
+
+		error = lyd_find_xpath(startup->tree, system_startup_subsystem_xpaths[i], &set);
+		if (error) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "lyd_find_xpath() error (%d) for %s", error, system_startup_subsystem_xpaths[i]);
+			goto error_out;
+		}
+
+		if (set->count) {
+			*populated |= SYSTEM_SUBSYSTEM_MASK(i);
+		} else {
+			*empty |= SYSTEM_SUBSYSTEM_MASK(i);
+		}
+
+		SYSTEM_LOG_INF("Startup datastore %s %s", set->count ? "configures" : "does not configure", system_startup_subsystem_xpaths[i]);
+
+		ly_set_free(set, NULL);
+		set = NULL;
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	if (startup) {
+		sr_release_data(startup);
+	}
+
+	return error;
+}
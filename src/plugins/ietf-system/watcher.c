@@ -0,0 +1,556 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "watcher.h"
+#include "core/common.h"
+#include "core/log.h"
+#include "core/context.h"
+#include "core/drift.h"
+#include "core/root.h"
+
+#include "datastore/running/load.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <pwd.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/limits.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+
+#include <sysrepo.h>
+#include <libyang/libyang.h>
+
+#ifdef SYSTEMD
+#include <systemd/sd-bus.h>
+#endif
+
+#define SYSTEM_WATCHER_ETC_DIRECTORY "/etc"
+#define SYSTEM_WATCHER_DIRECTORY_MASK (IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE)
+
+typedef struct system_watcher_ssh_s system_watcher_ssh_t;
+
+struct system_watcher_ssh_s {
+	int wd;
+	bool home; ///< ~/.ssh does not exist yet - the home directory is watched for its creation.
+};
+
+struct system_watcher_s {
+	system_ctx_t *ctx;
+	sr_session_ctx_t *session; ///< Running session with the drift originator name set.
+	pthread_t thread;
+	bool thread_started;
+	int inotify_fd;
+	int stop_fd;
+	int etc_wd;
+	system_watcher_ssh_t *ssh;
+	size_t ssh_count;
+	system_drift_schedule_t schedule; ///< Reloads of the subsystems with events.
+#ifdef SYSTEMD
+	sd_bus *bus;
+	sd_bus_slot *slot;
+#endif
+};
+
+// /etc files backing the subsystems
+static const struct {
+	const char *name;
+	system_subsystem_t subsystem;
+} system_watcher_etc_files[] = {
+	{"passwd", SYSTEM_SUBSYSTEM_AUTHENTICATION},
+	{"shadow", SYSTEM_SUBSYSTEM_AUTHENTICATION},
+	{"group", SYSTEM_SUBSYSTEM_AUTHENTICATION},
+	{"hostname", SYSTEM_SUBSYSTEM_HOSTNAME},
+	{"localtime", SYSTEM_SUBSYSTEM_CLOCK},
+	{"resolv.conf", SYSTEM_SUBSYSTEM_DNS_RESOLVER},
+};
+
+// running datastore nodes fully determined by the subsystem loaders
+static const char *const system_watcher_xpaths[SYSTEM_SUBSYSTEM_COUNT] = {
+	[SYSTEM_SUBSYSTEM_HOSTNAME] = SYSTEM_HOSTNAME_YANG_PATH,
+	[SYSTEM_SUBSYSTEM_CLOCK] = SYSTEM_TIMEZONE_NAME_YANG_PATH,
+	[SYSTEM_SUBSYSTEM_NTP] = NULL,
+	[SYSTEM_SUBSYSTEM_DNS_RESOLVER] = SYSTEM_DNS_RESOLVER_SEARCH_YANG_PATH " | " SYSTEM_DNS_RESOLVER_SERVER_YANG_PATH,
+	[SYSTEM_SUBSYSTEM_AUTHENTICATION] = SYSTEM_AUTHENTICATION_USER_YANG_PATH,
+};
+
+static void *system_watcher_thread(void *arg);
+static void system_watcher_mark(system_watcher_t *watcher, system_subsystem_t subsystem, int64_t delay);
+static void system_watcher_read_events(system_watcher_t *watcher);
+static void system_watcher_run_due(system_watcher_t *watcher);
+static int system_watcher_resync(system_watcher_t *watcher, system_subsystem_t subsystem);
+static int system_watcher_diff_to_edit(const struct ly_ctx *ly_ctx, const struct lyd_node *diff, struct lyd_node *edit);
+static void system_watcher_watch_ssh(system_watcher_t *watcher, const struct lyd_node *system_container_node);
+
+#ifdef SYSTEMD
+static int system_watcher_resolved_changed(sd_bus_message *m, void *userdata, sd_bus_error *ret_error);
+#endif
+
+int system_watcher_start(system_ctx_t *ctx, sr_conn_ctx_t *connection)
+{
+	int error = 0;
+	system_watcher_t *watcher = NULL;
+	char etc_path_buffer[PATH_MAX] = {0};
+
+	watcher = (system_watcher_t *) calloc(1, sizeof(system_watcher_t));
+	if (!watcher) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to allocate watcher");
+		goto error_out;
+	}
+
+	watcher->ctx = ctx;
+	watcher->inotify_fd = -1;
+	watcher->stop_fd = -1;
+	watcher->etc_wd = -1;
+
+	error = sr_session_start(connection, SR_DS_RUNNING, &watcher->session);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_session_start() error (%d): %s", error, sr_strerror(error));
+		goto error_out;
+	}
+
+	// change callbacks skip the edits made by the watcher
+	error = sr_session_set_orig_name(watcher->session, SYSTEM_DRIFT_ORIGINATOR);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_session_set_orig_name() error (%d): %s", error, sr_strerror(error));
+		goto error_out;
+	}
+
+	watcher->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	watcher->stop_fd = eventfd(0, EFD_CLOEXEC);
+	if (watcher->inotify_fd == -1 || watcher->stop_fd == -1) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to create watcher descriptors (%d)", errno);
+		goto error_out;
+	}
+
+	if (system_root_path(etc_path_buffer, sizeof(etc_path_buffer), SYSTEM_WATCHER_ETC_DIRECTORY)) {
+		goto error_out;
+	}
+
+	// account databases and /etc/localtime are replaced by rename - watch the directory instead of the files
+	watcher->etc_wd = inotify_add_watch(watcher->inotify_fd, etc_path_buffer, IN_ONLYDIR | SYSTEM_WATCHER_DIRECTORY_MASK);
+	if (watcher->etc_wd == -1) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "inotify_add_watch() failed (%d) for %s", errno, etc_path_buffer);
+		goto error_out;
+	}
+
+#ifdef SYSTEMD
+	// resolved keeps DNS settings in memory - follow its property changes
+	error = sd_bus_open_system(&watcher->bus);
+	if (error >= 0) {
+		error = sd_bus_match_signal(watcher->bus, &watcher->slot, SYSTEM_RESOLVED_SERVICE, SYSTEM_RESOLVED_OBJECT_PATH, "org.freedesktop.DBus.Properties", "PropertiesChanged", system_watcher_resolved_changed, watcher);
+	}
+	if (error < 0) {
+		SRPLG_LOG_WRN(PLUGIN_NAME, "Unable to watch systemd-resolved changes (%d) - DNS drift is detected only through %s/resolv.conf", error, etc_path_buffer);
+		watcher->slot = sd_bus_slot_unref(watcher->slot);
+		watcher->bus = sd_bus_flush_close_unref(watcher->bus);
+	}
+#endif
+
+	// the first authentication reload finds the ~/.ssh directories to watch
+	system_watcher_mark(watcher, SYSTEM_SUBSYSTEM_AUTHENTICATION, 0);
+
+	error = pthread_create(&watcher->thread, NULL, system_watcher_thread, watcher);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "pthread_create() error (%d)", error);
+		goto error_out;
+	}
+	watcher->thread_started = true;
+
+	ctx->watcher = watcher;
+
+	error = 0;
+	goto out;
+
+error_out:
+	error = -1;
+
+	if (watcher) {
+		ctx->watcher = watcher;
+		system_watcher_stop(ctx);
+	}
+
+out:
+	return error;
+}
+
+void system_watcher_stop(system_ctx_t *ctx)
+{
+	system_watcher_t *watcher = ctx->watcher;
+	uint64_t value = 1;
+
+	if (!watcher) {
+		return;
+	}
+
+	if (watcher->thread_started) {
+		if (write(watcher->stop_fd, &value, sizeof(value)) != sizeof(value)) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to stop the watcher thread (%d)", errno);
+		}
+		pthread_join(watcher->thread, NULL);
+	}
+
+#ifdef SYSTEMD
+	sd_bus_slot_unref(watcher->slot);
+	sd_bus_flush_close_unref(watcher->bus);
+#endif
+
+	if (watcher->inotify_fd != -1) {
+		close(watcher->inotify_fd);
+	}
+
+	if (watcher->stop_fd != -1) {
+		close(watcher->stop_fd);
+	}
+
+	if (watcher->session) {
+		sr_session_stop(watcher->session);
+	}
+
+	free(watcher->ssh);
+	free(watcher);
+
+	ctx->watcher = NULL;
+}
+
+static void *system_watcher_thread(void *arg)
+{
+	system_watcher_t *watcher = (system_watcher_t *) arg;
+	struct pollfd fds[3];
+	nfds_t fd_count = 0;
+
+	while (1) {
+		fds[0] = (struct pollfd){.fd = watcher->stop_fd, .events = POLLIN};
+		fds[1] = (struct pollfd){.fd = watcher->inotify_fd, .events = POLLIN};
+		fd_count = 2;
+
+#ifdef SYSTEMD
+		if (watcher->bus) {
+			// dispatch all queued messages before waiting on the bus descriptor again
+			while (sd_bus_process(watcher->bus, NULL) > 0)
+				;
+
+			fds[2] = (struct pollfd){.fd = sd_bus_get_fd(watcher->bus), .events = (short) sd_bus_get_events(watcher->bus)};
+			fd_count = 3;
+		}
+#endif
+
+		if (poll(fds, fd_count, system_drift_schedule_timeout(&watcher->schedule, system_drift_now_ms())) == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			SRPLG_LOG_ERR(PLUGIN_NAME, "poll() failed (%d) - stopping the watcher", errno);
+			break;
+		}
+
+		if (fds[0].revents) {
+			break;
+		}
+
+		if (fds[1].revents & POLLIN) {
+			system_watcher_read_events(watcher);
+		}
+
+		system_watcher_run_due(watcher);
+	}
+
+	return NULL;
+}
+
+static void system_watcher_mark(system_watcher_t *watcher, system_subsystem_t subsystem, int64_t delay)
+{
+	system_drift_schedule_mark(watcher->ctx, &watcher->schedule, subsystem, delay, system_drift_now_ms());
+}
+
+static void system_watcher_read_events(system_watcher_t *watcher)
+{
+	_Alignas(struct inotify_event) char buffer[4096];
+	ssize_t length = 0;
+
+	while ((length = read(watcher->inotify_fd, buffer, sizeof(buffer))) > 0) {
+		for (char *iter = buffer; iter < buffer + length;) {
+			const struct inotify_event *event = (const struct inotify_event *) (void *) iter;
+
+			iter += sizeof(struct inotify_event) + event->len;
+
+			if (event->mask & IN_Q_OVERFLOW) {
+				// events were lost - reload everything which is watched
+				system_watcher_mark(watcher, SYSTEM_SUBSYSTEM_HOSTNAME, SYSTEM_DRIFT_DEBOUNCE_MS);
+				system_watcher_mark(watcher, SYSTEM_SUBSYSTEM_CLOCK, SYSTEM_DRIFT_DEBOUNCE_MS);
+				system_watcher_mark(watcher, SYSTEM_SUBSYSTEM_DNS_RESOLVER, SYSTEM_DRIFT_DEBOUNCE_MS);
+				system_watcher_mark(watcher, SYSTEM_SUBSYSTEM_AUTHENTICATION, SYSTEM_DRIFT_DEBOUNCE_MS);
+				continue;
+			}
+
+			if (event->mask & IN_IGNORED) {
+				continue;
+			}
+
+			if (event->wd == watcher->etc_wd) {
+				for (size_t i = 0; event->len && i < ARRAY_SIZE(system_watcher_etc_files); i++) {
+					if (!strcmp(event->name, system_watcher_etc_files[i].name)) {
+						system_watcher_mark(watcher, system_watcher_etc_files[i].subsystem, SYSTEM_DRIFT_DEBOUNCE_MS);
+						break;
+					}
+				}
+				continue;
+			}
+
+			for (size_t i = 0; i < watcher->ssh_count; i++) {
+				if (watcher->ssh[i].wd != event->wd) {
+					continue;
+				}
+
+				// in home directories only the creation of ~/.ssh is of interest
+				if (!watcher->ssh[i].home || (event->len && !strcmp(event->name, ".ssh"))) {
+					system_watcher_mark(watcher, SYSTEM_SUBSYSTEM_AUTHENTICATION, SYSTEM_DRIFT_DEBOUNCE_MS);
+				}
+				break;
+			}
+		}
+	}
+}
+
+static void system_watcher_run_due(system_watcher_t *watcher)
+{
+	const int64_t now = system_drift_now_ms();
+
+	for (int i = 0; i < SYSTEM_SUBSYSTEM_COUNT; i++) {
+		if (!system_drift_schedule_take(watcher->ctx, &watcher->schedule, (system_subsystem_t) i, now)) {
+			continue;
+		}
+
+		if (system_watcher_resync(watcher, (system_subsystem_t) i)) {
+			SYSTEM_LOG_RATELIMITED(SR_LL_ERR, "Unable to synchronize subsystem %d with the running datastore", i);
+		}
+	}
+}
+
+static int system_watcher_resync(system_watcher_t *watcher, system_subsystem_t subsystem)
+{
+	int error = 0;
+	sr_conn_ctx_t *connection = sr_session_get_connection(watcher->session);
+	const struct ly_ctx *ly_ctx = NULL;
+	struct lyd_node *system_container_node = NULL;
+	struct lyd_node *diff = NULL;
+	sr_data_t *running = NULL;
+
+	if (!system_watcher_xpaths[subsystem]) {
+		goto out;
+	}
+
+	ly_ctx = sr_acquire_context(connection);
+	if (!ly_ctx) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to get ly_ctx variable");
+		goto error_out;
+	}
+
+	error = system_running_ds_load_subsystem(watcher->ctx, watcher->session, ly_ctx, subsystem, &system_container_node);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "system_running_ds_load_subsystem() error (%d)", error);
+		goto error_out;
+	}
+
+	if (subsystem == SYSTEM_SUBSYSTEM_AUTHENTICATION) {
+		system_watcher_watch_ssh(watcher, system_container_node);
+	}
+
+	error = sr_get_data(watcher->session, system_watcher_xpaths[subsystem], 0, 0, 0, &running);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_get_data() error (%d): %s", error, sr_strerror(error));
+		goto error_out;
+	}
+
+	error = lyd_diff_siblings(running ? running->tree : NULL, system_container_node, 0, &diff);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "lyd_diff_siblings() error (%d)", error);
+		goto error_out;
+	}
+
+	if (!diff) {
+		goto out;
+	}
+
+	SYSTEM_LOG_RATELIMITED(SR_LL_INF, "Out-of-band system change detected - updating %s", system_watcher_xpaths[subsystem]);
+
+	// merge the reloaded subtree and remove what disappeared from the system - sysrepo reports only the real changes
+	error = system_watcher_diff_to_edit(ly_ctx, diff, system_container_node);
+	if (error) {
+		goto error_out;
+	}
+
+	error = sr_edit_batch(watcher->session, system_container_node, "merge");
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_edit_batch() error (%d): %s", error, sr_strerror(error));
+		goto error_out;
+	}
+
+	error = sr_apply_changes(watcher->session, 0);
+	if (error) {
+		SRPLG_LOG_ERR(PLUGIN_NAME, "sr_apply_changes() error (%d): %s", error, sr_strerror(error));
+		sr_discard_changes(watcher->session);
+		goto error_out;
+	}
+
+	goto out;
+
+error_out:
+	error = -1;
+
+out:
+	if (diff) {
+		lyd_free_all(diff);
+	}
+
+	if (running) {
+		sr_release_data(running);
+	}
+
+	if (system_container_node) {
+		lyd_free_tree(system_container_node);
+	}
+
+	if (ly_ctx) {
+		sr_release_context(connection);
+	}
+
+	return error;
+}
+
+static int system_watcher_diff_to_edit(const struct ly_ctx *ly_ctx, const struct lyd_node *diff, struct lyd_node *edit)
+{
+	const struct lyd_node *iter = NULL;
+	struct lyd_node *node = NULL;
+	struct lyd_meta *meta = NULL;
+	const char *operation = NULL;
+	char *path = NULL;
+	int error = 0;
+
+	LY_LIST_FOR(diff, iter)
+	{
+		meta = lyd_find_meta(iter->meta, NULL, "yang:operation");
+		operation = meta ? lyd_get_meta_value(meta) : NULL;
+
+		if (operation && !strcmp(operation, "delete")) {
+			// node only in running - add it to the edit as removed
+			path = lyd_path(iter, LYD_PATH_STD, NULL, 0);
+			if (!path) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "lyd_path() failed");
+				return -1;
+			}
+
+			error = lyd_new_path(edit, NULL, path, (iter->schema->nodetype & LYS_LEAF) ? lyd_get_value(iter) : NULL, 0, &node);
+			if (!error) {
+				error = lyd_new_meta(ly_ctx, node, NULL, "ietf-netconf:operation", "remove", 0, NULL);
+			}
+			if (error) {
+				SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to remove %s (%d)", path, error);
+				free(path);
+				return -1;
+			}
+
+			free(path);
+		} else if (!operation || !strcmp(operation, "none")) {
+			// created or replaced nodes are already in the reloaded subtree - look for removals deeper only
+			if (system_watcher_diff_to_edit(ly_ctx, lyd_child(iter), edit)) {
+				return -1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+static void system_watcher_watch_ssh(system_watcher_t *watcher, const struct lyd_node *system_container_node)
+{
+	const struct lyd_node *authentication_node = NULL;
+	const struct lyd_node *user_iter = NULL;
+	char ssh_path_buffer[PATH_MAX] = {0};
+	char home_path_buffer[PATH_MAX] = {0};
+	char pw_buffer[4096] = {0};
+	struct passwd pw = {0};
+	system_watcher_ssh_t *ssh = NULL;
+	size_t ssh_count = 0;
+	int wd = -1;
+
+	// users come and go - rebuild the watch list on every authentication reload
+	for (size_t i = 0; i < watcher->ssh_count; i++) {
+		inotify_rm_watch(watcher->inotify_fd, watcher->ssh[i].wd);
+	}
+	free(watcher->ssh);
+	watcher->ssh = NULL;
+	watcher->ssh_count = 0;
+
+	LY_LIST_FOR(lyd_child(system_container_node), authentication_node)
+	{
+		if (!strcmp(LYD_NAME(authentication_node), "authentication")) {
+			break;
+		}
+	}
+
+	if (!authentication_node) {
+		return;
+	}
+
+	LY_LIST_FOR(lyd_child(authentication_node), user_iter)
+	{
+		if (strcmp(LYD_NAME(user_iter), "user")) {
+			continue;
+		}
+
+		// first child of the list instance is the name key
+		if (system_root_getpwnam(lyd_get_value(lyd_child(user_iter)), &pw, pw_buffer, sizeof(pw_buffer))) {
+			continue;
+		}
+
+		if (system_root_path(home_path_buffer, sizeof(home_path_buffer), pw.pw_dir) || snprintf(ssh_path_buffer, sizeof(ssh_path_buffer), "%s/.ssh", home_path_buffer) >= (int) sizeof(ssh_path_buffer)) {
+			continue;
+		}
+
+		ssh = (system_watcher_ssh_t *) realloc(watcher->ssh, (ssh_count + 1) * sizeof(system_watcher_ssh_t));
+		if (!ssh) {
+			SRPLG_LOG_ERR(PLUGIN_NAME, "Unable to allocate ~/.ssh watch list");
+			break;
+		}
+		watcher->ssh = ssh;
+
+		// both directories are owned by the user - a symlink planted there must not redirect the watch elsewhere
+		wd = inotify_add_watch(watcher->inotify_fd, ssh_path_buffer, IN_ONLYDIR | IN_DONT_FOLLOW | SYSTEM_WATCHER_DIRECTORY_MASK);
+		if (wd != -1) {
+			watcher->ssh[ssh_count++] = (system_watcher_ssh_t){.wd = wd, .home = false};
+			continue;
+		}
+
+		wd = inotify_add_watch(watcher->inotify_fd, home_path_buffer, IN_ONLYDIR | IN_DONT_FOLLOW | IN_CREATE | IN_MOVED_TO);
+		if (wd != -1) {
+			watcher->ssh[ssh_count++] = (system_watcher_ssh_t){.wd = wd, .home = true};
+		}
+	}
+
+	watcher->ssh_count = ssh_count;
+}
+
+#ifdef SYSTEMD
+static int system_watcher_resolved_changed(sd_bus_message *m, void *userdata, sd_bus_error *ret_error)
+{
+	system_watcher_t *watcher = (system_watcher_t *) userdata;
+
+	system_watcher_mark(watcher, SYSTEM_SUBSYSTEM_DNS_RESOLVER, SYSTEM_DRIFT_DEBOUNCE_MS);
+
+	return 0;
+}
+#endif
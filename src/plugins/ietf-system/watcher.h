@@ -0,0 +1,27 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_WATCHER_H
+#define SYSTEM_PLUGIN_WATCHER_H
+
+#include <core/context.h>
+
+/**
+ * Start a thread which watches the system files backing the running datastore (/etc/passwd, /etc/shadow,
+ * /etc/group, /etc/hostname, /etc/localtime, /etc/resolv.conf and ~/.ssh of every user) and, with systemd,
+ * systemd-resolved property changes. Changes made outside of the plugin are pushed into running as a minimal edit
+ * of the affected subsystem only.
+ */
+int system_watcher_start(system_ctx_t *ctx, sr_conn_ctx_t *connection);
+void system_watcher_stop(system_ctx_t *ctx);
+
+#endif // SYSTEM_PLUGIN_WATCHER_H
@@ -0,0 +1,114 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "core/common.h"
+#include "core/ssh/base64.h"
+#include "core/ssh/key_index.h"
+#include "core/ssh/sha256.h"
+
+#include <linux/limits.h>
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * sshd AuthorizedKeysCommand helper - prints the authorized_keys line of the offered key for the given user.
+ *
+ * sshd_config:
+ *     AuthorizedKeysCommand /usr/local/bin/ietf-system-authorized-keys %u %f
+ *     AuthorizedKeysCommandUser nobody
+ *
+ * The key can also be given as type and base64 blob (%u %t %k) in which case the fingerprint is computed here.
+ */
+
+static int get_fingerprint(int argc, char **argv, uint8_t fingerprint[SYSTEM_SHA256_DIGEST_LENGTH]);
+static int check_username(const char *username);
+
+int main(int argc, char **argv)
+{
+	int error = 0;
+	char path_buffer[PATH_MAX] = {0};
+	uint8_t fingerprint[SYSTEM_SHA256_DIGEST_LENGTH] = {0};
+	system_ssh_key_index_t index = {0};
+	const char *line = NULL;
+	size_t line_length = 0;
+
+	if (argc != 3 && argc != 4) {
+		fprintf(stderr, "Usage: %s <user> <SHA256:fingerprint>\n       %s <user> <key-type> <key-base64>\n", argv[0], argv[0]);
+		return 1;
+	}
+
+	if (check_username(argv[1]) || get_fingerprint(argc, argv, fingerprint)) {
+		// unknown user or malformed key - nothing to authorize
+		return 0;
+	}
+
+	if (snprintf(path_buffer, sizeof(path_buffer), "%s/%s.idx", SYSTEM_AUTHENTICATION_KEY_INDEX_DIRECTORY, argv[1]) >= (int) sizeof(path_buffer)) {
+		return 0;
+	}
+
+	error = system_ssh_key_index_open(&index, path_buffer);
+	if (error) {
+		// no keys configured for the user
+		return 0;
+	}
+
+	line = system_ssh_key_index_find(&index, fingerprint, &line_length);
+	if (line) {
+		fwrite(line, 1, line_length, stdout);
+		if (line[line_length - 1] != '\n') {
+			fputc('\n', stdout);
+		}
+	}
+
+	system_ssh_key_index_close(&index);
+
+	return 0;
+}
+
+static int get_fingerprint(int argc, char **argv, uint8_t fingerprint[SYSTEM_SHA256_DIGEST_LENGTH])
+{
+	static const char prefix[] = "SHA256:";
+	static uint8_t blob_buffer[16384];
+	size_t length = 0;
+
+	if (argc == 3) {
+		// fingerprint as printed by OpenSSH - unpadded base64 of the SHA256 digest
+		if (strncmp(argv[2], prefix, sizeof(prefix) - 1)) {
+			return -1;
+		}
+
+		if (system_base64_decode(argv[2] + sizeof(prefix) - 1, strlen(argv[2]) - (sizeof(prefix) - 1), fingerprint, SYSTEM_SHA256_DIGEST_LENGTH, &length) || length != SYSTEM_SHA256_DIGEST_LENGTH) {
+			return -1;
+		}
+
+		return 0;
+	}
+
+	// key type and blob
+	if (system_base64_decode(argv[3], strlen(argv[3]), blob_buffer, sizeof(blob_buffer), &length) || !length) {
+		return -1;
+	}
+
+	system_sha256(blob_buffer, length, fingerprint);
+
+	return 0;
+}
+
+static int check_username(const char *username)
+{
+	// the username is used as a file name - reject anything which could escape the index directory
+	if (!*username || !strcmp(username, ".") || !strcmp(username, "..") || strchr(username, '/')) {
+		return -1;
+	}
+
+	return 0;
+}
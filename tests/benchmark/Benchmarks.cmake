@@ -0,0 +1,49 @@
+#
+# telekom / sysrepo-plugin-system
+#
+# This program is made available under the terms of the
+# BSD 3-Clause license which is available at
+# https://opensource.org/licenses/BSD-3-Clause
+#
+# SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+# SPDX-FileContributor: Sartura Ltd.
+#
+# SPDX-License-Identifier: BSD-3-Clause
+#
+add_executable(
+    system_benchmark
+
+    ${CMAKE_SOURCE_DIR}/tests/benchmark/bench.c
+    ${CMAKE_SOURCE_DIR}/tests/benchmark/system_benchmark.c
+)
+
+target_link_libraries(
+    system_benchmark
+
+    ${PLUGIN_CORE_LIBRARY_NAME}
+    ${SYSREPO_LIBRARIES}
+    ${LIBYANG_LIBRARIES}
+    ${SRPC_LIBRARIES}
+    ${UMGMT_LIBRARIES}
+    ${SYSTEMD_LIBRARIES}
+    Threads::Threads
+    m
+)
+
+# make benchmark - results of the whole suite in benchmark.json of the build directory
+add_custom_target(
+    benchmark
+
+    COMMAND system_benchmark --output ${CMAKE_BINARY_DIR}/benchmark.json
+    DEPENDS system_benchmark
+    WORKING_DIRECTORY ${CMAKE_BINARY_DIR}
+)
+
+# make benchmark-dns - DNS backend against the resolved mock on a private bus, results in benchmark-dns.json
+add_custom_target(
+    benchmark-dns
+
+    COMMAND ${RESOLVED_MOCK_RUN} $<TARGET_FILE:resolved_mock> --latency-ms ${RESOLVED_MOCK_LATENCY_MS} -- $<TARGET_FILE:system_benchmark> --filter dns/ --output ${CMAKE_BINARY_DIR}/benchmark-dns.json
+    DEPENDS system_benchmark resolved_mock
+    WORKING_DIRECTORY ${CMAKE_BINARY_DIR}
+)
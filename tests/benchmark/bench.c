@@ -0,0 +1,191 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "bench.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// upper bound of the batch size for operations which are faster than the clock resolution allows to measure
+#define SYSTEM_BENCH_MAX_BATCH ((size_t) 1 << 24)
+
+static double system_bench_now_ns(void);
+static int system_bench_sample(const system_bench_t *bench, void *state, size_t batch, double *ns);
+static int system_bench_calibrate(const system_bench_t *bench, void *state, double sample_ms, size_t *batch);
+static int system_bench_double_cmp(const void *d1, const void *d2);
+static double system_bench_percentile(const double *sorted, size_t count, double p);
+
+int system_bench_run(const system_bench_t *benches, size_t count, const system_bench_options_t *options, FILE *out)
+{
+	int error = 0;
+	double *samples = NULL;
+	char date_buffer[32] = {0};
+	char host_buffer[256] = {0};
+	const time_t now = time(NULL);
+	struct tm tm = {0};
+	bool first = true;
+
+	samples = (double *) calloc(options->repetitions, sizeof(double));
+	if (!samples) {
+		return -1;
+	}
+
+	gmtime_r(&now, &tm);
+	strftime(date_buffer, sizeof(date_buffer), "%Y-%m-%dT%H:%M:%SZ", &tm);
+	gethostname(host_buffer, sizeof(host_buffer) - 1);
+
+	fprintf(out, "{\n\t\"context\": {\"date\": \"%s\", \"host\": \"%s\", \"warmup\": %zu, \"repetitions\": %zu, \"sample_ms\": %.3f},\n\t\"benchmarks\": [", date_buffer, host_buffer, options->warmup, options->repetitions, options->sample_ms);
+
+	for (size_t i = 0; i < count; i++) {
+		const system_bench_t *bench = &benches[i];
+		void *state = NULL;
+		size_t batch = 1;
+		double sum = 0, mean = 0, variance = 0;
+		const char *failure = NULL;
+
+		if (options->filter && !strstr(bench->name, options->filter)) {
+			continue;
+		}
+
+		fprintf(stderr, "%s\n", bench->name);
+
+		if (bench->setup && bench->setup(&state)) {
+			failure = "setup failed";
+			goto bench_out;
+		}
+
+		if (system_bench_calibrate(bench, state, options->sample_ms, &batch)) {
+			failure = "run failed";
+			goto bench_out;
+		}
+
+		for (size_t j = 0; j < options->warmup + options->repetitions; j++) {
+			double ns = 0;
+
+			if (system_bench_sample(bench, state, batch, &ns)) {
+				failure = "run failed";
+				goto bench_out;
+			}
+
+			if (j >= options->warmup) {
+				samples[j - options->warmup] = ns / (double) batch;
+			}
+		}
+
+		qsort(samples, options->repetitions, sizeof(double), system_bench_double_cmp);
+
+		for (size_t j = 0; j < options->repetitions; j++) {
+			sum += samples[j];
+		}
+		mean = sum / (double) options->repetitions;
+
+		for (size_t j = 0; j < options->repetitions; j++) {
+			variance += (samples[j] - mean) * (samples[j] - mean);
+		}
+		if (options->repetitions > 1) {
+			variance /= (double) (options->repetitions - 1);
+		}
+
+	bench_out:
+		fprintf(out, "%s\n\t\t{\"name\": \"%s\", ", first ? "" : ",", bench->name);
+		if (failure) {
+			fprintf(out, "\"error\": \"%s\"}", failure);
+			fprintf(stderr, "%s: %s\n", bench->name, failure);
+			error = -1;
+		} else {
+			fprintf(out, "\"unit\": \"ns\", \"batch\": %zu, \"samples\": %zu, \"min\": %.1f, \"p50\": %.1f, \"p90\": %.1f, \"p99\": %.1f, \"max\": %.1f, \"mean\": %.1f, \"stddev\": %.1f}", batch, options->repetitions, samples[0], system_bench_percentile(samples, options->repetitions, 0.5), system_bench_percentile(samples, options->repetitions, 0.9), system_bench_percentile(samples, options->repetitions, 0.99), samples[options->repetitions - 1], mean, sqrt(variance));
+		}
+		first = false;
+
+		if (bench->teardown) {
+			bench->teardown(state);
+		}
+	}
+
+	fprintf(out, "\n\t]\n}\n");
+
+	free(samples);
+
+	return error;
+}
+
+static double system_bench_now_ns(void)
+{
+	struct timespec ts = {0};
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (double) ts.tv_sec * 1e9 + (double) ts.tv_nsec;
+}
+
+static int system_bench_sample(const system_bench_t *bench, void *state, size_t batch, double *ns)
+{
+	const double start = system_bench_now_ns();
+
+	for (size_t i = 0; i < batch; i++) {
+		if (bench->run(state)) {
+			return -1;
+		}
+	}
+
+	*ns = system_bench_now_ns() - start;
+
+	return 0;
+}
+
+static int system_bench_calibrate(const system_bench_t *bench, void *state, double sample_ms, size_t *batch)
+{
+	const double target_ns = sample_ms * 1e6;
+	double ns = 0;
+
+	// double the batch until one sample takes long enough to be well above the timer overhead
+	*batch = 1;
+	while (1) {
+		if (system_bench_sample(bench, state, *batch, &ns)) {
+			return -1;
+		}
+
+		if (ns >= target_ns || *batch >= SYSTEM_BENCH_MAX_BATCH) {
+			break;
+		}
+
+		*batch *= 2;
+	}
+
+	return 0;
+}
+
+static int system_bench_double_cmp(const void *d1, const void *d2)
+{
+	const double v1 = *(const double *) d1;
+	const double v2 = *(const double *) d2;
+
+	return (v1 > v2) - (v1 < v2);
+}
+
+static double system_bench_percentile(const double *sorted, size_t count, double p)
+{
+	// linear interpolation between the closest ranks
+	const double rank = p * (double) (count - 1);
+	const size_t lower = (size_t) rank;
+	const double fraction = rank - (double) lower;
+
+	if (lower + 1 >= count) {
+		return sorted[count - 1];
+	}
+
+	return sorted[lower] + fraction * (sorted[lower + 1] - sorted[lower]);
+}
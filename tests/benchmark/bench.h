@@ -0,0 +1,46 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef SYSTEM_PLUGIN_BENCH_H
+#define SYSTEM_PLUGIN_BENCH_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+typedef struct system_bench_s system_bench_t;
+typedef struct system_bench_options_s system_bench_options_t;
+
+/**
+ * One measured operation. run() is called repeatedly and has to leave the state as it found it (or in an
+ * equivalent state), so that every call measures the same amount of work.
+ */
+struct system_bench_s {
+	const char *name;
+	int (*setup)(void **state);
+	int (*run)(void *state);
+	void (*teardown)(void *state);
+};
+
+struct system_bench_options_s {
+	size_t warmup; ///< Samples taken and thrown away before measuring.
+	size_t repetitions; ///< Measured samples per benchmark.
+	double sample_ms; ///< Target duration of one sample - the batch of run() calls is sized to reach it.
+	const char *filter; ///< Only benchmarks whose name contains the string are run.
+};
+
+/**
+ * Run all benchmarks and write the results as JSON into the given file. Each sample times a batch of run() calls;
+ * the reported statistics are per call.
+ */
+int system_bench_run(const system_bench_t *benches, size_t count, const system_bench_options_t *options, FILE *out);
+
+#endif // SYSTEM_PLUGIN_BENCH_H
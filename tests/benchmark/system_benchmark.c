@@ -0,0 +1,821 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "bench.h"
+
+// stdlib
+#include <errno.h>
+#include <ftw.h>
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/limits.h>
+#include <sys/stat.h>
+
+#include <sysrepo.h>
+#include <srpc.h>
+#include <utlist.h>
+
+// plugin code
+#include "core/common.h"
+#include "core/context.h"
+#include "core/root.h"
+
+// system API
+#include "core/api/system/check.h"
+#include "core/api/system/store.h"
+#include "core/api/system/authentication/check.h"
+#include "core/api/system/authentication/load.h"
+#include "core/api/system/authentication/store.h"
+#include "core/api/system/authentication/txn.h"
+#include "core/api/system/dns_resolver/load.h"
+#include "core/api/system/dns_resolver/store.h"
+
+// data
+#include "core/data/system/ntp/server.h"
+#include "core/data/system/ntp/server/list.h"
+#include "core/data/system/dns_resolver/search.h"
+#include "core/data/system/dns_resolver/search/list.h"
+#include "core/data/system/dns_resolver/server.h"
+#include "core/data/system/dns_resolver/server/list.h"
+#include "core/data/system/ip_address.h"
+#include "core/data/system/authentication/local_user.h"
+#include "core/data/system/authentication/local_user/list.h"
+#include "core/data/system/authentication/authorized_key.h"
+#include "core/data/system/authentication/authorized_key/list.h"
+
+#define SYSTEM_BENCH_LIST_SIZE 100
+#define SYSTEM_BENCH_USER_COUNT 1000
+#define SYSTEM_BENCH_KEY_COUNT 100
+#define SYSTEM_BENCH_USER "bench"
+#define SYSTEM_BENCH_HOME_COUNT 10
+#define SYSTEM_BENCH_DNS_COUNT 10
+#define SYSTEM_BENCH_DNS_BENCHES 4
+
+// set by tests/resolved-mock/run.sh - resolve1 calls are served by the mock
+#define SYSTEM_BENCH_RESOLVED_MOCK_ENV "SYSTEM_RESOLVED_MOCK"
+
+// encoded ssh-ed25519 blob - 4 + 11 + 4 + 32 bytes
+#define SYSTEM_BENCH_KEY_DATA_SIZE 72
+
+typedef struct system_bench_keys_s system_bench_keys_t;
+
+struct system_bench_keys_s {
+	system_authorized_key_element_t *heads[2]; ///< Two key sets differing in one key - stores alternate between them.
+	size_t next;
+};
+
+#ifdef SYSTEMD
+typedef struct system_bench_dns_s system_bench_dns_t;
+
+struct system_bench_dns_s {
+	system_dns_search_element_t *search_head;
+	system_dns_server_element_t *server_head;
+};
+#endif
+
+// setup and teardown
+static int system_bench_root_create(char *root);
+static void system_bench_root_remove(const char *root);
+static int system_bench_remove_entry(const char *path, const struct stat *st, int type, struct FTW *ftw);
+static int system_bench_write_file(const char *path, const char *content);
+static void system_bench_key_data(size_t index, char buffer[SYSTEM_BENCH_KEY_DATA_SIZE]);
+static int system_bench_key_list(system_authorized_key_element_t **head, size_t first);
+
+// data
+static int system_bench_ntp_server_list_setup(void **state);
+static int system_bench_ntp_server_list_add_remove(void *state);
+static int system_bench_ntp_server_list_find(void *state);
+static void system_bench_ntp_server_list_teardown(void *state);
+static int system_bench_ntp_server_set_word(void *state);
+static int system_bench_dns_search_list_setup(void **state);
+static int system_bench_dns_search_list_add_remove(void *state);
+static void system_bench_dns_search_list_teardown(void *state);
+static int system_bench_local_user_list_setup(void **state);
+static int system_bench_local_user_list_find(void *state);
+static void system_bench_local_user_list_teardown(void *state);
+static int system_bench_authorized_key_list_setup(void **state);
+static int system_bench_authorized_key_list_add_remove(void *state);
+static void system_bench_authorized_key_list_teardown(void *state);
+static int system_bench_authorized_key_set_data(void *state);
+
+// system API against the sandbox root
+static int system_bench_check_hostname(void *state);
+static int system_bench_check_timezone_name(void *state);
+static int system_bench_store_hostname(void *state);
+static int system_bench_store_timezone_name(void *state);
+static int system_bench_keys_setup(void **state);
+static int system_bench_load_user_authorized_key(void *state);
+static int system_bench_check_user_authorized_key(void *state);
+static int system_bench_store_user_authorized_key(void *state);
+static void system_bench_keys_teardown(void *state);
+static int system_bench_homes_setup(void **state);
+static int system_bench_commit_user_homes(void *state);
+static void system_bench_homes_teardown(void *state);
+
+#ifdef SYSTEMD
+// DNS backend against the resolved mock
+static int system_bench_dns_setup(void **state);
+static int system_bench_dns_load_search(void *state);
+static int system_bench_dns_load_server(void *state);
+static int system_bench_dns_store_search(void *state);
+static int system_bench_dns_store_server(void *state);
+static void system_bench_dns_teardown(void *state);
+#endif
+
+static system_ctx_t system_bench_ctx = {0};
+
+int main(int argc, char **argv)
+{
+	int error = 0;
+	char root[PATH_MAX] = "/tmp/sysrepo-plugin-system-bench-XXXXXX";
+	FILE *out = stdout;
+	const char *output = NULL;
+	int opt = 0;
+	size_t bench_count = 0;
+	system_bench_options_t options = {
+		.warmup = 3,
+		.repetitions = 30,
+		.sample_ms = 5.0,
+		.filter = NULL,
+	};
+	const struct option long_options[] = {
+		{"warmup", required_argument, NULL, 'w'},
+		{"repetitions", required_argument, NULL, 'r'},
+		{"sample-ms", required_argument, NULL, 's'},
+		{"filter", required_argument, NULL, 'f'},
+		{"output", required_argument, NULL, 'o'},
+		{NULL, 0, NULL, 0},
+	};
+	const system_bench_t benches[] = {
+		{"data/ntp_server_list/add_remove/100", system_bench_ntp_server_list_setup, system_bench_ntp_server_list_add_remove, system_bench_ntp_server_list_teardown},
+		{"data/ntp_server_list/find/100", system_bench_ntp_server_list_setup, system_bench_ntp_server_list_find, system_bench_ntp_server_list_teardown},
+		{"data/ntp_server/set_word", NULL, system_bench_ntp_server_set_word, NULL},
+		{"data/dns_search_list/add_remove/100", system_bench_dns_search_list_setup, system_bench_dns_search_list_add_remove, system_bench_dns_search_list_teardown},
+		{"data/local_user_list/find/1000", system_bench_local_user_list_setup, system_bench_local_user_list_find, system_bench_local_user_list_teardown},
+		{"data/authorized_key_list/add_remove/100", system_bench_authorized_key_list_setup, system_bench_authorized_key_list_add_remove, system_bench_authorized_key_list_teardown},
+		{"data/authorized_key/set_data", NULL, system_bench_authorized_key_set_data, NULL},
+		{"api/check_hostname", NULL, system_bench_check_hostname, NULL},
+		{"api/check_timezone_name", NULL, system_bench_check_timezone_name, NULL},
+		{"api/store_hostname", NULL, system_bench_store_hostname, NULL},
+		{"api/store_timezone_name", NULL, system_bench_store_timezone_name, NULL},
+		{"api/load_user_authorized_key/100", system_bench_keys_setup, system_bench_load_user_authorized_key, system_bench_keys_teardown},
+		{"api/check_user_authorized_key/100", system_bench_keys_setup, system_bench_check_user_authorized_key, system_bench_keys_teardown},
+		{"api/store_user_authorized_key/100", system_bench_keys_setup, system_bench_store_user_authorized_key, system_bench_keys_teardown},
+		{"api/commit_user_homes/10", system_bench_homes_setup, system_bench_commit_user_homes, system_bench_homes_teardown},
+#ifdef SYSTEMD
+		// keep last - skipped unless the resolved mock is running
+		{"dns/load_search/10", system_bench_dns_setup, system_bench_dns_load_search, system_bench_dns_teardown},
+		{"dns/load_server/10", system_bench_dns_setup, system_bench_dns_load_server, system_bench_dns_teardown},
+		{"dns/store_search/10", system_bench_dns_setup, system_bench_dns_store_search, system_bench_dns_teardown},
+		{"dns/store_server/10", system_bench_dns_setup, system_bench_dns_store_server, system_bench_dns_teardown},
+#endif
+	};
+
+	while ((opt = getopt_long(argc, argv, "w:r:s:f:o:", long_options, NULL)) != -1) {
+		switch (opt) {
+			case 'w':
+				options.warmup = strtoul(optarg, NULL, 10);
+				break;
+			case 'r':
+				options.repetitions = strtoul(optarg, NULL, 10);
+				break;
+			case 's':
+				options.sample_ms = strtod(optarg, NULL);
+				break;
+			case 'f':
+				options.filter = optarg;
+				break;
+			case 'o':
+				output = optarg;
+				break;
+			default:
+				fprintf(stderr, "Usage: %s [--warmup N] [--repetitions N] [--sample-ms MS] [--filter NAME] [--output FILE]\n", argv[0]);
+				return EXIT_FAILURE;
+		}
+	}
+
+	if (!options.repetitions) {
+		fprintf(stderr, "At least one repetition is needed\n");
+		return EXIT_FAILURE;
+	}
+
+	// only the plugin errors are of interest
+	sr_log_stderr(SR_LL_ERR);
+
+	// the system API works on a provisioned sandbox instead of the live system
+	if (system_bench_root_create(root)) {
+		fprintf(stderr, "Unable to create the sandbox root\n");
+		error = -1;
+		goto out;
+	}
+
+	if (output) {
+		out = fopen(output, "w");
+		if (!out) {
+			fprintf(stderr, "Unable to open %s (%d)\n", output, errno);
+			error = -1;
+			goto out;
+		}
+	}
+
+	bench_count = ARRAY_SIZE(benches);
+
+#ifdef SYSTEMD
+	// the DNS backend talks to resolved - never benchmark against the one of the host
+	if (!getenv(SYSTEM_BENCH_RESOLVED_MOCK_ENV)) {
+		bench_count -= SYSTEM_BENCH_DNS_BENCHES;
+	}
+#endif
+
+	error = system_bench_run(benches, bench_count, &options, out);
+
+out:
+	if (out && out != stdout) {
+		fclose(out);
+	}
+
+	system_root_set(NULL);
+
+	// mkdtemp() replaces the template - nothing to remove if it failed
+	if (strcmp(root + strlen(root) - 6, "XXXXXX")) {
+		system_bench_root_remove(root);
+	}
+
+	return error ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+static int system_bench_root_create(char *root)
+{
+	char path_buffer[PATH_MAX] = {0};
+	char passwd_buffer[256] = {0};
+	const char *directories[] = {
+		"/etc",
+		"/etc/skel",
+		"/home",
+		"/home/" SYSTEM_BENCH_USER,
+		"/usr",
+		"/usr/share",
+		SYSTEM_TIMEZONE_DIR,
+		SYSTEM_TIMEZONE_DIR "/Europe",
+		"/var",
+		"/var/lib",
+	};
+	const char *skel[] = {
+		"/etc/skel/.bashrc",
+		"/etc/skel/.profile",
+	};
+	const char *zones[] = {
+		SYSTEM_TIMEZONE_DIR "/Europe/Ljubljana",
+		SYSTEM_TIMEZONE_DIR "/Europe/Zagreb",
+	};
+
+	if (!mkdtemp(root) || system_root_set(root)) {
+		return -1;
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(directories); i++) {
+		if (system_root_path(path_buffer, sizeof(path_buffer), directories[i]) || mkdir(path_buffer, 0755)) {
+			return -1;
+		}
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(skel); i++) {
+		if (system_root_path(path_buffer, sizeof(path_buffer), skel[i]) || system_bench_write_file(path_buffer, "# bench\n")) {
+			return -1;
+		}
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(zones); i++) {
+		if (system_root_path(path_buffer, sizeof(path_buffer), zones[i]) || system_bench_write_file(path_buffer, "TZif")) {
+			return -1;
+		}
+	}
+
+	// the bench user is owned by whoever runs the benchmark
+	snprintf(passwd_buffer, sizeof(passwd_buffer), "root:x:0:0:root:/root:/bin/bash\n" SYSTEM_BENCH_USER ":x:%u:%u::/home/" SYSTEM_BENCH_USER ":/bin/bash\n", (unsigned int) getuid(), (unsigned int) getgid());
+	if (system_root_path(path_buffer, sizeof(path_buffer), SYSTEM_AUTHENTICATION_PASSWD_PATH) || system_bench_write_file(path_buffer, passwd_buffer)) {
+		return -1;
+	}
+
+	if (system_store_hostname(&system_bench_ctx, "bench") || system_store_timezone_name(&system_bench_ctx, "Europe/Ljubljana")) {
+		return -1;
+	}
+
+	return 0;
+}
+
+static int system_bench_remove_entry(const char *path, const struct stat *st, int type, struct FTW *ftw)
+{
+	return remove(path);
+}
+
+static void system_bench_root_remove(const char *root)
+{
+	nftw(root, system_bench_remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+static int system_bench_write_file(const char *path, const char *content)
+{
+	FILE *file = fopen(path, "w");
+
+	if (!file) {
+		return -1;
+	}
+
+	fputs(content, file);
+
+	return fclose(file);
+}
+
+static void system_bench_key_data(size_t index, char buffer[SYSTEM_BENCH_KEY_DATA_SIZE])
+{
+	static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	uint8_t blob[51] = {0, 0, 0, 11, 's', 's', 'h', '-', 'e', 'd', '2', '5', '5', '1', '9', 0, 0, 0, 32};
+	size_t out = 0;
+
+	// distinct public key per index - the content is irrelevant, only the fingerprints have to differ
+	for (size_t i = 0; i < 32; i++) {
+		blob[19 + i] = (uint8_t) ((index >> ((i % 4) * 8)) ^ (i * 37));
+	}
+
+	for (size_t i = 0; i < sizeof(blob); i += 3) {
+		const uint32_t triple = (uint32_t) blob[i] << 16 | (uint32_t) blob[i + 1] << 8 | blob[i + 2];
+
+		buffer[out++] = alphabet[(triple >> 18) & 0x3f];
+		buffer[out++] = alphabet[(triple >> 12) & 0x3f];
+		buffer[out++] = alphabet[(triple >> 6) & 0x3f];
+		buffer[out++] = alphabet[triple & 0x3f];
+	}
+
+	buffer[out] = 0;
+}
+
+static int system_bench_key_list(system_authorized_key_element_t **head, size_t first)
+{
+	char name_buffer[32] = {0};
+	char data_buffer[SYSTEM_BENCH_KEY_DATA_SIZE] = {0};
+	system_authorized_key_t key = {0};
+	int error = 0;
+
+	system_authorized_key_list_init(head);
+
+	for (size_t i = first; !error && i < first + SYSTEM_BENCH_KEY_COUNT; i++) {
+		snprintf(name_buffer, sizeof(name_buffer), "key-%zu", i);
+		system_bench_key_data(i, data_buffer);
+
+		system_authorized_key_init(&key);
+		error = system_authorized_key_set_name(&key, name_buffer) || system_authorized_key_set_algorithm(&key, "ssh-ed25519") || system_authorized_key_set_data(&key, data_buffer) || system_authorized_key_list_add(head, key);
+		system_authorized_key_free(&key);
+	}
+
+	return error ? -1 : 0;
+}
+
+static int system_bench_ntp_server_list_setup(void **state)
+{
+	system_ntp_server_element_t **head = (system_ntp_server_element_t **) calloc(1, sizeof(system_ntp_server_element_t *));
+	char name_buffer[32] = {0};
+	system_ntp_server_t server = {0};
+	int error = 0;
+
+	if (!head) {
+		return -1;
+	}
+
+	for (size_t i = 0; !error && i < SYSTEM_BENCH_LIST_SIZE; i++) {
+		snprintf(name_buffer, sizeof(name_buffer), "ntp%zu.example.com", i);
+		system_ntp_server_init(&server);
+		error = system_ntp_server_set_word(&server, name_buffer) || system_ntp_server_list_add(head, server);
+		system_ntp_server_free(&server);
+	}
+
+	*state = head;
+
+	return error ? -1 : 0;
+}
+
+static int system_bench_ntp_server_list_add_remove(void *state)
+{
+	system_ntp_server_element_t **head = (system_ntp_server_element_t **) state;
+	system_ntp_server_t server = {0};
+	int error = 0;
+
+	system_ntp_server_init(&server);
+	error = system_ntp_server_set_word(&server, "extra.example.com:123") || system_ntp_server_list_add(head, server) || system_ntp_server_list_remove(head, "extra.example.com:123");
+	system_ntp_server_free(&server);
+
+	return error ? -1 : 0;
+}
+
+static int system_bench_ntp_server_list_find(void *state)
+{
+	system_ntp_server_element_t **head = (system_ntp_server_element_t **) state;
+
+	// the last element - the whole list is walked
+	return system_ntp_server_list_find(*head, "ntp99.example.com") ? 0 : -1;
+}
+
+static void system_bench_ntp_server_list_teardown(void *state)
+{
+	system_ntp_server_element_t **head = (system_ntp_server_element_t **) state;
+
+	if (head) {
+		system_ntp_server_list_free(head);
+		free(head);
+	}
+}
+
+static int system_bench_ntp_server_set_word(void *state)
+{
+	system_ntp_server_t server = {0};
+	int error = 0;
+
+	system_ntp_server_init(&server);
+	error = system_ntp_server_set_word(&server, "0.pool.ntp.org:123");
+	system_ntp_server_free(&server);
+
+	return error;
+}
+
+static int system_bench_dns_search_list_setup(void **state)
+{
+	system_dns_search_element_t **head = (system_dns_search_element_t **) calloc(1, sizeof(system_dns_search_element_t *));
+	char domain_buffer[32] = {0};
+	system_dns_search_t search = {0};
+	int error = 0;
+
+	if (!head) {
+		return -1;
+	}
+
+	for (size_t i = 0; !error && i < SYSTEM_BENCH_LIST_SIZE; i++) {
+		snprintf(domain_buffer, sizeof(domain_buffer), "domain%zu.example.com", i);
+		system_dns_search_init(&search);
+		error = system_dns_search_set_domain(&search, domain_buffer) || system_dns_search_list_add(head, search);
+		system_dns_search_free(&search);
+	}
+
+	*state = head;
+
+	return error ? -1 : 0;
+}
+
+static int system_bench_dns_search_list_add_remove(void *state)
+{
+	system_dns_search_element_t **head = (system_dns_search_element_t **) state;
+	system_dns_search_t search = {
+		.domain = "extra.example.com",
+	};
+
+	if (system_dns_search_list_add(head, search)) {
+		return -1;
+	}
+
+	return system_dns_search_list_remove(head, search.domain);
+}
+
+static void system_bench_dns_search_list_teardown(void *state)
+{
+	system_dns_search_element_t **head = (system_dns_search_element_t **) state;
+
+	if (head) {
+		system_dns_search_list_free(head);
+		free(head);
+	}
+}
+
+static int system_bench_local_user_list_setup(void **state)
+{
+	system_local_user_element_t **head = (system_local_user_element_t **) calloc(1, sizeof(system_local_user_element_t *));
+	char name_buffer[32] = {0};
+	system_local_user_t user = {0};
+	int error = 0;
+
+	if (!head) {
+		return -1;
+	}
+
+	for (size_t i = 0; !error && i < SYSTEM_BENCH_USER_COUNT; i++) {
+		snprintf(name_buffer, sizeof(name_buffer), "user%zu", i);
+		system_local_user_init(&user);
+		error = system_local_user_set_name(&user, name_buffer) || system_local_user_list_add(head, user);
+		system_local_user_free(&user);
+	}
+
+	*state = head;
+
+	return error ? -1 : 0;
+}
+
+static int system_bench_local_user_list_find(void *state)
+{
+	system_local_user_element_t **head = (system_local_user_element_t **) state;
+
+	return system_local_user_list_find(*head, "user999") ? 0 : -1;
+}
+
+static void system_bench_local_user_list_teardown(void *state)
+{
+	system_local_user_element_t **head = (system_local_user_element_t **) state;
+
+	if (head) {
+		system_local_user_list_free(head);
+		free(head);
+	}
+}
+
+static int system_bench_authorized_key_list_setup(void **state)
+{
+	system_authorized_key_element_t **head = (system_authorized_key_element_t **) calloc(1, sizeof(system_authorized_key_element_t *));
+
+	if (!head) {
+		return -1;
+	}
+
+	*state = head;
+
+	return system_bench_key_list(head, 0);
+}
+
+static int system_bench_authorized_key_list_add_remove(void *state)
+{
+	system_authorized_key_element_t **head = (system_authorized_key_element_t **) state;
+
+	// the first element is re-added at the end - the list keeps its size and content
+	system_authorized_key_t key = (*head)->key;
+
+	key.name = "extra";
+	if (system_authorized_key_list_add(head, key)) {
+		return -1;
+	}
+
+	return system_authorized_key_list_remove(head, "extra");
+}
+
+static void system_bench_authorized_key_list_teardown(void *state)
+{
+	system_authorized_key_element_t **head = (system_authorized_key_element_t **) state;
+
+	if (head) {
+		system_authorized_key_list_free(head);
+		free(head);
+	}
+}
+
+static int system_bench_authorized_key_set_data(void *state)
+{
+	char data_buffer[SYSTEM_BENCH_KEY_DATA_SIZE] = {0};
+	system_authorized_key_t key = {0};
+	int error = 0;
+
+	system_bench_key_data(1, data_buffer);
+
+	system_authorized_key_init(&key);
+	error = system_authorized_key_set_data(&key, data_buffer);
+	system_authorized_key_free(&key);
+
+	return error;
+}
+
+static int system_bench_check_hostname(void *state)
+{
+	return system_check_hostname(&system_bench_ctx, "bench") == srpc_check_status_error ? -1 : 0;
+}
+
+static int system_bench_check_timezone_name(void *state)
+{
+	return system_check_timezone_name(&system_bench_ctx, "Europe/Ljubljana") == srpc_check_status_error ? -1 : 0;
+}
+
+static int system_bench_store_hostname(void *state)
+{
+	static size_t count = 0;
+
+	return system_store_hostname(&system_bench_ctx, (count++ % 2) ? "bench" : "bench-other");
+}
+
+static int system_bench_store_timezone_name(void *state)
+{
+	static size_t count = 0;
+
+	return system_store_timezone_name(&system_bench_ctx, (count++ % 2) ? "Europe/Ljubljana" : "Europe/Zagreb");
+}
+
+static int system_bench_keys_setup(void **state)
+{
+	system_bench_keys_t *keys = (system_bench_keys_t *) calloc(1, sizeof(system_bench_keys_t));
+
+	if (!keys) {
+		return -1;
+	}
+
+	*state = keys;
+
+	// the second set replaces the first key with a new one
+	if (system_bench_key_list(&keys->heads[0], 0) || system_bench_key_list(&keys->heads[1], 1)) {
+		return -1;
+	}
+
+	return system_authentication_store_user_authorized_key(&system_bench_ctx, SYSTEM_BENCH_USER, keys->heads[0]);
+}
+
+static int system_bench_load_user_authorized_key(void *state)
+{
+	system_authorized_key_element_t *head = NULL;
+	int error = 0;
+
+	error = system_authentication_load_user_authorized_key(&system_bench_ctx, SYSTEM_BENCH_USER, NULL, &head);
+	system_authorized_key_list_free(&head);
+
+	return error;
+}
+
+static int system_bench_check_user_authorized_key(void *state)
+{
+	system_bench_keys_t *keys = (system_bench_keys_t *) state;
+
+	return system_authentication_check_user_authorized_key(&system_bench_ctx, SYSTEM_BENCH_USER, keys->heads[0]) == srpc_check_status_equal ? 0 : -1;
+}
+
+static int system_bench_store_user_authorized_key(void *state)
+{
+	system_bench_keys_t *keys = (system_bench_keys_t *) state;
+
+	// alternate the key sets - every call rewrites authorized_keys and the index
+	return system_authentication_store_user_authorized_key(&system_bench_ctx, SYSTEM_BENCH_USER, keys->heads[++keys->next % 2]);
+}
+
+static void system_bench_keys_teardown(void *state)
+{
+	system_bench_keys_t *keys = (system_bench_keys_t *) state;
+
+	if (keys) {
+		system_authorized_key_list_free(&keys->heads[0]);
+		system_authorized_key_list_free(&keys->heads[1]);
+		free(keys);
+	}
+}
+
+static int system_bench_homes_setup(void **state)
+{
+	system_authentication_txn_t *txn = (system_authentication_txn_t *) calloc(1, sizeof(system_authentication_txn_t));
+	system_authentication_txn_user_t *user = NULL;
+	char name_buffer[32] = {0};
+
+	if (!txn) {
+		return -1;
+	}
+
+	*state = txn;
+
+	// users as left by add_user - the accounts themselves can not be written under a root, only their homes
+	for (size_t i = 0; i < SYSTEM_BENCH_HOME_COUNT; i++) {
+		user = (system_authentication_txn_user_t *) calloc(1, sizeof(system_authentication_txn_user_t));
+		if (!user) {
+			return -1;
+		}
+
+		LL_APPEND(txn->created, user);
+
+		snprintf(name_buffer, sizeof(name_buffer), SYSTEM_BENCH_USER "-home-%zu", i);
+		user->name = strdup(name_buffer);
+		if (!user->name) {
+			return -1;
+		}
+
+		user->uid = getuid();
+		user->gid = getgid();
+	}
+
+	return 0;
+}
+
+static int system_bench_commit_user_homes(void *state)
+{
+	system_authentication_txn_t *txn = (system_authentication_txn_t *) state;
+	int error = 0;
+
+	// the home directories with /etc/skel are created by one commit and removed by the next, both journaled
+	error = system_authentication_txn_commit(txn);
+
+	txn->deleted = txn->created;
+	txn->created = NULL;
+
+	if (!error) {
+		error = system_authentication_txn_commit(txn);
+	}
+
+	txn->created = txn->deleted;
+	txn->deleted = NULL;
+
+	return error;
+}
+
+static void system_bench_homes_teardown(void *state)
+{
+	system_authentication_txn_t *txn = (system_authentication_txn_t *) state;
+
+	if (txn) {
+		system_authentication_txn_free(txn);
+		free(txn);
+	}
+}
+
+#ifdef SYSTEMD
+static int system_bench_dns_setup(void **state)
+{
+	system_bench_dns_t *dns = (system_bench_dns_t *) calloc(1, sizeof(system_bench_dns_t));
+	char buffer[32] = {0};
+	system_dns_search_t search = {0};
+	system_dns_server_t server = {0};
+	int error = 0;
+
+	if (!dns) {
+		return -1;
+	}
+
+	*state = dns;
+
+	for (size_t i = 0; !error && i < SYSTEM_BENCH_DNS_COUNT; i++) {
+		snprintf(buffer, sizeof(buffer), "domain%zu.example.com", i);
+		system_dns_search_init(&search);
+		error = system_dns_search_set_domain(&search, buffer) || system_dns_search_list_add(&dns->search_head, search);
+		system_dns_search_free(&search);
+		if (error) {
+			break;
+		}
+
+		snprintf(buffer, sizeof(buffer), "192.0.2.%zu", i + 1);
+		system_dns_server_init(&server);
+		error = system_dns_server_set_name(&server, buffer) || system_ip_address_from_str(&server.address, buffer) || system_dns_server_list_add(&dns->server_head, server);
+		system_dns_server_free(&server);
+	}
+
+	if (error) {
+		return -1;
+	}
+
+	// loads read back what was stored
+	return system_dns_resolver_store_search(&system_bench_ctx, dns->search_head) || system_dns_resolver_store_server(&system_bench_ctx, dns->server_head) ? -1 : 0;
+}
+
+static int system_bench_dns_load_search(void *state)
+{
+	system_dns_search_element_t *head = NULL;
+	int error = 0;
+
+	error = system_dns_resolver_load_search(&system_bench_ctx, &head);
+	system_dns_search_list_free(&head);
+
+	return error;
+}
+
+static int system_bench_dns_load_server(void *state)
+{
+	system_dns_server_element_t *head = NULL;
+	int error = 0;
+
+	error = system_dns_resolver_load_server(&system_bench_ctx, &head);
+	system_dns_server_list_free(&head);
+
+	return error;
+}
+
+static int system_bench_dns_store_search(void *state)
+{
+	system_bench_dns_t *dns = (system_bench_dns_t *) state;
+
+	return system_dns_resolver_store_search(&system_bench_ctx, dns->search_head);
+}
+
+static int system_bench_dns_store_server(void *state)
+{
+	system_bench_dns_t *dns = (system_bench_dns_t *) state;
+
+	return system_dns_resolver_store_server(&system_bench_ctx, dns->server_head);
+}
+
+static void system_bench_dns_teardown(void *state)
+{
+	system_bench_dns_t *dns = (system_bench_dns_t *) state;
+
+	if (dns) {
+		system_dns_search_list_free(&dns->search_head);
+		system_dns_server_list_free(&dns->server_head);
+		free(dns);
+	}
+}
+#endif
@@ -0,0 +1,27 @@
+#
+# telekom / sysrepo-plugin-system
+#
+# This program is made available under the terms of the
+# BSD 3-Clause license which is available at
+# https://opensource.org/licenses/BSD-3-Clause
+#
+# SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+# SPDX-FileContributor: Sartura Ltd.
+#
+# SPDX-License-Identifier: BSD-3-Clause
+#
+add_executable(
+    resolved_mock
+
+    ${CMAKE_SOURCE_DIR}/tests/resolved-mock/resolved_mock.c
+)
+
+target_link_libraries(
+    resolved_mock
+
+    ${SYSTEMD_LIBRARIES}
+)
+
+# per-call latency of the mock used by the targets running against it
+set(RESOLVED_MOCK_LATENCY_MS 0 CACHE STRING "Latency of every resolved mock reply in milliseconds")
+set(RESOLVED_MOCK_RUN ${CMAKE_SOURCE_DIR}/tests/resolved-mock/run.sh)
@@ -0,0 +1,608 @@
+/*
+ * telekom / sysrepo-plugin-system
+ *
+ * This program is made available under the terms of the
+ * BSD 3-Clause license which is available at
+ * https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Minimal stand-in for systemd-resolved: owns org.freedesktop.resolve1 on the system bus (normally a private one, see
+ * run.sh) and implements the part of the Manager interface used by the plugin - the DNS and Domains properties and
+ * the SetLinkDNS and SetLinkDomains methods. Every reply is delayed by a configurable latency so that the plugin DNS
+ * backend can be load tested without root or systemd.
+ *
+ * The org.freedesktop.resolve1.Mock interface on the same object exposes call counters (GetCalls), allows changing
+ * the latency at runtime (SetLatency) and clears all state (Reset).
+ */
+#include <errno.h>
+#include <getopt.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/socket.h>
+
+#include <systemd/sd-bus.h>
+#include <systemd/sd-event.h>
+
+#include "core/common.h"
+
+#define RESOLVED_MOCK_INTERFACE "org.freedesktop.resolve1.Mock"
+#define RESOLVED_MOCK_PROPERTIES_INTERFACE "org.freedesktop.DBus.Properties"
+#define RESOLVED_MOCK_LATENCY_ENV "RESOLVED_MOCK_LATENCY_MS"
+
+typedef struct resolved_mock_dns_s resolved_mock_dns_t;
+typedef struct resolved_mock_domain_s resolved_mock_domain_t;
+typedef struct resolved_mock_s resolved_mock_t;
+
+struct resolved_mock_dns_s {
+	int ifindex;
+	int family;
+	uint8_t address[16];
+	size_t length;
+};
+
+struct resolved_mock_domain_s {
+	int ifindex;
+	char *domain;
+	int route_only;
+};
+
+struct resolved_mock_s {
+	sd_event *event;
+	sd_bus *bus;
+	uint64_t latency_usec;
+
+	resolved_mock_dns_t *dns;
+	size_t dns_count;
+	resolved_mock_domain_t *domains;
+	size_t domain_count;
+
+	// number of handled calls - read by tests through the Mock interface
+	uint64_t get_calls;
+	uint64_t set_dns_calls;
+	uint64_t set_domains_calls;
+};
+
+static int resolved_mock_handle(sd_bus_message *msg, void *userdata, sd_bus_error *ret_error);
+static int resolved_mock_get(resolved_mock_t *mock, sd_bus_message *msg, sd_bus_error *ret_error, sd_bus_message *reply);
+static int resolved_mock_set_dns(resolved_mock_t *mock, sd_bus_message *msg, sd_bus_error *ret_error);
+static int resolved_mock_set_domains(resolved_mock_t *mock, sd_bus_message *msg, sd_bus_error *ret_error);
+static int resolved_mock_reply(resolved_mock_t *mock, sd_bus_message *reply);
+static int resolved_mock_reply_send(sd_event_source *source, uint64_t usec, void *userdata);
+static int resolved_mock_exit(sd_event_source *source, const struct signalfd_siginfo *si, void *userdata);
+static void resolved_mock_changed(resolved_mock_t *mock, const char *property);
+static void resolved_mock_reset(resolved_mock_t *mock);
+
+int main(int argc, char **argv)
+{
+	int error = 0;
+	resolved_mock_t mock = {0};
+	const char *ready_file = NULL;
+	const char *latency_env = getenv(RESOLVED_MOCK_LATENCY_ENV);
+	FILE *ready = NULL;
+	sigset_t signals;
+	int opt = 0;
+	const struct option long_options[] = {
+		{"latency-ms", required_argument, NULL, 'l'},
+		{"ready-file", required_argument, NULL, 'r'},
+		{NULL, 0, NULL, 0},
+	};
+
+	if (latency_env) {
+		mock.latency_usec = strtoull(latency_env, NULL, 10) * 1000;
+	}
+
+	while ((opt = getopt_long(argc, argv, "l:r:", long_options, NULL)) != -1) {
+		switch (opt) {
+			case 'l':
+				mock.latency_usec = strtoull(optarg, NULL, 10) * 1000;
+				break;
+			case 'r':
+				ready_file = optarg;
+				break;
+			default:
+				fprintf(stderr, "Usage: %s [--latency-ms MS] [--ready-file FILE]\n", argv[0]);
+				return EXIT_FAILURE;
+		}
+	}
+
+	// signals are handled by the event loop
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGTERM);
+	sigaddset(&signals, SIGINT);
+	sigprocmask(SIG_BLOCK, &signals, NULL);
+
+	error = sd_event_default(&mock.event);
+	if (error < 0) {
+		fprintf(stderr, "sd_event_default() error: %s\n", strerror(-error));
+		goto out;
+	}
+
+	error = sd_event_add_signal(mock.event, NULL, SIGTERM, resolved_mock_exit, NULL);
+	if (error >= 0) {
+		error = sd_event_add_signal(mock.event, NULL, SIGINT, resolved_mock_exit, NULL);
+	}
+	if (error < 0) {
+		fprintf(stderr, "sd_event_add_signal() error: %s\n", strerror(-error));
+		goto out;
+	}
+
+	// DBUS_SYSTEM_BUS_ADDRESS selects the bus - the same variable the plugin follows
+	error = sd_bus_open_system(&mock.bus);
+	if (error < 0) {
+		fprintf(stderr, "sd_bus_open_system() error: %s\n", strerror(-error));
+		goto out;
+	}
+
+	error = sd_bus_add_object(mock.bus, NULL, SYSTEM_RESOLVED_OBJECT_PATH, resolved_mock_handle, &mock);
+	if (error < 0) {
+		fprintf(stderr, "sd_bus_add_object() error: %s\n", strerror(-error));
+		goto out;
+	}
+
+	error = sd_bus_request_name(mock.bus, SYSTEM_RESOLVED_SERVICE, 0);
+	if (error < 0) {
+		fprintf(stderr, "Unable to acquire %s: %s\n", SYSTEM_RESOLVED_SERVICE, strerror(-error));
+		goto out;
+	}
+
+	error = sd_bus_attach_event(mock.bus, mock.event, 0);
+	if (error < 0) {
+		fprintf(stderr, "sd_bus_attach_event() error: %s\n", strerror(-error));
+		goto out;
+	}
+
+	// the name is owned - clients can start calling
+	if (ready_file) {
+		ready = fopen(ready_file, "w");
+		if (!ready) {
+			fprintf(stderr, "Unable to create %s (%d)\n", ready_file, errno);
+			error = -1;
+			goto out;
+		}
+		fclose(ready);
+	}
+
+	error = sd_event_loop(mock.event);
+	if (error < 0) {
+		fprintf(stderr, "sd_event_loop() error: %s\n", strerror(-error));
+	}
+
+out:
+	resolved_mock_reset(&mock);
+	sd_bus_flush_close_unref(mock.bus);
+	sd_event_unref(mock.event);
+
+	return error < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+static int resolved_mock_handle(sd_bus_message *msg, void *userdata, sd_bus_error *ret_error)
+{
+	int error = 0;
+	resolved_mock_t *mock = userdata;
+	sd_bus_message *reply = NULL;
+
+	if (sd_bus_message_is_method_call(msg, RESOLVED_MOCK_PROPERTIES_INTERFACE, "Get")) {
+		error = sd_bus_message_new_method_return(msg, &reply);
+		if (error >= 0) {
+			error = resolved_mock_get(mock, msg, ret_error, reply);
+		}
+	} else if (sd_bus_message_is_method_call(msg, SYSTEM_RESOLVED_MANAGER_INTERFACE, "SetLinkDNS")) {
+		error = resolved_mock_set_dns(mock, msg, ret_error);
+		if (error >= 0) {
+			error = sd_bus_message_new_method_return(msg, &reply);
+		}
+	} else if (sd_bus_message_is_method_call(msg, SYSTEM_RESOLVED_MANAGER_INTERFACE, "SetLinkDomains")) {
+		error = resolved_mock_set_domains(mock, msg, ret_error);
+		if (error >= 0) {
+			error = sd_bus_message_new_method_return(msg, &reply);
+		}
+	} else if (sd_bus_message_is_method_call(msg, RESOLVED_MOCK_INTERFACE, "GetCalls")) {
+		// control calls are answered right away - they are not part of the measured traffic
+		return sd_bus_reply_method_return(msg, "ttt", mock->get_calls, mock->set_dns_calls, mock->set_domains_calls);
+	} else if (sd_bus_message_is_method_call(msg, RESOLVED_MOCK_INTERFACE, "SetLatency")) {
+		uint64_t latency_ms = 0;
+
+		error = sd_bus_message_read(msg, "t", &latency_ms);
+		if (error < 0) {
+			return error;
+		}
+		mock->latency_usec = latency_ms * 1000;
+		return sd_bus_reply_method_return(msg, "");
+	} else if (sd_bus_message_is_method_call(msg, RESOLVED_MOCK_INTERFACE, "Reset")) {
+		resolved_mock_reset(mock);
+		return sd_bus_reply_method_return(msg, "");
+	} else {
+		// unknown method - let sd-bus answer
+		return 0;
+	}
+
+	if (error < 0) {
+		sd_bus_message_unref(reply);
+		return error;
+	}
+
+	return resolved_mock_reply(mock, reply);
+}
+
+static int resolved_mock_get(resolved_mock_t *mock, sd_bus_message *msg, sd_bus_error *ret_error, sd_bus_message *reply)
+{
+	int error = 0;
+	const char *interface = NULL;
+	const char *property = NULL;
+
+	error = sd_bus_message_read(msg, "ss", &interface, &property);
+	if (error < 0) {
+		return error;
+	}
+
+	mock->get_calls++;
+
+	if (strcmp(interface, SYSTEM_RESOLVED_MANAGER_INTERFACE)) {
+		return sd_bus_error_setf(ret_error, SD_BUS_ERROR_UNKNOWN_PROPERTY, "Unknown interface %s", interface);
+	}
+
+	if (!strcmp(property, "DNS")) {
+		error = sd_bus_message_open_container(reply, 'v', "a(iiay)");
+		if (error < 0) {
+			return error;
+		}
+
+		error = sd_bus_message_open_container(reply, 'a', "(iiay)");
+		if (error < 0) {
+			return error;
+		}
+
+		for (size_t i = 0; i < mock->dns_count; i++) {
+			error = sd_bus_message_open_container(reply, 'r', "iiay");
+			if (error < 0) {
+				return error;
+			}
+
+			error = sd_bus_message_append(reply, "ii", mock->dns[i].ifindex, mock->dns[i].family);
+			if (error < 0) {
+				return error;
+			}
+
+			error = sd_bus_message_append_array(reply, 'y', mock->dns[i].address, mock->dns[i].length);
+			if (error < 0) {
+				return error;
+			}
+
+			error = sd_bus_message_close_container(reply);
+			if (error < 0) {
+				return error;
+			}
+		}
+	} else if (!strcmp(property, "Domains")) {
+		error = sd_bus_message_open_container(reply, 'v', "a(isb)");
+		if (error < 0) {
+			return error;
+		}
+
+		error = sd_bus_message_open_container(reply, 'a', "(isb)");
+		if (error < 0) {
+			return error;
+		}
+
+		for (size_t i = 0; i < mock->domain_count; i++) {
+			error = sd_bus_message_append(reply, "(isb)", mock->domains[i].ifindex, mock->domains[i].domain, mock->domains[i].route_only);
+			if (error < 0) {
+				return error;
+			}
+		}
+	} else {
+		return sd_bus_error_setf(ret_error, SD_BUS_ERROR_UNKNOWN_PROPERTY, "Unknown property %s", property);
+	}
+
+	// close the array and the variant
+	error = sd_bus_message_close_container(reply);
+	if (error < 0) {
+		return error;
+	}
+
+	return sd_bus_message_close_container(reply);
+}
+
+static int resolved_mock_set_dns(resolved_mock_t *mock, sd_bus_message *msg, sd_bus_error *ret_error)
+{
+	int error = 0;
+	int ifindex = 0;
+	resolved_mock_dns_t *entries = NULL;
+	size_t entry_count = 0;
+	size_t kept = 0;
+	resolved_mock_dns_t *tmp = NULL;
+
+	mock->set_dns_calls++;
+
+	error = sd_bus_message_read(msg, "i", &ifindex);
+	if (error < 0) {
+		goto error_out;
+	}
+
+	error = sd_bus_message_enter_container(msg, 'a', "(iay)");
+	if (error < 0) {
+		goto error_out;
+	}
+
+	// parse the whole request before touching the state - a rejected call changes nothing
+	for (;;) {
+		int family = 0;
+		const void *address = NULL;
+		size_t length = 0;
+
+		error = sd_bus_message_enter_container(msg, 'r', "iay");
+		if (error < 0) {
+			goto error_out;
+		}
+		if (error == 0) {
+			break;
+		}
+
+		error = sd_bus_message_read(msg, "i", &family);
+		if (error < 0) {
+			goto error_out;
+		}
+
+		error = sd_bus_message_read_array(msg, 'y', &address, &length);
+		if (error < 0) {
+			goto error_out;
+		}
+
+		if (!((family == AF_INET && length == 4) || (family == AF_INET6 && length == 16))) {
+			error = sd_bus_error_setf(ret_error, SD_BUS_ERROR_INVALID_ARGS, "Invalid address of family %d and length %zu", family, length);
+			goto error_out;
+		}
+
+		error = sd_bus_message_exit_container(msg);
+		if (error < 0) {
+			goto error_out;
+		}
+
+		tmp = realloc(entries, sizeof(*entries) * (entry_count + 1));
+		if (!tmp) {
+			error = -ENOMEM;
+			goto error_out;
+		}
+		entries = tmp;
+
+		entries[entry_count] = (resolved_mock_dns_t){
+			.ifindex = ifindex,
+			.family = family,
+			.length = length,
+		};
+		memcpy(entries[entry_count].address, address, length);
+		entry_count++;
+	}
+
+	error = sd_bus_message_exit_container(msg);
+	if (error < 0) {
+		goto error_out;
+	}
+
+	// drop the current servers of the link and append the new ones
+	for (size_t i = 0; i < mock->dns_count; i++) {
+		if (mock->dns[i].ifindex != ifindex) {
+			mock->dns[kept++] = mock->dns[i];
+		}
+	}
+	mock->dns_count = kept;
+
+	if (entry_count) {
+		tmp = realloc(mock->dns, sizeof(*mock->dns) * (mock->dns_count + entry_count));
+		if (!tmp) {
+			error = -ENOMEM;
+			goto error_out;
+		}
+		mock->dns = tmp;
+
+		memcpy(mock->dns + mock->dns_count, entries, sizeof(*entries) * entry_count);
+		mock->dns_count += entry_count;
+	}
+
+	resolved_mock_changed(mock, "DNS");
+
+	error = 0;
+	goto out;
+
+error_out:
+	if (error >= 0) {
+		error = -EINVAL;
+	}
+
+out:
+	free(entries);
+
+	return error;
+}
+
+static int resolved_mock_set_domains(resolved_mock_t *mock, sd_bus_message *msg, sd_bus_error *ret_error)
+{
+	int error = 0;
+	int ifindex = 0;
+	resolved_mock_domain_t *entries = NULL;
+	size_t entry_count = 0;
+	size_t kept = 0;
+	resolved_mock_domain_t *tmp = NULL;
+
+	mock->set_domains_calls++;
+
+	error = sd_bus_message_read(msg, "i", &ifindex);
+	if (error < 0) {
+		goto error_out;
+	}
+
+	error = sd_bus_message_enter_container(msg, 'a', "(sb)");
+	if (error < 0) {
+		goto error_out;
+	}
+
+	for (;;) {
+		const char *domain = NULL;
+		int route_only = 0;
+
+		error = sd_bus_message_read(msg, "(sb)", &domain, &route_only);
+		if (error < 0) {
+			goto error_out;
+		}
+		if (error == 0) {
+			break;
+		}
+
+		if (!*domain) {
+			error = sd_bus_error_set(ret_error, SD_BUS_ERROR_INVALID_ARGS, "Empty domain");
+			goto error_out;
+		}
+
+		tmp = realloc(entries, sizeof(*entries) * (entry_count + 1));
+		if (!tmp) {
+			error = -ENOMEM;
+			goto error_out;
+		}
+		entries = tmp;
+
+		entries[entry_count] = (resolved_mock_domain_t){
+			.ifindex = ifindex,
+			.domain = strdup(domain),
+			.route_only = route_only,
+		};
+		if (!entries[entry_count].domain) {
+			error = -ENOMEM;
+			goto error_out;
+		}
+		entry_count++;
+	}
+
+	error = sd_bus_message_exit_container(msg);
+	if (error < 0) {
+		goto error_out;
+	}
+
+	for (size_t i = 0; i < mock->domain_count; i++) {
+		if (mock->domains[i].ifindex != ifindex) {
+			mock->domains[kept++] = mock->domains[i];
+		} else {
+			free(mock->domains[i].domain);
+		}
+	}
+	mock->domain_count = kept;
+
+	if (entry_count) {
+		tmp = realloc(mock->domains, sizeof(*mock->domains) * (mock->domain_count + entry_count));
+		if (!tmp) {
+			error = -ENOMEM;
+			goto error_out;
+		}
+		mock->domains = tmp;
+
+		// ownership of the strings moves to the state
+		memcpy(mock->domains + mock->domain_count, entries, sizeof(*entries) * entry_count);
+		mock->domain_count += entry_count;
+		entry_count = 0;
+	}
+
+	resolved_mock_changed(mock, "Domains");
+
+	error = 0;
+	goto out;
+
+error_out:
+	if (error >= 0) {
+		error = -EINVAL;
+	}
+
+out:
+	for (size_t i = 0; i < entry_count; i++) {
+		free(entries[i].domain);
+	}
+	free(entries);
+
+	return error;
+}
+
+static int resolved_mock_reply(resolved_mock_t *mock, sd_bus_message *reply)
+{
+	int error = 0;
+	uint64_t now = 0;
+
+	if (!mock->latency_usec) {
+		error = sd_bus_send(NULL, reply, NULL);
+		sd_bus_message_unref(reply);
+		return error < 0 ? error : 1;
+	}
+
+	// the state is already changed - only the answer is held back, so calls overlap like they would with resolved
+	error = sd_event_now(mock->event, CLOCK_MONOTONIC, &now);
+	if (error < 0) {
+		goto error_out;
+	}
+
+	// floating source - owned by the event loop and released after it fires
+	error = sd_event_add_time(mock->event, NULL, CLOCK_MONOTONIC, now + mock->latency_usec, 0, resolved_mock_reply_send, reply);
+	if (error < 0) {
+		goto error_out;
+	}
+
+	return 1;
+
+error_out:
+	sd_bus_message_unref(reply);
+	return error;
+}
+
+static int resolved_mock_reply_send(sd_event_source *source, uint64_t usec, void *userdata)
+{
+	sd_bus_message *reply = userdata;
+	int error = 0;
+
+	error = sd_bus_send(NULL, reply, NULL);
+	if (error < 0) {
+		fprintf(stderr, "sd_bus_send() error: %s\n", strerror(-error));
+	}
+
+	sd_bus_message_unref(reply);
+
+	return 0;
+}
+
+static int resolved_mock_exit(sd_event_source *source, const struct signalfd_siginfo *si, void *userdata)
+{
+	return sd_event_exit(sd_event_source_get_event(source), 0);
+}
+
+static void resolved_mock_changed(resolved_mock_t *mock, const char *property)
+{
+	// resolved announces the properties as invalidated - the plugin watcher reacts to the signal alone
+	int error = sd_bus_emit_signal(mock->bus, SYSTEM_RESOLVED_OBJECT_PATH, RESOLVED_MOCK_PROPERTIES_INTERFACE, "PropertiesChanged", "sa{sv}as", SYSTEM_RESOLVED_MANAGER_INTERFACE, 0, 1, property);
+	if (error < 0) {
+		fprintf(stderr, "sd_bus_emit_signal() error: %s\n", strerror(-error));
+	}
+}
+
+static void resolved_mock_reset(resolved_mock_t *mock)
+{
+	for (size_t i = 0; i < mock->domain_count; i++) {
+		free(mock->domains[i].domain);
+	}
+	free(mock->domains);
+	free(mock->dns);
+
+	mock->domains = NULL;
+	mock->domain_count = 0;
+	mock->dns = NULL;
+	mock->dns_count = 0;
+
+	mock->get_calls = 0;
+	mock->set_dns_calls = 0;
+	mock->set_domains_calls = 0;
+}
@@ -0,0 +1,127 @@
+#!/bin/sh
+#
+# telekom / sysrepo-plugin-system
+#
+# This program is made available under the terms of the
+# BSD 3-Clause license which is available at
+# https://opensource.org/licenses/BSD-3-Clause
+#
+# SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+# SPDX-FileContributor: Sartura Ltd.
+#
+# SPDX-License-Identifier: BSD-3-Clause
+#
+# Run a command against a private system bus served by the resolved mock:
+#
+#   run.sh MOCK_BINARY [--latency-ms MS] -- COMMAND [ARGS...]
+#
+# A dbus-daemon is started on a socket in a temporary directory, DBUS_SYSTEM_BUS_ADDRESS is pointed at it and the mock
+# takes the org.freedesktop.resolve1 name. Neither root nor systemd is needed. Everything is torn down when COMMAND
+# exits and its exit status is returned.
+
+set -eu
+
+if [ $# -lt 1 ]; then
+	echo "Usage: $0 MOCK_BINARY [--latency-ms MS] -- COMMAND [ARGS...]" >&2
+	exit 2
+fi
+
+MOCK=$1
+shift
+LATENCY_MS=${RESOLVED_MOCK_LATENCY_MS:-0}
+
+while [ $# -gt 0 ]; do
+	case "$1" in
+		--latency-ms)
+			LATENCY_MS=$2
+			shift 2
+			;;
+		--)
+			shift
+			break
+			;;
+		*)
+			echo "Unknown option $1" >&2
+			exit 2
+			;;
+	esac
+done
+
+if [ $# -eq 0 ]; then
+	echo "No command given" >&2
+	exit 2
+fi
+
+DBUS_DAEMON=${DBUS_DAEMON:-dbus-daemon}
+DIR=$(mktemp -d "${TMPDIR:-/tmp}/resolved-mock-XXXXXX")
+BUS_PID=
+MOCK_PID=
+
+cleanup() {
+	set +e
+	for pid in $MOCK_PID $BUS_PID; do
+		kill "$pid" 2>/dev/null
+		wait "$pid" 2>/dev/null
+	done
+	rm -rf "$DIR"
+}
+trap cleanup EXIT
+trap 'exit 130' INT TERM
+
+# a private bus which anyone may own names on - clients reach it as the system bus through DBUS_SYSTEM_BUS_ADDRESS
+cat > "$DIR/bus.conf" <<EOF
+<!DOCTYPE busconfig PUBLIC "-//freedesktop//DTD D-Bus Bus Configuration 1.0//EN"
+ "http://www.freedesktop.org/standards/dbus/1.0/busconfig.dtd">
+<busconfig>
+  <type>custom</type>
+  <listen>unix:path=$DIR/system_bus_socket</listen>
+  <auth>EXTERNAL</auth>
+  <policy context="default">
+    <allow user="*"/>
+    <allow own="*"/>
+    <allow send_type="method_call"/>
+    <allow send_type="signal"/>
+    <allow send_type="method_return"/>
+    <allow send_type="error"/>
+    <allow receive_type="method_call"/>
+    <allow receive_type="signal"/>
+    <allow receive_type="method_return"/>
+    <allow receive_type="error"/>
+  </policy>
+</busconfig>
+EOF
+
+"$DBUS_DAEMON" --config-file="$DIR/bus.conf" --nofork --nopidfile &
+BUS_PID=$!
+
+export DBUS_SYSTEM_BUS_ADDRESS="unix:path=$DIR/system_bus_socket"
+
+tries=0
+until [ -S "$DIR/system_bus_socket" ]; do
+	tries=$((tries + 1))
+	if [ $tries -gt 100 ] || ! kill -0 "$BUS_PID" 2>/dev/null; then
+		echo "dbus-daemon did not start" >&2
+		exit 1
+	fi
+	sleep 0.05
+done
+
+"$MOCK" --latency-ms "$LATENCY_MS" --ready-file "$DIR/ready" &
+MOCK_PID=$!
+
+tries=0
+until [ -e "$DIR/ready" ]; do
+	tries=$((tries + 1))
+	if [ $tries -gt 100 ] || ! kill -0 "$MOCK_PID" 2>/dev/null; then
+		echo "resolved mock did not start" >&2
+		exit 1
+	fi
+	sleep 0.05
+done
+
+# lets benchmarks and tests know the resolve1 calls are served by the mock
+export SYSTEM_RESOLVED_MOCK=1
+
+status=0
+"$@" || status=$?
+exit $status
@@ -23,13 +23,20 @@ target_link_libraries(
     ${CMOCKA_LIBRARIES}
     ${SYSREPO_LIBRARIES}
     ${LIBYANG_LIBRARIES}
+    ${SRPC_LIBRARIES}
+    ${UMGMT_LIBRARIES}
     ${SYSTEMD_LIBRARIES}
+    Threads::Threads
 
     "-Wl,--wrap=gethostname"
     "-Wl,--wrap=sethostname"
     "-Wl,--wrap=unlink"
     "-Wl,--wrap=symlink"
     "-Wl,--wrap=sr_apply_changes"
+    "-Wl,--wrap=um_db_load"
+    "-Wl,--wrap=um_db_store"
+    "-Wl,--wrap=um_user_set_password_hash"
+    "-Wl,--wrap=um_group_set_password_hash"
 )
 
 add_test(NAME system_utest COMMAND system_utest)
@@ -23,6 +23,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 
 // plugin code
 #include "core/context.h"
@@ -39,6 +40,53 @@
 // ntp load API
 #include "core/api/system/dns_resolver/load.h"
 
+// NTP server data
+#include "core/data/system/ntp/server.h"
+
+// UID/GID allocator
+#include "core/data/system/authentication/id_allocator.h"
+
+// SSH keys
+#include "core/data/system/authentication/authorized_key.h"
+#include "core/data/system/authentication/authorized_key/list.h"
+#include "core/data/system/authentication/local_user/change.h"
+#include "core/api/system/authentication/load.h"
+#include "core/api/system/authentication/txn.h"
+#include "core/ssh/base64.h"
+#include "core/ssh/key_index.h"
+#include "core/ssh/sha256.h"
+
+// per-request change state
+#include "core/transaction.h"
+#include "core/snapshot.h"
+#include "core/fs_batch.h"
+#include "core/journal.h"
+
+// DNS resolver backends
+#include "core/api/system/dns_resolver/resolv_conf.h"
+#include "core/data/system/dns_resolver/search/list.h"
+#include "core/data/system/dns_resolver/server/list.h"
+#include "core/data/system/ip_address.h"
+
+// runtime statistics
+#include "core/stats.h"
+
+// span tracing
+#include "core/trace.h"
+
+// system files root
+#include "core/root.h"
+
+// logging
+#include "core/log.h"
+
+// drift detection
+#include "core/drift.h"
+
+// password hashing
+#include "core/api/system/authentication/password.h"
+#include <crypt.h>
+
 // init functionality
 static int setup(void **state);
 static int teardown(void **state);
@@ -65,12 +113,85 @@ static void test_check_timezone_name_incorrect(void **state);
 static void test_load_dns_resolver_search_correct(void **state);
 static void test_load_dns_resolver_server_correct(void **state);
 
+// id allocator
+static void test_id_allocator_get_sequential(void **state);
+static void test_id_allocator_get_wraps_to_holes(void **state);
+static void test_id_allocator_exhausted(void **state);
+static void test_id_allocator_release(void **state);
+
+// ssh keys
+static void test_ssh_key_fingerprint(void **state);
+static void test_ssh_key_index_lookup(void **state);
+static void test_authorized_key_set_data(void **state);
+static void test_authorized_keys_parse(void **state);
+
+// transactions
+static void test_transaction_cleanup(void **state);
+
+// stats
+static void test_stats_nested_operations(void **state);
+
+// span tracing
+static void test_trace_dump_chrome_json(void **state);
+
+// system files root
+static void test_root_hostname_and_passwd(void **state);
+
+// NTP server data
+static void test_ntp_server_set_word(void **state);
+
+// logging
+static void test_log_ratelimit(void **state);
+
+// drift detection
+static void test_drift_schedule_debounce(void **state);
+static void test_drift_suppressed_while_writing(void **state);
+
+// password hashing
+static void test_password_batch_hash(void **state);
+
+// user changes
+static void test_local_user_change_merge_keys(void **state);
+
+// snapshot
+static void test_snapshot_sources_collect(void **state);
+
+// filesystem batches
+static void test_fs_batch_chains(void **state);
+static void test_fs_batch_owned_directories(void **state);
+static void test_fs_batch_remove(void **state);
+static void test_journal_recover(void **state);
+static void test_journal_recover_existing_directory(void **state);
+static void test_journal_recover_uncommitted(void **state);
+static void test_journal_source(void **state);
+
+// account transactions
+static void test_txn_commit_root_refused(void **state);
+static void test_txn_add_delete_user(void **state);
+static void test_txn_add_user_cleartext(void **state);
+
+// DNS resolver backends
+#ifndef SYSTEM_DNS_RESOLVER_BACKEND_RESOLVED
+static void test_dns_resolver_resolv_conf(void **state);
+#endif
+
 // wrapper functions
 int __wrap_gethostname(char *buffer, size_t buffer_size);
 int __wrap_sethostname(char *hostname, size_t len);
 int __wrap_unlink(const char *pathname);
 int __wrap_symlink(const char *target, const char *linkpath);
+int __real_symlink(const char *target, const char *linkpath);
 int __wrap_sr_apply_changes(sr_session_ctx_t *session, uint32_t timeout_ms);
+int __wrap_um_db_load(um_db_t *db);
+int __wrap_um_db_store(um_db_t *db);
+int __wrap_um_user_set_password_hash(um_user_t *user, const char *password_hash);
+int __real_um_user_set_password_hash(um_user_t *user, const char *password_hash);
+int __wrap_um_group_set_password_hash(um_group_t *group, const char *password_hash);
+int __real_um_group_set_password_hash(um_group_t *group, const char *password_hash);
+
+// last values handed to umgmt for /etc/shadow and /etc/gshadow
+static char system_utest_user_hash[256];
+static char system_utest_group_hash[256];
 
 int main(void)
 {
@@ -88,6 +209,38 @@ int main(void)
 		cmocka_unit_test(test_check_timezone_name_incorrect),
 		// cmocka_unit_test(test_load_dns_resolver_search_correct),
 		// cmocka_unit_test(test_load_dns_resolver_server_correct),
+		cmocka_unit_test(test_id_allocator_get_sequential),
+		cmocka_unit_test(test_id_allocator_get_wraps_to_holes),
+		cmocka_unit_test(test_id_allocator_exhausted),
+		cmocka_unit_test(test_id_allocator_release),
+		cmocka_unit_test(test_ssh_key_fingerprint),
+		cmocka_unit_test(test_ssh_key_index_lookup),
+		cmocka_unit_test(test_authorized_key_set_data),
+		cmocka_unit_test(test_authorized_keys_parse),
+		cmocka_unit_test(test_transaction_cleanup),
+		cmocka_unit_test(test_stats_nested_operations),
+		cmocka_unit_test(test_trace_dump_chrome_json),
+		cmocka_unit_test(test_root_hostname_and_passwd),
+		cmocka_unit_test(test_ntp_server_set_word),
+		cmocka_unit_test(test_log_ratelimit),
+		cmocka_unit_test(test_drift_schedule_debounce),
+		cmocka_unit_test(test_drift_suppressed_while_writing),
+		cmocka_unit_test(test_password_batch_hash),
+		cmocka_unit_test(test_local_user_change_merge_keys),
+		cmocka_unit_test(test_snapshot_sources_collect),
+		cmocka_unit_test(test_fs_batch_chains),
+		cmocka_unit_test(test_fs_batch_owned_directories),
+		cmocka_unit_test(test_fs_batch_remove),
+		cmocka_unit_test(test_journal_recover),
+		cmocka_unit_test(test_journal_recover_existing_directory),
+		cmocka_unit_test(test_journal_recover_uncommitted),
+		cmocka_unit_test(test_journal_source),
+		cmocka_unit_test(test_txn_commit_root_refused),
+		cmocka_unit_test(test_txn_add_delete_user),
+		cmocka_unit_test(test_txn_add_user_cleartext),
+#ifndef SYSTEM_DNS_RESOLVER_BACKEND_RESOLVED
+		cmocka_unit_test(test_dns_resolver_resolv_conf),
+#endif
 	};
 
 	return cmocka_run_group_tests(tests, setup, teardown);
@@ -101,6 +254,8 @@ static int setup(void **state)
 	}
 
 	*ctx = (system_ctx_t){0};
+	pthread_mutex_init(&ctx->startup_lock, NULL);
+	pthread_rwlock_init(&ctx->features_lock, NULL);
 	*state = ctx;
 
 	return 0;
@@ -108,8 +263,12 @@ static int setup(void **state)
 
 static int teardown(void **state)
 {
-	if (*state) {
-		free(*state);
+	system_ctx_t *ctx = *state;
+
+	if (ctx) {
+		pthread_rwlock_destroy(&ctx->features_lock);
+		pthread_mutex_destroy(&ctx->startup_lock);
+		free(ctx);
 	}
 
 	return 0;
@@ -293,6 +452,1333 @@ static void test_load_dns_resolver_server_correct(void **state)
 	assert_int_equal(rc, 0);
 }
 
+static void test_id_allocator_get_sequential(void **state)
+{
+	system_id_allocator_t alloc = {0};
+	uint32_t id = 0;
+	int rc = 0;
+
+	rc = system_id_allocator_init(&alloc, 1000, 1199);
+	assert_int_equal(rc, 0);
+
+	system_id_allocator_mark(&alloc, 1000);
+	system_id_allocator_mark(&alloc, 1063);
+	system_id_allocator_mark(&alloc, 1064);
+
+	// allocation continues above the highest used ID
+	rc = system_id_allocator_get(&alloc, &id);
+	assert_int_equal(rc, 0);
+	assert_int_equal(id, 1065);
+
+	rc = system_id_allocator_get(&alloc, &id);
+	assert_int_equal(rc, 0);
+	assert_int_equal(id, 1066);
+
+	// a specific free ID can be taken once
+	assert_int_equal(system_id_allocator_take(&alloc, 1100), 0);
+	assert_int_not_equal(system_id_allocator_take(&alloc, 1100), 0);
+	assert_false(system_id_allocator_is_free(&alloc, 1100));
+	assert_true(system_id_allocator_is_free(&alloc, 1001));
+
+	// IDs out of range are never free
+	assert_false(system_id_allocator_is_free(&alloc, 999));
+	assert_false(system_id_allocator_is_free(&alloc, 1200));
+
+	system_id_allocator_free(&alloc);
+}
+
+static void test_id_allocator_get_wraps_to_holes(void **state)
+{
+	system_id_allocator_t alloc = {0};
+	uint32_t id = 0;
+	int rc = 0;
+
+	rc = system_id_allocator_init(&alloc, 10, 14);
+	assert_int_equal(rc, 0);
+
+	system_id_allocator_mark(&alloc, 11);
+	system_id_allocator_mark(&alloc, 14);
+
+	// top of the range is used - holes below are handed out in order
+	rc = system_id_allocator_get(&alloc, &id);
+	assert_int_equal(rc, 0);
+	assert_int_equal(id, 10);
+
+	rc = system_id_allocator_get(&alloc, &id);
+	assert_int_equal(rc, 0);
+	assert_int_equal(id, 12);
+
+	system_id_allocator_free(&alloc);
+}
+
+static void test_id_allocator_exhausted(void **state)
+{
+	system_id_allocator_t alloc = {0};
+	uint32_t id = 0;
+	int rc = 0;
+
+	rc = system_id_allocator_init(&alloc, 0, 129);
+	assert_int_equal(rc, 0);
+
+	for (uint32_t i = 0; i < 130; i++) {
+		rc = system_id_allocator_get(&alloc, &id);
+		assert_int_equal(rc, 0);
+		assert_int_equal(id, i);
+	}
+
+	rc = system_id_allocator_get(&alloc, &id);
+	assert_int_not_equal(rc, 0);
+
+	system_id_allocator_free(&alloc);
+
+	// invalid range
+	rc = system_id_allocator_init(&alloc, 10, 9);
+	assert_int_not_equal(rc, 0);
+}
+
+static void test_id_allocator_release(void **state)
+{
+	system_id_allocator_t alloc = {0};
+	uint32_t id = 0;
+	int rc = 0;
+
+	rc = system_id_allocator_init(&alloc, 1000, 1199);
+	assert_int_equal(rc, 0);
+
+	system_id_allocator_mark(&alloc, 1000);
+
+	// a released ID is handed out again - also the last one, so that the sequence has no gap
+	rc = system_id_allocator_get(&alloc, &id);
+	assert_int_equal(rc, 0);
+	assert_int_equal(id, 1001);
+
+	system_id_allocator_release(&alloc, 1001);
+	assert_true(system_id_allocator_is_free(&alloc, 1001));
+
+	rc = system_id_allocator_get(&alloc, &id);
+	assert_int_equal(rc, 0);
+	assert_int_equal(id, 1001);
+
+	// IDs out of range are ignored
+	system_id_allocator_release(&alloc, 999);
+	assert_false(system_id_allocator_is_free(&alloc, 999));
+
+	system_id_allocator_free(&alloc);
+}
+
+static void test_ssh_key_fingerprint(void **state)
+{
+	const char *key_data = "AAAAC3NzaC1lZDI1NTE5AAAAIH/tUkc+5zFsIIliQeYMgPAveqROJ2Jh2zh/DkmVqsL+";
+	// ssh-keygen -l -E sha256 output for the key above
+	const char *expected = "H4A0ZfvgXh3agefT3MEHjJc6lLXIfQiNXErThl6Xtoo";
+	uint8_t blob[128] = {0};
+	uint8_t fingerprint[SYSTEM_SHA256_DIGEST_LENGTH] = {0};
+	uint8_t expected_fingerprint[SYSTEM_SHA256_DIGEST_LENGTH] = {0};
+	size_t length = 0;
+	int rc = 0;
+
+	rc = system_base64_decode(key_data, strlen(key_data), blob, sizeof(blob), &length);
+	assert_int_equal(rc, 0);
+	assert_int_equal(length, 51);
+
+	system_sha256(blob, length, fingerprint);
+
+	rc = system_base64_decode(expected, strlen(expected), expected_fingerprint, sizeof(expected_fingerprint), &length);
+	assert_int_equal(rc, 0);
+	assert_int_equal(length, SYSTEM_SHA256_DIGEST_LENGTH);
+	assert_memory_equal(fingerprint, expected_fingerprint, SYSTEM_SHA256_DIGEST_LENGTH);
+
+	// invalid characters and lengths
+	rc = system_base64_decode("AAA*", 4, blob, sizeof(blob), &length);
+	assert_int_not_equal(rc, 0);
+	rc = system_base64_decode("AAAAA", 5, blob, sizeof(blob), &length);
+	assert_int_not_equal(rc, 0);
+}
+
+static void test_ssh_key_index_lookup(void **state)
+{
+	char path[] = "/tmp/system_utest_key_index_XXXXXX";
+	char lines[64][32] = {0};
+	system_ssh_key_line_t keys[64] = {0};
+	system_ssh_key_index_t index = {0};
+	system_fs_batch_t batch = {0};
+	size_t chain = 0;
+	uint8_t *buffer = NULL;
+	size_t buffer_size = 0;
+	uint8_t missing[SYSTEM_SHA256_DIGEST_LENGTH] = {0};
+	const char *line = NULL;
+	size_t length = 0;
+	int fd = -1;
+	int rc = 0;
+
+	fd = mkstemp(path);
+	assert_int_not_equal(fd, -1);
+	close(fd);
+
+	for (size_t i = 0; i < 64; i++) {
+		snprintf(lines[i], sizeof(lines[i]), "ssh-ed25519 AAAA key-%zu\n", i);
+		system_sha256(lines[i], strlen(lines[i]), keys[i].fingerprint);
+		keys[i].line = lines[i];
+		keys[i].length = strlen(lines[i]);
+	}
+
+	rc = system_ssh_key_index_render(keys, 64, &buffer, &buffer_size);
+	assert_int_equal(rc, 0);
+
+	// written the way the plugin writes it - as an atomic write of the user's batch chain
+	assert_int_equal(system_fs_batch_chain(&batch, &chain), 0);
+	assert_int_equal(system_fs_batch_add(&batch, chain, &(system_fs_op_t){.type = SYSTEM_FS_OP_WRITE, .path = path, .data = buffer, .size = buffer_size, .mode = 0644, .uid = (uid_t) -1, .gid = (gid_t) -1, .atomic = true}), 0);
+	assert_int_equal(system_fs_batch_run(&batch), 0);
+	system_fs_batch_free(&batch);
+	free(buffer);
+
+	rc = system_ssh_key_index_open(&index, path);
+	assert_int_equal(rc, 0);
+
+	for (size_t i = 0; i < 64; i++) {
+		line = system_ssh_key_index_find(&index, keys[i].fingerprint, &length);
+		assert_non_null(line);
+		assert_int_equal(length, keys[i].length);
+		assert_memory_equal(line, lines[i], length);
+	}
+
+	system_sha256("missing", 7, missing);
+	line = system_ssh_key_index_find(&index, missing, &length);
+	assert_null(line);
+
+	system_ssh_key_index_close(&index);
+	remove(path);
+}
+
+static void test_authorized_key_set_data(void **state)
+{
+	const char *key_data = "AAAAC3NzaC1lZDI1NTE5AAAAIH/tUkc+5zFsIIliQeYMgPAveqROJ2Jh2zh/DkmVqsL+";
+	const char *rsa_key_data = "AAAAB3NzaC1yc2EAAAADAQABAAABAQCiIf32L0B77f//ldk1QpUyfaJQUgI4mXSPtkmaokxUUlj8j9pxlwpFDSmsrZn2H0DJhZZ3ktAGsbFJabZJhV73l7HhQggC/6uzrNPSe+R3lOMGYIAhHaWbGSnT/uvpPMBVA/nWulDkBphiXv606WQHDxqGkngF1kzvvpd5FPpc/jy2vv+66HaP6XA9MgzHLYTOTb3ct3dVoz7HDAQ8tC5l3/3YYLyMhc3LxOBQLZ9PklWvQeSyO6neKi3Au0T13SpUGjtuqKpiCvE/X0ZuFtZSZzPo5UDASD65Er8jOqqYDcfHR1hsfJJjJA/nP+VKoGeBzUBxhxNetqswnEcPDEBv";
+	system_authorized_key_t key = {0};
+	system_authorized_key_t other = {0};
+	int rc = 0;
+
+	system_authorized_key_init(&key);
+	system_authorized_key_init(&other);
+
+	rc = system_authorized_key_set_data(&key, key_data);
+	assert_int_equal(rc, 0);
+	assert_string_equal(key.blob_algorithm, "ssh-ed25519");
+
+	// algorithm has to match the key type in the blob
+	rc = system_authorized_key_set_algorithm(&key, "ssh-rsa");
+	assert_int_equal(rc, 0);
+	assert_int_not_equal(system_authorized_key_check_algorithm(&key), 0);
+
+	rc = system_authorized_key_set_algorithm(&key, "ssh-ed25519");
+	assert_int_equal(rc, 0);
+	assert_int_equal(system_authorized_key_check_algorithm(&key), 0);
+
+	// RSA signature algorithms name keys of the ssh-rsa type
+	rc = system_authorized_key_set_data(&other, rsa_key_data);
+	assert_int_equal(rc, 0);
+	assert_string_equal(other.blob_algorithm, "ssh-rsa");
+	rc = system_authorized_key_set_algorithm(&other, "rsa-sha2-512");
+	assert_int_equal(rc, 0);
+	assert_int_equal(system_authorized_key_check_algorithm(&other), 0);
+	rc = system_authorized_key_set_algorithm(&other, "rsa-sha2-256");
+	assert_int_equal(rc, 0);
+	assert_int_equal(system_authorized_key_check_algorithm(&other), 0);
+	rc = system_authorized_key_set_algorithm(&key, "rsa-sha2-256");
+	assert_int_equal(rc, 0);
+	assert_int_not_equal(system_authorized_key_check_algorithm(&key), 0);
+	rc = system_authorized_key_set_algorithm(&key, "ssh-ed25519");
+	assert_int_equal(rc, 0);
+
+	// same key under a different name compares equal
+	rc = system_authorized_key_set_name(&other, "other");
+	assert_int_equal(rc, 0);
+	rc = system_authorized_key_set_data(&other, key_data);
+	assert_int_equal(rc, 0);
+	assert_int_equal(system_authorized_key_fingerprint_cmp_fn(&key, &other), 0);
+
+	// malformed data is rejected and not stored
+	rc = system_authorized_key_set_data(&other, "not base64!");
+	assert_int_not_equal(rc, 0);
+	assert_null(other.data);
+	rc = system_authorized_key_set_data(&other, "AAAA");
+	assert_int_not_equal(rc, 0);
+
+	system_authorized_key_free(&key);
+	system_authorized_key_free(&other);
+}
+
+static void test_authorized_keys_parse(void **state)
+{
+	// comments, options with quoted spaces, CRLF line ends and a last line without its newline
+	char content[] = "# managed by hand\r\n"
+					 "ssh-ed25519 AAAAC3NzaC1lZDI1NTE5AAAAIH/tUkc+5zFsIIliQeYMgPAveqROJ2Jh2zh/DkmVqsL+ alice@laptop\r\n"
+					 "no-pty,command=\"echo hello world\" ssh-rsa "
+					 "AAAAB3NzaC1yc2EAAAADAQABAAABAQCiIf32L0B77f//ldk1QpUyfaJQUgI4mXSPtkmaokxUUlj8j9pxlwpFDSmsrZn2H0DJhZZ3ktAGsbFJabZJhV73l7HhQggC/6uzrNPSe+R3lOMGYIAhHaWbGSnT/"
+					 "uvpPMBVA/nWulDkBphiXv606WQHDxqGkngF1kzvvpd5FPpc/jy2vv+66HaP6XA9MgzHLYTOTb3ct3dVoz7HDAQ8tC5l3/3YYLyMhc3LxOBQLZ9PklWvQeSyO6neKi3Au0T13SpUGjtuqKpiCvE/"
+					 "X0ZuFtZSZzPo5UDASD65Er8jOqqYDcfHR1hsfJJjJA/nP+VKoGeBzUBxhxNetqswnEcPDEBv bob key\n"
+					 "\n"
+					 "   # indented comment\n"
+					 "ssh-ed25519 AAAAC3NzaC1lZDI1NTE5AAAAIH/tUkc+5zFsIIliQeYMgPAveqROJ2Jh2zh/DkmVqsL+";
+	system_authorized_key_element_t *head = NULL;
+	system_authorized_key_element_t *iter = NULL;
+	size_t skipped = 0;
+	int rc = 0;
+
+	rc = system_authentication_parse_authorized_keys("test", content, sizeof(content) - 1, &head, &skipped);
+	assert_int_equal(rc, 0);
+
+	// both comments are lines which can not be written back - empty lines are not
+	assert_int_equal(skipped, 2);
+
+	iter = head;
+	assert_non_null(iter);
+	assert_string_equal(iter->key.name, "alice@laptop");
+	assert_string_equal(iter->key.algorithm, "ssh-ed25519");
+	assert_string_equal(iter->key.data, "AAAAC3NzaC1lZDI1NTE5AAAAIH/tUkc+5zFsIIliQeYMgPAveqROJ2Jh2zh/DkmVqsL+");
+	assert_null(iter->key.options);
+
+	// the options are kept for the key and the rest of the line is the name
+	iter = iter->next;
+	assert_non_null(iter);
+	assert_string_equal(iter->key.name, "bob key");
+	assert_string_equal(iter->key.options, "no-pty,command=\"echo hello world\"");
+	assert_string_equal(iter->key.algorithm, "ssh-rsa");
+	assert_string_equal(iter->key.blob_algorithm, "ssh-rsa");
+
+	// a key without a comment is named by its line
+	iter = iter->next;
+	assert_non_null(iter);
+	assert_string_equal(iter->key.name, "key-6");
+	assert_string_equal(iter->key.algorithm, "ssh-ed25519");
+	assert_string_equal(iter->key.data, "AAAAC3NzaC1lZDI1NTE5AAAAIH/tUkc+5zFsIIliQeYMgPAveqROJ2Jh2zh/DkmVqsL+");
+
+	assert_null(iter->next);
+
+	system_authorized_key_list_free(&head);
+}
+
+static void test_transaction_cleanup(void **state)
+{
+	system_transaction_t first = {0};
+	system_transaction_t second = {0};
+
+	(void) state;
+
+	// callbacks running in parallel each collect into their own transaction
+	assert_int_equal(system_dns_search_list_add(&first.dns_search, (system_dns_search_t){.domain = "a.example", .search = 1}), 0);
+	assert_int_equal(system_dns_search_list_add(&second.dns_search, (system_dns_search_t){.domain = "b.example", .search = 1}), 0);
+	assert_non_null(system_dns_search_list_find(first.dns_search, "a.example"));
+	assert_null(system_dns_search_list_find(first.dns_search, "b.example"));
+
+	system_transaction_cleanup(&first);
+	assert_null(first.dns_search);
+	assert_non_null(second.dns_search);
+
+	system_transaction_cleanup(&second);
+	assert_null(second.dns_search);
+}
+
+static void test_stats_nested_operations(void **state)
+{
+	(void) state;
+
+	system_stats_summary_t outer = {0};
+	system_stats_summary_t inner = {0};
+	system_stats_scope_t outer_scope = system_stats_begin(SYSTEM_STATS_OP_CHANGE_AUTHENTICATION_USER);
+	system_stats_scope_t inner_scope = system_stats_begin(SYSTEM_STATS_OP_STORE_AUTHORIZED_KEY);
+
+	// writes are accounted to the innermost running operation
+	system_stats_add_bytes(100);
+	system_stats_end(&inner_scope, true);
+
+	system_stats_add_bytes(10);
+	system_stats_add_fork();
+	system_stats_end(&outer_scope, false);
+
+	// nothing runs any more - not accounted
+	system_stats_add_bytes(1000);
+
+	system_stats_summary(SYSTEM_STATS_OP_CHANGE_AUTHENTICATION_USER, &outer);
+	system_stats_summary(SYSTEM_STATS_OP_STORE_AUTHORIZED_KEY, &inner);
+
+	assert_int_equal(outer.calls, 1);
+	assert_int_equal(outer.errors, 0);
+	assert_int_equal(outer.bytes_written, 10);
+	assert_int_equal(outer.forks, 1);
+	assert_int_equal(inner.calls, 1);
+	assert_int_equal(inner.errors, 1);
+	assert_int_equal(inner.bytes_written, 100);
+	assert_int_equal(inner.forks, 0);
+	assert_true(inner.p50_us <= inner.p99_us);
+	assert_true(outer.max_us >= inner.max_us);
+}
+
+static void test_trace_dump_chrome_json(void **state)
+{
+	(void) state;
+
+	char path[] = "/tmp/system_utest_trace_XXXXXX";
+	char buffer[4096] = {0};
+	int64_t start = 0;
+	size_t length = 0;
+	FILE *file = NULL;
+	struct stat st = {0};
+	int fd = mkstemp(path);
+
+	// the dump replaces the file with a new one of its own - unlink() is wrapped, so the file is removed here
+	assert_int_not_equal(fd, -1);
+	close(fd);
+	remove(path);
+
+	// disabled - nothing is recorded
+	system_trace_set_enabled(false);
+	assert_int_equal(system_trace_begin(), 0);
+	system_trace_end("not-recorded", NULL, 0);
+
+	system_trace_set_enabled(true);
+	system_trace_set_request(42);
+	start = system_trace_begin();
+	assert_true(start > 0);
+	system_trace_end("sr_apply_changes", "/ietf-system:system/\"hostname\"", start);
+	system_trace_set_enabled(false);
+
+	will_return(__wrap_unlink, 0);
+	assert_int_equal(system_trace_dump(path), 0);
+	assert_int_equal(stat(path, &st), 0);
+	assert_int_equal(st.st_mode & 0777, 0600);
+
+	// client supplied names stay in the state directory
+	assert_int_equal(system_trace_path(buffer, sizeof(buffer), "../shadow"), -1);
+	assert_int_equal(system_trace_path(buffer, sizeof(buffer), "/etc/shadow"), -1);
+	assert_int_equal(system_trace_path(buffer, sizeof(buffer), ".."), -1);
+	assert_int_equal(system_trace_path(buffer, sizeof(buffer), ""), -1);
+
+	file = fopen(path, "r");
+	assert_non_null(file);
+	length = fread(buffer, 1, sizeof(buffer) - 1, file);
+	fclose(file);
+	remove(path);
+
+	assert_true(length > 0);
+	assert_non_null(strstr(buffer, "\"traceEvents\""));
+	assert_non_null(strstr(buffer, "\"name\":\"sr_apply_changes\""));
+	assert_non_null(strstr(buffer, "\"request_id\":42"));
+	assert_non_null(strstr(buffer, "\\\"hostname\\\""));
+	assert_null(strstr(buffer, "not-recorded"));
+}
+
+static void test_root_hostname_and_passwd(void **state)
+{
+	system_ctx_t *ctx = *state;
+
+	char root[] = "/tmp/system_utest_root_XXXXXX";
+	char path_buffer[PATH_MAX] = {0};
+	char hostname_buffer[SYSTEM_HOSTNAME_LENGTH_MAX] = {0};
+	char trace_buffer[PATH_MAX] = {0};
+	char pw_buffer[1024] = {0};
+	struct passwd pw = {0};
+	FILE *file = NULL;
+
+	assert_non_null(mkdtemp(root));
+
+	// trailing slashes are dropped and relative roots refused
+	assert_int_equal(system_root_set("relative/root"), -1);
+	assert_false(system_root_active());
+	snprintf(path_buffer, sizeof(path_buffer), "%s//", root);
+	assert_int_equal(system_root_set(path_buffer), 0);
+	assert_string_equal(system_root_get(), root);
+
+	assert_int_equal(system_root_path(path_buffer, sizeof(path_buffer), "/etc"), 0);
+	assert_int_equal(mkdir(path_buffer, 0755), 0);
+
+	// the hostname of a separate root lives in its /etc/hostname - sethostname() and gethostname() are not called
+	assert_int_equal(system_store_hostname(ctx, "rooted"), 0);
+	assert_int_equal(system_load_hostname(ctx, hostname_buffer), 0);
+	assert_string_equal(hostname_buffer, "rooted");
+
+	// trace dumps go to the state directory of the root
+	assert_int_equal(system_root_path(path_buffer, sizeof(path_buffer), "/var"), 0);
+	assert_int_equal(mkdir(path_buffer, 0755), 0);
+	assert_int_equal(system_root_path(path_buffer, sizeof(path_buffer), "/var/lib"), 0);
+	assert_int_equal(mkdir(path_buffer, 0755), 0);
+	assert_int_equal(system_trace_path(trace_buffer, sizeof(trace_buffer), SYSTEM_TRACE_DEFAULT_NAME), 0);
+	snprintf(path_buffer, sizeof(path_buffer), "%s%s", root, SYSTEM_TRACE_DEFAULT_FILE);
+	assert_string_equal(trace_buffer, path_buffer);
+
+	// users are looked up in the passwd file of the root
+	assert_int_equal(system_root_path(path_buffer, sizeof(path_buffer), SYSTEM_AUTHENTICATION_PASSWD_PATH), 0);
+	file = fopen(path_buffer, "w");
+	assert_non_null(file);
+	fprintf(file, "root:x:0:0:root:/root:/bin/bash\nbench:x:1000:1000::/home/bench:/bin/bash\n");
+	fclose(file);
+
+	assert_int_equal(system_root_getpwnam("bench", &pw, pw_buffer, sizeof(pw_buffer)), 0);
+	assert_int_equal(pw.pw_uid, 1000);
+	assert_string_equal(pw.pw_dir, "/home/bench");
+	assert_int_equal(system_root_getpwnam("missing", &pw, pw_buffer, sizeof(pw_buffer)), -1);
+
+	remove(path_buffer);
+	assert_int_equal(system_root_path(path_buffer, sizeof(path_buffer), SYSTEM_HOSTNAME_FILE), 0);
+	remove(path_buffer);
+	assert_int_equal(system_root_path(path_buffer, sizeof(path_buffer), "/etc"), 0);
+	rmdir(path_buffer);
+	assert_int_equal(system_root_path(path_buffer, sizeof(path_buffer), SYSTEM_PLUGIN_STATE_DIRECTORY), 0);
+	rmdir(path_buffer);
+	assert_int_equal(system_root_path(path_buffer, sizeof(path_buffer), "/var/lib"), 0);
+	rmdir(path_buffer);
+	assert_int_equal(system_root_path(path_buffer, sizeof(path_buffer), "/var"), 0);
+	rmdir(path_buffer);
+	rmdir(root);
+
+	system_root_set(NULL);
+	assert_false(system_root_active());
+}
+
+static void test_ntp_server_set_word(void **state)
+{
+	(void) state;
+
+	system_ntp_server_t server = {0};
+
+	system_ntp_server_init(&server);
+
+	assert_int_equal(system_ntp_server_set_word(&server, "0.pool.ntp.org:123"), 0);
+	assert_string_equal(server.name, "0.pool.ntp.org:123");
+	assert_string_equal(server.address, "0.pool.ntp.org");
+	assert_string_equal(server.port, "123");
+
+	system_ntp_server_free(&server);
+	system_ntp_server_init(&server);
+
+	assert_int_equal(system_ntp_server_set_word(&server, "ntp.example.com"), 0);
+	assert_string_equal(server.address, "ntp.example.com");
+	assert_null(server.port);
+
+	system_ntp_server_free(&server);
+}
+
+static void test_log_ratelimit(void **state)
+{
+	(void) state;
+
+	system_log_ratelimit_t site = {0};
+
+	for (int i = 0; i < SYSTEM_LOG_RATELIMIT_BURST; i++) {
+		assert_true(system_log_ratelimit(&site, __FILE__, __LINE__));
+	}
+
+	// the burst is used up until the window ends
+	assert_false(system_log_ratelimit(&site, __FILE__, __LINE__));
+	assert_false(system_log_ratelimit(&site, __FILE__, __LINE__));
+	assert_int_equal(site.suppressed, 2);
+
+	// a new window starts with a full burst and forgets the suppressed messages once reported
+	site.window_start -= SYSTEM_LOG_RATELIMIT_INTERVAL_MS;
+	assert_true(system_log_ratelimit(&site, __FILE__, __LINE__));
+	assert_int_equal(site.suppressed, 0);
+	assert_int_equal(site.count, 1);
+
+	assert_string_equal(SYSTEM_LOG_SECRET("$6$salt$hash"), SYSTEM_LOG_REDACTED);
+}
+
+static void test_drift_schedule_debounce(void **state)
+{
+	system_ctx_t *ctx = *state;
+	system_drift_schedule_t schedule = {0};
+
+	// nothing pending - the watcher waits for events only
+	assert_int_equal(system_drift_schedule_timeout(&schedule, 1000), -1);
+
+	// a burst of events is reloaded once, one debounce period after the first event
+	system_drift_schedule_mark(ctx, &schedule, SYSTEM_SUBSYSTEM_HOSTNAME, SYSTEM_DRIFT_DEBOUNCE_MS, 1000);
+	system_drift_schedule_mark(ctx, &schedule, SYSTEM_SUBSYSTEM_HOSTNAME, SYSTEM_DRIFT_DEBOUNCE_MS, 1100);
+	assert_int_equal(system_drift_schedule_timeout(&schedule, 1100), 1000 + SYSTEM_DRIFT_DEBOUNCE_MS - 1100);
+
+	assert_false(system_drift_schedule_take(ctx, &schedule, SYSTEM_SUBSYSTEM_HOSTNAME, 1000 + SYSTEM_DRIFT_DEBOUNCE_MS - 1));
+	assert_false(system_drift_schedule_take(ctx, &schedule, SYSTEM_SUBSYSTEM_CLOCK, 1000 + SYSTEM_DRIFT_DEBOUNCE_MS));
+	assert_true(system_drift_schedule_take(ctx, &schedule, SYSTEM_SUBSYSTEM_HOSTNAME, 1000 + SYSTEM_DRIFT_DEBOUNCE_MS));
+	assert_false(system_drift_schedule_take(ctx, &schedule, SYSTEM_SUBSYSTEM_HOSTNAME, 1000 + SYSTEM_DRIFT_DEBOUNCE_MS));
+	assert_int_equal(schedule.pending, 0);
+
+	// the nearest reload decides the timeout - an overdue one is run right away
+	system_drift_schedule_mark(ctx, &schedule, SYSTEM_SUBSYSTEM_CLOCK, SYSTEM_DRIFT_DEBOUNCE_MS, 2000);
+	system_drift_schedule_mark(ctx, &schedule, SYSTEM_SUBSYSTEM_DNS_RESOLVER, 0, 2050);
+	assert_int_equal(system_drift_schedule_timeout(&schedule, 2000), 50);
+	assert_int_equal(system_drift_schedule_timeout(&schedule, 3000), 0);
+}
+
+static void test_drift_suppressed_while_writing(void **state)
+{
+	system_ctx_t *ctx = *state;
+	system_drift_schedule_t schedule = {0};
+	int64_t now = system_drift_now_ms();
+
+	// a commit longer than the trailing window - the subsystem stays suppressed until the last writer is done
+	system_drift_begin(ctx, SYSTEM_SUBSYSTEM_AUTHENTICATION);
+	system_drift_begin(ctx, SYSTEM_SUBSYSTEM_AUTHENTICATION);
+
+	system_drift_schedule_mark(ctx, &schedule, SYSTEM_SUBSYSTEM_AUTHENTICATION, SYSTEM_DRIFT_DEBOUNCE_MS, now);
+	assert_int_equal(schedule.due[SYSTEM_SUBSYSTEM_AUTHENTICATION], now + SYSTEM_DRIFT_SUPPRESS_MS);
+	assert_false(system_drift_schedule_take(ctx, &schedule, SYSTEM_SUBSYSTEM_AUTHENTICATION, now + 10 * SYSTEM_DRIFT_SUPPRESS_MS));
+	assert_int_equal(schedule.due[SYSTEM_SUBSYSTEM_AUTHENTICATION], now + 11 * SYSTEM_DRIFT_SUPPRESS_MS);
+
+	system_drift_end(ctx, SYSTEM_SUBSYSTEM_AUTHENTICATION);
+	assert_false(system_drift_schedule_take(ctx, &schedule, SYSTEM_SUBSYSTEM_AUTHENTICATION, now + 11 * SYSTEM_DRIFT_SUPPRESS_MS));
+
+	// the trailing window starts when the last write ends
+	system_drift_end(ctx, SYSTEM_SUBSYSTEM_AUTHENTICATION);
+	now = system_drift_now_ms();
+	assert_true(system_drift_suppressed_until(ctx, SYSTEM_SUBSYSTEM_AUTHENTICATION, now) >= now + SYSTEM_DRIFT_SUPPRESS_MS - 1);
+	assert_true(system_drift_suppressed_until(ctx, SYSTEM_SUBSYSTEM_AUTHENTICATION, now) <= now + SYSTEM_DRIFT_SUPPRESS_MS);
+
+	// events arriving inside the window are looked at only once it is over
+	schedule = (system_drift_schedule_t){0};
+	system_drift_schedule_mark(ctx, &schedule, SYSTEM_SUBSYSTEM_AUTHENTICATION, SYSTEM_DRIFT_DEBOUNCE_MS, now);
+	assert_false(system_drift_schedule_take(ctx, &schedule, SYSTEM_SUBSYSTEM_AUTHENTICATION, now + SYSTEM_DRIFT_DEBOUNCE_MS));
+	assert_true(system_drift_schedule_take(ctx, &schedule, SYSTEM_SUBSYSTEM_AUTHENTICATION, now + SYSTEM_DRIFT_SUPPRESS_MS));
+	assert_int_equal(schedule.pending, 0);
+
+	// other subsystems are not affected
+	system_drift_schedule_mark(ctx, &schedule, SYSTEM_SUBSYSTEM_HOSTNAME, 0, now);
+	assert_true(system_drift_schedule_take(ctx, &schedule, SYSTEM_SUBSYSTEM_HOSTNAME, now));
+}
+
+static void test_password_batch_hash(void **state)
+{
+	(void) state;
+
+	system_password_batch_t batch = {0};
+	char xpath[64] = {0};
+
+	assert_true(system_authentication_password_is_cleartext("$0$secret"));
+	assert_false(system_authentication_password_is_cleartext("$6$salt$hash"));
+	assert_false(system_authentication_password_is_cleartext(NULL));
+
+	// more jobs than hashing threads - every one is taken exactly once
+	setenv(SYSTEM_AUTHENTICATION_PASSWORD_WORKERS_ENV, "3", 1);
+	for (int i = 0; i < 10; i++) {
+		snprintf(xpath, sizeof(xpath), "/ietf-system:system/authentication/user[name='u%d']/password", i);
+		assert_int_equal(system_authentication_password_batch_add(&batch, xpath, i % 2 ? "secret" : "other"), 0);
+	}
+	assert_int_equal(system_authentication_password_batch_hash(&batch), 0);
+	unsetenv(SYSTEM_AUTHENTICATION_PASSWORD_WORKERS_ENV);
+
+	for (size_t i = 0; i < batch.count; i++) {
+		const system_password_job_t *job = &batch.jobs[i];
+
+		assert_non_null(job->hash);
+		assert_memory_equal(job->hash, SYSTEM_AUTHENTICATION_PASSWORD_HASH_PREFIX, sizeof(SYSTEM_AUTHENTICATION_PASSWORD_HASH_PREFIX) - 1);
+		assert_string_equal(crypt(job->cleartext, job->hash), job->hash);
+	}
+
+	// same password, different salt
+	assert_string_not_equal(batch.jobs[1].hash, batch.jobs[3].hash);
+
+	system_authentication_password_batch_free(&batch);
+	assert_null(batch.jobs);
+}
+
+static void test_local_user_change_merge_keys(void **state)
+{
+	(void) state;
+
+	system_local_user_change_t *map = NULL;
+	system_local_user_change_t *change = NULL;
+	system_authorized_key_element_t *key_el = NULL;
+
+	// every change of a user ends up in one record
+	change = system_local_user_change_get(&map, "alice");
+	assert_non_null(change);
+	assert_ptr_equal(system_local_user_change_get(&map, "alice"), change);
+	assert_non_null(system_local_user_change_get(&map, "bob"));
+	assert_int_equal(HASH_COUNT(map), 2);
+	assert_false(system_local_user_change_has_keys(change));
+
+	// keys currently in the file
+	assert_int_equal(system_authorized_key_list_add(&change->user.key_head, (system_authorized_key_t){.name = "laptop", .algorithm = "ssh-rsa"}), 0);
+	assert_int_equal(system_authorized_key_list_add(&change->user.key_head, (system_authorized_key_t){.name = "old", .algorithm = "ssh-rsa"}), 0);
+
+	key_el = system_local_user_change_get_key(&change->keys_modified, "laptop");
+	assert_non_null(key_el);
+	assert_int_equal(system_authorized_key_set_algorithm(&key_el->key, "ssh-ed25519"), 0);
+	assert_ptr_equal(system_local_user_change_get_key(&change->keys_modified, "laptop"), key_el);
+	assert_non_null(system_local_user_change_get_key(&change->keys_deleted, "old"));
+	assert_non_null(system_local_user_change_get_key(&change->keys_created, "desktop"));
+	assert_true(system_local_user_change_has_keys(change));
+
+	assert_int_equal(system_local_user_change_merge_keys(change), 0);
+
+	key_el = system_authorized_key_list_find(change->user.key_head, "laptop");
+	assert_non_null(key_el);
+	assert_string_equal(key_el->key.algorithm, "ssh-ed25519");
+	assert_null(system_authorized_key_list_find(change->user.key_head, "old"));
+	assert_non_null(system_authorized_key_list_find(change->user.key_head, "desktop"));
+
+	// a modified key has to exist
+	assert_non_null(system_local_user_change_get_key(&change->keys_modified, "missing"));
+	assert_int_equal(system_local_user_change_merge_keys(change), -1);
+
+	system_local_user_change_map_free(&map);
+	assert_null(map);
+}
+
+static void test_snapshot_sources_collect(void **state)
+{
+	(void) state;
+
+	char root[] = "/tmp/system_utest_snapshot_XXXXXX";
+	char path_buffer[PATH_MAX] = {0};
+	system_snapshot_sources_t first = {0}, second = {0};
+	FILE *file = NULL;
+
+	assert_non_null(mkdtemp(root));
+	assert_int_equal(system_root_set(root), 0);
+	assert_int_equal(system_root_path(path_buffer, sizeof(path_buffer), "/etc"), 0);
+	assert_int_equal(mkdir(path_buffer, 0755), 0);
+
+	// a missing file is validated as missing - only the cached subsystems are collected
+	assert_int_equal(system_snapshot_sources_collect(SYSTEM_SUBSYSTEM_MASK(SYSTEM_SUBSYSTEM_CLOCK) | SYSTEM_SUBSYSTEM_MASK(SYSTEM_SUBSYSTEM_HOSTNAME), &first), 0);
+	assert_non_null(first.data[SYSTEM_SUBSYSTEM_CLOCK]);
+	assert_null(first.data[SYSTEM_SUBSYSTEM_HOSTNAME]);
+	assert_string_equal(first.data[SYSTEM_SUBSYSTEM_CLOCK], "- " SYSTEM_LOCALTIME_FILE "\n");
+	system_snapshot_sources_free(&first);
+
+	assert_int_equal(system_root_path(path_buffer, sizeof(path_buffer), SYSTEM_LOCALTIME_FILE), 0);
+	file = fopen(path_buffer, "w");
+	assert_non_null(file);
+	fprintf(file, "TZif");
+	fclose(file);
+
+	// unchanged files give the same validators
+	assert_int_equal(system_snapshot_sources_collect(SYSTEM_SUBSYSTEM_MASK(SYSTEM_SUBSYSTEM_CLOCK), &first), 0);
+	assert_int_equal(system_snapshot_sources_collect(SYSTEM_SUBSYSTEM_MASK(SYSTEM_SUBSYSTEM_CLOCK), &second), 0);
+	assert_int_equal(first.length[SYSTEM_SUBSYSTEM_CLOCK], second.length[SYSTEM_SUBSYSTEM_CLOCK]);
+	assert_memory_equal(first.data[SYSTEM_SUBSYSTEM_CLOCK], second.data[SYSTEM_SUBSYSTEM_CLOCK], first.length[SYSTEM_SUBSYSTEM_CLOCK]);
+	system_snapshot_sources_free(&second);
+
+	file = fopen(path_buffer, "a");
+	assert_non_null(file);
+	fprintf(file, "2");
+	fclose(file);
+
+	assert_int_equal(system_snapshot_sources_collect(SYSTEM_SUBSYSTEM_MASK(SYSTEM_SUBSYSTEM_CLOCK), &second), 0);
+	assert_string_not_equal(first.data[SYSTEM_SUBSYSTEM_CLOCK], second.data[SYSTEM_SUBSYSTEM_CLOCK]);
+
+	system_snapshot_sources_free(&first);
+	system_snapshot_sources_free(&second);
+
+	remove(path_buffer);
+	assert_int_equal(system_root_path(path_buffer, sizeof(path_buffer), "/etc"), 0);
+	rmdir(path_buffer);
+	rmdir(root);
+
+	system_root_set(NULL);
+}
+
+static void test_fs_batch_chains(void **state)
+{
+	(void) state;
+
+	char root[] = "/tmp/system_utest_fs_batch_XXXXXX";
+	char home_buffer[PATH_MAX] = {0};
+	char path_buffer[PATH_MAX] = {0};
+	char content_buffer[32] = {0};
+	system_fs_batch_t batch = {0};
+	size_t chain = 0;
+	struct stat st = {0};
+	FILE *file = NULL;
+
+	assert_non_null(mkdtemp(root));
+	snprintf(home_buffer, sizeof(home_buffer), "%s/home", root);
+
+	// the directory is created before the file written into it
+	assert_int_equal(system_fs_batch_chain(&batch, &chain), 0);
+	assert_int_equal(system_fs_batch_add(&batch, chain, &(system_fs_op_t){.type = SYSTEM_FS_OP_MKDIR, .path = home_buffer, .mode = 0700, .uid = (uid_t) -1, .gid = (gid_t) -1, .exclusive = true}), 0);
+	snprintf(path_buffer, sizeof(path_buffer), "%s/keys", home_buffer);
+	assert_int_equal(system_fs_batch_add(&batch, chain, &(system_fs_op_t){.type = SYSTEM_FS_OP_WRITE, .path = path_buffer, .data = "ssh-ed25519 AAAA", .size = 16, .mode = 0600, .uid = (uid_t) -1, .gid = (gid_t) -1, .atomic = true}), 0);
+
+	// an existing directory fails an exclusive mkdir and stops its chain only
+	assert_int_equal(system_fs_batch_chain(&batch, &chain), 0);
+	assert_int_equal(system_fs_batch_add(&batch, chain, &(system_fs_op_t){.type = SYSTEM_FS_OP_MKDIR, .path = root, .mode = 0700, .uid = (uid_t) -1, .gid = (gid_t) -1, .exclusive = true}), 0);
+	snprintf(path_buffer, sizeof(path_buffer), "%s/skipped", root);
+	assert_int_equal(system_fs_batch_add(&batch, chain, &(system_fs_op_t){.type = SYSTEM_FS_OP_WRITE, .path = path_buffer, .data = "x", .size = 1, .mode = 0600, .uid = (uid_t) -1, .gid = (gid_t) -1}), 0);
+
+	assert_int_equal(system_fs_batch_run(&batch), -1);
+	system_fs_batch_free(&batch);
+
+	assert_int_not_equal(access(path_buffer, F_OK), 0);
+
+	snprintf(path_buffer, sizeof(path_buffer), "%s/keys", home_buffer);
+	assert_int_equal(stat(path_buffer, &st), 0);
+	assert_int_equal(st.st_mode & 0777, 0600);
+
+	file = fopen(path_buffer, "r");
+	assert_non_null(file);
+	assert_int_equal(fread(content_buffer, 1, sizeof(content_buffer) - 1, file), 16);
+	fclose(file);
+	assert_string_equal(content_buffer, "ssh-ed25519 AAAA");
+
+	remove(path_buffer);
+	rmdir(home_buffer);
+	rmdir(root);
+}
+
+static void test_fs_batch_owned_directories(void **state)
+{
+	(void) state;
+
+	char root[] = "/tmp/system_utest_fs_owned_XXXXXX";
+	char home_buffer[PATH_MAX] = {0};
+	char ssh_buffer[PATH_MAX] = {0};
+	char keys_buffer[PATH_MAX] = {0};
+	char other_buffer[PATH_MAX] = {0};
+	system_fs_batch_t batch = {0};
+	size_t chain = 0;
+
+	assert_non_null(mkdtemp(root));
+	snprintf(home_buffer, sizeof(home_buffer), "%s/user", root);
+	snprintf(ssh_buffer, sizeof(ssh_buffer), "%s/.ssh", home_buffer);
+	snprintf(keys_buffer, sizeof(keys_buffer), "%s/authorized_keys", ssh_buffer);
+	snprintf(other_buffer, sizeof(other_buffer), "%s/other", root);
+	assert_int_equal(mkdir(home_buffer, 0700), 0);
+	assert_int_equal(mkdir(other_buffer, 0700), 0);
+
+	// ~/.ssh replaced with a symlink - nothing is written where it points to
+	assert_int_equal(__real_symlink(other_buffer, ssh_buffer), 0);
+	assert_int_equal(system_fs_batch_chain(&batch, &chain), 0);
+	assert_int_equal(system_fs_batch_add(&batch, chain, &(system_fs_op_t){.type = SYSTEM_FS_OP_MKDIR, .path = ssh_buffer, .mode = 0700, .uid = getuid(), .gid = (gid_t) -1, .owned = 1}), 0);
+	assert_int_equal(system_fs_batch_add(&batch, chain, &(system_fs_op_t){.type = SYSTEM_FS_OP_WRITE, .path = keys_buffer, .data = "ssh-ed25519 AAAA", .size = 16, .mode = 0600, .uid = getuid(), .gid = (gid_t) -1, .atomic = true, .owned = 2}), 0);
+	assert_int_equal(system_fs_batch_run(&batch), -1);
+	system_fs_batch_free(&batch);
+
+	snprintf(other_buffer, sizeof(other_buffer), "%s/other/authorized_keys", root);
+	assert_int_not_equal(access(other_buffer, F_OK), 0);
+	assert_int_equal(remove(ssh_buffer), 0);
+
+	// directories of another owner are refused as well
+	assert_int_equal(system_fs_batch_chain(&batch, &chain), 0);
+	assert_int_equal(system_fs_batch_add(&batch, chain, &(system_fs_op_t){.type = SYSTEM_FS_OP_MKDIR, .path = ssh_buffer, .mode = 0700, .uid = getuid() + 1, .gid = (gid_t) -1, .owned = 1}), 0);
+	assert_int_equal(system_fs_batch_run(&batch), -1);
+	system_fs_batch_free(&batch);
+	assert_int_not_equal(access(ssh_buffer, F_OK), 0);
+
+	// owned by the user - created and written relative to the opened directories
+	assert_int_equal(system_fs_batch_chain(&batch, &chain), 0);
+	assert_int_equal(system_fs_batch_add(&batch, chain, &(system_fs_op_t){.type = SYSTEM_FS_OP_MKDIR, .path = ssh_buffer, .mode = 0700, .uid = getuid(), .gid = (gid_t) -1, .owned = 1}), 0);
+	assert_int_equal(system_fs_batch_add(&batch, chain, &(system_fs_op_t){.type = SYSTEM_FS_OP_WRITE, .path = keys_buffer, .data = "ssh-ed25519 AAAA", .size = 16, .mode = 0600, .uid = getuid(), .gid = (gid_t) -1, .atomic = true, .owned = 2}), 0);
+	assert_int_equal(system_fs_batch_add(&batch, chain, &(system_fs_op_t){.type = SYSTEM_FS_OP_UNLINK, .path = keys_buffer, .uid = getuid(), .owned = 2}), 0);
+	assert_int_equal(system_fs_batch_add(&batch, chain, &(system_fs_op_t){.type = SYSTEM_FS_OP_WRITE, .path = keys_buffer, .data = "ssh-ed25519 BBBB", .size = 16, .mode = 0600, .uid = getuid(), .gid = (gid_t) -1, .atomic = true, .owned = 2}), 0);
+	assert_int_equal(system_fs_batch_run(&batch), 0);
+	system_fs_batch_free(&batch);
+	assert_int_equal(access(keys_buffer, F_OK), 0);
+
+	remove(keys_buffer);
+	rmdir(ssh_buffer);
+	rmdir(home_buffer);
+	snprintf(other_buffer, sizeof(other_buffer), "%s/other", root);
+	rmdir(other_buffer);
+	rmdir(root);
+}
+
+static void test_fs_batch_remove(void **state)
+{
+	(void) state;
+
+	char root[] = "/tmp/system_utest_fs_remove_XXXXXX";
+	char home_buffer[PATH_MAX] = {0};
+	char path_buffer[PATH_MAX] = {0};
+	char other_buffer[PATH_MAX] = {0};
+	system_fs_batch_t batch = {0};
+	size_t chain = 0;
+	FILE *file = NULL;
+
+	assert_non_null(mkdtemp(root));
+	snprintf(home_buffer, sizeof(home_buffer), "%s/home; touch pwned", root);
+	snprintf(other_buffer, sizeof(other_buffer), "%s/other", root);
+	assert_int_equal(mkdir(home_buffer, 0700), 0);
+	assert_int_equal(mkdir(other_buffer, 0700), 0);
+
+	// nested directories, names the shell would expand and symlinks out of the tree
+	snprintf(path_buffer, sizeof(path_buffer), "%s/$(id) `id`", home_buffer);
+	assert_int_equal(mkdir(path_buffer, 0700), 0);
+	snprintf(path_buffer, sizeof(path_buffer), "%s/$(id) `id`/*", home_buffer);
+	file = fopen(path_buffer, "w");
+	assert_non_null(file);
+	fclose(file);
+	snprintf(path_buffer, sizeof(path_buffer), "%s/keep", other_buffer);
+	file = fopen(path_buffer, "w");
+	assert_non_null(file);
+	fclose(file);
+	snprintf(path_buffer, sizeof(path_buffer), "%s/link", home_buffer);
+	assert_int_equal(__real_symlink(other_buffer, path_buffer), 0);
+
+	assert_int_equal(system_fs_batch_chain(&batch, &chain), 0);
+	assert_int_equal(system_fs_batch_add(&batch, chain, &(system_fs_op_t){.type = SYSTEM_FS_OP_REMOVE, .path = home_buffer, .uid = (uid_t) -1, .gid = (gid_t) -1}), 0);
+	assert_int_equal(system_fs_batch_run(&batch), 0);
+	system_fs_batch_free(&batch);
+
+	// the tree is gone, the files behind the symlink are kept
+	assert_int_not_equal(access(home_buffer, F_OK), 0);
+	snprintf(path_buffer, sizeof(path_buffer), "%s/keep", other_buffer);
+	assert_int_equal(access(path_buffer, F_OK), 0);
+
+	// a missing directory was already removed
+	assert_int_equal(system_fs_batch_chain(&batch, &chain), 0);
+	assert_int_equal(system_fs_batch_add(&batch, chain, &(system_fs_op_t){.type = SYSTEM_FS_OP_REMOVE, .path = home_buffer, .uid = (uid_t) -1, .gid = (gid_t) -1}), 0);
+	assert_int_equal(system_fs_batch_run(&batch), 0);
+	system_fs_batch_free(&batch);
+
+	remove(path_buffer);
+	rmdir(other_buffer);
+	rmdir(root);
+}
+
+static void test_journal_recover(void **state)
+{
+	(void) state;
+
+	char root[] = "/tmp/system_utest_journal_XXXXXX";
+	char path_buffer[PATH_MAX] = {0};
+	char keys_buffer[2][PATH_MAX] = {0};
+	system_fs_batch_t batch = {0};
+	system_journal_t journal = {.fd = -1};
+	size_t chain = 0;
+	struct stat st = {0};
+
+	assert_non_null(mkdtemp(root));
+	assert_int_equal(system_root_set(root), 0);
+	assert_int_equal(system_root_path(path_buffer, sizeof(path_buffer), "/var"), 0);
+	assert_int_equal(mkdir(path_buffer, 0755), 0);
+	assert_int_equal(system_root_path(path_buffer, sizeof(path_buffer), "/var/lib"), 0);
+	assert_int_equal(mkdir(path_buffer, 0755), 0);
+
+	for (size_t i = 0; i < 2; i++) {
+		snprintf(path_buffer, sizeof(path_buffer), "%s/user%zu", root, i);
+		snprintf(keys_buffer[i], sizeof(keys_buffer[i]), "%s/authorized_keys", path_buffer);
+
+		assert_int_equal(system_fs_batch_chain(&batch, &chain), 0);
+		assert_int_equal(system_fs_batch_add(&batch, chain, &(system_fs_op_t){.type = SYSTEM_FS_OP_MKDIR, .path = path_buffer, .mode = 0700, .uid = (uid_t) -1, .gid = (gid_t) -1, .exclusive = true}), 0);
+		assert_int_equal(system_fs_batch_add(&batch, chain, &(system_fs_op_t){.type = SYSTEM_FS_OP_WRITE, .path = keys_buffer[i], .data = "ssh-ed25519 AAAA", .size = 16, .mode = 0600, .uid = (uid_t) -1, .gid = (gid_t) -1, .atomic = true}), 0);
+	}
+
+	// the process stops after the commit, the first chain done and the second home directory created
+	assert_int_equal(system_journal_begin(&journal, &batch, false), 0);
+	assert_int_equal(system_journal_commit(&journal), 0);
+	batch.chain_done(batch.chain_done_arg, 0);
+	batch.dir_created(batch.chain_done_arg, 1, 0);
+	close(journal.fd);
+	system_fs_batch_free(&batch);
+
+	// created, but stopped before its mode was set
+	snprintf(path_buffer, sizeof(path_buffer), "%s/user1", root);
+	assert_int_equal(mkdir(path_buffer, 0700), 0);
+	assert_int_equal(chmod(path_buffer, 0755), 0);
+
+	// only the unfinished chain is run again - its exclusive directory is accepted and gets its mode again
+	assert_int_equal(system_journal_recover(), 0);
+	assert_int_not_equal(access(keys_buffer[0], F_OK), 0);
+	assert_int_equal(access(keys_buffer[1], F_OK), 0);
+	assert_int_equal(stat(path_buffer, &st), 0);
+	assert_int_equal(st.st_mode & 07777, 0700);
+
+	// the journal is emptied - nothing is repeated on the next start
+	assert_int_equal(system_root_path(path_buffer, sizeof(path_buffer), SYSTEM_JOURNAL_FILE), 0);
+	assert_int_equal(stat(path_buffer, &st), 0);
+	assert_int_equal(st.st_size, 0);
+	assert_int_equal(system_journal_recover(), 0);
+
+	remove(path_buffer);
+	remove(keys_buffer[1]);
+	assert_int_equal(system_root_path(path_buffer, sizeof(path_buffer), "/user1"), 0);
+	rmdir(path_buffer);
+	assert_int_equal(system_root_path(path_buffer, sizeof(path_buffer), SYSTEM_PLUGIN_STATE_DIRECTORY), 0);
+	rmdir(path_buffer);
+	assert_int_equal(system_root_path(path_buffer, sizeof(path_buffer), "/var/lib"), 0);
+	rmdir(path_buffer);
+	assert_int_equal(system_root_path(path_buffer, sizeof(path_buffer), "/var"), 0);
+	rmdir(path_buffer);
+	rmdir(root);
+
+	system_root_set(NULL);
+}
+
+static void test_journal_recover_existing_directory(void **state)
+{
+	(void) state;
+
+	char root[] = "/tmp/system_utest_journal_XXXXXX";
+	char path_buffer[PATH_MAX] = {0};
+	char home_buffer[PATH_MAX] = {0};
+	system_fs_batch_t batch = {0};
+	system_journal_t journal = {.fd = -1};
+	size_t chain = 0;
+	struct stat st = {0};
+
+	assert_non_null(mkdtemp(root));
+	assert_int_equal(system_root_set(root), 0);
+	assert_int_equal(system_root_path(path_buffer, sizeof(path_buffer), "/var"), 0);
+	assert_int_equal(mkdir(path_buffer, 0755), 0);
+	assert_int_equal(system_root_path(path_buffer, sizeof(path_buffer), "/var/lib"), 0);
+	assert_int_equal(mkdir(path_buffer, 0755), 0);
+
+	snprintf(home_buffer, sizeof(home_buffer), "%s/user", root);
+	assert_int_equal(system_fs_batch_chain(&batch, &chain), 0);
+	assert_int_equal(system_fs_batch_add(&batch, chain, &(system_fs_op_t){.type = SYSTEM_FS_OP_MKDIR, .path = home_buffer, .mode = 0700, .uid = (uid_t) -1, .gid = (gid_t) -1, .exclusive = true}), 0);
+
+	// the process stops after the commit, before the home directory was created
+	assert_int_equal(system_journal_begin(&journal, &batch, false), 0);
+	assert_int_equal(system_journal_commit(&journal), 0);
+	close(journal.fd);
+	system_fs_batch_free(&batch);
+
+	// left over from an earlier account - not created by the batch
+	assert_int_equal(mkdir(home_buffer, 0755), 0);
+
+	// the exclusive directory is still refused and keeps its mode
+	assert_int_equal(system_journal_recover(), -1);
+	assert_int_equal(stat(home_buffer, &st), 0);
+	assert_int_equal(st.st_mode & 07777, 0755);
+
+	rmdir(home_buffer);
+	assert_int_equal(system_root_path(path_buffer, sizeof(path_buffer), SYSTEM_JOURNAL_FILE), 0);
+	remove(path_buffer);
+	assert_int_equal(system_root_path(path_buffer, sizeof(path_buffer), SYSTEM_PLUGIN_STATE_DIRECTORY), 0);
+	rmdir(path_buffer);
+	assert_int_equal(system_root_path(path_buffer, sizeof(path_buffer), "/var/lib"), 0);
+	rmdir(path_buffer);
+	assert_int_equal(system_root_path(path_buffer, sizeof(path_buffer), "/var"), 0);
+	rmdir(path_buffer);
+	rmdir(root);
+
+	system_root_set(NULL);
+}
+
+static void test_journal_recover_uncommitted(void **state)
+{
+	(void) state;
+
+	const char *users[] = {"alice", "bob"};
+	const char *deleted_users[] = {"carol", "dave"};
+	const char *directories[] = {"/etc", "/home", "/var", "/var/lib"};
+	char root[] = "/tmp/system_utest_journal_XXXXXX";
+	char path_buffer[PATH_MAX] = {0};
+	system_fs_batch_t batch = {0};
+	system_journal_t journal = {.fd = -1};
+	size_t chain = 0;
+	FILE *file = NULL;
+
+	assert_non_null(mkdtemp(root));
+	assert_int_equal(system_root_set(root), 0);
+
+	for (size_t i = 0; i < ARRAY_SIZE(directories); i++) {
+		assert_int_equal(system_root_path(path_buffer, sizeof(path_buffer), directories[i]), 0);
+		assert_int_equal(mkdir(path_buffer, 0755), 0);
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(users); i++) {
+		snprintf(path_buffer, sizeof(path_buffer), "%s/home/%s", root, users[i]);
+		assert_int_equal(system_fs_batch_chain(&batch, &chain), 0);
+		assert_int_equal(system_fs_batch_set_account(&batch, chain, users[i], false), 0);
+		assert_int_equal(system_fs_batch_add(&batch, chain, &(system_fs_op_t){.type = SYSTEM_FS_OP_MKDIR, .path = path_buffer, .mode = 0700, .uid = (uid_t) -1, .gid = (gid_t) -1, .exclusive = true}), 0);
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(deleted_users); i++) {
+		snprintf(path_buffer, sizeof(path_buffer), "%s/home/%s", root, deleted_users[i]);
+		assert_int_equal(mkdir(path_buffer, 0700), 0);
+		assert_int_equal(system_fs_batch_chain(&batch, &chain), 0);
+		assert_int_equal(system_fs_batch_set_account(&batch, chain, deleted_users[i], true), 0);
+		assert_int_equal(system_fs_batch_add(&batch, chain, &(system_fs_op_t){.type = SYSTEM_FS_OP_REMOVE, .path = path_buffer, .uid = (uid_t) -1, .gid = (gid_t) -1}), 0);
+	}
+
+	// the process stops after the account database is written with the first created user and without the first
+	// deleted one, before the commit
+	assert_int_equal(system_journal_begin(&journal, &batch, false), 0);
+	close(journal.fd);
+	system_fs_batch_free(&batch);
+
+	assert_int_equal(system_root_path(path_buffer, sizeof(path_buffer), SYSTEM_AUTHENTICATION_PASSWD_PATH), 0);
+	file = fopen(path_buffer, "w");
+	assert_non_null(file);
+	fputs("alice:x:1000:1000::/home/alice:/bin/sh\n", file);
+	fputs("dave:x:1001:1001::/home/dave:/bin/sh\n", file);
+	fclose(file);
+
+	// the written accounts get their home directories or lose them, the other changes never happened
+	assert_int_equal(system_journal_recover(), 0);
+	snprintf(path_buffer, sizeof(path_buffer), "%s/home/alice", root);
+	assert_int_equal(access(path_buffer, F_OK), 0);
+	rmdir(path_buffer);
+	snprintf(path_buffer, sizeof(path_buffer), "%s/home/bob", root);
+	assert_int_not_equal(access(path_buffer, F_OK), 0);
+	snprintf(path_buffer, sizeof(path_buffer), "%s/home/carol", root);
+	assert_int_not_equal(access(path_buffer, F_OK), 0);
+	snprintf(path_buffer, sizeof(path_buffer), "%s/home/dave", root);
+	assert_int_equal(access(path_buffer, F_OK), 0);
+	rmdir(path_buffer);
+
+	assert_int_equal(system_root_path(path_buffer, sizeof(path_buffer), SYSTEM_AUTHENTICATION_PASSWD_PATH), 0);
+	remove(path_buffer);
+	assert_int_equal(system_root_path(path_buffer, sizeof(path_buffer), SYSTEM_JOURNAL_FILE), 0);
+	remove(path_buffer);
+	assert_int_equal(system_root_path(path_buffer, sizeof(path_buffer), SYSTEM_PLUGIN_STATE_DIRECTORY), 0);
+	rmdir(path_buffer);
+	for (size_t i = ARRAY_SIZE(directories); i > 0; i--) {
+		assert_int_equal(system_root_path(path_buffer, sizeof(path_buffer), directories[i - 1]), 0);
+		rmdir(path_buffer);
+	}
+	rmdir(root);
+
+	system_root_set(NULL);
+}
+
+static void test_journal_source(void **state)
+{
+	(void) state;
+
+	char root[] = "/tmp/system_utest_journal_XXXXXX";
+	char path_buffer[PATH_MAX] = {0};
+	char source_buffer[PATH_MAX] = {0};
+	char target_buffer[PATH_MAX] = {0};
+	char content[16] = {0};
+	char *data = NULL;
+	system_fs_batch_t batch = {0};
+	system_journal_t journal = {.fd = -1};
+	size_t chain = 0;
+	struct stat st = {0};
+	FILE *file = NULL;
+
+	assert_non_null(mkdtemp(root));
+	assert_int_equal(system_root_set(root), 0);
+	assert_int_equal(system_root_path(path_buffer, sizeof(path_buffer), "/var"), 0);
+	assert_int_equal(mkdir(path_buffer, 0755), 0);
+	assert_int_equal(system_root_path(path_buffer, sizeof(path_buffer), "/var/lib"), 0);
+	assert_int_equal(mkdir(path_buffer, 0755), 0);
+
+	snprintf(source_buffer, sizeof(source_buffer), "%s/source", root);
+	snprintf(target_buffer, sizeof(target_buffer), "%s/target", root);
+	file = fopen(source_buffer, "w");
+	assert_non_null(file);
+	fputs("skel", file);
+	fclose(file);
+
+	data = malloc(65536);
+	assert_non_null(data);
+	memset(data, 'x', 65536);
+
+	// only the path of the source is recorded, not its content
+	assert_int_equal(system_fs_batch_chain(&batch, &chain), 0);
+	assert_int_equal(system_fs_batch_add(&batch, chain, &(system_fs_op_t){.type = SYSTEM_FS_OP_WRITE, .path = target_buffer, .data = data, .size = 65536, .source = source_buffer, .mode = 0644, .uid = (uid_t) -1, .gid = (gid_t) -1}), 0);
+	assert_int_equal(system_journal_begin(&journal, &batch, true), 0);
+	assert_int_equal(fstat(journal.fd, &st), 0);
+	assert_true(st.st_size < 4096);
+	close(journal.fd);
+	system_fs_batch_free(&batch);
+	free(data);
+
+	// the replay reads the source again
+	assert_int_equal(system_journal_recover(), 0);
+	file = fopen(target_buffer, "r");
+	assert_non_null(file);
+	assert_int_equal(fread(content, 1, sizeof(content) - 1, file), 4);
+	fclose(file);
+	assert_string_equal(content, "skel");
+
+	remove(target_buffer);
+	remove(source_buffer);
+	assert_int_equal(system_root_path(path_buffer, sizeof(path_buffer), SYSTEM_JOURNAL_FILE), 0);
+	remove(path_buffer);
+	assert_int_equal(system_root_path(path_buffer, sizeof(path_buffer), SYSTEM_PLUGIN_STATE_DIRECTORY), 0);
+	rmdir(path_buffer);
+	assert_int_equal(system_root_path(path_buffer, sizeof(path_buffer), "/var/lib"), 0);
+	rmdir(path_buffer);
+	assert_int_equal(system_root_path(path_buffer, sizeof(path_buffer), "/var"), 0);
+	rmdir(path_buffer);
+	rmdir(root);
+
+	system_root_set(NULL);
+}
+
+static void test_txn_commit_root_refused(void **state)
+{
+	(void) state;
+
+	char root[] = "/tmp/system_utest_txn_XXXXXX";
+	char path_buffer[PATH_MAX] = {0};
+	system_authentication_txn_t txn = {0};
+
+	assert_non_null(mkdtemp(root));
+	assert_int_equal(system_root_set(root), 0);
+
+	// an empty account database - um_db_store() must not be reached
+	will_return(__wrap_um_db_load, 0);
+	assert_int_equal(system_authentication_txn_begin(&txn), 0);
+	assert_int_equal(system_authentication_txn_add_user(&txn, "alice", "$6$salt$hash"), 0);
+
+	// the accounts of /etc are not changed for a separate root
+	assert_int_equal(system_authentication_txn_commit(&txn), -1);
+	system_authentication_txn_free(&txn);
+
+	snprintf(path_buffer, sizeof(path_buffer), "%s/home/alice", root);
+	assert_int_not_equal(access(path_buffer, F_OK), 0);
+	assert_int_equal(system_root_path(path_buffer, sizeof(path_buffer), SYSTEM_JOURNAL_FILE), 0);
+	assert_int_not_equal(access(path_buffer, F_OK), 0);
+
+	rmdir(root);
+
+	system_root_set(NULL);
+}
+
+static void test_txn_add_delete_user(void **state)
+{
+	(void) state;
+
+	char root[] = "/tmp/system_utest_txn_XXXXXX";
+	char path_buffer[PATH_MAX] = {0};
+	system_authentication_txn_t txn = {0};
+	FILE *file = NULL;
+
+	assert_non_null(mkdtemp(root));
+	assert_int_equal(system_root_set(root), 0);
+
+	will_return(__wrap_um_db_load, 0);
+	assert_int_equal(system_authentication_txn_begin(&txn), 0);
+
+	// the private group gets the UID as GID, a name is created only once
+	assert_int_equal(system_authentication_txn_add_user(&txn, "alice", "$6$salt$hash"), 0);
+	assert_non_null(um_db_get_user(txn.db, "alice"));
+	assert_int_equal(txn.created->uid, SYSTEM_AUTHENTICATION_UID_MIN);
+	assert_int_equal(txn.created->gid, SYSTEM_AUTHENTICATION_UID_MIN);
+	assert_int_equal(system_authentication_txn_add_user(&txn, "alice", "$6$salt$hash"), -1);
+
+	// names which would put the home directory elsewhere are refused
+	assert_int_equal(system_authentication_txn_add_user(&txn, "..", "$6$salt$hash"), -1);
+	assert_int_equal(system_authentication_txn_add_user(&txn, "a/b", "$6$salt$hash"), -1);
+	assert_int_equal(system_authentication_txn_delete_user(&txn, "../etc"), -1);
+
+	assert_int_equal(system_authentication_txn_delete_user(&txn, "alice"), 0);
+	assert_null(um_db_get_user(txn.db, "alice"));
+	assert_non_null(txn.deleted);
+	assert_string_equal(txn.deleted->name, "alice");
+	assert_true(txn.dirty);
+
+	// the refused commit leaves the home directory of the sandbox as it is
+	snprintf(path_buffer, sizeof(path_buffer), "%s/home", root);
+	assert_int_equal(mkdir(path_buffer, 0755), 0);
+	snprintf(path_buffer, sizeof(path_buffer), "%s/home/alice", root);
+	assert_int_equal(mkdir(path_buffer, 0700), 0);
+	snprintf(path_buffer, sizeof(path_buffer), "%s/home/alice/.profile", root);
+	file = fopen(path_buffer, "w");
+	assert_non_null(file);
+	fclose(file);
+
+	assert_int_equal(system_authentication_txn_commit(&txn), -1);
+	system_authentication_txn_free(&txn);
+	assert_int_equal(access(path_buffer, F_OK), 0);
+
+	remove(path_buffer);
+	snprintf(path_buffer, sizeof(path_buffer), "%s/home/alice", root);
+	rmdir(path_buffer);
+	snprintf(path_buffer, sizeof(path_buffer), "%s/home", root);
+	rmdir(path_buffer);
+	rmdir(root);
+
+	system_root_set(NULL);
+}
+
+static void test_txn_add_user_cleartext(void **state)
+{
+	(void) state;
+
+	system_authentication_txn_t txn = {0};
+
+	will_return(__wrap_um_db_load, 0);
+	assert_int_equal(system_authentication_txn_begin(&txn), 0);
+
+	// startup data is applied without the SR_EV_UPDATE hashing - the cleartext reaches neither shadow nor gshadow
+	assert_int_equal(system_authentication_txn_add_user(&txn, "carol", SYSTEM_AUTHENTICATION_PASSWORD_CLEARTEXT_PREFIX "secret"), 0);
+	assert_int_equal(strncmp(system_utest_user_hash, "$6$", 3), 0);
+	assert_null(strstr(system_utest_user_hash, "secret"));
+	assert_string_equal(system_utest_group_hash, SYSTEM_AUTHENTICATION_GROUP_PASSWORD_LOCKED);
+
+	assert_int_equal(system_authentication_txn_set_password(&txn, "carol", SYSTEM_AUTHENTICATION_PASSWORD_CLEARTEXT_PREFIX "other"), 0);
+	assert_int_equal(strncmp(system_utest_user_hash, "$6$", 3), 0);
+	assert_null(strstr(system_utest_user_hash, "other"));
+
+	system_authentication_txn_free(&txn);
+}
+
+#ifndef SYSTEM_DNS_RESOLVER_BACKEND_RESOLVED
+static void test_dns_resolver_resolv_conf(void **state)
+{
+	(void) state;
+
+	char root[] = "/tmp/system_utest_resolv_XXXXXX";
+	char path_buffer[PATH_MAX] = {0};
+	char content[512] = {0};
+	system_dns_search_element_t *search_head = NULL;
+	system_dns_server_element_t *server_head = NULL;
+	system_dns_server_t server = {0};
+	FILE *file = NULL;
+	size_t size = 0;
+
+	assert_non_null(mkdtemp(root));
+	assert_int_equal(system_root_set(root), 0);
+
+	assert_int_equal(system_root_path(path_buffer, sizeof(path_buffer), "/etc"), 0);
+	assert_int_equal(mkdir(path_buffer, 0755), 0);
+
+	// the last search or domain line is in effect, zoned addresses are skipped
+	assert_int_equal(system_root_path(path_buffer, sizeof(path_buffer), SYSTEM_RESOLV_CONF_FILE), 0);
+	file = fopen(path_buffer, "w");
+	assert_non_null(file);
+	fprintf(file, "# generated\ndomain old.example\nnameserver 192.0.2.1\noptions edns0\nsearch a.example b.example\nnameserver fe80::1%%eth0\nnameserver 2001:db8::1");
+	fclose(file);
+
+	assert_int_equal(system_dns_resolver_resolv_conf_load_search(&search_head), 0);
+	assert_non_null(search_head);
+	assert_string_equal(search_head->search.domain, "a.example");
+	assert_non_null(search_head->next);
+	assert_string_equal(search_head->next->search.domain, "b.example");
+	assert_null(search_head->next->next);
+
+	assert_int_equal(system_dns_resolver_resolv_conf_load_server(&server_head), 0);
+	assert_non_null(server_head);
+	assert_string_equal(server_head->server.name, "192.0.2.1");
+	assert_non_null(server_head->next);
+	assert_string_equal(server_head->next->server.name, "2001:db8::1");
+	assert_null(server_head->next->next);
+
+	// the new lines replace the first old one, comments and options are kept
+	system_dns_search_list_free(&search_head);
+	assert_int_equal(system_dns_search_list_add(&search_head, (system_dns_search_t){.domain = "c.example", .search = 1}), 0);
+	assert_int_equal(system_dns_resolver_resolv_conf_store_search(search_head), 0);
+
+	system_dns_server_list_free(&server_head);
+	assert_int_equal(system_ip_address_from_str(&server.address, "198.51.100.7"), 0);
+	server.name = "dns";
+	assert_int_equal(system_dns_server_list_add(&server_head, server), 0);
+	assert_int_equal(system_dns_resolver_resolv_conf_store_server(server_head), 0);
+
+	file = fopen(path_buffer, "r");
+	assert_non_null(file);
+	size = fread(content, 1, sizeof(content) - 1, file);
+	fclose(file);
+	content[size] = 0;
+	assert_string_equal(content, "# generated\nsearch c.example\nnameserver 198.51.100.7\noptions edns0\n");
+
+	system_dns_search_list_free(&search_head);
+	system_dns_server_list_free(&server_head);
+
+	remove(path_buffer);
+	assert_int_equal(system_root_path(path_buffer, sizeof(path_buffer), "/etc"), 0);
+	rmdir(path_buffer);
+	rmdir(root);
+
+	system_root_set(NULL);
+}
+#endif
+
 int __wrap_gethostname(char *buffer, size_t buffer_size)
 {
 	check_expected_ptr(buffer);
@@ -328,3 +1814,25 @@ int __wrap_sr_apply_changes(sr_session_ctx_t *session, uint32_t timeout_ms)
 {
 	return (int) mock();
 }
+
+int __wrap_um_db_load(um_db_t *db)
+{
+	return (int) mock();
+}
+
+int __wrap_um_db_store(um_db_t *db)
+{
+	return (int) mock();
+}
+
+int __wrap_um_user_set_password_hash(um_user_t *user, const char *password_hash)
+{
+	snprintf(system_utest_user_hash, sizeof(system_utest_user_hash), "%s", password_hash ? password_hash : "");
+	return __real_um_user_set_password_hash(user, password_hash);
+}
+
+int __wrap_um_group_set_password_hash(um_group_t *group, const char *password_hash)
+{
+	snprintf(system_utest_group_hash, sizeof(system_utest_group_hash), "%s", password_hash ? password_hash : "");
+	return __real_um_group_set_password_hash(group, password_hash);
+}